@@ -0,0 +1,365 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "FeatureExtractor.hpp"
+
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/feature/sift/ImageDescriber_SIFT.hpp>
+#include <aliceVision/image/io.hpp>
+#include <aliceVision/system/ConcurrentQueue.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/Tracing.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace aliceVision {
+namespace feature {
+
+namespace {
+
+/**
+ * @brief Limit the memory used by the jobs in flight.
+ * A job bigger than the whole budget is allowed to run alone.
+ */
+class MemoryBudget
+{
+public:
+  explicit MemoryBudget(std::size_t budget)
+    : _budget(budget)
+  {}
+
+  std::size_t acquire(std::size_t memory)
+  {
+    memory = std::min(memory, _budget);
+    std::unique_lock<std::mutex> lock(_mutex);
+    _released.wait(lock, [&]{ return _used + memory <= _budget; });
+    _used += memory;
+    _peak = std::max(_peak, _used);
+    return memory;
+  }
+
+  void release(std::size_t memory)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _used -= memory;
+    _released.notify_all();
+  }
+
+  std::size_t peak() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _peak;
+  }
+
+private:
+  const std::size_t _budget;
+  std::size_t _used = 0;
+  std::size_t _peak = 0;
+  mutable std::mutex _mutex;
+  std::condition_variable _released;
+};
+
+/**
+ * @brief Thread-safe accumulation of the timings of a stage.
+ */
+class StageStatsAccumulator
+{
+public:
+  StageStatsAccumulator(FeatureExtractorStageStats& stats, const std::string& name, std::size_t nbThreads)
+    : _stats(stats)
+  {
+    _stats.name = name;
+    _stats.nbThreads = nbThreads;
+  }
+
+  void add(double busyTime)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_stats.nbImages;
+    _stats.busyTime += busyTime;
+  }
+
+private:
+  FeatureExtractorStageStats& _stats;
+  std::mutex _mutex;
+};
+
+struct DecodedImage
+{
+  const FeatureExtractorJob* job = nullptr;
+  std::size_t memory = 0;
+  image::Image<float> image;
+};
+
+struct DescribedRegions
+{
+  const FeatureExtractorJob::Output* output = nullptr;
+  const ImageDescriber* describer = nullptr;
+  std::unique_ptr<Regions> regions;
+};
+
+std::ostream& operator<<(std::ostream& os, const FeatureExtractorStageStats& stats)
+{
+  os << "\t- " << stats.name << ": " << stats.nbImages << " images, "
+     << stats.nbThreads << " thread(s), "
+     << stats.busyTime << " s busy, "
+     << stats.throughput() << " images/s" << std::endl;
+  return os;
+}
+
+} // namespace
+
+std::ostream& operator<<(std::ostream& os, const FeatureExtractorStats& stats)
+{
+  os << "Feature extraction throughput:" << std::endl
+     << stats.decode << stats.describe << stats.write
+     << "\t- total: " << stats.describe.nbImages << " images in " << stats.totalTime << " s";
+  if(stats.totalTime > 0.0)
+    os << ", " << stats.describe.nbImages / stats.totalTime << " images/s";
+  os << std::endl
+     << "\t- peak memory budget used: " << stats.peakMemory / (1024 * 1024) << " MB" << std::endl
+     << "\t- failures: " << stats.nbFailures;
+  return os;
+}
+
+FeatureExtractor::FeatureExtractor(const std::vector<FeatureExtractorDescriber>& describers,
+                                   const FeatureExtractorParams& params)
+  : _describers(describers)
+  , _params(params)
+{}
+
+std::vector<std::unique_ptr<ImageDescriber>> FeatureExtractor::createDescribers() const
+{
+  std::vector<std::unique_ptr<ImageDescriber>> describers;
+  describers.reserve(_describers.size());
+  for(const FeatureExtractorDescriber& config : _describers)
+  {
+    std::unique_ptr<ImageDescriber> describer = createImageDescriber(config.type);
+    ImageDescriber_SIFT* siftDescriber = dynamic_cast<ImageDescriber_SIFT*>(describer.get());
+    if(siftDescriber != nullptr)
+      siftDescriber->setSiftEngine(config.siftEngine);
+    describer->Set_configuration_preset(config.preset);
+    describer->setUpRight(config.upRight);
+    describers.push_back(std::move(describer));
+  }
+  return describers;
+}
+
+std::size_t FeatureExtractor::jobMemoryConsumption(const FeatureExtractorJob& job,
+                                                   std::size_t width,
+                                                   std::size_t height,
+                                                   const std::vector<std::unique_ptr<ImageDescriber>>& describers) const
+{
+  const std::size_t nbPixels = width * height;
+  std::size_t describerMemory = 0;
+  bool needUCharImage = false;
+
+  for(const FeatureExtractorJob::Output& output : job.outputs)
+  {
+    const ImageDescriber& describer = *describers.at(output.describerIndex);
+    describerMemory = std::max(describerMemory, describer.getMemoryConsumption(width, height));
+    needUCharImage |= !describer.useFloatImage();
+  }
+  return nbPixels * sizeof(float) + (needUCharImage ? nbPixels : 0) + describerMemory;
+}
+
+bool FeatureExtractor::process(const std::vector<FeatureExtractorJob>& jobs)
+{
+  _stats = FeatureExtractorStats();
+
+  system::Timer timer;
+
+  const std::size_t nbCores = static_cast<std::size_t>(std::max(omp_get_max_threads(), 1));
+  const std::size_t nbDecodeThreads = std::max(_params.nbDecodeThreads, std::size_t(1));
+  const std::size_t nbDescribeThreads = (_params.nbDescribeThreads == 0) ? nbCores : _params.nbDescribeThreads;
+  const std::size_t nbWriteThreads = std::max(_params.nbWriteThreads, std::size_t(1));
+  // describers may use OpenMP internally, share the remaining cores between the describe threads
+  const int nbOmpThreads = static_cast<int>(std::max(nbCores / nbDescribeThreads, std::size_t(1)));
+
+  std::size_t memoryBudget = _params.memoryBudget;
+  if(memoryBudget == 0)
+    memoryBudget = system::getMemoryInfo().freeRam;
+
+  ALICEVISION_LOG_INFO("Feature extraction pipeline:" << std::endl
+                       << "\t- images: " << jobs.size() << std::endl
+                       << "\t- decode threads: " << nbDecodeThreads << std::endl
+                       << "\t- describe threads: " << nbDescribeThreads << std::endl
+                       << "\t- write threads: " << nbWriteThreads << std::endl
+                       << "\t- prefetch size: " << _params.prefetchSize << std::endl
+                       << "\t- memory budget: " << memoryBudget / (1024 * 1024) << " MB");
+
+  // one instance of each describer per describe thread
+  std::vector<std::vector<std::unique_ptr<ImageDescriber>>> threadDescribers(nbDescribeThreads);
+  for(auto& describers : threadDescribers)
+    describers = createDescribers();
+
+  MemoryBudget budget(memoryBudget);
+  StageStatsAccumulator decodeStats(_stats.decode, "decode", nbDecodeThreads);
+  StageStatsAccumulator describeStats(_stats.describe, "describe", nbDescribeThreads);
+  StageStatsAccumulator writeStats(_stats.write, "write", nbWriteThreads);
+  std::atomic<std::size_t> nbFailures(0);
+  std::atomic<std::size_t> nextJob(0);
+
+  system::ConcurrentQueue<std::unique_ptr<DecodedImage>> decodedQueue(std::max(_params.prefetchSize, std::size_t(1)));
+  system::ConcurrentQueue<std::unique_ptr<DescribedRegions>> describedQueue;
+
+  // decode stage
+  auto decode = [&]()
+  {
+    for(std::size_t i = nextJob++; i < jobs.size(); i = nextJob++)
+    {
+      const FeatureExtractorJob& job = jobs[i];
+      std::unique_ptr<DecodedImage> decoded(new DecodedImage);
+      decoded->job = &job;
+
+      try
+      {
+        std::size_t width = job.width;
+        std::size_t height = job.height;
+        if(width == 0 || height == 0)
+        {
+          int metadataWidth, metadataHeight;
+          std::map<std::string, std::string> metadata;
+          image::readImageMetadata(job.imagePath, metadataWidth, metadataHeight, metadata);
+          width = metadataWidth;
+          height = metadataHeight;
+        }
+        decoded->memory = budget.acquire(jobMemoryConsumption(job, width, height, threadDescribers.front()));
+
+        ALICEVISION_TRACE_SCOPE("featureExtraction.decode", job.viewId);
+        system::Timer decodeTimer;
+        image::readImage(job.imagePath, decoded->image);
+        decodeStats.add(decodeTimer.elapsed());
+      }
+      catch(std::exception& e)
+      {
+        ALICEVISION_LOG_ERROR("Cannot read image of view " << job.viewId << ": '" << job.imagePath << "'" << std::endl << e.what());
+        budget.release(decoded->memory);
+        ++nbFailures;
+        continue;
+      }
+      decodedQueue.push(std::move(decoded));
+    }
+  };
+
+  // describe stage
+  auto describe = [&](std::size_t threadIndex)
+  {
+    omp_set_num_threads(nbOmpThreads);
+    const std::vector<std::unique_ptr<ImageDescriber>>& describers = threadDescribers.at(threadIndex);
+    std::unique_ptr<DecodedImage> decoded;
+
+    while(decodedQueue.pop(decoded))
+    {
+      const FeatureExtractorJob& job = *decoded->job;
+      image::Image<unsigned char> imageGrayUChar;
+      ALICEVISION_TRACE_SCOPE("featureExtraction.describe", job.viewId);
+      system::Timer describeTimer;
+
+      for(const FeatureExtractorJob::Output& output : job.outputs)
+      {
+        ImageDescriber& describer = *describers.at(output.describerIndex);
+        std::unique_ptr<DescribedRegions> described(new DescribedRegions);
+        described->output = &output;
+        described->describer = &describer;
+
+        ALICEVISION_LOG_INFO("Extracting " << EImageDescriberType_enumToString(describer.getDescriberType())
+                             << " features from view " << job.viewId << " : '" << job.imagePath << "'");
+        try
+        {
+          if(describer.useFloatImage())
+          {
+            // image buffer use float image, use the read buffer
+            describer.Describe(decoded->image, described->regions);
+          }
+          else
+          {
+            // image buffer can't use float image
+            if(imageGrayUChar.Width() == 0) // the first time, convert the float buffer to uchar
+              imageGrayUChar = decoded->image.GetMat().cast<unsigned char>() * 255;
+            describer.Describe(imageGrayUChar, described->regions);
+          }
+        }
+        catch(std::exception& e)
+        {
+          ALICEVISION_LOG_ERROR("Cannot extract features of view " << job.viewId << ": '" << job.imagePath << "'" << std::endl << e.what());
+          ++nbFailures;
+          continue;
+        }
+        describedQueue.push(std::move(described));
+      }
+      describeStats.add(describeTimer.elapsed());
+
+      // the scale space and the image are released, the next images can be decoded
+      const std::size_t memory = decoded->memory;
+      decoded.reset();
+      budget.release(memory);
+    }
+  };
+
+  // write stage
+  auto write = [&]()
+  {
+    std::unique_ptr<DescribedRegions> described;
+
+    while(describedQueue.pop(described))
+    {
+      ALICEVISION_TRACE_SCOPE("featureExtraction.write");
+      system::Timer writeTimer;
+      try
+      {
+        described->describer->Save(described->regions.get(), described->output->featFilename, described->output->descFilename);
+      }
+      catch(std::exception& e)
+      {
+        ALICEVISION_LOG_ERROR("Cannot write '" << described->output->featFilename << "': " << e.what());
+        ++nbFailures;
+        continue;
+      }
+      writeStats.add(writeTimer.elapsed());
+    }
+  };
+
+  std::vector<std::thread> decodeThreads;
+  std::vector<std::thread> describeThreads;
+  std::vector<std::thread> writeThreads;
+
+  for(std::size_t i = 0; i < nbWriteThreads; ++i)
+    writeThreads.emplace_back(write);
+  for(std::size_t i = 0; i < nbDescribeThreads; ++i)
+    describeThreads.emplace_back(describe, i);
+  for(std::size_t i = 0; i < nbDecodeThreads; ++i)
+    decodeThreads.emplace_back(decode);
+
+  // shutdown the stages in order
+  for(std::thread& thread : decodeThreads)
+    thread.join();
+  decodedQueue.close();
+
+  for(std::thread& thread : describeThreads)
+    thread.join();
+  describedQueue.close();
+
+  for(std::thread& thread : writeThreads)
+    thread.join();
+
+  _stats.nbFailures = nbFailures;
+  _stats.peakMemory = budget.peak();
+  _stats.totalTime = timer.elapsed();
+
+  ALICEVISION_LOG_INFO(_stats);
+
+  return (_stats.nbFailures == 0);
+}
+
+} // namespace feature
+} // namespace aliceVision
@@ -0,0 +1,174 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/feature/sift/SIFT.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief Configuration of an image describer used by the FeatureExtractor.
+ * Each describe thread creates its own ImageDescriber from it.
+ */
+struct FeatureExtractorDescriber
+{
+  EImageDescriberType type;
+  EImageDescriberPreset preset = EImageDescriberPreset::NORMAL;
+  bool upRight = false;
+  /// CPU extraction engine of the SIFT describers
+  ESiftEngine siftEngine = ESiftEngine::VLFEAT;
+};
+
+/**
+ * @brief An image to describe and the files to export.
+ */
+struct FeatureExtractorJob
+{
+  struct Output
+  {
+    /// index of the describer in the FeatureExtractor describers list
+    std::size_t describerIndex;
+    std::string featFilename;
+    std::string descFilename;
+  };
+
+  IndexT viewId = UndefinedIndexT;
+  std::string imagePath;
+  /// image size, read from the image metadata if unknown (0)
+  std::size_t width = 0;
+  std::size_t height = 0;
+  std::vector<Output> outputs;
+};
+
+/**
+ * @brief FeatureExtractor parameters.
+ */
+struct FeatureExtractorParams
+{
+  /// number of threads reading images
+  std::size_t nbDecodeThreads = 1;
+  /// number of threads computing features (0 for automatic mode)
+  std::size_t nbDescribeThreads = 0;
+  /// number of threads writing features and descriptors files
+  std::size_t nbWriteThreads = 1;
+  /// maximum number of decoded images waiting for description
+  std::size_t prefetchSize = 2;
+  /// maximum memory used by decoded images and scale spaces in bytes (0 for available memory)
+  std::size_t memoryBudget = 0;
+};
+
+/**
+ * @brief Timings of a FeatureExtractor stage.
+ */
+struct FeatureExtractorStageStats
+{
+  std::string name;
+  std::size_t nbThreads = 0;
+  std::size_t nbImages = 0;
+  /// time spent working by all the threads of the stage in seconds
+  double busyTime = 0.0;
+
+  /**
+   * @brief Get the number of images per second the stage can process.
+   * @return images/second
+   */
+  double throughput() const
+  {
+    return (busyTime > 0.0) ? nbImages * nbThreads / busyTime : 0.0;
+  }
+};
+
+/**
+ * @brief FeatureExtractor timings.
+ */
+struct FeatureExtractorStats
+{
+  FeatureExtractorStageStats decode;
+  FeatureExtractorStageStats describe;
+  FeatureExtractorStageStats write;
+  std::size_t nbFailures = 0;
+  /// maximum memory budget used by concurrent jobs in bytes
+  std::size_t peakMemory = 0;
+  /// elapsed time in seconds
+  double totalTime = 0.0;
+};
+
+std::ostream& operator<<(std::ostream& os, const FeatureExtractorStats& stats);
+
+/**
+ * @brief In-process multithreaded feature extraction pipeline.
+ *
+ * Images go through 3 stages connected by queues:
+ * - decode: read the images, bounded by the prefetch size,
+ * - describe: detect and describe regions with one ImageDescriber instance per thread,
+ * - write: export the .feat and .desc files asynchronously.
+ *
+ * The number of images in flight is limited by a memory budget: the decoded images
+ * and the estimated describers working memory should fit into it.
+ */
+class FeatureExtractor
+{
+public:
+
+  /**
+   * @brief FeatureExtractor constructor
+   * @param[in] describers The image describers configurations
+   * @param[in] params The pipeline parameters
+   */
+  FeatureExtractor(const std::vector<FeatureExtractorDescriber>& describers,
+                   const FeatureExtractorParams& params = FeatureExtractorParams());
+
+  /**
+   * @brief Run the pipeline on the given jobs.
+   * @param[in] jobs The images to describe
+   * @return true if all the jobs succeed
+   */
+  bool process(const std::vector<FeatureExtractorJob>& jobs);
+
+  /**
+   * @brief Get the timings of the last process call.
+   * @return FeatureExtractorStats
+   */
+  const FeatureExtractorStats& getStats() const
+  {
+    return _stats;
+  }
+
+private:
+
+  /**
+   * @brief Estimate the memory needed to describe an image with all its outputs.
+   * @param[in] job The image job
+   * @param[in] width The image width
+   * @param[in] height The image height
+   * @param[in] describers The image describers
+   * @return memory in bytes
+   */
+  std::size_t jobMemoryConsumption(const FeatureExtractorJob& job,
+                                   std::size_t width,
+                                   std::size_t height,
+                                   const std::vector<std::unique_ptr<ImageDescriber>>& describers) const;
+
+  /// create an ImageDescriber for each configuration
+  std::vector<std::unique_ptr<ImageDescriber>> createDescribers() const;
+
+  std::vector<FeatureExtractorDescriber> _describers;
+  FeatureExtractorParams _params;
+  FeatureExtractorStats _stats;
+};
+
+} // namespace feature
+} // namespace aliceVision
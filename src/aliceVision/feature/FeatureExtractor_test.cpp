@@ -0,0 +1,183 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/feature/FeatureExtractor.hpp"
+#include "aliceVision/image/io.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE FeatureExtractor
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::feature;
+
+namespace fs = boost::filesystem;
+
+static const std::string outputFolder = "FeatureExtractor_test";
+
+/**
+ * @brief Write a textured image: random squares over a noisy background,
+ * different for each view.
+ */
+std::string writeTestImage(IndexT viewId)
+{
+  const int width = 160 + 16 * viewId;
+  const int height = 120 + 8 * viewId;
+  std::mt19937 generator(viewId);
+  std::uniform_int_distribution<int> noise(0, 20);
+  std::uniform_int_distribution<int> gray(40, 255);
+
+  image::Image<unsigned char> image(width, height);
+  for(int y = 0; y < height; ++y)
+    for(int x = 0; x < width; ++x)
+      image(y, x) = noise(generator);
+
+  std::uniform_int_distribution<int> positionX(0, width - 20);
+  std::uniform_int_distribution<int> positionY(0, height - 20);
+  std::uniform_int_distribution<int> size(6, 20);
+  for(int i = 0; i < 30; ++i)
+  {
+    const int x0 = positionX(generator);
+    const int y0 = positionY(generator);
+    const int s = size(generator);
+    const unsigned char value = gray(generator);
+    for(int y = y0; y < y0 + s; ++y)
+      for(int x = x0; x < x0 + s; ++x)
+        image(y, x) = value;
+  }
+
+  const std::string imagePath = (fs::path(outputFolder) / (std::to_string(viewId) + ".png")).string();
+  image::writeImage(imagePath, image);
+  return imagePath;
+}
+
+std::vector<FeatureExtractorDescriber> getDescribers()
+{
+  FeatureExtractorDescriber describer;
+  describer.type = EImageDescriberType::SIFT;
+  return {describer};
+}
+
+FeatureExtractorJob createJob(IndexT viewId, const std::string& imagePath, const std::string& folder)
+{
+  FeatureExtractorJob job;
+  job.viewId = viewId;
+  job.imagePath = imagePath;
+  const std::string basename = (fs::path(folder) / (std::to_string(viewId) + ".sift")).string();
+  job.outputs.push_back({0, basename + ".feat", basename + ".desc"});
+  return job;
+}
+
+/**
+ * @brief Check the files of a job against the features extracted directly from its image.
+ */
+void checkJobOutput(const FeatureExtractorJob& job)
+{
+  std::unique_ptr<ImageDescriber> describer = createImageDescriber(EImageDescriberType::SIFT);
+
+  // same image conversion as the FeatureExtractor describe stage
+  image::Image<float> imageFloat;
+  image::readImage(job.imagePath, imageFloat);
+  std::unique_ptr<Regions> expectedRegions;
+  if(describer->useFloatImage())
+  {
+    describer->Describe(imageFloat, expectedRegions);
+  }
+  else
+  {
+    image::Image<unsigned char> imageUChar;
+    imageUChar = imageFloat.GetMat().cast<unsigned char>() * 255;
+    describer->Describe(imageUChar, expectedRegions);
+  }
+
+  std::unique_ptr<Regions> regions;
+  describer->Allocate(regions);
+  describer->Load(regions.get(), job.outputs.front().featFilename, job.outputs.front().descFilename);
+
+  BOOST_REQUIRE_EQUAL(regions->RegionCount(), expectedRegions->RegionCount());
+  for(std::size_t i = 0; i < regions->RegionCount(); ++i)
+    BOOST_CHECK_SMALL((regions->GetRegionPosition(i) - expectedRegions->GetRegionPosition(i)).norm(), 1e-3);
+}
+
+BOOST_AUTO_TEST_CASE(FeatureExtractor_outputsOrder)
+{
+  fs::remove_all(outputFolder);
+  fs::create_directory(outputFolder);
+
+  const std::size_t nbViews = 8;
+  std::vector<FeatureExtractorJob> jobs;
+  for(IndexT viewId = 0; viewId < nbViews; ++viewId)
+    jobs.push_back(createJob(viewId, writeTestImage(viewId), outputFolder));
+
+  FeatureExtractorParams parallelParams;
+  parallelParams.nbDecodeThreads = 2;
+  parallelParams.nbDescribeThreads = 3;
+  parallelParams.nbWriteThreads = 2;
+  parallelParams.prefetchSize = 1;
+
+  // a budget smaller than one image: the jobs run one at a time
+  FeatureExtractorParams sequentialParams = parallelParams;
+  sequentialParams.memoryBudget = 1;
+
+  for(const FeatureExtractorParams& params : {parallelParams, sequentialParams})
+  {
+    for(const FeatureExtractorJob& job : jobs)
+      fs::remove(job.outputs.front().featFilename);
+
+    FeatureExtractor extractor(getDescribers(), params);
+    BOOST_CHECK(extractor.process(jobs));
+
+    const FeatureExtractorStats& stats = extractor.getStats();
+    BOOST_CHECK_EQUAL(stats.nbFailures, 0);
+    BOOST_CHECK_EQUAL(stats.decode.nbImages, nbViews);
+    BOOST_CHECK_EQUAL(stats.describe.nbImages, nbViews);
+    BOOST_CHECK_EQUAL(stats.write.nbImages, nbViews);
+    BOOST_CHECK_GT(stats.peakMemory, 0);
+    if(params.memoryBudget != 0)
+      BOOST_CHECK_LE(stats.peakMemory, params.memoryBudget);
+
+    // whatever the threads completion order, each file holds the features of its own image
+    for(const FeatureExtractorJob& job : jobs)
+      checkJobOutput(job);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(FeatureExtractor_errors)
+{
+  fs::remove_all(outputFolder);
+  fs::create_directory(outputFolder);
+
+  std::vector<FeatureExtractorJob> jobs;
+  for(IndexT viewId = 0; viewId < 4; ++viewId)
+    jobs.push_back(createJob(viewId, writeTestImage(viewId), outputFolder));
+
+  // the image cannot be read
+  jobs.push_back(createJob(10, (fs::path(outputFolder) / "missing.png").string(), outputFolder));
+  // the features cannot be written
+  jobs.push_back(createJob(11, jobs.front().imagePath, (fs::path(outputFolder) / "missing").string()));
+
+  FeatureExtractorParams params;
+  params.nbDecodeThreads = 2;
+  params.nbDescribeThreads = 2;
+  params.nbWriteThreads = 2;
+
+  FeatureExtractor extractor(getDescribers(), params);
+  BOOST_CHECK(!extractor.process(jobs));
+
+  // the failures are counted and the other jobs are done
+  const FeatureExtractorStats& stats = extractor.getStats();
+  BOOST_CHECK_EQUAL(stats.nbFailures, 2);
+  BOOST_CHECK_EQUAL(stats.decode.nbImages, 5);
+  BOOST_CHECK_EQUAL(stats.describe.nbImages, 5);
+  BOOST_CHECK_EQUAL(stats.write.nbImages, 4);
+  for(std::size_t i = 0; i < 4; ++i)
+    checkJobOutput(jobs.at(i));
+  BOOST_CHECK(!fs::exists(jobs.back().outputs.front().featFilename));
+}
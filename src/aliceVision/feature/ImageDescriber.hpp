@@ -86,6 +86,18 @@ public:
    */
   virtual bool Set_configuration_preset(EImageDescriberPreset preset) = 0;
 
+  /**
+   * @brief Get the estimated memory consumption of the description of an image
+   * By default, assume a few float buffers of the image size.
+   * @param[in] width The image width
+   * @param[in] height The image height
+   * @return The estimated memory consumption in bytes
+   */
+  virtual std::size_t getMemoryConsumption(std::size_t width, std::size_t height) const
+  {
+    return 4 * width * height * sizeof(float);
+  }
+
   /**
    * @brief Set if yes or no imageDescriber need to use cuda implementation
    * @param[in] useCuda
@@ -105,6 +105,10 @@ public:
   // - Binary: Hamming
   virtual double SquaredDescriptorDistance(std::size_t i, const Regions *, std::size_t j) const = 0;
 
+  /// Compute the squared distances between the Inth descriptor and a list of descriptors of another Region container
+  // Same metric as SquaredDescriptorDistance, resolved once for all the requested descriptors.
+  virtual void SquaredDescriptorDistances(std::size_t i, const Regions *, const std::vector<IndexT>& indexes, std::vector<double>& out_distances) const = 0;
+
   /// Add the Inth region to another Region container
   virtual void CopyRegion(std::size_t i, Regions *) const = 0;
 
@@ -267,6 +271,23 @@ public:
     return metric(this->_vec_descs[i].getData(), regionsT->_vec_descs[j].getData(), DescriptorT::static_size);
   }
 
+  void SquaredDescriptorDistances(std::size_t i, const Regions * genericRegions, const std::vector<IndexT>& indexes, std::vector<double>& out_distances) const override
+  {
+    assert(i < this->_vec_descs.size());
+    assert(genericRegions);
+
+    const This * regionsT = dynamic_cast<const This*>(genericRegions);
+    static typename SquaredMetric<T, regionType>::Metric metric;
+    const auto& descriptor = this->_vec_descs[i];
+
+    out_distances.resize(indexes.size());
+    for(std::size_t k = 0; k < indexes.size(); ++k)
+    {
+      assert(indexes[k] < regionsT->_vec_descs.size());
+      out_distances[k] = metric(descriptor.getData(), regionsT->_vec_descs[indexes[k]].getData(), DescriptorT::static_size);
+    }
+  }
+
   /**
    * @brief Add the Inth region to another Region container
    * @param[in] i: index of the region to copy
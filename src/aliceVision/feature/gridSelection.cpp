@@ -0,0 +1,135 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "gridSelection.hpp"
+
+#include <cassert>
+#include <numeric>
+
+namespace aliceVision {
+namespace feature {
+
+namespace {
+
+/// Order the element indices by decreasing score, then by increasing index
+struct IsBetter
+{
+  explicit IsBetter(const std::vector<float>& scores)
+    : _scores(scores)
+  {}
+
+  bool operator()(std::size_t a, std::size_t b) const
+  {
+    if(_scores[a] != _scores[b])
+      return _scores[a] > _scores[b];
+    return a < b;
+  }
+
+  const std::vector<float>& _scores;
+};
+
+} // namespace
+
+void bucketByCell(const std::vector<std::size_t>& cellIndices,
+                  std::size_t nbCells,
+                  std::vector<std::size_t>& cellOffsets,
+                  std::vector<std::size_t>& sortedIndices)
+{
+  cellOffsets.assign(nbCells + 1, 0);
+  for(const std::size_t cell : cellIndices)
+  {
+    assert(cell < nbCells);
+    ++cellOffsets[cell + 1];
+  }
+  std::partial_sum(cellOffsets.begin(), cellOffsets.end(), cellOffsets.begin());
+
+  std::vector<std::size_t> nextPosition(cellOffsets.begin(), cellOffsets.end() - 1);
+  sortedIndices.resize(cellIndices.size());
+  for(std::size_t i = 0; i < cellIndices.size(); ++i)
+    sortedIndices[nextPosition[cellIndices[i]]++] = i;
+}
+
+void selectBest(const std::vector<float>& scores,
+                std::size_t maxNbElements,
+                std::vector<std::size_t>& selectedIndices)
+{
+  const IsBetter isBetter(scores);
+
+  selectedIndices.resize(scores.size());
+  std::iota(selectedIndices.begin(), selectedIndices.end(), 0);
+
+  if(maxNbElements > 0 && maxNbElements < selectedIndices.size())
+  {
+    std::nth_element(selectedIndices.begin(), selectedIndices.begin() + maxNbElements, selectedIndices.end(), isBetter);
+    selectedIndices.resize(maxNbElements);
+  }
+  std::sort(selectedIndices.begin(), selectedIndices.end(), isBetter);
+}
+
+void gridSelection(const std::vector<std::size_t>& cellIndices,
+                   const std::vector<float>& scores,
+                   std::size_t nbCells,
+                   std::size_t maxNbElements,
+                   std::vector<std::size_t>& selectedIndices)
+{
+  assert(cellIndices.size() == scores.size());
+
+  // nothing to filter
+  if(maxNbElements == 0 || scores.size() <= maxNbElements || nbCells <= 1)
+  {
+    selectBest(scores, maxNbElements, selectedIndices);
+    return;
+  }
+
+  const IsBetter isBetter(scores);
+
+  std::vector<std::size_t> cellOffsets;
+  std::vector<std::size_t> sortedIndices;
+  bucketByCell(cellIndices, nbCells, cellOffsets, sortedIndices);
+
+  // move the best elements of each cell at the beginning of the cell
+  const std::size_t budgetPerCell = maxNbElements / nbCells;
+  std::vector<std::size_t> nbSelectedPerCell(nbCells);
+
+  #pragma omp parallel for schedule(dynamic) if(scores.size() > 10000)
+  for(int c = 0; c < static_cast<int>(nbCells); ++c)
+  {
+    const auto cellBegin = sortedIndices.begin() + cellOffsets[c];
+    const auto cellEnd = sortedIndices.begin() + cellOffsets[c + 1];
+    const std::size_t cellSize = cellOffsets[c + 1] - cellOffsets[c];
+
+    if(cellSize > budgetPerCell)
+      std::nth_element(cellBegin, cellBegin + budgetPerCell, cellEnd, isBetter);
+    nbSelectedPerCell[c] = std::min(cellSize, budgetPerCell);
+  }
+
+  selectedIndices.clear();
+  selectedIndices.reserve(maxNbElements);
+  std::vector<std::size_t> rejectedIndices;
+  rejectedIndices.reserve(scores.size());
+
+  for(std::size_t c = 0; c < nbCells; ++c)
+  {
+    const auto cellBegin = sortedIndices.begin() + cellOffsets[c];
+    const auto cellEnd = sortedIndices.begin() + cellOffsets[c + 1];
+    selectedIndices.insert(selectedIndices.end(), cellBegin, cellBegin + nbSelectedPerCell[c]);
+    rejectedIndices.insert(rejectedIndices.end(), cellBegin + nbSelectedPerCell[c], cellEnd);
+  }
+
+  // if some cells do not have enough elements (empty regions of the grid for example),
+  // add the best other ones, without repartition constraint
+  const std::size_t nbRemaining = std::min(rejectedIndices.size(), maxNbElements - selectedIndices.size());
+  if(nbRemaining > 0)
+  {
+    if(nbRemaining < rejectedIndices.size())
+      std::nth_element(rejectedIndices.begin(), rejectedIndices.begin() + nbRemaining, rejectedIndices.end(), isBetter);
+    selectedIndices.insert(selectedIndices.end(), rejectedIndices.begin(), rejectedIndices.begin() + nbRemaining);
+  }
+
+  std::sort(selectedIndices.begin(), selectedIndices.end(), isBetter);
+}
+
+} // namespace feature
+} // namespace aliceVision
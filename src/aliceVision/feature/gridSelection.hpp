@@ -0,0 +1,80 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief Get the index of the cell of a regular gridSize x gridSize grid containing a 2D point.
+ * The points outside of the image are assigned to the nearest border cell.
+ * @param[in] x The point abscissa
+ * @param[in] y The point ordinate
+ * @param[in] cellWidth The width of a cell
+ * @param[in] cellHeight The height of a cell
+ * @param[in] gridSize The number of cells per row and per column
+ * @return the cell index (row major)
+ */
+inline std::size_t getGridCellIndex(double x, double y, double cellWidth, double cellHeight, std::size_t gridSize)
+{
+  const double cellX = std::min(std::max(x / cellWidth, 0.0), double(gridSize - 1));
+  const double cellY = std::min(std::max(y / cellHeight, 0.0), double(gridSize - 1));
+  return std::size_t(cellY) * gridSize + std::size_t(cellX);
+}
+
+/**
+ * @brief Partition elements into cells with a counting sort, in O(N + nbCells).
+ * The elements of a cell keep their input order.
+ * @param[in] cellIndices The cell of each element
+ * @param[in] nbCells The number of cells
+ * @param[out] cellOffsets The nbCells + 1 offsets of the cells in sortedIndices:
+ *             the elements of the cell c are in [cellOffsets[c], cellOffsets[c + 1])
+ * @param[out] sortedIndices The element indices ordered by cell
+ */
+void bucketByCell(const std::vector<std::size_t>& cellIndices,
+                  std::size_t nbCells,
+                  std::vector<std::size_t>& cellOffsets,
+                  std::vector<std::size_t>& sortedIndices);
+
+/**
+ * @brief Select the indices of the elements with the highest scores.
+ * The top-K is selected with nth_element, only the selected elements are sorted,
+ * so the cost is O(N + K log K). Equal scores are ordered by index (as a stable sort).
+ * @param[in] scores The score of each element
+ * @param[in] maxNbElements The maximum number of elements to select (0 to select all of them)
+ * @param[out] selectedIndices The selected indices, by decreasing score
+ */
+void selectBest(const std::vector<float>& scores,
+                std::size_t maxNbElements,
+                std::vector<std::size_t>& selectedIndices);
+
+/**
+ * @brief Select the indices of the elements with the highest scores with a uniform budget per cell.
+ *
+ * The elements are partitioned into cells with a counting sort and each cell keeps
+ * its maxNbElements / nbCells best elements (nth_element, in parallel across cells).
+ * The budget left by the cells with fewer elements is filled with the best rejected
+ * elements, regardless of their cell. The cost is O(N + K log K) for K selected elements.
+ * Equal scores are ordered by index, so the selection does not depend on the number of threads.
+ *
+ * @param[in] cellIndices The cell of each element
+ * @param[in] scores The score of each element
+ * @param[in] nbCells The number of cells
+ * @param[in] maxNbElements The maximum number of elements to select (0 to select all of them)
+ * @param[out] selectedIndices The selected indices, by decreasing score
+ */
+void gridSelection(const std::vector<std::size_t>& cellIndices,
+                   const std::vector<float>& scores,
+                   std::size_t nbCells,
+                   std::size_t maxNbElements,
+                   std::vector<std::size_t>& selectedIndices);
+
+} // namespace feature
+} // namespace aliceVision
@@ -0,0 +1,148 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/feature/gridSelection.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE gridSelection
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::feature;
+
+/**
+ * @brief Create random cells and scores, with equal scores.
+ */
+void createElements(std::size_t nbElements, std::size_t nbCells, std::vector<std::size_t>& cells, std::vector<float>& scores)
+{
+  std::mt19937 generator(0);
+  // few cells get most of the elements
+  std::uniform_int_distribution<std::size_t> cellDistribution(0, nbCells - 1);
+  std::uniform_int_distribution<int> scoreDistribution(0, 1000);
+
+  cells.resize(nbElements);
+  scores.resize(nbElements);
+  for(std::size_t i = 0; i < nbElements; ++i)
+  {
+    cells[i] = std::min(cellDistribution(generator), cellDistribution(generator));
+    scores[i] = scoreDistribution(generator) / 10.0f;
+  }
+}
+
+/**
+ * @brief Reference grid selection with a global stable sort.
+ */
+std::vector<std::size_t> referenceGridSelection(const std::vector<std::size_t>& cells, const std::vector<float>& scores, std::size_t nbCells, std::size_t maxNbElements)
+{
+  std::vector<std::size_t> sortedIndexes(scores.size());
+  std::iota(sortedIndexes.begin(), sortedIndexes.end(), 0);
+  std::stable_sort(sortedIndexes.begin(), sortedIndexes.end(), [&](std::size_t a, std::size_t b){ return scores[a] > scores[b]; });
+
+  std::vector<std::size_t> countPerCell(nbCells, 0);
+  std::vector<std::size_t> selected;
+  std::vector<std::size_t> rejected;
+  for(const std::size_t i : sortedIndexes)
+  {
+    if(countPerCell[cells[i]]++ < maxNbElements / nbCells)
+      selected.push_back(i);
+    else
+      rejected.push_back(i);
+  }
+  const std::size_t nbRemaining = std::min(rejected.size(), maxNbElements - selected.size());
+  selected.insert(selected.end(), rejected.begin(), rejected.begin() + nbRemaining);
+  std::stable_sort(selected.begin(), selected.end(), [&](std::size_t a, std::size_t b){ return scores[a] > scores[b] || (scores[a] == scores[b] && a < b); });
+  return selected;
+}
+
+BOOST_AUTO_TEST_CASE(gridSelection_cellIndex)
+{
+  // 4x4 grid over a 400x200 image
+  BOOST_CHECK_EQUAL(getGridCellIndex(0.0, 0.0, 100.0, 50.0, 4), 0);
+  BOOST_CHECK_EQUAL(getGridCellIndex(150.0, 60.0, 100.0, 50.0, 4), 5);
+  BOOST_CHECK_EQUAL(getGridCellIndex(399.0, 199.0, 100.0, 50.0, 4), 15);
+  // outside of the image
+  BOOST_CHECK_EQUAL(getGridCellIndex(-10.0, 120.0, 100.0, 50.0, 4), 8);
+  BOOST_CHECK_EQUAL(getGridCellIndex(400.0, 200.0, 100.0, 50.0, 4), 15);
+}
+
+BOOST_AUTO_TEST_CASE(gridSelection_bucketByCell)
+{
+  const std::size_t nbCells = 9;
+  std::vector<std::size_t> cells;
+  std::vector<float> scores;
+  createElements(1000, nbCells, cells, scores);
+
+  std::vector<std::size_t> cellOffsets;
+  std::vector<std::size_t> sortedIndexes;
+  bucketByCell(cells, nbCells, cellOffsets, sortedIndexes);
+
+  BOOST_CHECK_EQUAL(cellOffsets.size(), nbCells + 1);
+  BOOST_CHECK_EQUAL(cellOffsets.back(), cells.size());
+  BOOST_CHECK_EQUAL(sortedIndexes.size(), cells.size());
+
+  for(std::size_t c = 0; c < nbCells; ++c)
+  {
+    for(std::size_t k = cellOffsets[c]; k < cellOffsets[c + 1]; ++k)
+    {
+      BOOST_CHECK_EQUAL(cells[sortedIndexes[k]], c);
+      // input order within a cell
+      if(k > cellOffsets[c])
+        BOOST_CHECK_LT(sortedIndexes[k - 1], sortedIndexes[k]);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(gridSelection_selectBest)
+{
+  std::vector<std::size_t> cells;
+  std::vector<float> scores;
+  createElements(5000, 1, cells, scores);
+
+  std::vector<std::size_t> expected(scores.size());
+  std::iota(expected.begin(), expected.end(), 0);
+  std::stable_sort(expected.begin(), expected.end(), [&](std::size_t a, std::size_t b){ return scores[a] > scores[b]; });
+
+  std::vector<std::size_t> selected;
+  selectBest(scores, 0, selected);
+  BOOST_CHECK(selected == expected);
+
+  selectBest(scores, 100, selected);
+  expected.resize(100);
+  BOOST_CHECK(selected == expected);
+}
+
+BOOST_AUTO_TEST_CASE(gridSelection_uniformBudget)
+{
+  const std::size_t nbCells = 16;
+  std::vector<std::size_t> cells;
+  std::vector<float> scores;
+  // enough elements to select the cells in parallel
+  createElements(50000, nbCells, cells, scores);
+
+  for(const std::size_t maxNbElements : {10, 1000, 6000, 49999, 50000})
+  {
+    const std::vector<std::size_t> expected = referenceGridSelection(cells, scores, nbCells, maxNbElements);
+
+    std::vector<std::size_t> selected;
+    gridSelection(cells, scores, nbCells, maxNbElements, selected);
+    BOOST_CHECK_EQUAL(selected.size(), std::min(maxNbElements, scores.size()));
+    BOOST_CHECK(selected == expected);
+  }
+
+  // the selection does not depend on the number of threads
+  const int nbThreads = omp_get_max_threads();
+  std::vector<std::size_t> selectedParallel;
+  gridSelection(cells, scores, nbCells, 1000, selectedParallel);
+  omp_set_num_threads(1);
+  std::vector<std::size_t> selectedSequential;
+  gridSelection(cells, scores, nbCells, 1000, selectedSequential);
+  omp_set_num_threads(nbThreads);
+  BOOST_CHECK(selectedParallel == selectedSequential);
+}
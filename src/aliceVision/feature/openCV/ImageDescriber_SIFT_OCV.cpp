@@ -5,6 +5,7 @@
 
 #include "ImageDescriber_SIFT_OCV.hpp"
 
+#include <aliceVision/feature/gridSelection.hpp>
 #include <aliceVision/image/all.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/system/Logger.hpp>
@@ -81,57 +82,39 @@ bool ImageDescriber_SIFT_openCV::Describe(const image::Image<unsigned char>& ima
   ALICEVISION_LOG_TRACE("Grid size: " << _params.gridSize << ", maxTotalKeypoints: " << _params.maxTotalKeypoints << std::endl);
   ALICEVISION_LOG_TRACE("Number of detected features: " << v_keypoints.size() << std::endl);
 
-  // cv::KeyPoint::response: the response by which the most strong keypoints have been selected.
-  // Can be used for the further sorting or subsampling.
-  std::sort(v_keypoints.begin(), v_keypoints.end(), [](const cv::KeyPoint& a, const cv::KeyPoint& b) { return a.size > b.size; });
-
-  // Grid filtering of the keypoints to ensure a global repartition
-  if(_params.gridSize && _params.maxTotalKeypoints)
+  // Sort the keypoints by decreasing size and apply the grid filtering of the keypoints to ensure a global repartition.
+  // Only the kept keypoints are sorted (see gridSelection).
   {
-    // Only filter features if we have more features than the maxTotalKeypoints
-    if(v_keypoints.size() > _params.maxTotalKeypoints)
-    {
-      std::vector< cv::KeyPoint > filtered_keypoints;
-      std::vector< cv::KeyPoint > rejected_keypoints;
-      filtered_keypoints.reserve(std::min(v_keypoints.size(), _params.maxTotalKeypoints));
-      rejected_keypoints.reserve(v_keypoints.size());
+    std::vector<float> sizes(v_keypoints.size());
+    for(std::size_t i = 0; i < v_keypoints.size(); ++i)
+      sizes[i] = v_keypoints[i].size;
 
-      cv::Mat countFeatPerCell(_params.gridSize, _params.gridSize, cv::DataType<std::size_t>::type, cv::Scalar(0));
-      const std::size_t keypointsPerCell = _params.maxTotalKeypoints / countFeatPerCell.total();
-      const double regionWidth = image.Width() / double(countFeatPerCell.cols);
-      const double regionHeight = image.Height() / double(countFeatPerCell.rows);
+    std::vector<std::size_t> selectedIndexes;
+    if(_params.gridSize && _params.maxTotalKeypoints)
+    {
+      const double regionWidth = image.Width() / double(_params.gridSize);
+      const double regionHeight = image.Height() / double(_params.gridSize);
 
-      ALICEVISION_LOG_TRACE ("Grid filtering -- keypointsPerCell: " << keypointsPerCell
+      ALICEVISION_LOG_TRACE("Grid filtering -- keypointsPerCell: " << _params.maxTotalKeypoints / (_params.gridSize * _params.gridSize)
                         << ", regionWidth: " << regionWidth
                         << ", regionHeight: " << regionHeight << std::endl);
 
-      for(const cv::KeyPoint& keypoint: v_keypoints)
-      {
-        const std::size_t cellX = std::min(std::size_t(keypoint.pt.x / regionWidth), _params.gridSize);
-        const std::size_t cellY = std::min(std::size_t(keypoint.pt.y / regionHeight), _params.gridSize);
-        // std::cout << "- keypoint.pt.x: " << keypoint.pt.x << ", keypoint.pt.y: " << keypoint.pt.y << std::endl;
-        // std::cout << "- cellX: " << cellX << ", cellY: " << cellY << std::endl;
-        // std::cout << "- countFeatPerCell: " << countFeatPerCell << std::endl;
-        // std::cout << "- gridSize: " << _params.gridSize << std::endl;
-
-        const std::size_t count = countFeatPerCell.at<std::size_t>(cellX, cellY);
-        countFeatPerCell.at<std::size_t>(cellX, cellY) = count + 1;
-        if(count < keypointsPerCell)
-          filtered_keypoints.push_back(keypoint);
-        else
-          rejected_keypoints.push_back(keypoint);
-      }
-      // If we don't have enough features (less than maxTotalKeypoints) after the grid filtering (empty regions in the grid for example).
-      // We add the best other ones, without repartition constraint.
-      if( filtered_keypoints.size() < _params.maxTotalKeypoints )
-      {
-        const std::size_t remainingElements = std::min(rejected_keypoints.size(), _params.maxTotalKeypoints - filtered_keypoints.size());
-        ALICEVISION_LOG_TRACE("Grid filtering -- Copy remaining points: " << remainingElements << std::endl);
-        filtered_keypoints.insert(filtered_keypoints.end(), rejected_keypoints.begin(), rejected_keypoints.begin() + remainingElements);
-      }
-
-      v_keypoints.swap(filtered_keypoints);
+      std::vector<std::size_t> cellIndexes(v_keypoints.size());
+      for(std::size_t i = 0; i < v_keypoints.size(); ++i)
+        cellIndexes[i] = getGridCellIndex(v_keypoints[i].pt.x, v_keypoints[i].pt.y, regionWidth, regionHeight, _params.gridSize);
+
+      gridSelection(cellIndexes, sizes, _params.gridSize * _params.gridSize, _params.maxTotalKeypoints, selectedIndexes);
     }
+    else
+    {
+      selectBest(sizes, 0, selectedIndexes);
+    }
+
+    std::vector<cv::KeyPoint> selectedKeypoints;
+    selectedKeypoints.reserve(selectedIndexes.size());
+    for(const std::size_t i : selectedIndexes)
+      selectedKeypoints.push_back(v_keypoints[i]);
+    v_keypoints.swap(selectedKeypoints);
   }
   ALICEVISION_LOG_TRACE("Number of features: " << v_keypoints.size() << std::endl);
 
@@ -5,63 +5,56 @@
 
 #include "selection.hpp"
 
+#include <aliceVision/feature/gridSelection.hpp>
 #include <aliceVision/numeric/numeric.hpp>
 
+#include <algorithm>
+
 namespace aliceVision {
 namespace feature {
 
 const size_t gridSize = 3;
   
 /**
-* @brief Sort the matches.
+* @brief Sort the matches by decreasing mean scale of their features.
 * @param[in] inputMatches Set of indices for (putative) matches.
 * @param[in] regionsI Reference to the regions of the left image.
 * @param[in] regionsJ Reference to the regions of the right image.
 * @param[out] outputMatches Subset of inputMatches containing the best n matches, sorted.
+* @param[in] maxNbMatches The maximum number of matches to keep (0 to keep all of them).
 */
 void sortMatches(
 	const aliceVision::matching::IndMatches& inputMatches,
 	const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& regionsI,
 	const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& regionsJ,
-	aliceVision::matching::IndMatches& outputMatches)
+	aliceVision::matching::IndMatches& outputMatches,
+	std::size_t maxNbMatches)
 {
 	const std::vector<aliceVision::feature::SIOPointFeature>& vecFeatureI = regionsI.Features();
 	const std::vector<aliceVision::feature::SIOPointFeature>& vecFeatureJ = regionsJ.Features();
 
-	//outputMatches will contain the sorted matches if inputMatches.
-	outputMatches.reserve(inputMatches.size());
-
-	//This vector is just a temporary container to link the index of the matches in the original vector inputMatches.
-	//It will be used to retrieve the correct matches after the sort.
-	std::vector<std::pair<float, size_t>> vecFeatureScale;
-
+	//Mean scale of the features of each match, indexed as inputMatches.
+	std::vector<float> matchScales(inputMatches.size());
 	for (size_t i = 0; i < inputMatches.size(); i++)
   {
-		float scale1 = vecFeatureI[inputMatches[i]._i].scale();
-		float scale2 = vecFeatureJ[inputMatches[i]._j].scale();
-		vecFeatureScale.emplace_back((scale1 + scale2) / 2.0, i);
+		const float scale1 = vecFeatureI[inputMatches[i]._i].scale();
+		const float scale2 = vecFeatureJ[inputMatches[i]._j].scale();
+		matchScales[i] = (scale1 + scale2) / 2.0f;
 	}
 
-	std::sort(vecFeatureScale.begin(), vecFeatureScale.end(), matchCompare);
+	//Only the kept matches are sorted, equal scales keep the input order.
+	std::vector<std::size_t> sortedIndexes;
+	selectBest(matchScales, maxNbMatches, sortedIndexes);
 
-	//The sorted match vector is filled according to the result of the sorting above.
-	for (size_t i = 0; i < vecFeatureScale.size(); i++)
+	//outputMatches will contain the sorted matches of inputMatches.
+	outputMatches.clear();
+	outputMatches.reserve(sortedIndexes.size());
+	for (const std::size_t i : sortedIndexes)
   {
-		outputMatches.push_back(inputMatches[vecFeatureScale[i].second]);
+		outputMatches.push_back(inputMatches[i]);
 	}
 }
 
-/**
-* @brief Compare method used in the match sorting.
-* @param[in] firstElem The first element to be compared.
-* @param[in] secondElem The second element to be compared.
-* @return True if firstElem is less than secondElem.
-*/
-bool matchCompare(const std::pair<float, size_t>& firstElem, const std::pair<float, size_t>& secondElem)
-{
-	return firstElem.first > secondElem.first;
-}
-
 /**
 * @brief Extracts by copy the first (and best) uNumMatchesToKeep.
 * @param[out] outputMatches Set of image pairs and their respective sets of matches thresholded to the first uNumMatchesToKeep.
@@ -80,80 +73,64 @@ void thresholdMatches(aliceVision::matching::IndMatches& outputMatches, const st
  * @param[in] rRegions The regions of the second picture
  * @param[in] indexImagePair The Pair of matched images
  * @param[in] sfm_data The sfm data file
- * @param[out] outMatches The remaining matches
+ * @param[in,out] outMatches The matches sorted by decreasing scale, reordered
  */
 void matchesGridFiltering(const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& lRegions, 
         const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& rRegions, 
         const aliceVision::Pair& indexImagePair,
-        const aliceVision::sfm::SfMData sfm_data, 
+        const aliceVision::sfm::SfMData& sfm_data, 
         aliceVision::matching::IndMatches& outMatches)
 {
-  const std::size_t lWidth = sfm_data.GetViews().at(indexImagePair.first)->getWidth();
-  const std::size_t lHeight = sfm_data.GetViews().at(indexImagePair.first)->getHeight();
-  const std::size_t rWidth = sfm_data.GetViews().at(indexImagePair.second)->getWidth();
-  const std::size_t rHeight = sfm_data.GetViews().at(indexImagePair.second)->getHeight();
-  
-  const size_t leftCellHeight = std::ceil(lHeight / (float)gridSize);
-  const size_t leftCellWidth = std::ceil(lWidth / (float)gridSize);
-  const size_t rightCellHeight = std::ceil(rHeight / (float)gridSize);
-  const size_t rightCellWidth = std::ceil(rWidth / (float)gridSize);
-
-  std::vector< aliceVision::matching::IndMatches > completeGrid(gridSize*gridSize*2);
-  // Reserve all cells
-  for(aliceVision::matching::IndMatches& cell: completeGrid)
-  {
-    cell.reserve(outMatches.size()/completeGrid.size());
-  }
-  // Split matches in grid cells
-  for(const auto& match: outMatches)
-  {
-    const aliceVision::feature::SIOPointFeature& leftPoint = lRegions.Features()[match._i];
-    const aliceVision::feature::SIOPointFeature& rightPoint = rRegions.Features()[match._j];
-    
-    const float leftGridIndex_f = std::floor(leftPoint.x() / (float)leftCellWidth) + std::floor(leftPoint.y() / (float)leftCellHeight) * gridSize;
-    const float rightGridIndex_f = std::floor(rightPoint.x() / (float)rightCellWidth) + std::floor(rightPoint.y() / (float)rightCellHeight) * gridSize;
-    // clamp the values if we have feature/marker centers outside the image size.
-    const std::size_t leftGridIndex = clamp(leftGridIndex_f, 0.f, float(gridSize-1));
-    const std::size_t rightGridIndex = clamp(rightGridIndex_f, 0.f, float(gridSize-1));
-
-    aliceVision::matching::IndMatches& currentCaseL = completeGrid[leftGridIndex];
-    aliceVision::matching::IndMatches& currentCaseR = completeGrid[rightGridIndex + gridSize*gridSize];
-    
-    if(currentCaseL.size() <= currentCaseR.size())
-    {
-      currentCaseL.push_back(match);
-    }
-    else
-    {
-      currentCaseR.push_back(match);
-    }
-  }
-  
-  // max Size of the cells:
-  int maxSize = 0;
-  for (const auto& cell: completeGrid)
+  const aliceVision::sfm::View& lView = *sfm_data.GetViews().at(indexImagePair.first);
+  const aliceVision::sfm::View& rView = *sfm_data.GetViews().at(indexImagePair.second);
+
+  const double leftCellWidth = lView.getWidth() / double(gridSize);
+  const double leftCellHeight = lView.getHeight() / double(gridSize);
+  const double rightCellWidth = rView.getWidth() / double(gridSize);
+  const double rightCellHeight = rView.getHeight() / double(gridSize);
+
+  // the cells of the left picture, then the cells of the right picture
+  const std::size_t nbCellsPerImage = gridSize * gridSize;
+  std::vector<std::size_t> cellSizes(2 * nbCellsPerImage, 0);
+  std::vector<std::size_t> matchCells(outMatches.size());
+
+  // Split matches in grid cells: each match goes to the least filled of its left and right cells
+  for(std::size_t i = 0; i < outMatches.size(); ++i)
   {
-    if(cell.size() > maxSize)
-    {
-      maxSize = cell.size();
-    }
+    const aliceVision::feature::SIOPointFeature& leftPoint = lRegions.Features()[outMatches[i]._i];
+    const aliceVision::feature::SIOPointFeature& rightPoint = rRegions.Features()[outMatches[i]._j];
+
+    // feature/marker centers outside the image size are assigned to the border cells
+    const std::size_t leftGridIndex = getGridCellIndex(leftPoint.x(), leftPoint.y(), leftCellWidth, leftCellHeight, gridSize);
+    const std::size_t rightGridIndex = nbCellsPerImage + getGridCellIndex(rightPoint.x(), rightPoint.y(), rightCellWidth, rightCellHeight, gridSize);
+
+    const std::size_t gridIndex = (cellSizes[leftGridIndex] <= cellSizes[rightGridIndex]) ? leftGridIndex : rightGridIndex;
+    ++cellSizes[gridIndex];
+    matchCells[i] = gridIndex;
   }
-  
+
+  // Counting sort of the matches by cell, the matches of a cell stay sorted by scale
+  std::vector<std::size_t> cellOffsets;
+  std::vector<std::size_t> sortedIndexes;
+  bucketByCell(matchCells, cellSizes.size(), cellOffsets, sortedIndexes);
+
+  const std::size_t maxSize = *std::max_element(cellSizes.begin(), cellSizes.end());
+
   aliceVision::matching::IndMatches finalMatches;
   finalMatches.reserve(outMatches.size());
-  
+
   // Combine all cells into a global ordered vector
-  for (int cmpt = 0; cmpt < maxSize; ++cmpt)
+  for(std::size_t cmpt = 0; cmpt < maxSize; ++cmpt)
   {
-    for(const auto& cell: completeGrid)
+    for(std::size_t cell = 0; cell < cellSizes.size(); ++cell)
     {
-      if(cmpt < cell.size())
+      if(cmpt < cellSizes[cell])
       {
-        finalMatches.push_back(cell[cmpt]);
+        finalMatches.push_back(outMatches[sortedIndexes[cellOffsets[cell] + cmpt]]);
       }
     }
   }
-  
+
   outMatches.swap(finalMatches);
 }
 
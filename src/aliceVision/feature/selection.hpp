@@ -19,26 +19,20 @@ namespace aliceVision {
 namespace feature {
 
 /**
-* @brief Compute the n best matches.
+* @brief Sort the matches by decreasing mean scale of their features.
 * @param[in] inputMatches Set of indices for (putative) matches.
 * @param[in] regionsI Reference to the regions of the left image.
 * @param[in] regionsJ Reference to the regions of the right image.
 * @param[out] outputMatches Subset of inputMatches containing the best n matches, sorted.
+* @param[in] maxNbMatches The maximum number of matches to keep (0 to keep all of them),
+*            only the kept matches are sorted.
 */
 void sortMatches(
 	const aliceVision::matching::IndMatches& inputMatches,
 	const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& regionsI,
 	const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& regionsJ,
-	aliceVision::matching::IndMatches& outputMatches);
-
-
-/**
-* @brief Compare method used in the match sorting.
-* @param[in] firstElem The first element to be compared.
-* @param[in] secondElem The second element to be compared.
-* @return True if firstElem is less than secondElem.
-*/
-bool matchCompare(const std::pair<float, size_t>& firstElem, const std::pair<float, size_t>& secondElem);
+	aliceVision::matching::IndMatches& outputMatches,
+	std::size_t maxNbMatches = 0);
 
 /**
 * @brief Extracts by copy the first (and best) uNumMatchesToKeep.
@@ -48,17 +42,18 @@ bool matchCompare(const std::pair<float, size_t>& firstElem, const std::pair<flo
 void thresholdMatches(aliceVision::matching::IndMatches& outputMatches, const std::size_t uNumMatchesToKeep);
 
 /**
- * @brief Perform the gris filtering on the matches
+ * @brief Perform the grid filtering on the matches: reorder the matches to alternate between
+ * the cells of a grid on both pictures, so the first matches have a global repartition.
  * @param[in] lRegions The regions of the first picture
  * @param[in] rRegions The regions of the second picture
  * @param[in] indexImagePair The Pair of matched images
  * @param[in] sfm_data The sfm data file
- * @param[out] outMatches The remaining matches
+ * @param[in,out] outMatches The matches sorted by decreasing scale, reordered
  */
 void matchesGridFiltering(const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& lRegions, 
         const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& rRegions, 
         const aliceVision::Pair& indexImagePair,
-        const aliceVision::sfm::SfMData sfm_data, 
+        const aliceVision::sfm::SfMData& sfm_data, 
         aliceVision::matching::IndMatches& outMatches);
 
 }
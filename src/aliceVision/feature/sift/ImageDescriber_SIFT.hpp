@@ -6,6 +6,7 @@
 #pragma once
 
 #include <aliceVision/config.hpp>
+#include <aliceVision/feature/sift/ImageDescriber_SIFT_native.hpp>
 #include <aliceVision/feature/sift/ImageDescriber_SIFT_vlfeat.hpp>
 
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_POPSIFT)
@@ -44,6 +45,17 @@ public:
     return _imageDescriberImpl->getDescriberType();
   }
 
+  /**
+   * @brief Get the estimated memory consumption of the description of an image
+   * @param[in] width The image width
+   * @param[in] height The image height
+   * @return The estimated memory consumption in bytes
+   */
+  std::size_t getMemoryConsumption(std::size_t width, std::size_t height) const override
+  {
+    return _imageDescriberImpl->getMemoryConsumption(width, height);
+  }
+
   /**
    * @brief Use a preset to control the number of detected regions
    * @param[in] preset The preset configuration
@@ -80,7 +92,20 @@ public:
     }
 #endif
 
-    _imageDescriberImpl.reset(new ImageDescriber_SIFT_vlfeat(_params, _isOriented));
+    if(_params._engine == ESiftEngine::NATIVE)
+      _imageDescriberImpl.reset(new ImageDescriber_SIFT_native(_params, _isOriented));
+    else
+      _imageDescriberImpl.reset(new ImageDescriber_SIFT_vlfeat(_params, _isOriented));
+  }
+
+  /**
+   * @brief Set the SIFT engine used on CPU (VLFeat by default)
+   * @param[in] engine
+   */
+  void setSiftEngine(ESiftEngine engine)
+  {
+    _params._engine = engine;
+    setUseCuda(_useCuda);
   }
 
   void setCudaPipe(int pipe) override
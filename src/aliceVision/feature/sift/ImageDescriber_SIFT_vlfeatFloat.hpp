@@ -32,12 +32,12 @@ public:
     , _isOriented(isOriented)
   {
     // Configure VLFeat
-    vl_constructor();
+    vlfeatAcquire();
   }
 
   ~ImageDescriber_SIFT_vlfeatFloat()
   {
-    vl_destructor();
+    vlfeatRelease();
   }
 
   /**
@@ -58,6 +58,17 @@ public:
     return EImageDescriberType::SIFT_FLOAT;
   }
   
+  /**
+   * @brief Get the estimated memory consumption of the description of an image
+   * @param[in] width The image width
+   * @param[in] height The image height
+   * @return The estimated memory consumption in bytes
+   */
+  std::size_t getMemoryConsumption(std::size_t width, std::size_t height) const override
+  {
+    return getSiftMemoryConsumption(width, height, _params);
+  }
+
   /**
    * @brief Use a preset to control the number of detected regions
    * @param[in] preset The preset configuration
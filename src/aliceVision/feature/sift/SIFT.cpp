@@ -0,0 +1,62 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "SIFT.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <mutex>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace feature {
+
+namespace {
+
+std::mutex vlfeatMutex;
+std::size_t vlfeatUsers = 0;
+
+} // namespace
+
+ESiftEngine ESiftEngine_stringToEnum(const std::string& engine)
+{
+  std::string type = engine;
+  std::transform(type.begin(), type.end(), type.begin(), ::tolower);
+
+  if(type == "vlfeat")
+    return ESiftEngine::VLFEAT;
+  if(type == "native")
+    return ESiftEngine::NATIVE;
+  throw std::invalid_argument("Invalid SIFT engine: " + engine);
+}
+
+std::string ESiftEngine_enumToString(ESiftEngine engine)
+{
+  switch(engine)
+  {
+    case ESiftEngine::VLFEAT: return "vlfeat";
+    case ESiftEngine::NATIVE: return "native";
+  }
+  throw std::out_of_range("Invalid SIFT engine enum");
+}
+
+void vlfeatAcquire()
+{
+  std::lock_guard<std::mutex> lock(vlfeatMutex);
+  if(vlfeatUsers++ == 0)
+    vl_constructor();
+}
+
+void vlfeatRelease()
+{
+  std::lock_guard<std::mutex> lock(vlfeatMutex);
+  assert(vlfeatUsers > 0);
+  if(--vlfeatUsers == 0)
+    vl_destructor();
+}
+
+} // namespace feature
+} // namespace aliceVision
@@ -7,6 +7,7 @@
 
 #include <aliceVision/feature/Descriptor.hpp>
 #include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/feature/gridSelection.hpp>
 #include <aliceVision/feature/regionsFactory.hpp>
 #include <aliceVision/config.hpp>
 
@@ -14,9 +15,15 @@ extern "C" {
 #include "nonFree/sift/vl/sift.h"
 }
 
+#include <algorithm>
+#include <cassert>
 #include <iostream>
 #include <numeric>
 #include <stdexcept>
+#include <string>
+#include <cmath>
+#include <cstddef>
+#include <vector>
 
 namespace aliceVision {
 namespace feature {
@@ -27,6 +34,31 @@ namespace feature {
  * Three things everyone should know to improve object retrieval. CVPR2012.
  */
 
+/**
+ * @brief The SIFT extraction engine used on CPU
+ */
+enum class ESiftEngine
+{
+  /// VLFeat implementation (default)
+  VLFEAT = 0,
+  /// native multithreaded implementation, close to VLFeat but not identical
+  NATIVE
+};
+
+/**
+ * @brief It returns the SIFT engine from a string.
+ * @param[in] engine the input string (vlfeat, native).
+ * @return the associated SIFT engine.
+ */
+ESiftEngine ESiftEngine_stringToEnum(const std::string& engine);
+
+/**
+ * @brief It converts a SIFT engine to a string.
+ * @param[in] engine the SIFT engine enum to convert.
+ * @return the string associated to the SIFT engine.
+ */
+std::string ESiftEngine_enumToString(ESiftEngine engine);
+
 struct SiftParams
 {
   SiftParams(
@@ -63,6 +95,8 @@ struct SiftParams
   std::size_t _maxTotalKeypoints;
   //
   bool _root_sift;        // see [1]
+  //
+  ESiftEngine _engine = ESiftEngine::VLFEAT; // CPU extraction engine
   
   bool setPreset(EImageDescriberPreset preset) // TODO: void
   {
@@ -110,6 +144,35 @@ struct SiftParams
   
 };
 
+/**
+ * @brief Initialize the VLFeat global state.
+ * The state is reference counted, so several SIFT image describers
+ * (e.g. one per thread) can be created and destroyed independently.
+ */
+void vlfeatAcquire();
+
+/**
+ * @brief Release the VLFeat global state acquired with vlfeatAcquire.
+ */
+void vlfeatRelease();
+
+/**
+ * @brief Estimate the memory needed by the VLFeat scale space of an image.
+ * VLFeat only keeps one octave in memory: the gaussians, the DoG and the gradients
+ * of the first (and biggest) octave.
+ * @param[in] width image width
+ * @param[in] height image height
+ * @param[in] params SIFT parameters
+ * @return the estimated memory in bytes
+ */
+inline std::size_t getSiftMemoryConsumption(std::size_t width, std::size_t height, const SiftParams& params)
+{
+  const double octaveScale = std::pow(2.0, -params._first_octave);
+  const std::size_t octavePixels = static_cast<std::size_t>(width * octaveScale * height * octaveScale);
+  const std::size_t nbPlanes = 1 + (params._num_scales + 3) + (params._num_scales + 2) + 2 * params._num_scales;
+  return octavePixels * nbPlanes * sizeof(vl_sift_pix);
+}
+
 //convertSIFT
 //////////////////////////////
 template < typename TOut > 
@@ -158,8 +221,67 @@ inline void convertSIFT<unsigned char>(
   }
 }
 
+/**
+ * @brief Sort the SIFT regions by decreasing scale and apply the grid filtering
+ * to keep at most params._maxTotalKeypoints regions with a global repartition.
+ * The regions are bucketed into the grid cells and only the kept ones are sorted (see gridSelection),
+ * equal scales keep their input order, so the output only depends on the input order.
+ * @param[in,out] regions The SIFT regions
+ * @param[in] params SIFT parameters (_gridSize, _maxTotalKeypoints)
+ * @param[in] w The image width
+ * @param[in] h The image height
+ */
+template <typename T>
+void sortAndGridFilterSIFT(ScalarRegions<SIOPointFeature,T,128>& regions,
+    const SiftParams& params,
+    int w, int h)
+{
+  typedef ScalarRegions<SIOPointFeature,T,128> SIFT_Region_T;
+
+  const auto& features = regions.Features();
+  const auto& descriptors = regions.Descriptors();
+  assert(features.size() == descriptors.size());
+
+  std::vector<float> scales(features.size());
+  for(std::size_t i = 0; i < features.size(); ++i)
+    scales[i] = features[i].scale();
+
+  std::vector<std::size_t> selectedIndexes;
+
+  // Grid filtering of the keypoints to ensure a global repartition
+  if(params._gridSize && params._maxTotalKeypoints)
+  {
+    const double regionWidth = w / double(params._gridSize);
+    const double regionHeight = h / double(params._gridSize);
+
+    std::vector<std::size_t> cellIndexes(features.size());
+    for(std::size_t i = 0; i < features.size(); ++i)
+      cellIndexes[i] = getGridCellIndex(features[i].x(), features[i].y(), regionWidth, regionHeight, params._gridSize);
+
+    gridSelection(cellIndexes, scales, params._gridSize * params._gridSize, params._maxTotalKeypoints, selectedIndexes);
+  }
+  else
+  {
+    selectBest(scales, 0, selectedIndexes);
+  }
+
+  std::vector<typename SIFT_Region_T::FeatureT> selectedFeatures(selectedIndexes.size());
+  std::vector<typename SIFT_Region_T::DescriptorT> selectedDescriptors(selectedIndexes.size());
+  for(std::size_t i = 0; i < selectedIndexes.size(); ++i)
+  {
+    selectedFeatures[i] = features[selectedIndexes[i]];
+    selectedDescriptors[i] = descriptors[selectedIndexes[i]];
+  }
+  regions.Features().swap(selectedFeatures);
+  regions.Descriptors().swap(selectedDescriptors);
+
+  assert(features.size() == descriptors.size());
+}
+
 /**
  * @brief Extract SIFT regions (in float or unsigned char).
+ * The orientations and descriptors of each octave are computed in parallel
+ * in preallocated slots, so the regions order does not depend on the number of threads.
  *
  * @param image
  * @param regions
@@ -183,7 +305,6 @@ bool extractSIFT(const image::Image<float>& image,
     vl_sift_set_peak_thresh(filt, params._peak_threshold/params._num_scales);
 
   Descriptor<vl_sift_pix, 128> vlFeatDescriptor;
-  Descriptor<T, 128> descriptor;
 
   // Process SIFT computation
   vl_sift_process_first_octave(filt, image.data());
@@ -198,6 +319,11 @@ bool extractSIFT(const image::Image<float>& image,
   regionsCasted->Features().reserve(reserveSize);
   regionsCasted->Descriptors().reserve(reserveSize);
 
+  // up to 4 orientations per keypoint
+  std::vector<typename SIFT_Region_T::FeatureT> octaveFeatures;
+  std::vector<typename SIFT_Region_T::DescriptorT> octaveDescriptors;
+  std::vector<int> octaveNbAngles;
+
   while (true)
   {
     vl_sift_detect(filt);
@@ -208,7 +334,11 @@ bool extractSIFT(const image::Image<float>& image,
     // Update gradient before launching parallel extraction
     vl_sift_update_gradient(filt);
 
-    #pragma omp parallel for private(vlFeatDescriptor, descriptor)
+    octaveFeatures.resize(4 * nkeys);
+    octaveDescriptors.resize(4 * nkeys);
+    octaveNbAngles.assign(nkeys, 0);
+
+    #pragma omp parallel for private(vlFeatDescriptor)
     for (int i = 0; i < nkeys; ++i)
     {
 
@@ -230,17 +360,21 @@ bool extractSIFT(const image::Image<float>& image,
       for (int q=0 ; q < nangles ; ++q)
       {
         vl_sift_calc_keypoint_descriptor(filt, &vlFeatDescriptor[0], keys+i, angles[q]);
-        const SIOPointFeature fp(keys[i].x, keys[i].y,
+        octaveFeatures[4 * i + q] = SIOPointFeature(keys[i].x, keys[i].y,
           keys[i].sigma, static_cast<float>(angles[q]));
 
-        convertSIFT<T>(&vlFeatDescriptor[0], descriptor, params._root_sift);
-        
-        #pragma omp critical
-        {
-          regionsCasted->Descriptors().push_back(descriptor);
-          regionsCasted->Features().push_back(fp);
-        }
-        
+        convertSIFT<T>(&vlFeatDescriptor[0], octaveDescriptors[4 * i + q], params._root_sift);
+      }
+      octaveNbAngles[i] = nangles;
+    }
+
+    // keep the keypoints order
+    for (int i = 0; i < nkeys; ++i)
+    {
+      for (int q = 0; q < octaveNbAngles[i]; ++q)
+      {
+        regionsCasted->Features().push_back(octaveFeatures[4 * i + q]);
+        regionsCasted->Descriptors().push_back(octaveDescriptors[4 * i + q]);
       }
     }
     
@@ -249,85 +383,8 @@ bool extractSIFT(const image::Image<float>& image,
   }
   vl_sift_delete(filt);
 
-  const auto& features = regionsCasted->Features();
-  const auto& descriptors = regionsCasted->Descriptors();
-  assert(features.size() == descriptors.size());
-  
-  //Sorting the extracted features according to their scale
-  {
-    std::vector<std::size_t> indexSort(features.size());
-    std::iota(indexSort.begin(), indexSort.end(), 0);
-    std::sort(indexSort.begin(), indexSort.end(), [&](std::size_t a, std::size_t b){ return features[a].scale() > features[b].scale(); });
-    
-    std::vector<typename SIFT_Region_T::FeatureT> sortedFeatures(features.size());
-    std::vector<typename SIFT_Region_T::DescriptorT> sortedDescriptors(features.size());
-    for(std::size_t i: indexSort)
-    {
-      sortedFeatures[i] = features[indexSort[i]];
-      sortedDescriptors[i] = descriptors[indexSort[i]];
-    }
-    regionsCasted->Features().swap(sortedFeatures);
-    regionsCasted->Descriptors().swap(sortedDescriptors);
-  }
-
-  // Grid filtering of the keypoints to ensure a global repartition
-  if(params._gridSize && params._maxTotalKeypoints)
-  {
-    // Only filter features if we have more features than the maxTotalKeypoints
-    if(features.size() > params._maxTotalKeypoints)
-    {
-      std::vector<IndexT> filtered_indexes;
-      std::vector<IndexT> rejected_indexes;
-      filtered_indexes.reserve(std::min(features.size(), params._maxTotalKeypoints));
-      rejected_indexes.reserve(features.size());
-
-      const std::size_t sizeMat = params._gridSize * params._gridSize;
-      std::vector<std::size_t> countFeatPerCell(sizeMat, 0);
-      for (int Indice = 0; Indice < sizeMat; Indice++)
-      {
-    	  countFeatPerCell[Indice] = 0;
-      }
-      const std::size_t keypointsPerCell = params._maxTotalKeypoints / sizeMat;
-      const double regionWidth = w / double(params._gridSize);
-      const double regionHeight = h / double(params._gridSize);
-
-      for(IndexT i = 0; i < features.size(); ++i)
-      {
-        const auto& keypoint = features.at(i);
-        
-        const std::size_t cellX = std::min(std::size_t(keypoint.x() / regionWidth), params._gridSize);
-        const std::size_t cellY = std::min(std::size_t(keypoint.y() / regionHeight), params._gridSize);
-
-        std::size_t &count = countFeatPerCell[cellX*params._gridSize + cellY];
-        ++count;
-
-        if(count < keypointsPerCell)
-          filtered_indexes.push_back(i);
-        else
-          rejected_indexes.push_back(i);
-      }
-      // If we don't have enough features (less than maxTotalKeypoints) after the grid filtering (empty regions in the grid for example).
-      // We add the best other ones, without repartition constraint.
-      if( filtered_indexes.size() < params._maxTotalKeypoints )
-      {
-        const std::size_t remainingElements = std::min(rejected_indexes.size(), params._maxTotalKeypoints - filtered_indexes.size());
-        std::cout << "Grid filtering -- Copy remaining points: " << remainingElements << std::endl;
-        filtered_indexes.insert(filtered_indexes.end(), rejected_indexes.begin(), rejected_indexes.begin() + remainingElements);
-      }
+  sortAndGridFilterSIFT<T>(*regionsCasted, params, w, h);
 
-      std::vector<typename SIFT_Region_T::FeatureT> filtered_features(filtered_indexes.size());
-      std::vector<typename SIFT_Region_T::DescriptorT> filtered_descriptors(filtered_indexes.size());
-      for(IndexT i = 0; i < filtered_indexes.size(); ++i)
-      {
-        filtered_features[i] = features[filtered_indexes[i]];
-        filtered_descriptors[i] = descriptors[filtered_indexes[i]];
-      }
-      regionsCasted->Features().swap(filtered_features);
-      regionsCasted->Descriptors().swap(filtered_descriptors);
-    }
-  }
-  assert(features.size() == descriptors.size());
-  
   return true;
 }
 
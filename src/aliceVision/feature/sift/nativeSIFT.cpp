@@ -0,0 +1,698 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "nativeSIFT.hpp"
+#include <aliceVision/image/convolution.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace aliceVision {
+namespace feature {
+
+namespace {
+
+typedef image::Image<float> Plane;
+
+const double kPi2 = 2.0 * M_PI;
+
+/// number of rows of the extrema detection tiles (independent of the number of threads)
+const int kTileHeight = 32;
+/// number of bins of the orientation histogram
+const int kNbOrientationBins = 36;
+/// descriptor: number of orientation bins
+const int kNBO = 8;
+/// descriptor: number of spatial bins along x and y
+const int kNBP = 4;
+/// descriptor: size of a spatial bin in scale units
+const double kMagnif = 3.0;
+/// descriptor: gaussian window size in spatial bins
+const double kWindowSize = kNBP / 2;
+
+/**
+ * @brief Keypoint in octave coordinates.
+ */
+struct OctaveKeypoint
+{
+  double x;
+  double y;
+  /// scale in octave units
+  double sigma;
+  /// integer position of the extremum in the DoG
+  int ix;
+  int iy;
+  int is;
+};
+
+/**
+ * @brief Scale space geometry, as in VLFeat.
+ * Each octave has the gaussian levels [sMin, sMax] and the DoG levels [sMin, sMax-1].
+ */
+struct ScaleSpace
+{
+  ScaleSpace(const SiftParams& params, int width, int height)
+    : nbScales(params._num_scales)
+    , firstOctave(params._first_octave)
+    , sMin(-1)
+    , sMax(params._num_scales + 1)
+  {
+    sigmak = std::pow(2.0, 1.0 / nbScales);
+    sigma0 = 1.6 * sigmak;
+    dsigma0 = sigma0 * std::sqrt(1.0 - 1.0 / (sigmak * sigmak));
+    peakThreshold = (params._peak_threshold >= 0) ? params._peak_threshold / nbScales : 0.0;
+    edgeThreshold = (params._edge_threshold >= 0) ? params._edge_threshold : 10.0;
+
+    const int maxNbOctaves = std::max(int(std::floor(std::log2(std::min(width, height)))) - firstOctave - 3, 1);
+    nbOctaves = (params._num_octaves > 0) ? std::min(params._num_octaves, maxNbOctaves) : maxNbOctaves;
+  }
+
+  int nbScales;
+  int firstOctave;
+  int nbOctaves;
+  int sMin;
+  int sMax;
+  double sigmak;
+  double sigma0;
+  double dsigma0;
+  /// nominal smoothing of the input image
+  const double sigman = 0.5;
+  double peakThreshold;
+  double edgeThreshold;
+};
+
+/**
+ * @brief Gaussian blur of a plane.
+ * The vectorized separable convolution is used if the plane is bigger than the kernel.
+ */
+void gaussianBlur(const Plane& in, Plane& out, double sigma)
+{
+  const int radius = std::max(1, int(std::ceil(4.0 * sigma)));
+  const int size = 2 * radius + 1;
+
+  Eigen::Matrix<float, 1, Eigen::Dynamic> kernel(size);
+  double sum = 0.0;
+  for(int i = 0; i < size; ++i)
+  {
+    const double dx = (i - radius) / sigma;
+    kernel(i) = static_cast<float>(std::exp(-0.5 * dx * dx));
+    sum += kernel(i);
+  }
+  kernel /= static_cast<float>(sum);
+
+  out.resize(in.Width(), in.Height(), false);
+
+  if(in.Width() >= size && in.Height() >= size)
+  {
+    image::SeparableConvolution2d(in.GetMat(), kernel, kernel, &static_cast<Plane::Base&>(out));
+  }
+  else
+  {
+    const Eigen::VectorXf kernelVec = kernel.transpose();
+    Plane tmp;
+    image::ImageHorizontalConvolution(in, kernelVec, tmp);
+    image::ImageVerticalConvolution(tmp, kernelVec, out);
+  }
+}
+
+/// Double the resolution of a plane with a bilinear interpolation
+void upsample(const Plane& in, Plane& out)
+{
+  const int w = in.Width();
+  const int h = in.Height();
+  out.resize(2 * w, 2 * h, false);
+
+  #pragma omp parallel for
+  for(int y = 0; y < h; ++y)
+  {
+    const int y1 = std::min(y + 1, h - 1);
+    for(int x = 0; x < w; ++x)
+    {
+      const int x1 = std::min(x + 1, w - 1);
+      const float a = in(y, x);
+      const float b = in(y, x1);
+      const float c = in(y1, x);
+      const float d = in(y1, x1);
+      out(2 * y, 2 * x) = a;
+      out(2 * y, 2 * x + 1) = 0.5f * (a + b);
+      out(2 * y + 1, 2 * x) = 0.5f * (a + c);
+      out(2 * y + 1, 2 * x + 1) = 0.25f * (a + b + c + d);
+    }
+  }
+}
+
+/// Keep one pixel every step pixels
+void downsample(const Plane& in, Plane& out, int step, int width, int height)
+{
+  out.resize(width, height, false);
+
+  #pragma omp parallel for
+  for(int y = 0; y < height; ++y)
+    for(int x = 0; x < width; ++x)
+      out(y, x) = in(y * step, x * step);
+}
+
+/**
+ * @brief Test if the DoG value at (x, y) is a strict extremum of its 26 neighbors.
+ */
+template <typename Compare>
+bool isExtremum(const Plane& prev, const Plane& cur, const Plane& next, int x, int y, Compare compare)
+{
+  const float v = cur(y, x);
+  for(int dy = -1; dy <= 1; ++dy)
+  {
+    for(int dx = -1; dx <= 1; ++dx)
+    {
+      if(!compare(v, prev(y + dy, x + dx)) || !compare(v, next(y + dy, x + dx)))
+        return false;
+      if((dx != 0 || dy != 0) && !compare(v, cur(y + dy, x + dx)))
+        return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Refine the position of an extremum with a quadratic fit, as in VLFeat.
+ * @param[in] level The DoG level of the extremum (in [1, nbScales])
+ * @return true if the refined keypoint is stable
+ */
+bool refineKeypoint(const ScaleSpace& ss, const std::vector<Plane>& dogs, int level,
+                    int x, int y, OctaveKeypoint& keypoint)
+{
+  const Plane& prev = dogs[level - 1];
+  const Plane& cur = dogs[level];
+  const Plane& next = dogs[level + 1];
+  const int w = cur.Width();
+  const int h = cur.Height();
+
+  double Dx = 0, Dy = 0, Ds = 0, Dxx = 0, Dyy = 0, Dss = 0, Dxy = 0, Dxs = 0, Dys = 0;
+  double b[3] = {0.0, 0.0, 0.0};
+
+  for(int iter = 0; iter < 5; ++iter)
+  {
+    const double v = cur(y, x);
+    Dx = 0.5 * (cur(y, x + 1) - cur(y, x - 1));
+    Dy = 0.5 * (cur(y + 1, x) - cur(y - 1, x));
+    Ds = 0.5 * (next(y, x) - prev(y, x));
+    Dxx = cur(y, x + 1) + cur(y, x - 1) - 2.0 * v;
+    Dyy = cur(y + 1, x) + cur(y - 1, x) - 2.0 * v;
+    Dss = next(y, x) + prev(y, x) - 2.0 * v;
+    Dxy = 0.25 * (cur(y + 1, x + 1) + cur(y - 1, x - 1) - cur(y + 1, x - 1) - cur(y - 1, x + 1));
+    Dxs = 0.25 * (next(y, x + 1) + prev(y, x - 1) - next(y, x - 1) - prev(y, x + 1));
+    Dys = 0.25 * (next(y + 1, x) + prev(y - 1, x) - next(y - 1, x) - prev(y + 1, x));
+
+    double A[3][3] = {{Dxx, Dxy, Dxs},
+                      {Dxy, Dyy, Dys},
+                      {Dxs, Dys, Dss}};
+    b[0] = -Dx;
+    b[1] = -Dy;
+    b[2] = -Ds;
+
+    // gauss elimination with partial pivoting
+    for(int j = 0; j < 3; ++j)
+    {
+      int maxi = j;
+      for(int i = j + 1; i < 3; ++i)
+      {
+        if(std::abs(A[i][j]) > std::abs(A[maxi][j]))
+          maxi = i;
+      }
+      const double maxa = A[maxi][j];
+
+      // singular: give up
+      if(std::abs(maxa) < 1e-10)
+      {
+        b[0] = b[1] = b[2] = 0.0;
+        break;
+      }
+
+      for(int jj = j; jj < 3; ++jj)
+      {
+        std::swap(A[maxi][jj], A[j][jj]);
+        A[j][jj] /= maxa;
+      }
+      std::swap(b[maxi], b[j]);
+      b[j] /= maxa;
+
+      for(int ii = j + 1; ii < 3; ++ii)
+      {
+        const double a = A[ii][j];
+        for(int jj = j; jj < 3; ++jj)
+          A[ii][jj] -= a * A[j][jj];
+        b[ii] -= a * b[j];
+      }
+    }
+
+    // backward substitution
+    for(int i = 2; i > 0; --i)
+      for(int ii = i - 1; ii >= 0; --ii)
+        b[ii] -= b[i] * A[ii][i];
+
+    // move the keypoint if the translation is big
+    const int dx = ((b[0] > 0.6 && x < w - 2) ? 1 : 0) + ((b[0] < -0.6 && x > 1) ? -1 : 0);
+    const int dy = ((b[1] > 0.6 && y < h - 2) ? 1 : 0) + ((b[1] < -0.6 && y > 1) ? -1 : 0);
+
+    if(dx == 0 && dy == 0)
+      break;
+
+    x += dx;
+    y += dy;
+  }
+
+  const int s = level + ss.sMin;
+  const double val = cur(y, x) + 0.5 * (Dx * b[0] + Dy * b[1] + Ds * b[2]);
+  const double score = (Dxx + Dyy) * (Dxx + Dyy) / (Dxx * Dyy - Dxy * Dxy);
+  const double xn = x + b[0];
+  const double yn = y + b[1];
+  const double sn = s + b[2];
+  const double te = ss.edgeThreshold;
+
+  const bool isValid = std::abs(val) > ss.peakThreshold &&
+                       score < (te + 1) * (te + 1) / te &&
+                       score >= 0 &&
+                       std::abs(b[0]) < 1.5 &&
+                       std::abs(b[1]) < 1.5 &&
+                       std::abs(b[2]) < 1.5 &&
+                       xn >= 0 && xn <= w - 1 &&
+                       yn >= 0 && yn <= h - 1 &&
+                       sn >= ss.sMin && sn <= ss.sMax;
+  if(!isValid)
+    return false;
+
+  keypoint.x = xn;
+  keypoint.y = yn;
+  keypoint.sigma = ss.sigma0 * std::pow(2.0, sn / ss.nbScales);
+  keypoint.ix = x;
+  keypoint.iy = y;
+  keypoint.is = s;
+  return true;
+}
+
+/**
+ * @brief Detect and refine the extrema of the DoG of an octave.
+ * The DoG levels are split in tiles of kTileHeight rows processed in parallel,
+ * and the keypoints are gathered in the tiles order.
+ */
+std::vector<OctaveKeypoint> detectKeypoints(const ScaleSpace& ss, const std::vector<Plane>& dogs)
+{
+  const int w = dogs.front().Width();
+  const int h = dogs.front().Height();
+  const int nbBands = (h - 2 + kTileHeight - 1) / kTileHeight;
+  const int nbTiles = ss.nbScales * nbBands;
+  const float threshold = static_cast<float>(0.8 * ss.peakThreshold);
+
+  std::vector<std::vector<OctaveKeypoint>> keypointsPerTile(nbTiles);
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int t = 0; t < nbTiles; ++t)
+  {
+    const int level = 1 + t / nbBands;
+    const int yBegin = 1 + (t % nbBands) * kTileHeight;
+    const int yEnd = std::min(yBegin + kTileHeight, h - 1);
+
+    const Plane& prev = dogs[level - 1];
+    const Plane& cur = dogs[level];
+    const Plane& next = dogs[level + 1];
+
+    std::vector<OctaveKeypoint>& keypoints = keypointsPerTile[t];
+    for(int y = yBegin; y < yEnd; ++y)
+    {
+      for(int x = 1; x < w - 1; ++x)
+      {
+        const float v = cur(y, x);
+        const bool isCandidate =
+          (v >= threshold && isExtremum(prev, cur, next, x, y, std::greater<float>())) ||
+          (v <= -threshold && isExtremum(prev, cur, next, x, y, std::less<float>()));
+
+        OctaveKeypoint keypoint;
+        if(isCandidate && refineKeypoint(ss, dogs, level, x, y, keypoint))
+          keypoints.push_back(keypoint);
+      }
+    }
+  }
+
+  std::size_t nbKeypoints = 0;
+  for(const auto& keypoints : keypointsPerTile)
+    nbKeypoints += keypoints.size();
+
+  std::vector<OctaveKeypoint> keypoints;
+  keypoints.reserve(nbKeypoints);
+  for(const auto& tileKeypoints : keypointsPerTile)
+    keypoints.insert(keypoints.end(), tileKeypoints.begin(), tileKeypoints.end());
+  return keypoints;
+}
+
+/**
+ * @brief Compute the gradient (modulus, angle) of the gaussian levels [sMin+1, sMax-2].
+ * The gradients are interleaved: [mod, angle] per pixel, with the angle in [0, 2pi).
+ */
+void computeGradients(const ScaleSpace& ss, const std::vector<Plane>& gaussians,
+                      std::vector<std::vector<float>>& gradients)
+{
+  const int w = gaussians.front().Width();
+  const int h = gaussians.front().Height();
+  gradients.resize(ss.nbScales);
+  for(auto& gradient : gradients)
+    gradient.resize(2 * std::size_t(w) * h);
+
+  #pragma omp parallel for
+  for(int t = 0; t < ss.nbScales * h; ++t)
+  {
+    const int i = t / h;
+    const int y = t % h;
+    const Plane& src = gaussians[i + 1];
+    float* grad = gradients[i].data() + 2 * std::size_t(w) * y;
+
+    for(int x = 0; x < w; ++x)
+    {
+      const float gx = (x == 0) ? src(y, 1) - src(y, 0) :
+                       (x == w - 1) ? src(y, w - 1) - src(y, w - 2) :
+                       0.5f * (src(y, x + 1) - src(y, x - 1));
+      const float gy = (y == 0) ? src(1, x) - src(0, x) :
+                       (y == h - 1) ? src(h - 1, x) - src(h - 2, x) :
+                       0.5f * (src(y + 1, x) - src(y - 1, x));
+      grad[2 * x] = std::sqrt(gx * gx + gy * gy);
+      grad[2 * x + 1] = static_cast<float>(std::fmod(std::atan2(gy, gx) + kPi2, kPi2));
+    }
+  }
+}
+
+/**
+ * @brief Compute the orientations of a keypoint, as in VLFeat.
+ * @param[out] angles The orientations (up to 4)
+ * @return The number of orientations
+ */
+int computeOrientations(const ScaleSpace& ss, const std::vector<std::vector<float>>& gradients,
+                        int w, int h, const OctaveKeypoint& keypoint, double angles[4])
+{
+  const int xi = static_cast<int>(keypoint.x + 0.5);
+  const int yi = static_cast<int>(keypoint.y + 0.5);
+  const int si = keypoint.is;
+  const double sigmaw = 1.5 * keypoint.sigma;
+  const int W = std::max(static_cast<int>(std::floor(3.0 * sigmaw)), 1);
+
+  if(xi < 0 || xi > w - 1 || yi < 0 || yi > h - 1 || si < ss.sMin + 1 || si > ss.sMax - 2)
+    return 0;
+
+  std::array<double, kNbOrientationBins> hist;
+  hist.fill(0.0);
+
+  const float* grad = gradients[si - ss.sMin - 1].data();
+
+  for(int ys = std::max(-W, -yi); ys <= std::min(W, h - 1 - yi); ++ys)
+  {
+    for(int xs = std::max(-W, -xi); xs <= std::min(W, w - 1 - xi); ++xs)
+    {
+      const double dx = xi + xs - keypoint.x;
+      const double dy = yi + ys - keypoint.y;
+      const double r2 = dx * dx + dy * dy;
+
+      if(r2 >= W * W + 0.6)
+        continue;
+
+      const float* g = grad + 2 * (std::size_t(w) * (yi + ys) + xi + xs);
+      const double wgt = std::exp(-r2 / (2 * sigmaw * sigmaw));
+      const double mod = g[0];
+      const double ang = g[1];
+      const double fbin = kNbOrientationBins * ang / kPi2;
+      const int bin = static_cast<int>(std::floor(fbin - 0.5));
+      const double rbin = fbin - bin - 0.5;
+      hist[(bin + kNbOrientationBins) % kNbOrientationBins] += (1 - rbin) * mod * wgt;
+      hist[(bin + 1) % kNbOrientationBins] += rbin * mod * wgt;
+    }
+  }
+
+  // smooth the histogram
+  for(int iter = 0; iter < 6; ++iter)
+  {
+    double prev = hist[kNbOrientationBins - 1];
+    const double first = hist[0];
+    int i;
+    for(i = 0; i < kNbOrientationBins - 1; ++i)
+    {
+      const double newh = (prev + hist[i] + hist[i + 1]) / 3.0;
+      prev = hist[i];
+      hist[i] = newh;
+    }
+    hist[i] = (prev + hist[i] + first) / 3.0;
+  }
+
+  const double maxh = *std::max_element(hist.begin(), hist.end());
+
+  int nbAngles = 0;
+  for(int i = 0; i < kNbOrientationBins; ++i)
+  {
+    const double h0 = hist[i];
+    const double hm = hist[(i - 1 + kNbOrientationBins) % kNbOrientationBins];
+    const double hp = hist[(i + 1) % kNbOrientationBins];
+
+    // is this a peak?
+    if(h0 > 0.8 * maxh && h0 > hm && h0 > hp)
+    {
+      const double di = -0.5 * (hp - hm) / (hp + hm - 2 * h0);
+      angles[nbAngles++] = kPi2 * (i + di + 0.5) / kNbOrientationBins;
+      if(nbAngles == 4)
+        break;
+    }
+  }
+  return nbAngles;
+}
+
+/**
+ * @brief Compute the SIFT descriptor of an oriented keypoint, as in VLFeat.
+ * @param[out] descr The normalized descriptor
+ */
+void computeDescriptor(const ScaleSpace& ss, const std::vector<std::vector<float>>& gradients,
+                       int w, int h, const OctaveKeypoint& keypoint, double angle0, float* descr)
+{
+  const int xi = static_cast<int>(keypoint.x + 0.5);
+  const int yi = static_cast<int>(keypoint.y + 0.5);
+  const int si = keypoint.is;
+  const double st0 = std::sin(angle0);
+  const double ct0 = std::cos(angle0);
+  const double SBP = kMagnif * keypoint.sigma + std::numeric_limits<double>::epsilon();
+  const int W = static_cast<int>(std::floor(std::sqrt(2.0) * SBP * (kNBP + 1) / 2.0 + 0.5));
+
+  // descriptor layout: [biny][binx][bint]
+  const int binto = 1;
+  const int binyo = kNBO * kNBP;
+  const int binxo = kNBO;
+
+  std::fill(descr, descr + kNBO * kNBP * kNBP, 0.0f);
+
+  if(xi < 0 || xi >= w || yi < 0 || yi >= h - 1 || si < ss.sMin + 1 || si > ss.sMax - 2)
+    return;
+
+  const float* grad = gradients[si - ss.sMin - 1].data();
+  float* dpt = descr + (kNBP / 2) * binyo + (kNBP / 2) * binxo;
+
+  for(int dyi = std::max(-W, 1 - yi); dyi <= std::min(W, h - yi - 2); ++dyi)
+  {
+    for(int dxi = std::max(-W, 1 - xi); dxi <= std::min(W, w - xi - 2); ++dxi)
+    {
+      const float* g = grad + 2 * (std::size_t(w) * (yi + dyi) + xi + dxi);
+      const double mod = g[0];
+      const double angle = g[1];
+      const double theta = std::fmod(angle - angle0 + 2 * kPi2, kPi2);
+
+      // fractional displacement and normalized coordinates in the rotated frame
+      const double dx = xi + dxi - keypoint.x;
+      const double dy = yi + dyi - keypoint.y;
+      const double nx = (ct0 * dx + st0 * dy) / SBP;
+      const double ny = (-st0 * dx + ct0 * dy) / SBP;
+      const double nt = kNBO * theta / kPi2;
+
+      const double win = std::exp(-(nx * nx + ny * ny) / (2.0 * kWindowSize * kWindowSize));
+
+      const int binx = static_cast<int>(std::floor(nx - 0.5));
+      const int biny = static_cast<int>(std::floor(ny - 0.5));
+      const int bint = static_cast<int>(std::floor(nt));
+      const double rbinx = nx - (binx + 0.5);
+      const double rbiny = ny - (biny + 0.5);
+      const double rbint = nt - bint;
+
+      // trilinear interpolation in the histogram
+      for(int dbinx = 0; dbinx < 2; ++dbinx)
+      {
+        for(int dbiny = 0; dbiny < 2; ++dbiny)
+        {
+          for(int dbint = 0; dbint < 2; ++dbint)
+          {
+            if(binx + dbinx >= -(kNBP / 2) && binx + dbinx < (kNBP / 2) &&
+               biny + dbiny >= -(kNBP / 2) && biny + dbiny < (kNBP / 2))
+            {
+              const double weight = win * mod *
+                                    std::abs(1 - dbinx - rbinx) *
+                                    std::abs(1 - dbiny - rbiny) *
+                                    std::abs(1 - dbint - rbint);
+              dpt[((bint + dbint) % kNBO) * binto + (biny + dbiny) * binyo + (binx + dbinx) * binxo] += static_cast<float>(weight);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // normalize, clamp the big values and normalize again
+  const auto normalize = [descr]()
+  {
+    float norm = 0.0f;
+    for(int i = 0; i < kNBO * kNBP * kNBP; ++i)
+      norm += descr[i] * descr[i];
+    norm = std::sqrt(norm) + std::numeric_limits<float>::epsilon();
+    for(int i = 0; i < kNBO * kNBP * kNBP; ++i)
+      descr[i] /= norm;
+  };
+
+  normalize();
+  for(int i = 0; i < kNBO * kNBP * kNBP; ++i)
+    descr[i] = std::min(descr[i], 0.2f);
+  normalize();
+}
+
+} // namespace
+
+template <typename T>
+bool extractNativeSIFT(const image::Image<float>& image,
+    std::unique_ptr<Regions>& regions,
+    const SiftParams& params,
+    bool orientation,
+    const image::Image<unsigned char>* mask)
+{
+  typedef ScalarRegions<SIOPointFeature,T,128> SIFT_Region_T;
+  regions.reset(new SIFT_Region_T);
+  SIFT_Region_T* regionsCasted = dynamic_cast<SIFT_Region_T*>(regions.get());
+
+  const int w = image.Width();
+  const int h = image.Height();
+  if(w <= 0 || h <= 0 || params._num_scales <= 0)
+    return false;
+
+  const ScaleSpace ss(params, w, h);
+  const int nbLevels = ss.sMax - ss.sMin + 1;
+  const int nbSlots = orientation ? 4 : 1;
+
+  std::vector<Plane> gaussians(nbLevels);
+  std::vector<Plane> dogs(nbLevels - 1);
+  std::vector<std::vector<float>> gradients;
+
+  for(int octave = 0; octave < ss.nbOctaves; ++octave)
+  {
+    const int o = ss.firstOctave + octave;
+    const int ow = (o >= 0) ? (w >> o) : (w << -o);
+    const int oh = (o >= 0) ? (h >> o) : (h << -o);
+    const double xper = std::pow(2.0, o);
+
+    if(ow < 3 || oh < 3)
+      break;
+
+    // first gaussian level of the octave
+    {
+      Plane base;
+      const double sa = ss.sigma0 * std::pow(ss.sigmak, ss.sMin);
+      double sb;
+
+      if(octave == 0)
+      {
+        if(o < 0)
+        {
+          base = image;
+          for(int i = 0; i < -o; ++i)
+          {
+            Plane upsampled;
+            upsample(base, upsampled);
+            base.swap(upsampled);
+          }
+        }
+        else if(o > 0)
+          downsample(image, base, 1 << o, ow, oh);
+        else
+          base = image;
+        sb = ss.sigman * std::pow(2.0, -o);
+      }
+      else
+      {
+        const int sBest = std::min(ss.sMin + ss.nbScales, ss.sMax);
+        downsample(gaussians[sBest - ss.sMin], base, 2, ow, oh);
+        sb = ss.sigma0 * std::pow(ss.sigmak, sBest - ss.nbScales);
+      }
+
+      if(sa > sb)
+        gaussianBlur(base, gaussians[0], std::sqrt(sa * sa - sb * sb));
+      else
+        gaussians[0].swap(base);
+    }
+
+    // gaussian levels and DoG
+    for(int s = ss.sMin + 1; s <= ss.sMax; ++s)
+      gaussianBlur(gaussians[s - 1 - ss.sMin], gaussians[s - ss.sMin], ss.dsigma0 * std::pow(ss.sigmak, s));
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbLevels - 1; ++i)
+      dogs[i] = Plane::Base(gaussians[i + 1].GetMat() - gaussians[i].GetMat());
+
+    const std::vector<OctaveKeypoint> keypoints = detectKeypoints(ss, dogs);
+    computeGradients(ss, gaussians, gradients);
+
+    // orientations and descriptors in preallocated slots
+    const int nbKeypoints = static_cast<int>(keypoints.size());
+    std::vector<typename SIFT_Region_T::FeatureT> features(nbSlots * std::size_t(nbKeypoints));
+    std::vector<typename SIFT_Region_T::DescriptorT> descriptors(nbSlots * std::size_t(nbKeypoints));
+    std::vector<int> nbAngles(nbKeypoints, 0);
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for(int i = 0; i < nbKeypoints; ++i)
+    {
+      const OctaveKeypoint& keypoint = keypoints[i];
+      const float x = static_cast<float>(keypoint.x * xper);
+      const float y = static_cast<float>(keypoint.y * xper);
+
+      // feature masking
+      if(mask && (*mask)(static_cast<int>(y), static_cast<int>(x)) > 0)
+        continue;
+
+      double angles[4] = {0.0, 0.0, 0.0, 0.0};
+      int nangles = 1; // by default (1 upright feature)
+      if(orientation)
+        nangles = computeOrientations(ss, gradients, ow, oh, keypoint, angles);
+
+      std::array<float, 128> siftDescriptor;
+      for(int q = 0; q < nangles; ++q)
+      {
+        computeDescriptor(ss, gradients, ow, oh, keypoint, angles[q], siftDescriptor.data());
+        features[nbSlots * i + q] = SIOPointFeature(x, y, static_cast<float>(keypoint.sigma * xper), static_cast<float>(angles[q]));
+        convertSIFT<T>(siftDescriptor.data(), descriptors[nbSlots * i + q], params._root_sift);
+      }
+      nbAngles[i] = nangles;
+    }
+
+    for(int i = 0; i < nbKeypoints; ++i)
+    {
+      for(int q = 0; q < nbAngles[i]; ++q)
+      {
+        regionsCasted->Features().push_back(features[nbSlots * i + q]);
+        regionsCasted->Descriptors().push_back(descriptors[nbSlots * i + q]);
+      }
+    }
+  }
+
+  sortAndGridFilterSIFT<T>(*regionsCasted, params, w, h);
+
+  return true;
+}
+
+template bool extractNativeSIFT<unsigned char>(const image::Image<float>&, std::unique_ptr<Regions>&,
+    const SiftParams&, bool, const image::Image<unsigned char>*);
+
+template bool extractNativeSIFT<float>(const image::Image<float>&, std::unique_ptr<Regions>&,
+    const SiftParams&, bool, const image::Image<unsigned char>*);
+
+} // namespace feature
+} // namespace aliceVision
@@ -0,0 +1,45 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/feature/sift/SIFT.hpp>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief Extract SIFT regions (in float or unsigned char) with the native multithreaded engine.
+ *
+ * The scale space follows the VLFeat implementation (same octaves, scales, thresholds,
+ * orientation and descriptor computation), but each step is parallelized:
+ * - the gaussians are computed with the vectorized separable convolution,
+ * - the extrema are detected and refined per tile (DoG level x band of rows),
+ * - the orientations and descriptors are written in preallocated slots.
+ * The tiles do not depend on the number of threads and the results are gathered
+ * in the tiles order, so the regions are identical whatever the number of threads.
+ *
+ * @param[in] image The float image
+ * @param[out] regions The detected regions
+ * @param[in] params SIFT parameters
+ * @param[in] orientation Compute the keypoints orientations (otherwise upright)
+ * @param[in] mask 8-bit gray image for keypoint filtering (optional)
+ * @return true if the extraction succeeded
+ */
+template <typename T>
+bool extractNativeSIFT(const image::Image<float>& image,
+    std::unique_ptr<Regions>& regions,
+    const SiftParams& params,
+    bool orientation,
+    const image::Image<unsigned char>* mask);
+
+extern template bool extractNativeSIFT<unsigned char>(const image::Image<float>&, std::unique_ptr<Regions>&,
+    const SiftParams&, bool, const image::Image<unsigned char>*);
+
+extern template bool extractNativeSIFT<float>(const image::Image<float>&, std::unique_ptr<Regions>&,
+    const SiftParams&, bool, const image::Image<unsigned char>*);
+
+} // namespace feature
+} // namespace aliceVision
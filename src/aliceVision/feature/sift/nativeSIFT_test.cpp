@@ -0,0 +1,213 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/feature/sift/nativeSIFT.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE nativeSIFT
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::feature;
+
+/**
+ * @brief Create an image with dark gaussian blobs on a textured background.
+ */
+image::Image<float> createBlobsImage(int width, int height, std::vector<Vec2>& centers)
+{
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<float> noise(0.0f, 0.05f);
+
+  image::Image<float> image(width, height);
+  for(int y = 0; y < height; ++y)
+    for(int x = 0; x < width; ++x)
+      image(y, x) = 0.8f + noise(generator);
+
+  const double sigma = 6.0;
+  for(int cy = 40; cy < height - 40; cy += 80)
+  {
+    for(int cx = 40; cx < width - 40; cx += 80)
+    {
+      centers.emplace_back(cx, cy);
+      for(int y = cy - 30; y <= cy + 30; ++y)
+        for(int x = cx - 30; x <= cx + 30; ++x)
+          image(y, x) -= 0.6f * std::exp(-((x - cx) * (x - cx) + (y - cy) * (y - cy)) / (2.0 * sigma * sigma));
+    }
+  }
+  return image;
+}
+
+/**
+ * @brief Create an image with random gaussian blobs of several sizes and contrasts on a noisy background.
+ */
+image::Image<float> createRandomBlobsImage(int width, int height)
+{
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<float> noise(0.0f, 0.05f);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+  image::Image<float> image(width, height);
+  for(int y = 0; y < height; ++y)
+    for(int x = 0; x < width; ++x)
+      image(y, x) = 0.5f + noise(generator);
+
+  for(int i = 0; i < 300; ++i)
+  {
+    const double cx = uniform(generator) * width;
+    const double cy = uniform(generator) * height;
+    const double sigma = 1.5 + uniform(generator) * 8.0;
+    const double contrast = (uniform(generator) - 0.5) * 0.8;
+    const int radius = static_cast<int>(3.0 * sigma) + 1;
+
+    for(int y = std::max(0, int(cy) - radius); y < std::min(height, int(cy) + radius); ++y)
+      for(int x = std::max(0, int(cx) - radius); x < std::min(width, int(cx) + radius); ++x)
+        image(y, x) += contrast * std::exp(-((x - cx) * (x - cx) + (y - cy) * (y - cy)) / (2.0 * sigma * sigma));
+  }
+  return image;
+}
+
+BOOST_AUTO_TEST_CASE(nativeSIFT_blobs)
+{
+  std::vector<Vec2> centers;
+  const image::Image<float> image = createBlobsImage(480, 320, centers);
+
+  SiftParams params;
+  params._maxTotalKeypoints = 0; // no grid filtering
+
+  std::unique_ptr<Regions> regions;
+  BOOST_CHECK(extractNativeSIFT<unsigned char>(image, regions, params, true, nullptr));
+
+  const auto& features = dynamic_cast<SIFT_Regions*>(regions.get())->Features();
+  BOOST_CHECK(!features.empty());
+
+  // each blob is detected
+  for(const Vec2& center : centers)
+  {
+    bool isDetected = false;
+    for(const SIOPointFeature& feature : features)
+      isDetected |= (feature.coords().cast<double>() - center).norm() < 2.0 && feature.scale() > 4.0;
+    BOOST_CHECK(isDetected);
+  }
+
+  // sorted by decreasing scale
+  for(std::size_t i = 1; i < features.size(); ++i)
+    BOOST_CHECK_GE(features[i - 1].scale(), features[i].scale());
+}
+
+BOOST_AUTO_TEST_CASE(nativeSIFT_deterministic)
+{
+  std::vector<Vec2> centers;
+  const image::Image<float> image = createBlobsImage(640, 480, centers);
+
+  for(int firstOctave : {-1, 0, 1})
+  {
+    SiftParams params;
+    params._first_octave = firstOctave;
+    params._peak_threshold = 0.001f;
+    params._maxTotalKeypoints = 200;
+
+    const int nbThreads = omp_get_max_threads();
+
+    omp_set_num_threads(1);
+    std::unique_ptr<Regions> regionsSerial;
+    extractNativeSIFT<unsigned char>(image, regionsSerial, params, true, nullptr);
+
+    omp_set_num_threads(std::max(nbThreads, 4));
+    std::unique_ptr<Regions> regionsParallel;
+    extractNativeSIFT<unsigned char>(image, regionsParallel, params, true, nullptr);
+
+    omp_set_num_threads(nbThreads);
+
+    const SIFT_Regions& serial = dynamic_cast<const SIFT_Regions&>(*regionsSerial);
+    const SIFT_Regions& parallel = dynamic_cast<const SIFT_Regions&>(*regionsParallel);
+
+    BOOST_CHECK_LE(serial.RegionCount(), params._maxTotalKeypoints);
+    BOOST_REQUIRE_EQUAL(serial.RegionCount(), parallel.RegionCount());
+
+    for(std::size_t i = 0; i < serial.RegionCount(); ++i)
+    {
+      const SIOPointFeature& a = serial.Features()[i];
+      const SIOPointFeature& b = parallel.Features()[i];
+      BOOST_CHECK(a.x() == b.x() && a.y() == b.y() && a.scale() == b.scale() && a.orientation() == b.orientation());
+      BOOST_CHECK(serial.Descriptors()[i] == parallel.Descriptors()[i]);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(nativeSIFT_vlfeatRegression)
+{
+  const image::Image<float> image = createRandomBlobsImage(640, 480);
+
+  vlfeatAcquire();
+
+  for(int firstOctave : {-1, 0, 1})
+  {
+    SiftParams params;
+    params._first_octave = firstOctave;
+    params._maxTotalKeypoints = 0; // no grid filtering
+
+    std::unique_ptr<Regions> regionsVLFeat;
+    std::unique_ptr<Regions> regionsNative;
+    BOOST_CHECK(extractSIFT<unsigned char>(image, regionsVLFeat, params, true, nullptr));
+    BOOST_CHECK(extractNativeSIFT<unsigned char>(image, regionsNative, params, true, nullptr));
+
+    const SIFT_Regions& vlfeat = dynamic_cast<const SIFT_Regions&>(*regionsVLFeat);
+    const SIFT_Regions& native = dynamic_cast<const SIFT_Regions&>(*regionsNative);
+
+    BOOST_REQUIRE(vlfeat.RegionCount() > 100);
+    BOOST_CHECK_CLOSE(double(native.RegionCount()), double(vlfeat.RegionCount()), 10.0);
+
+    std::size_t nbRepeated = 0;
+    std::size_t nbMatched = 0;
+    for(std::size_t i = 0; i < vlfeat.RegionCount(); ++i)
+    {
+      const SIOPointFeature& feature = vlfeat.Features()[i];
+
+      // repeatability: a native keypoint at the same position and scale
+      const auto repeatedIt = std::find_if(native.Features().begin(), native.Features().end(), [&](const SIOPointFeature& other)
+      {
+        return (other.coords() - feature.coords()).norm() < 1.5f && std::abs(std::log(other.scale() / feature.scale())) < std::log(1.25f);
+      });
+      if(repeatedIt == native.Features().end())
+        continue;
+      ++nbRepeated;
+
+      // matching: the nearest native descriptor is at the same position
+      std::size_t nearest = 0;
+      double nearestDistance = std::numeric_limits<double>::max();
+      for(std::size_t j = 0; j < native.RegionCount(); ++j)
+      {
+        double distance = 0.0;
+        for(std::size_t k = 0; k < 128; ++k)
+        {
+          const double diff = double(vlfeat.Descriptors()[i][k]) - double(native.Descriptors()[j][k]);
+          distance += diff * diff;
+        }
+        if(distance < nearestDistance)
+        {
+          nearestDistance = distance;
+          nearest = j;
+        }
+      }
+      if((native.Features()[nearest].coords() - feature.coords()).norm() < 1.5f)
+        ++nbMatched;
+    }
+
+    const double repeatability = nbRepeated / double(vlfeat.RegionCount());
+    const double matchingScore = nbMatched / double(std::max(nbRepeated, std::size_t(1)));
+    BOOST_TEST_MESSAGE("first octave " << firstOctave << ": repeatability " << repeatability << ", matching score " << matchingScore);
+    BOOST_CHECK_GE(repeatability, 0.9);
+    BOOST_CHECK_GE(matchingScore, 0.9);
+  }
+
+  vlfeatRelease();
+}
@@ -0,0 +1,150 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "AABBTree.hpp"
+
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace aliceVision {
+namespace geometry {
+
+/// minimum number of items of a subtree to build it in a separate task
+static const std::size_t parallelBuildMinSize = 4096;
+
+Vec3 AABB::center() const
+{
+  Vec3 c;
+  for(int axis = 0; axis < 3; ++axis)
+  {
+    const bool minFinite = std::isfinite(min(axis));
+    const bool maxFinite = std::isfinite(max(axis));
+
+    if(minFinite && maxFinite)
+      c(axis) = 0.5 * (min(axis) + max(axis));
+    else if(minFinite)
+      c(axis) = min(axis);
+    else if(maxFinite)
+      c(axis) = max(axis);
+    else
+      c(axis) = 0.0;
+  }
+  return c;
+}
+
+void AABBTree::build(const std::vector<AABB>& boxes)
+{
+  _nbBoxes = boxes.size();
+  _nodes.clear();
+
+  if(boxes.empty())
+    return;
+
+  // binary tree with one item per leaf
+  _nodes.resize(2 * boxes.size() - 1);
+
+  std::vector<Vec3> centers(boxes.size());
+  for(std::size_t i = 0; i < boxes.size(); ++i)
+    centers[i] = boxes[i].center();
+
+  std::vector<IndexT> items(boxes.size());
+  std::iota(items.begin(), items.end(), 0);
+
+  #pragma omp parallel
+  {
+    #pragma omp single nowait
+    buildNode(boxes, centers, items, 0, 0, boxes.size());
+  }
+}
+
+void AABBTree::buildNode(const std::vector<AABB>& boxes,
+                         const std::vector<Vec3>& centers,
+                         std::vector<IndexT>& items,
+                         std::size_t node,
+                         std::size_t begin,
+                         std::size_t end)
+{
+  Node& current = _nodes[node];
+
+  if(end - begin == 1)
+  {
+    current.item = items[begin];
+    current.box = boxes[current.item];
+    return;
+  }
+
+  // split along the largest axis of the centers
+  AABB centersBox;
+  for(std::size_t i = begin; i < end; ++i)
+    centersBox.extend(centers[items[i]]);
+
+  int axis;
+  (centersBox.max - centersBox.min).maxCoeff(&axis);
+
+  const std::size_t mid = begin + (end - begin) / 2;
+  std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end,
+                   [&](IndexT a, IndexT b)
+  {
+    // ties are broken by index for a deterministic tree
+    return (centers[a](axis) < centers[b](axis)) ||
+           (centers[a](axis) == centers[b](axis) && a < b);
+  });
+
+  // the left subtree of n items uses 2n-1 nodes
+  const std::size_t leftNode = node + 1;
+  const std::size_t rightNode = node + 2 * (mid - begin);
+  current.right = rightNode;
+
+  if(end - begin >= parallelBuildMinSize)
+  {
+    #pragma omp task shared(boxes, centers, items)
+    buildNode(boxes, centers, items, leftNode, begin, mid);
+    #pragma omp task shared(boxes, centers, items)
+    buildNode(boxes, centers, items, rightNode, mid, end);
+    #pragma omp taskwait
+  }
+  else
+  {
+    buildNode(boxes, centers, items, leftNode, begin, mid);
+    buildNode(boxes, centers, items, rightNode, mid, end);
+  }
+
+  current.box = _nodes[leftNode].box;
+  current.box.extend(_nodes[rightNode].box);
+}
+
+void AABBTree::query(const AABB& box, std::vector<IndexT>& out_indexes) const
+{
+  if(_nodes.empty())
+    return;
+
+  // depth of a median split tree is logarithmic
+  std::size_t stack[64];
+  std::size_t stackSize = 0;
+  stack[stackSize++] = 0;
+
+  while(stackSize > 0)
+  {
+    const Node& node = _nodes[stack[--stackSize]];
+    if(!node.box.overlaps(box))
+      continue;
+
+    if(node.right == UndefinedIndexT)
+    {
+      out_indexes.push_back(node.item);
+    }
+    else
+    {
+      stack[stackSize++] = node.right;
+      stack[stackSize++] = &node - _nodes.data() + 1;
+    }
+  }
+}
+
+} // namespace geometry
+} // namespace aliceVision
@@ -0,0 +1,134 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/numeric/numeric.hpp>
+
+#include <limits>
+#include <vector>
+
+namespace aliceVision {
+namespace geometry {
+
+/**
+ * @brief Axis-aligned bounding box.
+ * Bounds can be infinite (i.e. for infinite camera frustums).
+ */
+struct AABB
+{
+  Vec3 min = Vec3::Constant(std::numeric_limits<double>::infinity());
+  Vec3 max = Vec3::Constant(-std::numeric_limits<double>::infinity());
+
+  AABB() = default;
+
+  AABB(const Vec3& minPoint, const Vec3& maxPoint)
+    : min(minPoint)
+    , max(maxPoint)
+  {}
+
+  /// Return true if the two boxes share at least one point
+  inline bool overlaps(const AABB& other) const
+  {
+    return (min.array() <= other.max.array()).all() &&
+           (other.min.array() <= max.array()).all();
+  }
+
+  /// Grow the box to contain another box
+  inline void extend(const AABB& other)
+  {
+    min = min.cwiseMin(other.min);
+    max = max.cwiseMax(other.max);
+  }
+
+  /// Grow the box to contain a point
+  inline void extend(const Vec3& point)
+  {
+    min = min.cwiseMin(point);
+    max = max.cwiseMax(point);
+  }
+
+  /**
+   * @brief Get a representative point of the box, used to split the boxes.
+   * The finite bound is used along the half-infinite axes.
+   */
+  Vec3 center() const;
+};
+
+/**
+ * @brief Bounding volume hierarchy over a set of axis-aligned bounding boxes.
+ *
+ * The tree is a binary tree with one box per leaf, built by median split
+ * along the largest axis of the boxes centers. The nodes are stored in
+ * depth-first order in a preallocated array, so the subtrees are built in parallel.
+ * Once built, the tree is read-only and can be queried concurrently.
+ */
+class AABBTree
+{
+public:
+
+  AABBTree() = default;
+
+  /**
+   * @brief Build the tree.
+   * @param[in] boxes The boxes, their index in this vector is used as identifier
+   */
+  explicit AABBTree(const std::vector<AABB>& boxes)
+  {
+    build(boxes);
+  }
+
+  /**
+   * @brief Build the tree.
+   * @param[in] boxes The boxes, their index in this vector is used as identifier
+   */
+  void build(const std::vector<AABB>& boxes);
+
+  /**
+   * @brief Append the indexes of the boxes overlapping a query box.
+   * @param[in] box The query box
+   * @param[in,out] out_indexes The indexes of the overlapping boxes
+   */
+  void query(const AABB& box, std::vector<IndexT>& out_indexes) const;
+
+  std::size_t size() const
+  {
+    return _nbBoxes;
+  }
+
+private:
+
+  struct Node
+  {
+    AABB box;
+    /// index of the right child, the left child is the next node (UndefinedIndexT for a leaf)
+    IndexT right = UndefinedIndexT;
+    /// box index for a leaf
+    IndexT item = UndefinedIndexT;
+  };
+
+  /**
+   * @brief Build the subtree of the items [begin, end) at a given node.
+   * @param[in] boxes The boxes
+   * @param[in] centers The boxes centers
+   * @param[in,out] items The boxes indexes, reordered
+   * @param[in] node The subtree root node
+   * @param[in] begin The first item of the subtree
+   * @param[in] end The end of the subtree items
+   */
+  void buildNode(const std::vector<AABB>& boxes,
+                 const std::vector<Vec3>& centers,
+                 std::vector<IndexT>& items,
+                 std::size_t node,
+                 std::size_t begin,
+                 std::size_t end);
+
+  std::vector<Node> _nodes;
+  std::size_t _nbBoxes = 0;
+};
+
+} // namespace geometry
+} // namespace aliceVision
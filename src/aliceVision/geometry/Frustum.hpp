@@ -8,6 +8,8 @@
 
 #include "aliceVision/geometry/HalfPlane.hpp"
 
+#include <limits>
+
 namespace aliceVision {
 namespace geometry {
 
@@ -105,6 +107,41 @@ struct Frustum
     return planes.size() == 6;
   }
 
+  /// Compute the axis-aligned bounding box of the frustum.
+  /// The infinite frustum is unbounded along the axes where its edges have opposite directions.
+  void bounds(Vec3 & minPoint, Vec3 & maxPoint) const
+  {
+    if (isTruncated())
+    {
+      minPoint = maxPoint = points[0];
+      for (const Vec3 & point : points)
+      {
+        minPoint = minPoint.cwiseMin(point);
+        maxPoint = maxPoint.cwiseMax(point);
+      }
+      return;
+    }
+
+    // the infinite frustum is the cone from the camera center along the 4 edges directions
+    const double inf = std::numeric_limits<double>::infinity();
+    minPoint = maxPoint = cones[0];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      bool positive = true;
+      bool negative = true;
+      for (int i = 1; i < 5; ++i)
+      {
+        const double direction = cones[i](axis) - cones[0](axis);
+        positive &= (direction >= 0.0);
+        negative &= (direction <= 0.0);
+      }
+      if (!positive)
+        minPoint(axis) = -inf;
+      if (!negative)
+        maxPoint(axis) = inf;
+    }
+  }
+
   // Return the supporting frustum points (5 for the infinite, 8 for the truncated)
   const std::vector<Vec3> & frustum_points() const
   {
@@ -0,0 +1,91 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/geometry/AABBTree.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+
+#define BOOST_TEST_MODULE aabbTree
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::geometry;
+
+std::vector<AABB> randomBoxes(std::size_t nbBoxes, std::mt19937& gen)
+{
+  std::uniform_real_distribution<double> position(-100.0, 100.0);
+  std::uniform_real_distribution<double> size(0.0, 10.0);
+  std::uniform_int_distribution<int> infinite(0, 20);
+
+  std::vector<AABB> boxes(nbBoxes);
+  for(AABB& box : boxes)
+  {
+    for(int axis = 0; axis < 3; ++axis)
+    {
+      box.min(axis) = position(gen);
+      box.max(axis) = box.min(axis) + size(gen);
+    }
+    // some half-infinite boxes, as for infinite frustums
+    const int axis = infinite(gen);
+    if(axis < 3)
+      box.max(axis) = std::numeric_limits<double>::infinity();
+    else if(axis < 6)
+      box.min(axis - 3) = -std::numeric_limits<double>::infinity();
+  }
+  return boxes;
+}
+
+BOOST_AUTO_TEST_CASE(AABBTree_query)
+{
+  std::mt19937 gen(0);
+
+  for(const std::size_t nbBoxes : {1, 2, 3, 100, 10000})
+  {
+    const std::vector<AABB> boxes = randomBoxes(nbBoxes, gen);
+    const AABBTree tree(boxes);
+    BOOST_CHECK_EQUAL(nbBoxes, tree.size());
+
+    const std::vector<AABB> queries = randomBoxes(50, gen);
+    for(const AABB& query : queries)
+    {
+      std::vector<IndexT> indexes;
+      tree.query(query, indexes);
+      std::sort(indexes.begin(), indexes.end());
+
+      std::vector<IndexT> expected;
+      for(std::size_t i = 0; i < boxes.size(); ++i)
+      {
+        if(boxes[i].overlaps(query))
+          expected.push_back(i);
+      }
+      BOOST_CHECK(indexes == expected);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(AABBTree_empty)
+{
+  const AABBTree tree(std::vector<AABB>{});
+  std::vector<IndexT> indexes;
+  tree.query(AABB(Vec3::Zero(), Vec3::Ones()), indexes);
+  BOOST_CHECK(indexes.empty());
+}
+
+BOOST_AUTO_TEST_CASE(AABB_overlaps)
+{
+  const AABB a(Vec3::Zero(), Vec3::Ones());
+  BOOST_CHECK(a.overlaps(AABB(Vec3::Ones(), Vec3::Constant(2.0))));
+  BOOST_CHECK(!a.overlaps(AABB(Vec3(1.5, 0.0, 0.0), Vec3::Constant(2.0))));
+
+  // unbounded box
+  const AABB b(Vec3(0.5, -std::numeric_limits<double>::infinity(), 0.0),
+               Vec3(std::numeric_limits<double>::infinity(), 0.0, 1.0));
+  BOOST_CHECK(a.overlaps(b));
+  BOOST_CHECK(b.overlaps(AABB(Vec3(1e10, -1e10, 0.5), Vec3(1e10, -1e10, 0.5))));
+  BOOST_CHECK(!b.overlaps(AABB(Vec3(0.0, 0.5, 0.5), Vec3(0.2, 1.0, 1.0))));
+}
@@ -167,3 +167,38 @@ BOOST_AUTO_TEST_CASE(empty_intersection)
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(bounds)
+{
+  const int focal = 1000;
+  const int principal_Point = 500;
+  const int iNviews = 6;
+  const int iNbPoints = 6;
+  const NViewDataSet d =
+    NRealisticCamerasRing(
+    iNviews, iNbPoints,
+    NViewDatasetConfigurator(focal, focal, principal_Point, principal_Point, 5, 0));
+
+  for (int i=0; i < iNviews; ++i)
+  {
+    // Infinite frustum: the bounds contain the points along the frustum edges
+    const Frustum infiniteFrustum(principal_Point*2, principal_Point*2, d._K[i], d._R[i], d._C[i]);
+    Vec3 minPoint, maxPoint;
+    infiniteFrustum.bounds(minPoint, maxPoint);
+    for (int k=1; k < 5; ++k)
+    {
+      for (const double t : {0.0, 1.0, 1e3, 1e9})
+      {
+        const Vec3 X = d._C[i] + t * (infiniteFrustum.cones[k] - d._C[i]);
+        BOOST_CHECK((X.array() >= minPoint.array()).all() && (X.array() <= maxPoint.array()).all());
+      }
+    }
+
+    // Truncated frustum: the bounds are the bounds of the supporting points
+    const Frustum truncatedFrustum(principal_Point*2, principal_Point*2, d._K[i], d._R[i], d._C[i], 1.0, 10.0);
+    truncatedFrustum.bounds(minPoint, maxPoint);
+    BOOST_CHECK(minPoint.allFinite() && maxPoint.allFinite());
+    for (const Vec3 & X : truncatedFrustum.frustum_points())
+      BOOST_CHECK((X.array() >= minPoint.array()).all() && (X.array() <= maxPoint.array()).all());
+  }
+}
@@ -0,0 +1,201 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "CCTagKeyFrameIndex.hpp"
+#include <aliceVision/feature/cctag/ImageDescriber_CCTAG.hpp>
+#include <aliceVision/matching/Hamming.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace aliceVision {
+namespace localization {
+
+const std::size_t CCTagKeyFrameIndex::nbMarkerIds;
+const std::size_t CCTagKeyFrameIndex::nbWords;
+
+namespace {
+
+inline std::size_t popcount(uint64_t word)
+{
+  return matching::Hamming<unsigned char>::popcnt64(word);
+}
+
+} // namespace
+
+void CCTagKeyFrameIndex::computeMarkerIds(const feature::CCTAG_Regions& regions, std::vector<IndexT>& out_markerIds)
+{
+  out_markerIds.resize(regions.Descriptors().size());
+  for(std::size_t i = 0; i < regions.Descriptors().size(); ++i)
+    out_markerIds[i] = feature::getCCTagId(regions.Descriptors()[i]);
+}
+
+CCTagKeyFrameIndex::ViewDescriptor CCTagKeyFrameIndex::computeViewDescriptor(const std::vector<IndexT>& markerIds)
+{
+  ViewDescriptor descriptor;
+  descriptor.fill(0);
+  for(const IndexT markerId : markerIds)
+  {
+    if(markerId != UndefinedIndexT)
+    {
+      assert(markerId < nbMarkerIds);
+      descriptor[markerId / 64] |= uint64_t(1) << (markerId % 64);
+    }
+  }
+  return descriptor;
+}
+
+std::size_t CCTagKeyFrameIndex::similarity(const ViewDescriptor& descriptorA, const ViewDescriptor& descriptorB)
+{
+  std::size_t similarity = 0;
+  for(std::size_t w = 0; w < nbWords; ++w)
+    similarity += popcount(descriptorA[w] & descriptorB[w]);
+  return similarity;
+}
+
+void CCTagKeyFrameIndex::matchMarkerIds(const std::vector<IndexT>& markerIdsA,
+                                        const std::vector<IndexT>& markerIdsB,
+                                        std::vector<matching::IndMatch>& out_featureMatches)
+{
+  out_featureMatches.clear();
+
+  std::array<int32_t, nbMarkerIds> regionPerMarkerId;
+  regionPerMarkerId.fill(-1);
+  for(std::size_t j = 0; j < markerIdsB.size(); ++j)
+  {
+    const IndexT markerId = markerIdsB[j];
+    if(markerId != UndefinedIndexT && regionPerMarkerId[markerId] < 0)
+      regionPerMarkerId[markerId] = static_cast<int32_t>(j);
+  }
+
+  for(std::size_t i = 0; i < markerIdsA.size(); ++i)
+  {
+    const IndexT markerId = markerIdsA[i];
+    if(markerId != UndefinedIndexT && regionPerMarkerId[markerId] >= 0)
+      out_featureMatches.emplace_back(i, regionPerMarkerId[markerId]);
+  }
+}
+
+void CCTagKeyFrameIndex::clear()
+{
+  _viewIds.clear();
+  _descriptors.clear();
+  _regionPerMarkerId.clear();
+  _keyFrameIndexPerView.clear();
+}
+
+void CCTagKeyFrameIndex::reserve(std::size_t nbKeyFrames)
+{
+  _viewIds.reserve(nbKeyFrames);
+  _descriptors.reserve(nbKeyFrames * nbWords);
+  _regionPerMarkerId.reserve(nbKeyFrames * nbMarkerIds);
+  _keyFrameIndexPerView.reserve(nbKeyFrames);
+}
+
+void CCTagKeyFrameIndex::addKeyFrame(IndexT viewId, const feature::CCTAG_Regions& regions)
+{
+  assert(!hasKeyFrame(viewId));
+
+  std::vector<IndexT> markerIds;
+  computeMarkerIds(regions, markerIds);
+
+  _keyFrameIndexPerView[viewId] = _viewIds.size();
+  _viewIds.push_back(viewId);
+
+  const ViewDescriptor descriptor = computeViewDescriptor(markerIds);
+  _descriptors.insert(_descriptors.end(), descriptor.begin(), descriptor.end());
+
+  const std::size_t offset = _regionPerMarkerId.size();
+  _regionPerMarkerId.resize(offset + nbMarkerIds, -1);
+  for(std::size_t j = 0; j < markerIds.size(); ++j)
+  {
+    const IndexT markerId = markerIds[j];
+    if(markerId != UndefinedIndexT && _regionPerMarkerId[offset + markerId] < 0)
+      _regionPerMarkerId[offset + markerId] = static_cast<int32_t>(j);
+  }
+}
+
+void CCTagKeyFrameIndex::kNearestKeyFrames(const ViewDescriptor& queryDescriptor,
+                                           std::size_t nNearestKeyFrames,
+                                           std::vector<IndexT>& out_kNearestFrames,
+                                           float similarityThreshold) const
+{
+  out_kNearestFrames.clear();
+  if(nNearestKeyFrames == 0)
+    return;
+
+  const std::size_t nbKeyFrames = _viewIds.size();
+
+  // similarity with all the keyframes, on the contiguous packed descriptors
+  static_assert(nbWords == 2, "The view descriptor is expected to be 2 words.");
+  std::vector<uint8_t> similarities(nbKeyFrames);
+  {
+    const uint64_t q0 = queryDescriptor[0];
+    const uint64_t q1 = queryDescriptor[1];
+    const uint64_t* descriptor = _descriptors.data();
+    for(std::size_t k = 0; k < nbKeyFrames; ++k, descriptor += nbWords)
+      similarities[k] = static_cast<uint8_t>(popcount(q0 & descriptor[0]) + popcount(q1 & descriptor[1]));
+  }
+
+  // bounded heap of the k best keyframes: the top of the heap is the worst one
+  using Candidate = std::pair<uint8_t, IndexT>; // similarity, view id
+  const auto isBetter = [](const Candidate& a, const Candidate& b)
+  {
+    return a > b;
+  };
+
+  std::vector<Candidate> heap;
+  heap.reserve(std::min(nNearestKeyFrames, nbKeyFrames) + 1);
+
+  for(std::size_t k = 0; k < nbKeyFrames; ++k)
+  {
+    if(similarities[k] < similarityThreshold)
+      continue;
+
+    const Candidate candidate(similarities[k], _viewIds[k]);
+    if(heap.size() < nNearestKeyFrames)
+    {
+      heap.push_back(candidate);
+      std::push_heap(heap.begin(), heap.end(), isBetter);
+    }
+    else if(isBetter(candidate, heap.front()))
+    {
+      std::pop_heap(heap.begin(), heap.end(), isBetter);
+      heap.back() = candidate;
+      std::push_heap(heap.begin(), heap.end(), isBetter);
+    }
+  }
+
+  // sort the best first
+  std::sort_heap(heap.begin(), heap.end(), isBetter);
+
+  out_kNearestFrames.reserve(heap.size());
+  for(const Candidate& candidate : heap)
+    out_kNearestFrames.push_back(candidate.second);
+}
+
+void CCTagKeyFrameIndex::viewMatching(const std::vector<IndexT>& queryMarkerIds,
+                                      IndexT viewId,
+                                      std::vector<matching::IndMatch>& out_featureMatches) const
+{
+  out_featureMatches.clear();
+
+  const auto it = _keyFrameIndexPerView.find(viewId);
+  if(it == _keyFrameIndexPerView.end())
+    return;
+
+  const int32_t* regionPerMarkerId = &_regionPerMarkerId[it->second * nbMarkerIds];
+
+  for(std::size_t i = 0; i < queryMarkerIds.size(); ++i)
+  {
+    const IndexT markerId = queryMarkerIds[i];
+    if(markerId != UndefinedIndexT && regionPerMarkerId[markerId] >= 0)
+      out_featureMatches.emplace_back(i, regionPerMarkerId[markerId]);
+  }
+}
+
+} // namespace localization
+} // namespace aliceVision
@@ -0,0 +1,134 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/feature/regionsFactory.hpp>
+#include <aliceVision/matching/IndMatch.hpp>
+#include <aliceVision/types.hpp>
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace aliceVision {
+namespace localization {
+
+/**
+ * @brief Index of the CCTag markers seen by the keyframes of the database.
+ *
+ * For each keyframe, it stores contiguously:
+ * - the view descriptor: a packed bitset of the visible marker ids (128 bits, ie 2 words),
+ * - a lookup table from the marker id to the index of the region of the keyframe.
+ *
+ * The retrieval of the nearest keyframes is a popcount over the packed bitsets of all
+ * the keyframes followed by a bounded heap, and the matching with a keyframe is a lookup
+ * per query marker.
+ */
+class CCTagKeyFrameIndex
+{
+public:
+
+  /// maximum number of marker ids (size of a CCTag descriptor)
+  static const std::size_t nbMarkerIds = 128;
+  /// number of 64-bit words of a view descriptor
+  static const std::size_t nbWords = nbMarkerIds / 64;
+
+  /// view descriptor: bit i is set if the marker with id i is visible
+  using ViewDescriptor = std::array<uint64_t, nbWords>;
+
+  /**
+   * @brief Get the marker id of each region (UndefinedIndexT if the descriptor is not a valid CCTag id).
+   */
+  static void computeMarkerIds(const feature::CCTAG_Regions& regions, std::vector<IndexT>& out_markerIds);
+
+  /**
+   * @brief Get the view descriptor from the marker ids of the regions of a view.
+   */
+  static ViewDescriptor computeViewDescriptor(const std::vector<IndexT>& markerIds);
+
+  /**
+   * @brief Get the number of markers visible in both views.
+   */
+  static std::size_t similarity(const ViewDescriptor& descriptorA, const ViewDescriptor& descriptorB);
+
+  /**
+   * @brief Match the regions of two views by marker id: each region of A is matched
+   * with the first region of B with the same marker id.
+   *
+   * @param[in] markerIdsA The marker ids of the regions of view A
+   * @param[in] markerIdsB The marker ids of the regions of view B
+   * @param[out] out_featureMatches The matches (region of A, region of B)
+   */
+  static void matchMarkerIds(const std::vector<IndexT>& markerIdsA,
+                             const std::vector<IndexT>& markerIdsB,
+                             std::vector<matching::IndMatch>& out_featureMatches);
+
+  /// Remove all the keyframes
+  void clear();
+
+  /// Reserve the memory for a number of keyframes
+  void reserve(std::size_t nbKeyFrames);
+
+  /**
+   * @brief Add a keyframe to the index.
+   * @param[in] viewId The view id of the keyframe (must not be already in the index)
+   * @param[in] regions The reconstructed CCTag regions of the keyframe
+   */
+  void addKeyFrame(IndexT viewId, const feature::CCTAG_Regions& regions);
+
+  /// Get the number of keyframes
+  std::size_t size() const
+  {
+    return _viewIds.size();
+  }
+
+  /// Returns true if the keyframe is in the index
+  bool hasKeyFrame(IndexT viewId) const
+  {
+    return _keyFrameIndexPerView.count(viewId) > 0;
+  }
+
+  /**
+   * @brief Retrieve the k nearest keyframes of a query.
+   *
+   * The similarity is the number of markers visible in both views; for the same
+   * similarity, the keyframe with the greatest view id comes first.
+   *
+   * @param[in] queryDescriptor The view descriptor of the query
+   * @param[in] nNearestKeyFrames Number of nearest keyframes to return
+   * @param[out] out_kNearestFrames The view ids of the nearest keyframes, the most similar first
+   * @param[in] similarityThreshold Only the keyframes with at least this similarity are returned
+   */
+  void kNearestKeyFrames(const ViewDescriptor& queryDescriptor,
+                         std::size_t nNearestKeyFrames,
+                         std::vector<IndexT>& out_kNearestFrames,
+                         float similarityThreshold = 1.0f) const;
+
+  /**
+   * @brief Match the regions of the query with the regions of a keyframe by marker id.
+   *
+   * @param[in] queryMarkerIds The marker ids of the regions of the query
+   * @param[in] viewId The view id of the keyframe
+   * @param[out] out_featureMatches The matches (query region, keyframe region)
+   */
+  void viewMatching(const std::vector<IndexT>& queryMarkerIds,
+                    IndexT viewId,
+                    std::vector<matching::IndMatch>& out_featureMatches) const;
+
+private:
+  /// view id of each keyframe
+  std::vector<IndexT> _viewIds;
+  /// view descriptors of the keyframes, nbWords per keyframe
+  std::vector<uint64_t> _descriptors;
+  /// for each keyframe and each marker id, index of the first region with this id (-1 if not visible)
+  std::vector<int32_t> _regionPerMarkerId;
+  /// position of each keyframe in the index
+  std::unordered_map<IndexT, std::size_t> _keyFrameIndexPerView;
+};
+
+} // namespace localization
+} // namespace aliceVision
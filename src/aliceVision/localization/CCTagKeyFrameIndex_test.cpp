@@ -0,0 +1,153 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "CCTagKeyFrameIndex.hpp"
+#include <aliceVision/feature/cctag/ImageDescriber_CCTAG.hpp>
+
+#include <bitset>
+#include <map>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE CCTagKeyFrameIndex
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::localization;
+
+/**
+ * @brief Create CCTag regions with the given marker ids (UndefinedIndexT for an invalid descriptor).
+ */
+feature::CCTAG_Regions createRegions(const std::vector<IndexT>& markerIds)
+{
+  feature::CCTAG_Regions regions;
+  for(const IndexT markerId : markerIds)
+  {
+    feature::CCTAG_Regions::DescriptorT descriptor;
+    for(std::size_t i = 0; i < descriptor.size(); ++i)
+      descriptor[i] = 0;
+    if(markerId != UndefinedIndexT)
+      descriptor[markerId] = 255;
+    else
+      descriptor[0] = descriptor[1] = 255;
+
+    regions.Features().emplace_back(0.0f, 0.0f, 1.0f, 0.0f);
+    regions.Descriptors().push_back(descriptor);
+  }
+  return regions;
+}
+
+std::vector<IndexT> randomMarkerIds(std::mt19937& generator)
+{
+  std::uniform_int_distribution<int> nbMarkers(0, 8);
+  std::uniform_int_distribution<int> markerId(0, 24);
+  std::vector<IndexT> markerIds(nbMarkers(generator));
+  for(IndexT& id : markerIds)
+    id = (markerId(generator) == 24) ? UndefinedIndexT : markerId(generator);
+  return markerIds;
+}
+
+/// reference similarity: number of markers visible in both views
+std::size_t referenceSimilarity(const std::vector<IndexT>& markerIdsA, const std::vector<IndexT>& markerIdsB)
+{
+  std::bitset<128> a, b;
+  for(const IndexT id : markerIdsA)
+    if(id != UndefinedIndexT)
+      a.set(id);
+  for(const IndexT id : markerIdsB)
+    if(id != UndefinedIndexT)
+      b.set(id);
+  return (a & b).count();
+}
+
+BOOST_AUTO_TEST_CASE(CCTagKeyFrameIndex_kNearestKeyFrames)
+{
+  std::mt19937 generator(0);
+
+  std::map<IndexT, std::vector<IndexT>> keyFrames;
+  CCTagKeyFrameIndex index;
+  for(IndexT viewId = 0; viewId < 500; ++viewId)
+  {
+    keyFrames[viewId * 3] = randomMarkerIds(generator);
+    index.addKeyFrame(viewId * 3, createRegions(keyFrames.at(viewId * 3)));
+  }
+  BOOST_CHECK_EQUAL(index.size(), keyFrames.size());
+
+  for(int q = 0; q < 50; ++q)
+  {
+    const std::vector<IndexT> queryMarkerIds = randomMarkerIds(generator);
+    const CCTagKeyFrameIndex::ViewDescriptor queryDescriptor = CCTagKeyFrameIndex::computeViewDescriptor(queryMarkerIds);
+
+    // reference: sort by decreasing similarity, the greatest view id first for the same similarity
+    std::multimap<float, IndexT> sortedViewSimilarities;
+    for(const auto& keyFrame : keyFrames)
+      sortedViewSimilarities.emplace(referenceSimilarity(queryMarkerIds, keyFrame.second), keyFrame.first);
+
+    // with a null threshold, the keyframes without any common marker are also returned
+    for(float similarityThreshold : {0.0f, 1.0f, 2.0f})
+    {
+      for(std::size_t k : {1, 4, 10})
+      {
+        std::vector<IndexT> expected;
+        for(auto it = sortedViewSimilarities.crbegin(); it != sortedViewSimilarities.crend() && expected.size() < k; ++it)
+        {
+          if(it->first < similarityThreshold)
+            break;
+          expected.push_back(it->second);
+        }
+
+        std::vector<IndexT> nearestKeyFrames;
+        index.kNearestKeyFrames(queryDescriptor, k, nearestKeyFrames, similarityThreshold);
+        BOOST_CHECK_EQUAL_COLLECTIONS(nearestKeyFrames.begin(), nearestKeyFrames.end(), expected.begin(), expected.end());
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(CCTagKeyFrameIndex_viewMatching)
+{
+  std::mt19937 generator(1);
+
+  for(int t = 0; t < 100; ++t)
+  {
+    const std::vector<IndexT> markerIdsA = randomMarkerIds(generator);
+    const std::vector<IndexT> markerIdsB = randomMarkerIds(generator);
+
+    CCTagKeyFrameIndex index;
+    index.addKeyFrame(7, createRegions(markerIdsB));
+
+    std::vector<IndexT> queryMarkerIds;
+    CCTagKeyFrameIndex::computeMarkerIds(createRegions(markerIdsA), queryMarkerIds);
+    BOOST_CHECK_EQUAL_COLLECTIONS(queryMarkerIds.begin(), queryMarkerIds.end(), markerIdsA.begin(), markerIdsA.end());
+
+    // reference: each valid marker of A is matched with the first region of B with the same id
+    std::vector<matching::IndMatch> expected;
+    for(std::size_t i = 0; i < markerIdsA.size(); ++i)
+    {
+      if(markerIdsA[i] == UndefinedIndexT)
+        continue;
+      for(std::size_t j = 0; j < markerIdsB.size(); ++j)
+      {
+        if(markerIdsA[i] == markerIdsB[j])
+        {
+          expected.emplace_back(i, j);
+          break;
+        }
+      }
+    }
+
+    std::vector<matching::IndMatch> matches;
+    index.viewMatching(queryMarkerIds, 7, matches);
+    BOOST_CHECK(matches == expected);
+
+    CCTagKeyFrameIndex::matchMarkerIds(markerIdsA, markerIdsB, matches);
+    BOOST_CHECK(matches == expected);
+
+    // unknown keyframe
+    index.viewMatching(queryMarkerIds, 8, matches);
+    BOOST_CHECK(matches.empty());
+  }
+}
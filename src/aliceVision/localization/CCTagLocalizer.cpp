@@ -134,6 +134,15 @@ bool CCTagLocalizer::loadReconstructionDescriptors(const sfm::SfMData & sfm_data
     }
   }
 
+  // Build the keyframe index once for all the queries
+  _keyFrameIndex.clear();
+  _keyFrameIndex.reserve(_regionsPerView.getData().size());
+  for(const auto& keyFrame : _regionsPerView.getData())
+  {
+    _keyFrameIndex.addKeyFrame(keyFrame.first, keyFrame.second.getRegions<feature::CCTAG_Regions>(_cctagDescType));
+  }
+  ALICEVISION_LOG_DEBUG("Keyframe index built with " << _keyFrameIndex.size() << " keyframes");
+
 
   {
     std::set<int> presentCCtagIds;
@@ -405,7 +414,7 @@ bool CCTagLocalizer::localizeRig(const std::vector<image::Image<unsigned char> >
   std::vector<feature::MapRegionsPerDesc> vec_queryRegions(numCams);
   std::vector<std::pair<std::size_t, std::size_t> > vec_imageSize;
   
-  //@todo parallelize?
+  // the CCTag extraction uses the CUDA pipe of the localizer, the images are processed sequentially
   for(size_t i = 0; i < numCams; ++i)
   {
     // extract descriptors and features from each image
@@ -492,10 +501,9 @@ bool CCTagLocalizer::localizeRig_opengv(const std::vector<feature::MapRegionsPer
   std::vector<Mat> vec_pts2D(numCams);
   std::vector<std::vector<voctree::DocMatch> > vec_matchedImages(numCams);
 
-  // for each camera retrieve the associations
-  //@todo parallelize?
-  size_t numAssociations = 0;
-  for( size_t i = 0; i < numCams; ++i )
+  // for each camera retrieve the associations, the cameras are independent
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < static_cast<int>(numCams); ++i)
   {
     // this map is used to collect the 2d-3d associations as we go through the images
     // the key is a pair <Id3D, Id2d>
@@ -506,8 +514,11 @@ bool CCTagLocalizer::localizeRig_opengv(const std::vector<feature::MapRegionsPer
     Mat &pts2D = vec_pts2D[i];
     const feature::CCTAG_Regions &queryRegions = vec_queryRegions[i].getRegions<feature::CCTAG_Regions>(_cctagDescType);
     getAllAssociations(queryRegions, imageSize[i],*param, occurrences, pts2D, pts3D, matchedImages);
-    numAssociations += occurrences.size();
   }
+
+  std::size_t numAssociations = 0;
+  for(const auto& occurrences : vec_occurrences)
+    numAssociations += occurrences.size();
   
   // @todo Here it could be possible to filter the associations according to their
   // occurrences, eg giving priority to those associations that are more frequent
@@ -671,10 +682,11 @@ bool CCTagLocalizer::localizeRig_naive(const std::vector<feature::MapRegionsPerD
 
   vec_localizationResults.resize(numCams);
     
-  // this is basic, just localize each camera alone
-  //@todo parallelize?
-  std::vector<bool> isLocalized(numCams, false);
-  for(size_t i = 0; i < numCams; ++i)
+  // this is basic, just localize each camera alone, the localization from the
+  // regions does not modify the localizer so the cameras are localized in parallel
+  std::vector<char> isLocalized(numCams, false);
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < static_cast<int>(numCams); ++i)
   {
     isLocalized[i] = localize(vec_queryRegions[i], imageSize[i], param, true /*useInputIntrinsics*/, vec_queryIntrinsics[i], vec_localizationResults[i]);
     if(!isLocalized[i])
@@ -686,7 +698,7 @@ bool CCTagLocalizer::localizeRig_naive(const std::vector<feature::MapRegionsPerD
   
   // ** 'easy' cases in which we don't need further processing **
   
-  const std::size_t numLocalizedCam = std::count(isLocalized.begin(), isLocalized.end(), true);
+  const std::size_t numLocalizedCam = std::count(isLocalized.begin(), isLocalized.end(), char(true));
   
   // no camera has be localized
   if(numLocalizedCam == 0)
@@ -710,7 +722,7 @@ bool CCTagLocalizer::localizeRig_naive(const std::vector<feature::MapRegionsPerD
 
     // find the index of the first localized camera
     const std::size_t idx = std::distance(isLocalized.begin(), 
-                                          std::find(isLocalized.begin(), isLocalized.end(), true));
+                                          std::find(isLocalized.begin(), isLocalized.end(), char(true)));
     
     // useless safeguard as there should be at least 1 element at this point but
     // better safe than sorry
@@ -761,14 +773,16 @@ void CCTagLocalizer::getAllAssociations(const feature::CCTAG_Regions &queryRegio
                                         std::vector<voctree::DocMatch>& out_matchedImages,
                                         const std::string& imagePath) const
 {
+  // the marker ids of the query are computed once for the retrieval and the matching
+  std::vector<IndexT> queryMarkerIds;
+  CCTagKeyFrameIndex::computeMarkerIds(queryRegions, queryMarkerIds);
+
+  // same threshold as the kNearestKeyFrames function: only the keyframes sharing a marker with the query
   std::vector<IndexT> nearestKeyFrames;
-  nearestKeyFrames.reserve(param._nNearestKeyFrames);
-  
-  kNearestKeyFrames(queryRegions,
-                    _cctagDescType,
-                    _regionsPerView,
-                    param._nNearestKeyFrames,
-                    nearestKeyFrames);
+  _keyFrameIndex.kNearestKeyFrames(CCTagKeyFrameIndex::computeViewDescriptor(queryMarkerIds),
+                                   param._nNearestKeyFrames,
+                                   nearestKeyFrames,
+                                   1.0f);
   
   out_matchedImages.clear();
   out_matchedImages.reserve(nearestKeyFrames.size());
@@ -784,7 +798,7 @@ void CCTagLocalizer::getAllAssociations(const feature::CCTAG_Regions &queryRegio
 
     // Matching
     std::vector<matching::IndMatch> vec_featureMatches;
-    viewMatching(queryRegions, matchedCCtagRegions, vec_featureMatches);
+    _keyFrameIndex.viewMatching(queryMarkerIds, keyframeId, vec_featureMatches);
     ALICEVISION_LOG_DEBUG("[matching]\tFound "<< vec_featureMatches.size() <<" matches.");
     
     out_matchedImages.emplace_back(keyframeId, vec_featureMatches.size());
@@ -908,60 +922,37 @@ void kNearestKeyFrames(const feature::CCTAG_Regions & queryRegions,
                        const feature::RegionsPerView & regionsPerView,
                        std::size_t nNearestKeyFrames,
                        std::vector<IndexT> & out_kNearestFrames,
-                       const float similarityThreshold /*=.0f*/)
+                       const float similarityThreshold /*=1.0f*/)
 {
-  out_kNearestFrames.clear();
-  
-  // A std::multimap is used instead of a std::map because is very likely that the
-  // similarity measure is equal for a subset of views in the CCTag regions case.
-  std::multimap<float, IndexT> sortedViewSimilarities;
-  
+  CCTagKeyFrameIndex keyFrameIndex;
+  keyFrameIndex.reserve(regionsPerView.getData().size());
   for(const auto & keyFrame : regionsPerView.getData())
   {
-    const feature::CCTAG_Regions& keyFrameCCTagRegions = keyFrame.second.getRegions<feature::CCTAG_Regions>(cctagDescType);
-    const float similarity = viewSimilarity(queryRegions, keyFrameCCTagRegions);
-    sortedViewSimilarities.emplace(similarity, keyFrame.first);
-  }
-  
-  std::size_t counter = 0;
-  out_kNearestFrames.reserve(nNearestKeyFrames);
-  for (auto rit = sortedViewSimilarities.crbegin(); rit != sortedViewSimilarities.crend(); ++rit)
-  {
-    if(rit->first < similarityThreshold)
-      // since it is ordered, the first having smaller similarity guarantees that
-      // there won't be other useful kframes
-      break;
-    
-    out_kNearestFrames.push_back(rit->second);
-    ++counter;
-    
-    if (counter == nNearestKeyFrames)
-      break;
+    keyFrameIndex.addKeyFrame(keyFrame.first, keyFrame.second.getRegions<feature::CCTAG_Regions>(cctagDescType));
   }
+
+  std::vector<IndexT> queryMarkerIds;
+  CCTagKeyFrameIndex::computeMarkerIds(queryRegions, queryMarkerIds);
+
+  keyFrameIndex.kNearestKeyFrames(CCTagKeyFrameIndex::computeViewDescriptor(queryMarkerIds),
+                                  nNearestKeyFrames,
+                                  out_kNearestFrames,
+                                  similarityThreshold);
 }
  
 void viewMatching(const feature::CCTAG_Regions & regionsA,
                   const feature::CCTAG_Regions & regionsB,
                   std::vector<matching::IndMatch> & out_featureMatches)
 {
-  out_featureMatches.clear();
-  
-  for(std::size_t i=0 ; i < regionsA.Descriptors().size() ; ++i)
-  {
-    const IndexT cctagIdA = feature::getCCTagId(regionsA.Descriptors()[i]);
-    // todo: Should be change to: Find in regionsB.Descriptors() the nearest 
-    // descriptor to descriptorA. Currently, a cctag descriptor encode directly
-    // the cctag id, then the id equality is tested.
-    for(std::size_t j=0 ; j < regionsB.Descriptors().size() ; ++j)
-    {
-      const IndexT cctagIdB = feature::getCCTagId(regionsB.Descriptors()[j]);
-      if ( cctagIdA == cctagIdB )
-      {
-        out_featureMatches.emplace_back(i,j);
-        break;
-      }
-    }
-  }
+  // todo: Should be change to: Find in regionsB.Descriptors() the nearest 
+  // descriptor to descriptorA. Currently, a cctag descriptor encode directly
+  // the cctag id, then the id equality is tested.
+  std::vector<IndexT> markerIdsA;
+  std::vector<IndexT> markerIdsB;
+  CCTagKeyFrameIndex::computeMarkerIds(regionsA, markerIdsA);
+  CCTagKeyFrameIndex::computeMarkerIds(regionsB, markerIdsB);
+
+  CCTagKeyFrameIndex::matchMarkerIds(markerIdsA, markerIdsB, out_featureMatches);
 }
  
  
@@ -970,12 +961,15 @@ float viewSimilarity(const feature::CCTAG_Regions & regionsA,
                      const feature::CCTAG_Regions & regionsB)
 {
   assert(regionsA.DescriptorLength() == regionsB.DescriptorLength()); 
-  
-  const std::bitset<128> descriptorViewA = constructCCTagViewDescriptor(regionsA.Descriptors());
-  const std::bitset<128> descriptorViewB = constructCCTagViewDescriptor(regionsB.Descriptors());
+
+  std::vector<IndexT> markerIdsA;
+  std::vector<IndexT> markerIdsB;
+  CCTagKeyFrameIndex::computeMarkerIds(regionsA, markerIdsA);
+  CCTagKeyFrameIndex::computeMarkerIds(regionsB, markerIdsB);
   
   // The similarity is the sum of all the cctags sharing the same id visible in both views.
-  return (descriptorViewA & descriptorViewB).count();
+  return CCTagKeyFrameIndex::similarity(CCTagKeyFrameIndex::computeViewDescriptor(markerIdsA),
+                                        CCTagKeyFrameIndex::computeViewDescriptor(markerIdsB));
 }
 
 std::bitset<128> constructCCTagViewDescriptor(const std::vector<feature::CCTAG_Regions::DescriptorT> & vCCTagDescriptors)
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "ILocalizer.hpp"
+#include "CCTagKeyFrameIndex.hpp"
 #include "LocalizationResult.hpp"
 #include "VoctreeLocalizer.hpp"
 #include <aliceVision/config.hpp>
@@ -161,6 +162,9 @@ private:
   /// @warning: descType needs to be a CCTAG_Regions
   feature::EImageDescriberType _cctagDescType = feature::EImageDescriberType::CCTAG3;
 
+  /// the markers seen by each view, to retrieve and match the keyframes
+  CCTagKeyFrameIndex _keyFrameIndex;
+
   // CUDA CCTag supports several parallel pipelines, where each one can
   // processing different image dimensions.
   int _cudaPipe = 0;
@@ -0,0 +1,236 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LocalizationServer.hpp"
+
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/image/io.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace localization {
+
+LocalizationServer::LocalizationServer(const VoctreeLocalizer& localizer,
+                                       const VoctreeLocalizer::Parameters& localizerParams,
+                                       const LocalizationServerParams& params)
+  : _localizer(localizer)
+  , _localizerParams(localizerParams)
+  , _params(params)
+{
+  if(!_localizer.isInit())
+    throw std::invalid_argument("LocalizationServer: the localizer is not initialized.");
+
+  for(const auto& imageDescriber : _localizer._imageDescribers)
+    _describerTypes.push_back(imageDescriber->getDescriberType());
+
+  const std::size_t nbWorkers = (_params.nbWorkers > 0) ? _params.nbWorkers : static_cast<std::size_t>(std::max(omp_get_max_threads(), 1));
+
+  ALICEVISION_LOG_INFO("Localization server started with " << nbWorkers << " worker(s)");
+
+  _workers.reserve(nbWorkers);
+  for(std::size_t i = 0; i < nbWorkers; ++i)
+    _workers.emplace_back(&LocalizationServer::work, this);
+}
+
+LocalizationServer::~LocalizationServer()
+{
+  stop();
+}
+
+IndexT LocalizationServer::submit(LocalizationRequest request)
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  _notFull.wait(lock, [this]{ return _stopped || _params.maxPendingRequests == 0 || _nbPendingRequests < _params.maxPendingRequests; });
+
+  if(_stopped)
+    throw std::logic_error("LocalizationServer: cannot submit a request to a stopped server.");
+
+  Job job;
+  job.requestId = _nextRequestId++;
+  job.request = std::move(request);
+  const IndexT requestId = job.requestId;
+  ++_nbPendingRequests;
+
+  if(job.request.cameraId != UndefinedIndexT)
+  {
+    CameraQueue& cameraQueue = _cameraQueues[job.request.cameraId];
+    if(cameraQueue.isActive)
+    {
+      // wait for the previous frames of the camera
+      cameraQueue.pendingJobs.push_back(std::move(job));
+      return requestId;
+    }
+    cameraQueue.isActive = true;
+  }
+
+  _readyJobs.push_back(std::move(job));
+  _jobReady.notify_one();
+  return requestId;
+}
+
+std::vector<IndexT> LocalizationServer::submit(std::vector<LocalizationRequest> requests)
+{
+  std::vector<IndexT> requestIds;
+  requestIds.reserve(requests.size());
+  for(LocalizationRequest& request : requests)
+    requestIds.push_back(submit(std::move(request)));
+  return requestIds;
+}
+
+bool LocalizationServer::waitResponse(LocalizationResponse& response)
+{
+  return _responses.pop(response);
+}
+
+void LocalizationServer::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopped = true;
+    _jobReady.notify_all();
+    _notFull.notify_all();
+  }
+
+  for(std::thread& worker : _workers)
+  {
+    if(worker.joinable())
+      worker.join();
+  }
+  _responses.close();
+}
+
+std::size_t LocalizationServer::getNbPendingRequests() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _nbPendingRequests;
+}
+
+void LocalizationServer::work()
+{
+  // the image describers are not thread-safe, each worker has its own ones
+  std::vector<std::unique_ptr<feature::ImageDescriber>> describers;
+  describers.reserve(_describerTypes.size());
+  for(const feature::EImageDescriberType describerType : _describerTypes)
+  {
+    describers.push_back(feature::createImageDescriber(describerType));
+    describers.back()->Set_configuration_preset(_localizerParams._featurePreset);
+  }
+
+  for(;;)
+  {
+    Job job;
+    CameraQueue* cameraQueue = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      // the pending requests of a camera become ready when the previous one is localized,
+      // so the workers only leave once all the requests are localized
+      _jobReady.wait(lock, [this]{ return _stopped || !_readyJobs.empty(); });
+      if(_readyJobs.empty())
+        return;
+
+      job = std::move(_readyJobs.front());
+      _readyJobs.pop_front();
+
+      if(job.request.cameraId != UndefinedIndexT)
+        cameraQueue = &_cameraQueues.at(job.request.cameraId);
+    }
+
+    LocalizationResponse response;
+    {
+      VoctreeLocalizer::Session independentSession;
+      VoctreeLocalizer::Session& session = cameraQueue ? cameraQueue->session : independentSession;
+
+      if(job.request.resetSession)
+        session = VoctreeLocalizer::Session();
+
+      process(job, describers, session, response);
+    }
+
+    // the response is available before the next frame of the camera is scheduled,
+    // so the responses of a camera are in order
+    _responses.push(std::move(response));
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if(cameraQueue)
+      {
+        if(cameraQueue->pendingJobs.empty())
+        {
+          cameraQueue->isActive = false;
+        }
+        else
+        {
+          _readyJobs.push_back(std::move(cameraQueue->pendingJobs.front()));
+          cameraQueue->pendingJobs.pop_front();
+          _jobReady.notify_one();
+        }
+      }
+      --_nbPendingRequests;
+      _notFull.notify_one();
+    }
+  }
+}
+
+void LocalizationServer::process(Job& job,
+                                 const std::vector<std::unique_ptr<feature::ImageDescriber>>& describers,
+                                 VoctreeLocalizer::Session& session,
+                                 LocalizationResponse& response) const
+{
+  LocalizationRequest& request = job.request;
+
+  response.requestId = job.requestId;
+  response.cameraId = request.cameraId;
+  response.frameId = request.frameId;
+  response.queueTime = job.timer.elapsedMs();
+
+  try
+  {
+    system::Timer timer;
+
+    if(request.regions.empty())
+    {
+      if(request.imagePath.empty())
+        throw std::invalid_argument("no image and no features");
+
+      image::Image<unsigned char> imageGrey;
+      image::readImage(request.imagePath, imageGrey);
+      request.imageSize = std::make_pair(imageGrey.Width(), imageGrey.Height());
+
+      for(const auto& describer : describers)
+      {
+        std::unique_ptr<feature::Regions>& regions = request.regions[describer->getDescriberType()];
+        describer->Allocate(regions);
+        describer->Describe(imageGrey, regions, nullptr);
+      }
+    }
+    response.featureTime = timer.elapsedMs();
+    timer.reset();
+
+    response.isLocalized = _localizer.localize(request.regions,
+                                               request.imageSize,
+                                               _localizerParams,
+                                               request.useInputIntrinsics,
+                                               request.intrinsics,
+                                               response.result,
+                                               session,
+                                               request.imagePath);
+    response.localizationTime = timer.elapsedMs();
+    response.stats = session.lastFrameStats;
+  }
+  catch(std::exception& e)
+  {
+    ALICEVISION_LOG_ERROR("Cannot localize request " << job.requestId << " (camera: " << request.cameraId
+                          << ", frame: " << request.frameId << "): " << e.what());
+    response.isLocalized = false;
+  }
+
+  response.latency = job.timer.elapsedMs();
+}
+
+} // namespace localization
+} // namespace aliceVision
@@ -0,0 +1,213 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "LocalizationResult.hpp"
+#include "VoctreeLocalizer.hpp"
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/camera/PinholeRadial.hpp>
+#include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/system/ConcurrentQueue.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+namespace localization {
+
+/**
+ * @brief A query to localize: an image to describe or its precomputed features.
+ */
+struct LocalizationRequest
+{
+  /// camera the query comes from: the requests of the same camera share a session
+  /// (frame buffer, tracking) and are localized in order, UndefinedIndexT for independent queries
+  IndexT cameraId = UndefinedIndexT;
+  /// user defined id of the frame, returned with the response
+  IndexT frameId = UndefinedIndexT;
+  /// forget the previous frames of the camera before localizing this one
+  bool resetSession = false;
+  /// path of the query image, read and described by the server if no features are given
+  std::string imagePath;
+  /// precomputed features of the query image
+  feature::MapRegionsPerDesc regions;
+  /// size of the query image, required with precomputed features
+  std::pair<std::size_t, std::size_t> imageSize = std::make_pair(0, 0);
+  /// use the given intrinsics as known calibration
+  bool useInputIntrinsics = false;
+  camera::PinholeRadialK3 intrinsics;
+};
+
+/**
+ * @brief The localization of a query and its timings (in ms).
+ */
+struct LocalizationResponse
+{
+  /// id given by the server at the submission
+  IndexT requestId = UndefinedIndexT;
+  IndexT cameraId = UndefinedIndexT;
+  IndexT frameId = UndefinedIndexT;
+  bool isLocalized = false;
+  LocalizationResult result;
+  /// timings and status of the localizer
+  VoctreeLocalizer::FrameStats stats;
+  /// time waiting in the queue, including the previous frames of the same camera
+  double queueTime = 0.0;
+  /// time to read and describe the query image
+  double featureTime = 0.0;
+  /// time to localize the query features
+  double localizationTime = 0.0;
+  /// time from the submission to the availability of the response
+  double latency = 0.0;
+};
+
+/**
+ * @brief LocalizationServer parameters.
+ */
+struct LocalizationServerParams
+{
+  /// number of worker threads (0 for the number of cores)
+  std::size_t nbWorkers = 0;
+  /// maximum number of requests submitted and not yet localized (0 for unbounded),
+  /// the submission waits while it is reached
+  std::size_t maxPendingRequests = 0;
+};
+
+/**
+ * @brief Localize queries from several cameras concurrently with a single localizer.
+ *
+ * The reconstruction, the regions and the vocabulary tree database of the localizer are
+ * shared by all the worker threads, each one has its own image describers.
+ * The mutable state of the localization (frame buffer, previous pose) is kept in one
+ * VoctreeLocalizer::Session per camera, so the frames of a camera are localized
+ * sequentially while different cameras are localized in parallel.
+ *
+ * Requests are submitted one by one or by batches, responses are retrieved in
+ * completion order (in submission order for the requests of the same camera).
+ */
+class LocalizationServer
+{
+public:
+
+  /**
+   * @brief Start the worker threads.
+   * @param[in] localizer The initialized localizer, it must outlive the server
+   * @param[in] localizerParams The parameters of the localization
+   * @param[in] params The server parameters
+   */
+  LocalizationServer(const VoctreeLocalizer& localizer,
+                     const VoctreeLocalizer::Parameters& localizerParams,
+                     const LocalizationServerParams& params = LocalizationServerParams());
+
+  /// Localize the pending requests and stop the worker threads
+  ~LocalizationServer();
+
+  LocalizationServer(const LocalizationServer&) = delete;
+  LocalizationServer& operator=(const LocalizationServer&) = delete;
+
+  /**
+   * @brief Submit a query, wait if the maximum number of pending requests is reached.
+   * @param[in] request The query to localize
+   * @return the id of the request, given back in the response
+   */
+  IndexT submit(LocalizationRequest request);
+
+  /**
+   * @brief Submit a batch of queries.
+   * @param[in] requests The queries to localize
+   * @return the ids of the requests
+   */
+  std::vector<IndexT> submit(std::vector<LocalizationRequest> requests);
+
+  /**
+   * @brief Get the next available response, wait if none is available.
+   * @param[out] response The response
+   * @return false if the server is stopped and all the responses have been retrieved
+   */
+  bool waitResponse(LocalizationResponse& response);
+
+  /**
+   * @brief Localize the pending requests and stop the worker threads.
+   * The remaining responses can still be retrieved with waitResponse.
+   */
+  void stop();
+
+  /// Get the number of requests submitted and not yet localized
+  std::size_t getNbPendingRequests() const;
+
+  /// Get the number of worker threads
+  std::size_t getNbWorkers() const
+  {
+    return _workers.size();
+  }
+
+private:
+
+  struct Job
+  {
+    IndexT requestId = UndefinedIndexT;
+    LocalizationRequest request;
+    /// started at the submission
+    system::Timer timer;
+  };
+
+  /// Session and queued requests of a camera
+  struct CameraQueue
+  {
+    VoctreeLocalizer::Session session;
+    /// requests waiting for the localization of the previous frame of the camera
+    std::deque<Job> pendingJobs;
+    /// a request of the camera is being localized
+    bool isActive = false;
+  };
+
+  /// worker thread main loop
+  void work();
+
+  /**
+   * @brief Describe the query if needed and localize it.
+   * @param[in,out] job The request, its features are computed if not given
+   * @param[in] describers The image describers of the worker
+   * @param[in,out] session The session of the camera
+   * @param[out] response The response
+   */
+  void process(Job& job,
+               const std::vector<std::unique_ptr<feature::ImageDescriber>>& describers,
+               VoctreeLocalizer::Session& session,
+               LocalizationResponse& response) const;
+
+  const VoctreeLocalizer& _localizer;
+  VoctreeLocalizer::Parameters _localizerParams;
+  LocalizationServerParams _params;
+  std::vector<feature::EImageDescriberType> _describerTypes;
+
+  mutable std::mutex _mutex;
+  std::condition_variable _jobReady;
+  std::condition_variable _notFull;
+  /// requests ready to be localized: independent ones and the first one of each inactive camera
+  std::deque<Job> _readyJobs;
+  /// node based container: the sessions are used outside of the lock
+  std::map<IndexT, CameraQueue> _cameraQueues;
+  IndexT _nextRequestId = 0;
+  std::size_t _nbPendingRequests = 0;
+  bool _stopped = false;
+
+  system::ConcurrentQueue<LocalizationResponse> _responses;
+  std::vector<std::thread> _workers;
+};
+
+} // namespace localization
+} // namespace aliceVision
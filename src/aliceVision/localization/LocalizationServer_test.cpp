@@ -0,0 +1,176 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LocalizationServer.hpp"
+#include "localizerTestScene.hpp"
+
+#include <cmath>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#define BOOST_TEST_MODULE LocalizationServer
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::localization;
+
+VoctreeLocalizer::Parameters getLocalizerParameters()
+{
+  VoctreeLocalizer::Parameters param;
+  param._algorithm = VoctreeLocalizer::Algorithm::AllResults;
+  param._numResults = 4;
+  param._nbFrameBufferMatching = 2;
+  param._ccTagUseCuda = false;
+  param._errorMax = 4.0;
+  param._matchingError = 4.0;
+  return param;
+}
+
+/**
+ * @brief Create a request with the precomputed features of a pose on the ring of the scene,
+ *        each camera moves along the ring from its own starting position.
+ */
+LocalizationRequest createRequest(const LocalizerTestScene& scene, IndexT cameraId, IndexT frameId)
+{
+  const double startAngle = (cameraId == UndefinedIndexT) ? 0.0 : cameraId * 2.0 * M_PI / 3.0;
+  const geometry::Pose3 pose = scene.getRingPose(startAngle + 0.05 * (frameId + 1));
+
+  LocalizationRequest request;
+  request.cameraId = cameraId;
+  request.frameId = frameId;
+  request.regions = scene.createQueryRegions(pose);
+  request.imageSize = scene.getImageSize();
+  request.useInputIntrinsics = true;
+  request.intrinsics = scene.getIntrinsics();
+  return request;
+}
+
+BOOST_AUTO_TEST_CASE(LocalizationServer_cameraOrder)
+{
+  const LocalizerTestScene scene(12, 150);
+  const VoctreeLocalizer localizer(scene.sfmDataFilepath, scene.folder, scene.voctreeFilepath, "", {scene.descType});
+  BOOST_REQUIRE(localizer.isInit());
+
+  const std::size_t nbCameras = 3;
+  const std::size_t nbFrames = 6;
+
+  LocalizationServerParams serverParams;
+  serverParams.nbWorkers = 4;
+
+  std::vector<LocalizationResponse> responses;
+  {
+    LocalizationServer server(localizer, getLocalizerParameters(), serverParams);
+    BOOST_CHECK_EQUAL(server.getNbWorkers(), 4);
+
+    std::thread consumer([&]()
+    {
+      LocalizationResponse response;
+      while(server.waitResponse(response))
+        responses.push_back(std::move(response));
+    });
+
+    // the frames of the cameras are interleaved
+    for(std::size_t f = 0; f < nbFrames; ++f)
+      for(std::size_t c = 0; c < nbCameras; ++c)
+        server.submit(createRequest(scene, c, f));
+
+    server.stop();
+    consumer.join();
+  }
+
+  BOOST_CHECK_EQUAL(responses.size(), nbCameras * nbFrames);
+
+  // the responses of a camera are in submission order
+  std::map<IndexT, std::vector<IndexT>> framesPerCamera;
+  std::map<IndexT, IndexT> lastRequestPerCamera;
+  for(const LocalizationResponse& response : responses)
+  {
+    BOOST_CHECK(response.isLocalized);
+    if(lastRequestPerCamera.count(response.cameraId))
+      BOOST_CHECK_LT(lastRequestPerCamera.at(response.cameraId), response.requestId);
+    lastRequestPerCamera[response.cameraId] = response.requestId;
+    framesPerCamera[response.cameraId].push_back(response.frameId);
+  }
+
+  BOOST_CHECK_EQUAL(framesPerCamera.size(), nbCameras);
+  for(const auto& frames : framesPerCamera)
+  {
+    BOOST_REQUIRE_EQUAL(frames.second.size(), nbFrames);
+    for(std::size_t f = 0; f < nbFrames; ++f)
+      BOOST_CHECK_EQUAL(frames.second[f], f);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(LocalizationServer_maxPendingRequests)
+{
+  const LocalizerTestScene scene(12, 150);
+  const VoctreeLocalizer localizer(scene.sfmDataFilepath, scene.folder, scene.voctreeFilepath, "", {scene.descType});
+  BOOST_REQUIRE(localizer.isInit());
+
+  const std::size_t nbRequests = 20;
+
+  LocalizationServerParams serverParams;
+  serverParams.nbWorkers = 1;
+  serverParams.maxPendingRequests = 2;
+
+  LocalizationServer server(localizer, getLocalizerParameters(), serverParams);
+
+  // the requests are submitted much faster than they are localized:
+  // the submission waits for the worker each time the server is full
+  for(std::size_t i = 0; i < nbRequests; ++i)
+  {
+    server.submit(createRequest(scene, UndefinedIndexT, i));
+    BOOST_CHECK_LE(server.getNbPendingRequests(), serverParams.maxPendingRequests);
+  }
+
+  server.stop();
+  BOOST_CHECK_EQUAL(server.getNbPendingRequests(), 0);
+
+  std::size_t nbResponses = 0;
+  LocalizationResponse response;
+  while(server.waitResponse(response))
+    ++nbResponses;
+  BOOST_CHECK_EQUAL(nbResponses, nbRequests);
+}
+
+BOOST_AUTO_TEST_CASE(LocalizationServer_stop)
+{
+  const LocalizerTestScene scene(12, 150);
+  const VoctreeLocalizer localizer(scene.sfmDataFilepath, scene.folder, scene.voctreeFilepath, "", {scene.descType});
+  BOOST_REQUIRE(localizer.isInit());
+
+  LocalizationServerParams serverParams;
+  serverParams.nbWorkers = 2;
+
+  LocalizationServer server(localizer, getLocalizerParameters(), serverParams);
+
+  // requests of cameras and independent requests, nothing is retrieved before the stop
+  // the requests are not copyable, the vector is not resized
+  std::vector<LocalizationRequest> requests(12);
+  for(std::size_t f = 0; f < 4; ++f)
+  {
+    requests[3 * f] = createRequest(scene, 0, f);
+    requests[3 * f + 1] = createRequest(scene, 1, f);
+    requests[3 * f + 2] = createRequest(scene, UndefinedIndexT, f);
+  }
+  const std::vector<IndexT> requestIds = server.submit(std::move(requests));
+  BOOST_CHECK_EQUAL(requestIds.size(), 12);
+
+  // all the pending requests are localized before the workers stop
+  server.stop();
+  BOOST_CHECK_EQUAL(server.getNbPendingRequests(), 0);
+  BOOST_CHECK_THROW(server.submit(createRequest(scene, 0, 4)), std::logic_error);
+
+  std::set<IndexT> responseIds;
+  LocalizationResponse response;
+  while(server.waitResponse(response))
+    BOOST_CHECK(responseIds.insert(response.requestId).second);
+
+  BOOST_CHECK(responseIds == std::set<IndexT>(requestIds.begin(), requestIds.end()));
+  BOOST_CHECK(!server.waitResponse(response));
+}
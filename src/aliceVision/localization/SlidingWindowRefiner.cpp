@@ -0,0 +1,287 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "SlidingWindowRefiner.hpp"
+#include <aliceVision/sfm/ResidualErrorFunctor.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <ceres/ceres.h>
+#include <ceres/rotation.h>
+
+#include <algorithm>
+
+namespace aliceVision {
+namespace localization {
+
+namespace {
+
+/**
+ * @brief Constant velocity prior on three consecutive poses.
+ *
+ * The residual is the difference of the velocities (pose2 - pose1) / dt21 and (pose1 - pose0) / dt10,
+ * weighted so that the rotation and translation residuals are expressed in pixels.
+ */
+struct ConstantVelocityPriorFunctor
+{
+  ConstantVelocityPriorFunctor(double rotationWeight, double translationWeight, double dt10, double dt21)
+    : _rotationWeight(rotationWeight)
+    , _translationWeight(translationWeight)
+    , _dt10(dt10)
+    , _dt21(dt21)
+  {}
+
+  template <typename T>
+  bool operator()(const T* const pose0, const T* const pose1, const T* const pose2, T* residuals) const
+  {
+    for(int i = 0; i < 6; ++i)
+    {
+      const T weight = T(i < 3 ? _rotationWeight : _translationWeight);
+      residuals[i] = weight * ((pose2[i] - pose1[i]) / T(_dt21) - (pose1[i] - pose0[i]) / T(_dt10));
+    }
+    return true;
+  }
+
+  double _rotationWeight;
+  double _translationWeight;
+  double _dt10;
+  double _dt21;
+};
+
+std::array<double, 6> poseToParams(const geometry::Pose3& pose)
+{
+  std::array<double, 6> params;
+  const Mat3 R = pose.rotation();
+  const Vec3 t = pose.translation();
+  ceres::RotationMatrixToAngleAxis(static_cast<const double*>(R.data()), params.data());
+  params[3] = t(0);
+  params[4] = t(1);
+  params[5] = t(2);
+  return params;
+}
+
+geometry::Pose3 paramsToPose(const std::array<double, 6>& params)
+{
+  Mat3 R;
+  ceres::AngleAxisToRotationMatrix(params.data(), R.data());
+  const Vec3 t(params[3], params[4], params[5]);
+  return geometry::Pose3(R, -R.transpose() * t);
+}
+
+} // namespace
+
+bool SlidingWindowRefiner::addFrame(IndexT frameId, LocalizationResult& localizationResult)
+{
+  if(!localizationResult.isValid() || localizationResult.getInliers().size() < _options.minNbInliers)
+    return false;
+
+  if(!_window.empty() && frameId <= _window.back().frameId)
+  {
+    ALICEVISION_LOG_WARNING("[SlidingWindowRefiner] Frame " << frameId << " is not after the last frame of the window, ignored.");
+    return false;
+  }
+
+  system::Timer timer;
+
+  const geometry::Pose3& pose = localizationResult.getPose();
+  const std::vector<double> intrinsics = localizationResult.getIntrinsics().getParams();
+  assert(intrinsics.size() == 6);
+
+  Frame frame;
+  frame.frameId = frameId;
+  frame.pose = poseToParams(pose);
+  std::copy(intrinsics.begin(), intrinsics.end(), frame.intrinsics.begin());
+
+  if(_options.refineIntrinsics && _intrinsics.empty())
+    _intrinsics = intrinsics;
+
+  // inliers observations and median depth
+  {
+    const Mat& pt2D = localizationResult.getPt2D();
+    const Mat& pt3D = localizationResult.getPt3D();
+    const std::vector<std::size_t>& inliers = localizationResult.getInliers();
+
+    frame.points2D.reserve(2 * inliers.size());
+    frame.points3D.reserve(3 * inliers.size());
+
+    std::vector<double> depths;
+    depths.reserve(inliers.size());
+
+    for(const std::size_t idx : inliers)
+    {
+      frame.points2D.push_back(pt2D(0, idx));
+      frame.points2D.push_back(pt2D(1, idx));
+      frame.points3D.push_back(pt3D(0, idx));
+      frame.points3D.push_back(pt3D(1, idx));
+      frame.points3D.push_back(pt3D(2, idx));
+
+      const double depth = pose.depth(pt3D.col(idx));
+      if(depth > 0.0)
+        depths.push_back(depth);
+    }
+
+    frame.depth = 1.0;
+    if(!depths.empty())
+    {
+      std::nth_element(depths.begin(), depths.begin() + depths.size() / 2, depths.end());
+      frame.depth = depths[depths.size() / 2];
+    }
+  }
+
+  _window.push_back(std::move(frame));
+
+  // marginalize the frames leaving the window
+  while(_window.size() > std::max<std::size_t>(_options.windowSize, 1))
+  {
+    Frame& oldest = _window.front();
+    oldest.points2D.clear();
+    oldest.points2D.shrink_to_fit();
+    oldest.points3D.clear();
+    oldest.points3D.shrink_to_fit();
+
+    _marginalized.push_back(std::move(oldest));
+    _window.pop_front();
+
+    if(_marginalized.size() > 2)
+      _marginalized.pop_front();
+  }
+
+  const bool isRefined = solve();
+
+  if(isRefined)
+  {
+    for(const Frame& f : _window)
+      _poses[f.frameId] = paramsToPose(f.pose);
+
+    localizationResult.setPose(_poses.at(frameId));
+
+    if(_options.refineIntrinsics)
+      localizationResult.updateIntrinsics(_intrinsics);
+  }
+  else
+  {
+    ALICEVISION_LOG_WARNING("[SlidingWindowRefiner] Unable to refine frame " << frameId << ".");
+    _poses[frameId] = pose;
+  }
+
+  _lastLatency = timer.elapsedMs();
+  _sumLatency += _lastLatency;
+  _maxLatency = std::max(_maxLatency, _lastLatency);
+  ++_nbRefinedFrames;
+
+  return isRefined;
+}
+
+void SlidingWindowRefiner::clear()
+{
+  _window.clear();
+  _marginalized.clear();
+  _intrinsics.clear();
+  _poses.clear();
+  _lastLatency = 0.0;
+  _sumLatency = 0.0;
+  _maxLatency = 0.0;
+  _nbRefinedFrames = 0;
+}
+
+bool SlidingWindowRefiner::solve()
+{
+  // keep the current parameters to restore them if the solution is not usable
+  std::vector<std::array<double, 6>> initialPoses;
+  initialPoses.reserve(_window.size());
+  for(const Frame& frame : _window)
+    initialPoses.push_back(frame.pose);
+  const std::vector<double> initialIntrinsics = _intrinsics;
+
+  ceres::Problem problem;
+  ceres::LossFunction* lossFunction = new ceres::HuberLoss(Square(4.0));
+
+  // reprojection errors of the frames of the window
+  for(Frame& frame : _window)
+  {
+    double* intrinsics = _options.refineIntrinsics ? _intrinsics.data() : frame.intrinsics.data();
+
+    problem.AddParameterBlock(frame.pose.data(), 6);
+    problem.AddParameterBlock(intrinsics, 6);
+
+    if(!_options.refineIntrinsics)
+      problem.SetParameterBlockConstant(intrinsics);
+
+    const std::size_t nbPoints = frame.points2D.size() / 2;
+    for(std::size_t i = 0; i < nbPoints; ++i)
+    {
+      double* point = &frame.points3D[3 * i];
+
+      ceres::CostFunction* costFunction = new ceres::AutoDiffCostFunction<sfm::ResidualErrorFunctor_PinholeRadialK3, 2, 6, 6, 3>(
+        new sfm::ResidualErrorFunctor_PinholeRadialK3(&frame.points2D[2 * i]));
+
+      problem.AddResidualBlock(costFunction, lossFunction, intrinsics, frame.pose.data(), point);
+      problem.SetParameterBlockConstant(point);
+    }
+  }
+
+  // constant velocity prior, anchored on the marginalized frames
+  if(_options.smoothingWeight > 0.0)
+  {
+    std::vector<Frame*> frames;
+    frames.reserve(_marginalized.size() + _window.size());
+
+    for(Frame& frame : _marginalized)
+    {
+      problem.AddParameterBlock(frame.pose.data(), 6);
+      problem.SetParameterBlockConstant(frame.pose.data());
+      frames.push_back(&frame);
+    }
+    for(Frame& frame : _window)
+      frames.push_back(&frame);
+
+    for(std::size_t i = 2; i < frames.size(); ++i)
+    {
+      Frame& frame0 = *frames[i - 2];
+      Frame& frame1 = *frames[i - 1];
+      Frame& frame2 = *frames[i];
+
+      // express the prior in pixels: a rotation of 1 rad moves the image by ~focal pixels,
+      // a translation of 1 unit moves it by ~focal / depth pixels
+      const double focal = _options.refineIntrinsics ? _intrinsics[0] : frame2.intrinsics[0];
+      const double rotationWeight = _options.smoothingWeight * focal;
+      const double translationWeight = _options.smoothingWeight * focal / frame2.depth;
+
+      ceres::CostFunction* costFunction = new ceres::AutoDiffCostFunction<ConstantVelocityPriorFunctor, 6, 6, 6, 6>(
+        new ConstantVelocityPriorFunctor(rotationWeight, translationWeight,
+                                         static_cast<double>(frame1.frameId - frame0.frameId),
+                                         static_cast<double>(frame2.frameId - frame1.frameId)));
+
+      problem.AddResidualBlock(costFunction, nullptr, frame0.pose.data(), frame1.pose.data(), frame2.pose.data());
+    }
+  }
+
+  ceres::Solver::Options options;
+  options.linear_solver_type = ceres::DENSE_QR;
+  options.max_num_iterations = _options.maxIterations;
+  if(_options.maxSolverTime > 0.0)
+    options.max_solver_time_in_seconds = _options.maxSolverTime;
+  options.minimizer_progress_to_stdout = false;
+  options.logging_type = ceres::SILENT;
+  options.num_threads = 1;
+  options.num_linear_solver_threads = 1;
+
+  ceres::Solver::Summary summary;
+  ceres::Solve(options, &problem, &summary);
+
+  ALICEVISION_LOG_TRACE(summary.BriefReport());
+
+  if(!summary.IsSolutionUsable())
+  {
+    for(std::size_t i = 0; i < _window.size(); ++i)
+      _window[i].pose = initialPoses[i];
+    _intrinsics = initialIntrinsics;
+    return false;
+  }
+  return true;
+}
+
+} // namespace localization
+} // namespace aliceVision
@@ -0,0 +1,146 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "LocalizationResult.hpp"
+#include <aliceVision/geometry/Pose3.hpp>
+#include <aliceVision/types.hpp>
+
+#include <array>
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace aliceVision {
+namespace localization {
+
+/**
+ * @brief Online refinement of a localized sequence on a sliding window of frames.
+ *
+ * Each new frame is refined with the 2D-3D inliers of the last frames:
+ * - the poses of the frames of the window (and optionally their shared intrinsics) are refined,
+ * - the 3D points of the map are constant,
+ * - a constant velocity prior links consecutive frames (temporal smoothing).
+ *
+ * The frames leaving the window are marginalized: their pose is frozen, and the two
+ * last ones anchor the velocity prior of the window.
+ * The size of the problem only depends on the window size, so the refinement time
+ * of a frame does not grow with the length of the sequence.
+ */
+class SlidingWindowRefiner
+{
+public:
+
+  struct Options
+  {
+    /// number of frames of the sliding window
+    std::size_t windowSize = 10;
+    /// refine the intrinsics shared by the frames
+    bool refineIntrinsics = false;
+    /// weight of the constant velocity prior, relative to a reprojection error of 1 pixel (0 to disable)
+    double smoothingWeight = 1.0;
+    /// maximum number of iterations of the solver per frame
+    int maxIterations = 10;
+    /// maximum solver time per frame in seconds (0 for no limit)
+    double maxSolverTime = 0.0;
+    /// minimum number of inliers of a frame to be refined
+    std::size_t minNbInliers = 10;
+  };
+
+  SlidingWindowRefiner()
+  {}
+
+  explicit SlidingWindowRefiner(const Options& options)
+    : _options(options)
+  {}
+
+  /**
+   * @brief Add a localized frame and refine the sliding window.
+   * @param[in] frameId The frame id, increasing along the sequence
+   * @param[in,out] localizationResult The localization of the frame, its pose
+   * (and its intrinsics if refineIntrinsics) are updated with the refined values
+   * @return true if the frame has been refined
+   */
+  bool addFrame(IndexT frameId, LocalizationResult& localizationResult);
+
+  /// Remove all the frames
+  void clear();
+
+  /**
+   * @brief Get the current poses of all the refined frames.
+   * The poses of the frames still in the window may be refined again by the next frames.
+   */
+  const std::map<IndexT, geometry::Pose3>& getPoses() const
+  {
+    return _poses;
+  }
+
+  /// Get the refined intrinsics parameters (valid if refineIntrinsics and at least one frame has been refined)
+  const std::vector<double>& getIntrinsics() const
+  {
+    return _intrinsics;
+  }
+
+  /// Get the refinement time of the last frame (ms)
+  double getLastLatency() const
+  {
+    return _lastLatency;
+  }
+
+  /// Get the mean refinement time per frame (ms)
+  double getMeanLatency() const
+  {
+    return (_nbRefinedFrames > 0) ? _sumLatency / _nbRefinedFrames : 0.0;
+  }
+
+  /// Get the max refinement time per frame (ms)
+  double getMaxLatency() const
+  {
+    return _maxLatency;
+  }
+
+  /// Get the number of refined frames
+  std::size_t getNbRefinedFrames() const
+  {
+    return _nbRefinedFrames;
+  }
+
+private:
+
+  /// Frame of the sliding window
+  struct Frame
+  {
+    IndexT frameId;
+    /// pose parameters: angle axis rotation, translation
+    std::array<double, 6> pose;
+    /// PinholeRadialK3 parameters: focal, principal point, k1, k2, k3
+    std::array<double, 6> intrinsics;
+    /// median depth of the inliers, to express the translation prior in pixels
+    double depth;
+    /// inliers observations (x, y) and 3D points (X, Y, Z)
+    std::vector<double> points2D;
+    std::vector<double> points3D;
+  };
+
+  /// Solve the window, return false if the solution is not usable
+  bool solve();
+
+  Options _options;
+  std::deque<Frame> _window;
+  /// last marginalized frames (at most 2, without observations), oldest first
+  std::deque<Frame> _marginalized;
+  /// shared intrinsics if refineIntrinsics
+  std::vector<double> _intrinsics;
+  std::map<IndexT, geometry::Pose3> _poses;
+
+  double _lastLatency = 0.0;
+  double _sumLatency = 0.0;
+  double _maxLatency = 0.0;
+  std::size_t _nbRefinedFrames = 0;
+};
+
+} // namespace localization
+} // namespace aliceVision
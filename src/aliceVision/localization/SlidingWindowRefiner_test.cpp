@@ -0,0 +1,102 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "SlidingWindowRefiner.hpp"
+#include <aliceVision/camera/PinholeRadial.hpp>
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/sfm/pipeline/localization/SfMLocalizer.hpp>
+
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE SlidingWindowRefiner
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+
+/**
+ * @brief Generate the localization of a camera moving at constant velocity,
+ * with noisy observations and a noisy initial pose.
+ */
+localization::LocalizationResult generateFrame(const geometry::Pose3& pose,
+                                               const camera::PinholeRadialK3& intrinsics,
+                                               const Mat3X& points,
+                                               std::mt19937& generator)
+{
+  std::normal_distribution<double> pixelNoise(0.0, 0.5);
+  std::normal_distribution<double> centerNoise(0.0, 0.05);
+
+  sfm::ImageLocalizerMatchData data;
+  data.pt3D = points;
+  data.pt2D = Mat(2, points.cols());
+
+  std::vector<localization::IndMatch3D2D> indMatch3D2D;
+
+  for(Mat::Index i = 0; i < points.cols(); ++i)
+  {
+    const Vec2 pt = intrinsics.project(pose, points.col(i));
+    data.pt2D(0, i) = pt(0) + pixelNoise(generator);
+    data.pt2D(1, i) = pt(1) + pixelNoise(generator);
+    data.vec_inliers.push_back(i);
+    indMatch3D2D.emplace_back(i, feature::EImageDescriberType::UNKNOWN, i);
+  }
+
+  const geometry::Pose3 noisyPose(pose.rotation(), pose.center() + Vec3(centerNoise(generator), centerNoise(generator), centerNoise(generator)));
+
+  return localization::LocalizationResult(data, indMatch3D2D, noisyPose, intrinsics, {}, true);
+}
+
+BOOST_AUTO_TEST_CASE(SlidingWindowRefiner_constantVelocity)
+{
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<double> coordinate(-5.0, 5.0);
+  std::uniform_real_distribution<double> depth(8.0, 12.0);
+
+  const camera::PinholeRadialK3 intrinsics(640, 480, 800, 320, 240, 0.0, 0.0, 0.0);
+
+  Mat3X points(3, 100);
+  for(Mat::Index i = 0; i < points.cols(); ++i)
+    points.col(i) = Vec3(coordinate(generator), coordinate(generator), depth(generator));
+
+  localization::SlidingWindowRefiner::Options options;
+  options.windowSize = 5;
+  localization::SlidingWindowRefiner refiner(options);
+
+  const std::size_t nbFrames = 30;
+  std::vector<geometry::Pose3> groundTruth;
+  double initialError = 0.0;
+  double refinedError = 0.0;
+
+  for(std::size_t frameId = 0; frameId < nbFrames; ++frameId)
+  {
+    const geometry::Pose3 pose(RotationAroundY(0.005 * frameId), Vec3(0.05 * frameId, 0.0, 0.0));
+    groundTruth.push_back(pose);
+
+    localization::LocalizationResult result = generateFrame(pose, intrinsics, points, generator);
+    initialError += (result.getPose().center() - pose.center()).norm();
+
+    BOOST_CHECK(refiner.addFrame(frameId, result));
+    BOOST_CHECK_GE(refiner.getLastLatency(), 0.0);
+  }
+
+  BOOST_CHECK_EQUAL(refiner.getNbRefinedFrames(), nbFrames);
+  BOOST_CHECK_EQUAL(refiner.getPoses().size(), nbFrames);
+  BOOST_CHECK_LE(refiner.getMeanLatency(), refiner.getMaxLatency());
+
+  for(const auto& posePair : refiner.getPoses())
+    refinedError += (posePair.second.center() - groundTruth.at(posePair.first).center()).norm();
+
+  // the refined poses are closer to the ground truth than the initial ones
+  BOOST_CHECK_LT(refinedError, 0.5 * initialError);
+
+  // frames in the past of the window are rejected
+  localization::LocalizationResult result = generateFrame(groundTruth.front(), intrinsics, points, generator);
+  BOOST_CHECK(!refiner.addFrame(0, result));
+
+  refiner.clear();
+  BOOST_CHECK(refiner.getPoses().empty());
+  BOOST_CHECK_EQUAL(refiner.getNbRefinedFrames(), 0);
+}
@@ -28,11 +28,73 @@
 #include <boost/filesystem.hpp>
 
 #include <algorithm>
+#include <array>
 #include <chrono>
 
 namespace aliceVision {
 namespace localization {
 
+namespace {
+
+/**
+ * @brief Whether the describer detects markers: the marker describers share
+ * the CUDA pipe of the localizer and cannot run concurrently.
+ */
+bool isMarkerDescriber(feature::EImageDescriberType describerType)
+{
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
+  return describerType == feature::EImageDescriberType::CCTAG3 ||
+         describerType == feature::EImageDescriberType::CCTAG4;
+#else
+  (void)describerType;
+  return false;
+#endif
+}
+
+/// Spread the 10 lower bits of a value every 3 bits
+uint32_t spreadBits(uint32_t v)
+{
+  v = (v * 0x00010001u) & 0xFF0000FFu;
+  v = (v * 0x00000101u) & 0x0F00F00Fu;
+  v = (v * 0x00000011u) & 0xC30C30C3u;
+  v = (v * 0x00000005u) & 0x49249249u;
+  return v;
+}
+
+/// Morton code of a point quantized on a 1024^3 grid over its bounding box
+uint32_t mortonCode(const Vec3& point, const Vec3& minBound, const Vec3& scale)
+{
+  const Vec3 cell = ((point - minBound).cwiseProduct(scale)).cwiseMax(0.0).cwiseMin(1023.0);
+  return (spreadBits(static_cast<uint32_t>(cell(0))) << 2) |
+         (spreadBits(static_cast<uint32_t>(cell(1))) << 1) |
+          spreadBits(static_cast<uint32_t>(cell(2)));
+}
+
+/**
+ * @brief Position of a bounding sphere relative to the frustum of a camera.
+ * @param[in] center The sphere center in camera coordinates
+ * @param[in] radius The sphere radius
+ * @param[in] planes The normals of the 4 side planes of the frustum, pointing inside
+ * @return -1 if no point of the sphere is in the image, 1 if all of them are, 0 otherwise
+ */
+int classifySphere(const Vec3& center, double radius, const std::array<Vec3, 4>& planes)
+{
+  if(center(2) <= -radius)
+    return -1;
+  int position = (center(2) > radius) ? 1 : 0;
+  for(const Vec3& normal : planes)
+  {
+    const double distance = normal.dot(center);
+    if(distance < -radius)
+      return -1;
+    if(distance <= radius)
+      position = 0;
+  }
+  return position;
+}
+
+} // namespace
+
 std::ostream& operator<<( std::ostream& os, const voctree::Document &doc )	
 {
   os << "[ ";
@@ -123,7 +185,6 @@ VoctreeLocalizer::VoctreeLocalizer(const std::string &sfmFilePath,
                                    const std::string &weightsFilepath,
                                    const std::vector<feature::EImageDescriberType>& matchingDescTypes)
   : ILocalizer()
-  , _frameBuffer(5)
 {
   using namespace aliceVision::feature;
 
@@ -175,29 +236,97 @@ bool VoctreeLocalizer::localize(const feature::MapRegionsPerDesc & queryRegions,
     // error!
     throw std::invalid_argument("The parameters are not in the right format!!");
   }
-  
-  switch(voctreeParam->_algorithm)
+
+  return localize(queryRegions,
+                  imageSize,
+                  *voctreeParam,
+                  useInputIntrinsics,
+                  queryIntrinsics,
+                  localizationResult,
+                  _session,
+                  imagePath);
+}
+
+bool VoctreeLocalizer::localize(const feature::MapRegionsPerDesc & queryRegions,
+                                const std::pair<std::size_t, std::size_t> &imageSize,
+                                const Parameters &param,
+                                bool useInputIntrinsics,
+                                camera::PinholeRadialK3 &queryIntrinsics,
+                                LocalizationResult & localizationResult,
+                                Session &session,
+                                const std::string& imagePath) const
+{
+  session.lastFrameStats = FrameStats();
+  FrameStats& frameStats = session.lastFrameStats;
+  bool isLocalized = false;
+
+  // tracking mode: try first with the views seen from the previous pose
+  if(param._useTemporalPrior && session.hasPreviousPose)
+  {
+    frameStats.isTrackingAttempt = true;
+    isLocalized = localizeTemporalPrior(queryRegions,
+                                        imageSize,
+                                        param,
+                                        useInputIntrinsics,
+                                        queryIntrinsics,
+                                        localizationResult,
+                                        session,
+                                        imagePath);
+    frameStats.isTracked = isLocalized;
+
+    if(!isLocalized)
+      ALICEVISION_LOG_DEBUG("[tracking]\tTracking from the previous pose failed, fallback on the voctree retrieval");
+  }
+
+  if(!isLocalized)
   {
-    case Algorithm::FirstBest:
-    return localizeFirstBestResult(queryRegions,
-                                   imageSize,
-                                   *voctreeParam,
-                                   useInputIntrinsics,
-                                   queryIntrinsics,
-                                   localizationResult,
-                                   imagePath);
-    case Algorithm::BestResult: throw std::invalid_argument("BestResult not yet implemented");
-    case Algorithm::AllResults:
-    return localizeAllResults(queryRegions,
-                              imageSize,
-                              *voctreeParam,
-                              useInputIntrinsics,
-                              queryIntrinsics,
-                              localizationResult,
-                              imagePath);
-    case Algorithm::Cluster: throw std::invalid_argument("Cluster not yet implemented");
-    default: throw std::invalid_argument("Unknown algorithm type");
+    switch(param._algorithm)
+    {
+      case Algorithm::FirstBest:
+        isLocalized = localizeFirstBestResult(queryRegions,
+                                              imageSize,
+                                              param,
+                                              useInputIntrinsics,
+                                              queryIntrinsics,
+                                              localizationResult,
+                                              session,
+                                              imagePath);
+        break;
+      case Algorithm::BestResult: throw std::invalid_argument("BestResult not yet implemented");
+      case Algorithm::AllResults:
+        isLocalized = localizeAllResults(queryRegions,
+                                         imageSize,
+                                         param,
+                                         useInputIntrinsics,
+                                         queryIntrinsics,
+                                         localizationResult,
+                                         session,
+                                         imagePath);
+        break;
+      case Algorithm::Cluster: throw std::invalid_argument("Cluster not yet implemented");
+      default: throw std::invalid_argument("Unknown algorithm type");
+    }
   }
+
+  // keep the pose for the tracking of the next frame
+  session.hasPreviousPose = isLocalized;
+  if(isLocalized)
+  {
+    session.previousPose = localizationResult.getPose();
+    session.previousIntrinsics = localizationResult.getIntrinsics();
+  }
+
+  frameStats.isLocalized = isLocalized;
+  SequenceStats& sequenceStats = session.sequenceStats;
+  ++sequenceStats.nbFrames;
+  sequenceStats.nbLocalizedFrames += isLocalized;
+  sequenceStats.nbTrackingAttempts += frameStats.isTrackingAttempt;
+  sequenceStats.nbTrackedFrames += frameStats.isTracked;
+  sequenceStats.retrievalTime += frameStats.retrievalTime;
+  sequenceStats.matchingTime += frameStats.matchingTime;
+  sequenceStats.resectionTime += frameStats.resectionTime;
+
+  return isLocalized;
 }
 
 bool VoctreeLocalizer::localize(const image::Image<unsigned char> & imageGrey,
@@ -382,19 +511,85 @@ bool VoctreeLocalizer::initDatabase(const std::string & vocTreeFilepath,
       ++my_progress_bar;
     }
   }
+
+  buildVisibilityIndex();
   return true;
 }
 
+void VoctreeLocalizer::buildVisibilityIndex()
+{
+  _landmarksPerView.clear();
+  _landmarksPerView.reserve(_reconstructedRegionsMappingPerView.size());
+
+  for(const auto& mappingPerView : _reconstructedRegionsMappingPerView)
+  {
+    const IndexT viewId = mappingPerView.first;
+    if(!_sfm_data.IsPoseAndIntrinsicDefined(viewId))
+      continue;
+
+    std::size_t nbPoints = 0;
+    for(const auto& mappingPerDesc : mappingPerView.second)
+      nbPoints += mappingPerDesc.second._associated3dPoint.size();
+
+    if(nbPoints == 0)
+      continue;
+
+    Mat3X points(3, nbPoints);
+    std::size_t index = 0;
+    for(const auto& mappingPerDesc : mappingPerView.second)
+      for(const IndexT landmarkId : mappingPerDesc.second._associated3dPoint)
+        points.col(index++) = _sfm_data.GetLandmarks().at(landmarkId).X;
+
+    // sort the points along a Morton curve: consecutive points are close to each other
+    const Vec3 minBound = points.rowwise().minCoeff();
+    const Vec3 extent = points.rowwise().maxCoeff() - minBound;
+    const Vec3 scale = 1023.0 * extent.cwiseMax(1e-12).cwiseInverse();
+    std::vector<std::pair<uint32_t, Mat::Index>> sortedPoints(nbPoints);
+    for(Mat::Index j = 0; j < points.cols(); ++j)
+      sortedPoints[j] = std::make_pair(mortonCode(points.col(j), minBound, scale), j);
+    std::sort(sortedPoints.begin(), sortedPoints.end());
+
+    ViewLandmarks viewLandmarks;
+    viewLandmarks.viewId = viewId;
+    viewLandmarks.opticalAxis = _sfm_data.getPose(*_sfm_data.GetViews().at(viewId)).rotation().row(2).transpose();
+    viewLandmarks.points.resize(3, nbPoints);
+    for(std::size_t j = 0; j < nbPoints; ++j)
+      viewLandmarks.points.col(j) = points.col(sortedPoints[j].second);
+
+    // bounding sphere of consecutive points, centered on their bounding box
+    const auto computeChunk = [&viewLandmarks](Mat::Index begin, Mat::Index end)
+    {
+      const auto chunkPoints = viewLandmarks.points.middleCols(begin, end - begin);
+      LandmarksChunk chunk;
+      chunk.center = 0.5 * (chunkPoints.rowwise().minCoeff() + chunkPoints.rowwise().maxCoeff());
+      chunk.radius = (chunkPoints.colwise() - chunk.center).colwise().norm().maxCoeff();
+      chunk.begin = begin;
+      chunk.end = end;
+      return chunk;
+    };
+
+    const Mat::Index chunkSize = 64;
+    viewLandmarks.bounds = computeChunk(0, nbPoints);
+    for(Mat::Index begin = 0; begin < viewLandmarks.points.cols(); begin += chunkSize)
+      viewLandmarks.chunks.push_back(computeChunk(begin, std::min(begin + chunkSize, viewLandmarks.points.cols())));
+
+    _landmarksPerView.push_back(std::move(viewLandmarks));
+  }
+  ALICEVISION_LOG_DEBUG("Visibility index built for " << _landmarksPerView.size() << " views");
+}
+
 bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc &queryRegions,
                                                const std::pair<std::size_t, std::size_t> queryImageSize,
                                                const Parameters &param,
                                                bool useInputIntrinsics,
                                                camera::PinholeRadialK3 &queryIntrinsics,
                                                LocalizationResult &localizationResult,
-                                               const std::string& imagePath)
+                                               Session &session,
+                                               const std::string& imagePath) const
 {
   // A. Find the (visually) similar images in the database 
   ALICEVISION_LOG_DEBUG("[database]\tRequest closest images from voctree");
+  system::Timer timer;
   // pass the descriptors through the vocabulary tree to get the visual words
   // associated to each feature
   voctree::SparseHistogram requestImageWords = _voctree->quantizeToSparse(queryRegions.at(_voctreeDescType)->blindDescriptors());
@@ -402,6 +597,7 @@ bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc
   // Request closest images from voctree
   std::vector<voctree::DocMatch> matchedImages;
   _database.find(requestImageWords, param._numResults, matchedImages);
+  session.lastFrameStats.retrievalTime += timer.elapsedMs();
   
 //  // Debugging log
 //  // for each similar image found print score and number of features
@@ -454,6 +650,7 @@ bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc
 
     const camera::Pinhole *matchedIntrinsics = (const camera::Pinhole*)(matchedIntrinsicsBase);
     
+    timer.reset();
     matching::MatchesPerDescType featureMatches;
     bool matchWorked = robustMatching(matchers,
                                       // pass the input intrinsic if they are valid, null otherwise
@@ -468,6 +665,8 @@ bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc
                                       std::make_pair(matchedView->getWidth(), matchedView->getHeight()),
                                       featureMatches,
                                       param._matchingEstimator);
+    session.lastFrameStats.matchingTime += timer.elapsedMs();
+
     if (!matchWorked)
     {
       ALICEVISION_LOG_DEBUG("[matching]\tMatching with " << matchedView->getImagePath() << " failed! Skipping image");
@@ -535,6 +734,7 @@ bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc
     // Do the resectioning: compute the camera pose.
     resectionData.error_max = param._errorMax;
     ALICEVISION_LOG_DEBUG("[poseEstimation]\tEstimating camera pose...");
+    timer.reset();
     bool bResection = sfm::SfMLocalizer::Localize(queryImageSize,
                                                    // pass the input intrinsic if they are valid, null otherwise
                                                    (useInputIntrinsics) ? &queryIntrinsics : nullptr,
@@ -544,6 +744,7 @@ bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc
 
     if(!bResection)
     {
+      session.lastFrameStats.resectionTime += timer.elapsedMs();
       ALICEVISION_LOG_DEBUG("[poseEstimation]\tResection failed");
       // try next one
       continue;
@@ -577,6 +778,8 @@ bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc
                                                        resectionData, 
                                                        true /*b_refine_pose*/, 
                                                        param._refineIntrinsics /*b_refine_intrinsic*/);
+    session.lastFrameStats.resectionTime += timer.elapsedMs();
+
     if(!refineStatus)
     {
       ALICEVISION_LOG_DEBUG("[poseEstimation]\tRefine pose failed.");
@@ -610,27 +813,211 @@ bool VoctreeLocalizer::localizeAllResults(const feature::MapRegionsPerDesc &quer
                                           bool useInputIntrinsics,
                                           camera::PinholeRadialK3 &queryIntrinsics,
                                           LocalizationResult &localizationResult,
-                                          const std::string& imagePath)
+                                          Session &session,
+                                          const std::string& imagePath) const
+{
+  // find the (visually) similar images in the database
+  system::Timer timer;
+  std::vector<voctree::DocMatch> matchedImages;
+  queryDatabase(queryRegions, param, matchedImages);
+  session.lastFrameStats.retrievalTime += timer.elapsedMs();
+
+  const bool isLocalized = localizeFromViews(queryRegions,
+                                             queryImageSize,
+                                             param,
+                                             useInputIntrinsics,
+                                             queryIntrinsics,
+                                             matchedImages,
+                                             localizationResult,
+                                             session,
+                                             imagePath);
+
+  if(isLocalized && param._nbFrameBufferMatching > 0)
+  {
+    // add everything to the buffer
+    session.frameBuffer.emplace_back(localizationResult, queryRegions);
+  }
+
+  return isLocalized;
+}
+
+bool VoctreeLocalizer::localizeTemporalPrior(const feature::MapRegionsPerDesc &queryRegions,
+                                             const std::pair<std::size_t, std::size_t> queryImageSize,
+                                             const Parameters &param,
+                                             bool useInputIntrinsics,
+                                             camera::PinholeRadialK3 &queryIntrinsics,
+                                             LocalizationResult &localizationResult,
+                                             Session &session,
+                                             const std::string& imagePath) const
+{
+  // select the views that see the landmarks visible from the previous pose
+  system::Timer timer;
+  std::vector<voctree::DocMatch> selectedViews;
+  selectViewsFromPose(session.previousPose, session.previousIntrinsics, param._temporalPriorNbViews, selectedViews);
+  session.lastFrameStats.retrievalTime += timer.elapsedMs();
+
+  if(selectedViews.empty())
+  {
+    ALICEVISION_LOG_DEBUG("[tracking]\tNo view sees the landmarks visible from the previous pose");
+    return false;
+  }
+  ALICEVISION_LOG_DEBUG("[tracking]\t" << selectedViews.size() << " views selected from the previous pose");
+
+  // work on a copy of the intrinsics, they are only updated if the tracking succeeds
+  camera::PinholeRadialK3 trackingIntrinsics = queryIntrinsics;
+  LocalizationResult trackingResult;
+
+  if(!localizeFromViews(queryRegions,
+                        queryImageSize,
+                        param,
+                        useInputIntrinsics,
+                        trackingIntrinsics,
+                        selectedViews,
+                        trackingResult,
+                        session,
+                        imagePath))
+  {
+    return false;
+  }
+
+  if(trackingResult.getInliers().size() < param._temporalPriorMinInliers)
+  {
+    ALICEVISION_LOG_DEBUG("[tracking]\tNot enough inliers: " << trackingResult.getInliers().size()
+                          << " < " << param._temporalPriorMinInliers);
+    return false;
+  }
+
+  queryIntrinsics = trackingIntrinsics;
+  localizationResult = std::move(trackingResult);
+
+  if(param._nbFrameBufferMatching > 0)
+  {
+    // add everything to the buffer
+    session.frameBuffer.emplace_back(localizationResult, queryRegions);
+  }
+
+  return true;
+}
+
+void VoctreeLocalizer::selectViewsFromPose(const geometry::Pose3& pose,
+                                           const camera::PinholeRadialK3& intrinsics,
+                                           std::size_t nbViews,
+                                           std::vector<voctree::DocMatch>& out_selectedViews) const
+{
+  // minimum number of points that allows a reliable 3D reconstruction
+  const std::size_t minNum3DPoints = 5;
+  // maximum angle between the optical axes of the pose and of a selected view
+  const double minCosAngle = std::cos(D2R(60.0));
+
+  const Mat3& R = pose.rotation();
+  const Vec3& C = pose.center();
+  const Vec3 opticalAxis = R.row(2).transpose();
+  const Mat3& K = intrinsics.K();
+  const double width = intrinsics.w();
+  const double height = intrinsics.h();
+
+  // side planes of the frustum in camera coordinates: a point X in front of the camera
+  // is projected in the image if it is on the inner side of the 4 planes
+  const std::array<Vec3, 4> planes = {{
+    Vec3(K(0, 0), 0.0, K(0, 2)).normalized(),
+    Vec3(-K(0, 0), 0.0, width - K(0, 2)).normalized(),
+    Vec3(0.0, K(1, 1), K(1, 2)).normalized(),
+    Vec3(0.0, -K(1, 1), height - K(1, 2)).normalized()
+  }};
+
+  const auto classify = [&](const LandmarksChunk& chunk)
+  {
+    return classifySphere(R * (chunk.center - C), chunk.radius, planes);
+  };
+
+  std::vector<std::size_t> nbVisiblePoints(_landmarksPerView.size(), 0);
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < static_cast<int>(_landmarksPerView.size()); ++i)
+  {
+    const ViewLandmarks& viewLandmarks = _landmarksPerView[i];
+
+    // frustum culling on the viewing direction
+    if(static_cast<std::size_t>(viewLandmarks.points.cols()) < minNum3DPoints ||
+       opticalAxis.dot(viewLandmarks.opticalAxis) < minCosAngle)
+      continue;
+
+    const int viewPosition = classify(viewLandmarks.bounds);
+    if(viewPosition != 0)
+    {
+      nbVisiblePoints[i] = (viewPosition > 0) ? viewLandmarks.points.cols() : 0;
+      continue;
+    }
+
+    // count the landmarks projected inside the image (the distortion is negligible here),
+    // only the chunks crossing the frustum boundary are projected
+    std::size_t nbVisible = 0;
+    for(const LandmarksChunk& chunk : viewLandmarks.chunks)
+    {
+      const int chunkPosition = classify(chunk);
+      if(chunkPosition != 0)
+      {
+        nbVisible += (chunkPosition > 0) ? (chunk.end - chunk.begin) : 0;
+        continue;
+      }
+
+      for(Mat::Index j = chunk.begin; j < chunk.end; ++j)
+      {
+        const Vec3 X = R * (viewLandmarks.points.col(j) - C);
+        if(X(2) <= 0.0)
+          continue;
+        const double x = K(0, 0) * X(0) / X(2) + K(0, 2);
+        const double y = K(1, 1) * X(1) / X(2) + K(1, 2);
+        if(x >= 0.0 && x < width && y >= 0.0 && y < height)
+          ++nbVisible;
+      }
+    }
+    nbVisiblePoints[i] = nbVisible;
+  }
+
+  out_selectedViews.clear();
+  for(std::size_t i = 0; i < _landmarksPerView.size(); ++i)
+  {
+    if(nbVisiblePoints[i] >= minNum3DPoints)
+      out_selectedViews.emplace_back(_landmarksPerView[i].viewId, -static_cast<float>(nbVisiblePoints[i]));
+  }
+
+  std::stable_sort(out_selectedViews.begin(), out_selectedViews.end());
+  if(out_selectedViews.size() > nbViews)
+    out_selectedViews.resize(nbViews);
+}
+
+bool VoctreeLocalizer::localizeFromViews(const feature::MapRegionsPerDesc &queryRegions,
+                                         const std::pair<std::size_t, std::size_t> queryImageSize,
+                                         const Parameters &param,
+                                         bool useInputIntrinsics,
+                                         camera::PinholeRadialK3 &queryIntrinsics,
+                                         const std::vector<voctree::DocMatch>& matchedImages,
+                                         LocalizationResult &localizationResult,
+                                         Session &session,
+                                         const std::string& imagePath) const
 {
-  
   sfm::ImageLocalizerMatchData resectionData;
   // a map containing for each pair <pt3D_id, pt2D_id> the number of times that 
   // the association has been seen
   OccurenceMap occurences;
   
-  // get all the association from the database images
-  std::vector<voctree::DocMatch> matchedImages;
-  getAllAssociations(queryRegions,
-                     queryImageSize,
-                     param,
-                     useInputIntrinsics,
-                     queryIntrinsics,
-                     occurences,
-                     resectionData.pt2D,
-                     resectionData.pt3D,
-                     resectionData.vec_descType,
-                     matchedImages,
-                     imagePath);
+  // get all the association from the matched images
+  system::Timer timer;
+  getAssociationsFromViews(queryRegions,
+                           queryImageSize,
+                           param,
+                           useInputIntrinsics,
+                           queryIntrinsics,
+                           matchedImages,
+                           occurences,
+                           resectionData.pt2D,
+                           resectionData.pt3D,
+                           resectionData.vec_descType,
+                           session.frameBuffer,
+                           imagePath);
+  session.lastFrameStats.matchingTime += timer.elapsedMs();
+  timer.reset();
 
   const std::size_t numCollectedPts = occurences.size();
   std::vector<IndMatch3D2D> associationIDs;
@@ -661,6 +1048,7 @@ bool VoctreeLocalizer::localizeAllResults(const feature::MapRegionsPerDesc &quer
 
   if(!bResection)
   {
+    session.lastFrameStats.resectionTime += timer.elapsedMs();
     ALICEVISION_LOG_DEBUG("[poseEstimation]\tResection failed");
     if(!param._visualDebug.empty() && !imagePath.empty())
     {
@@ -702,6 +1090,8 @@ bool VoctreeLocalizer::localizeAllResults(const feature::MapRegionsPerDesc &quer
                                                      resectionData,
                                                      true /*b_refine_pose*/,
                                                      param._refineIntrinsics /*b_refine_intrinsic*/);
+  session.lastFrameStats.resectionTime += timer.elapsedMs();
+
   if(!refineStatus)
     ALICEVISION_LOG_DEBUG("Refine pose failed.");
 
@@ -731,12 +1121,6 @@ bool VoctreeLocalizer::localizeAllResults(const feature::MapRegionsPerDesc &quer
                 << " max = " << std::sqrt(sqrErrors.maxCoeff()));
   }
 
-  if(param._nbFrameBufferMatching > 0)
-  {
-    // add everything to the buffer
-    _frameBuffer.emplace_back(localizationResult, queryRegions);
-  }
-
   return localizationResult.isValid();
 }
 
@@ -752,9 +1136,27 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
                                           std::vector<voctree::DocMatch>& out_matchedImages,
                                           const std::string& imagePath) const
 {
-  assert(out_descTypes.size() == 0);
-
   // A. Find the (visually) similar images in the database 
+  queryDatabase(queryRegions, param, out_matchedImages);
+
+  getAssociationsFromViews(queryRegions,
+                           imageSize,
+                           param,
+                           useInputIntrinsics,
+                           queryIntrinsics,
+                           out_matchedImages,
+                           out_occurences,
+                           out_pt2D,
+                           out_pt3D,
+                           out_descTypes,
+                           _session.frameBuffer,
+                           imagePath);
+}
+
+void VoctreeLocalizer::queryDatabase(const feature::MapRegionsPerDesc &queryRegions,
+                                     const Parameters &param,
+                                     std::vector<voctree::DocMatch>& out_matchedImages) const
+{
   // pass the descriptors through the vocabulary tree to get the visual words
   // associated to each feature
   ALICEVISION_LOG_DEBUG("[database]\tRequest closest images from voctree");
@@ -767,6 +1169,26 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
   
   // Request closest images from voctree
   _database.find(requestImageWords, (param._numResults==0) ? (_database.size()) : (param._numResults) , out_matchedImages);
+}
+
+void VoctreeLocalizer::getAssociationsFromViews(const feature::MapRegionsPerDesc &queryRegions,
+                                                const std::pair<std::size_t, std::size_t> &imageSize,
+                                                const Parameters &param,
+                                                bool useInputIntrinsics,
+                                                const camera::PinholeRadialK3 &queryIntrinsics,
+                                                const std::vector<voctree::DocMatch>& matchedImages,
+                                                OccurenceMap &out_occurences,
+                                                Mat &out_pt2D,
+                                                Mat &out_pt3D,
+                                                std::vector<feature::EImageDescriberType>& out_descTypes,
+                                                const BoundedBuffer<FrameData>& frameBuffer,
+                                                const std::string& imagePath) const
+{
+  assert(out_descTypes.size() == 0);
+
+  // the query image has no feature of the voctree describer type, nothing was retrieved
+  if(matchedImages.empty() && queryRegions.count(_voctreeDescType) == 0)
+    return;
 
 //  // Debugging log
 //  // for each similar image found print score and number of features
@@ -790,7 +1212,7 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
   // query image adn the similar image
   // stop when param._maxResults successful matches have been found
   std::size_t goodMatches = 0;
-  for(const voctree::DocMatch& matchedImage : out_matchedImages)
+  for(const voctree::DocMatch& matchedImage : matchedImages)
   {
     // minimum number of points that allows a reliable 3D reconstruction
     const size_t minNum3DPoints = 5;
@@ -926,7 +1348,7 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
   {
     ALICEVISION_LOG_DEBUG("[matching]\tUsing frameBuffer matching: matching with the past " 
             << param._nbFrameBufferMatching << " frames" );
-    getAssociationsFromBuffer(matchers, imageSize, param, useInputIntrinsics, queryIntrinsics, out_occurences);
+    getAssociationsFromBuffer(matchers, frameBuffer, imageSize, param, useInputIntrinsics, queryIntrinsics, out_occurences);
   }
   
   const std::size_t numCollectedPts = out_occurences.size();
@@ -977,6 +1399,7 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
 }
 
 void VoctreeLocalizer::getAssociationsFromBuffer(matching::RegionsDatabaseMatcherPerDesc & matchers,
+                                                 const BoundedBuffer<FrameData>& frameBuffer,
                                                  const std::pair<std::size_t, std::size_t> queryImageSize,
                                                  const Parameters &param,
                                                  bool useInputIntrinsics,
@@ -986,7 +1409,7 @@ void VoctreeLocalizer::getAssociationsFromBuffer(matching::RegionsDatabaseMatche
 {
   std::size_t frameCounter = 0;
   // for all the past frames
-  for(const auto& frame : _frameBuffer)
+  for(const auto& frame : frameBuffer)
   {
     // gather the data
     const auto &frameReconstructedRegions = frame._regionsWith3D;
@@ -1161,18 +1584,49 @@ bool VoctreeLocalizer::localizeRig(const std::vector<image::Image<unsigned char>
   assert(numCams == vec_subPoses.size() + 1);
 
   std::vector<feature::MapRegionsPerDesc> vec_queryRegions(numCams);
-  std::vector<std::pair<std::size_t, std::size_t> > vec_imageSize;
-  
-  //@todo parallelize?
-  for(size_t i = 0; i < numCams; ++i)
+  std::vector<std::pair<std::size_t, std::size_t> > vec_imageSize(numCams);
+
+  // the image describers are not thread-safe, each camera of the rig has its own ones
+  if(_rigImageDescribers.size() < numCams)
+  {
+    const std::size_t firstNewCam = _rigImageDescribers.size();
+    _rigImageDescribers.resize(numCams);
+    for(std::size_t i = firstNewCam; i < numCams; ++i)
+    {
+      for(const auto& imageDescriber : _imageDescribers)
+        _rigImageDescribers[i].push_back(feature::createImageDescriber(imageDescriber->getDescriberType()));
+    }
+  }
+
+  // extract descriptors and features from the images of all the cameras in parallel
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < static_cast<int>(numCams); ++i)
   {
     // add the image size for this image
-    vec_imageSize.emplace_back(vec_imageGrey[i].Width(), vec_imageGrey[i].Height());
+    vec_imageSize[i] = std::make_pair(vec_imageGrey[i].Width(), vec_imageGrey[i].Height());
+
+    for(auto& imageDescriber: _rigImageDescribers[i])
+    {
+      // the markers use the shared CUDA pipe, they are extracted below
+      if(isMarkerDescriber(imageDescriber->getDescriberType()))
+        continue;
 
-    // extract descriptors and features from each image
+      ALICEVISION_LOG_DEBUG("[features]\tExtract " << feature::EImageDescriberType_enumToString(imageDescriber->getDescriberType()) << " from query image " << i << "...");
+      imageDescriber->Set_configuration_preset(parameters->_featurePreset);
+      imageDescriber->Describe(vec_imageGrey[i], vec_queryRegions[i][imageDescriber->getDescriberType()]);
+      ALICEVISION_LOG_DEBUG("[features]\tExtract done: found " <<  vec_queryRegions[i][imageDescriber->getDescriberType()]->RegionCount() << " features");
+    }
+  }
+
+  for(size_t i = 0; i < numCams; ++i)
+  {
     for(auto& imageDescriber: _imageDescribers)
     {
-      ALICEVISION_LOG_DEBUG("[features]\tExtract " << feature::EImageDescriberType_enumToString(imageDescriber->getDescriberType()) << " from query image...");
+      if(!isMarkerDescriber(imageDescriber->getDescriberType()))
+        continue;
+
+      ALICEVISION_LOG_DEBUG("[features]\tExtract " << feature::EImageDescriberType_enumToString(imageDescriber->getDescriberType()) << " from query image " << i << "...");
+      imageDescriber->setCudaPipe(_cudaPipe);
       imageDescriber->Describe(vec_imageGrey[i], vec_queryRegions[i][imageDescriber->getDescriberType()]);
       ALICEVISION_LOG_DEBUG("[features]\tExtract done: found " <<  vec_queryRegions[i][imageDescriber->getDescriberType()]->RegionCount() << " features");
     }
@@ -1256,10 +1710,10 @@ bool VoctreeLocalizer::localizeRig_opengv(const std::vector<feature::MapRegionsP
   std::vector<Mat> vec_pts3D(numCams);
   std::vector<Mat> vec_pts2D(numCams);
 
-  // for each camera retrieve the associations
-  //@todo parallelize?
-  size_t numAssociations = 0;
-  for(std::size_t camID = 0; camID < numCams; ++camID)
+  // for each camera retrieve the associations, the cameras are independent and
+  // each one builds its own matchers on its query regions
+  #pragma omp parallel for schedule(dynamic)
+  for(int camID = 0; camID < static_cast<int>(numCams); ++camID)
   {
 
     // this map is used to collect the 2d-3d associations as we go through the images
@@ -1283,8 +1737,11 @@ bool VoctreeLocalizer::localizeRig_opengv(const std::vector<feature::MapRegionsP
                        pts3D,
                        descTypes,
                        matchedImages);
-    numAssociations += occurrences.size();
   }
+
+  std::size_t numAssociations = 0;
+  for(const auto& occurrences : vec_occurrences)
+    numAssociations += occurrences.size();
   
   // @todo Here it could be possible to filter the associations according to their
   // occurrences, eg giving priority to those associations that are more frequent
@@ -1504,12 +1961,20 @@ bool VoctreeLocalizer::localizeRig_naive(const std::vector<feature::MapRegionsPe
 
   vec_localizationResults.resize(numCams);
     
+  // the tracking from the previous pose follows a single camera, not the cameras of the rig
+  Parameters cameraParameters = *static_cast<const Parameters *>(parameters);
+  cameraParameters._useTemporalPrior = false;
+
+  // each camera has its own session (frame buffer) so they can be localized in parallel
+  if(_rigSessions.size() != numCams)
+    _rigSessions.resize(numCams);
+
   // this is basic, just localize each camera alone
-  //@todo parallelize?
-  std::vector<bool> isLocalized(numCams, false);
-  for(size_t i = 0; i < numCams; ++i)
+  std::vector<char> isLocalized(numCams, false);
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < static_cast<int>(numCams); ++i)
   {
-    isLocalized[i] = localize(vec_queryRegions[i], vec_imageSize[i], parameters, true /*useInputIntrinsics*/, vec_queryIntrinsics[i], vec_localizationResults[i]);
+    isLocalized[i] = localize(vec_queryRegions[i], vec_imageSize[i], cameraParameters, true /*useInputIntrinsics*/, vec_queryIntrinsics[i], vec_localizationResults[i], _rigSessions[i]);
     assert(isLocalized[i] == vec_localizationResults[i].isValid());
     if(!isLocalized[i])
     {
@@ -1519,7 +1984,7 @@ bool VoctreeLocalizer::localizeRig_naive(const std::vector<feature::MapRegionsPe
   }
   
   // ** 'easy' cases in which we don't need further processing **
-  const std::size_t numLocalizedCam = std::count(isLocalized.begin(), isLocalized.end(), true);
+  const std::size_t numLocalizedCam = std::count(isLocalized.begin(), isLocalized.end(), char(true));
   
   // no camera has be localized
   if(numLocalizedCam == 0)
@@ -1542,7 +2007,7 @@ bool VoctreeLocalizer::localizeRig_naive(const std::vector<feature::MapRegionsPe
   { 
     // find the index of the first localized camera
     const std::size_t idx = std::distance(isLocalized.begin(), 
-                                          std::find(isLocalized.begin(), isLocalized.end(), true));
+                                          std::find(isLocalized.begin(), isLocalized.end(), char(true)));
     
     // useless safeguard as there should be at least 1 element at this point but
     // better safe than sorry
@@ -20,6 +20,8 @@
 #include <aliceVision/matching/RegionsMatcher.hpp>
 #include <flann/algorithms/dist.h>
 
+#include <deque>
+
 
 namespace aliceVision {
 namespace localization {
@@ -53,7 +55,10 @@ public:
       _numCommonViews(3),
       _ccTagUseCuda(true),
       _matchingError(std::numeric_limits<double>::infinity()),
-      _nbFrameBufferMatching(10)
+      _nbFrameBufferMatching(10),
+      _useTemporalPrior(false),
+      _temporalPriorNbViews(4),
+      _temporalPriorMinInliers(30)
     { }
     
     /// Enable/disable guided matching when matching images
@@ -74,6 +79,67 @@ public:
     double _matchingError;
     /// maximum capacity of the frame buffer
     std::size_t _nbFrameBufferMatching;
+    /// tracking mode: first match against the views that see the landmarks visible
+    /// from the previous pose, fallback on the voctree retrieval if it fails
+    bool _useTemporalPrior;
+    /// number of views selected from the previous pose in tracking mode
+    std::size_t _temporalPriorNbViews;
+    /// minimum number of resection inliers for the tracking to succeed
+    std::size_t _temporalPriorMinInliers;
+  };
+
+  /// Timings (in ms) and status of the localization of one frame
+  struct FrameStats
+  {
+    /// time to retrieve the views to match (voctree query or selection from the previous pose)
+    double retrievalTime = 0.0;
+    /// time to match the query image with the retrieved views
+    double matchingTime = 0.0;
+    /// time to estimate and refine the pose
+    double resectionTime = 0.0;
+    /// the tracking from the previous pose has been tried
+    bool isTrackingAttempt = false;
+    /// the frame has been localized by the tracking from the previous pose
+    bool isTracked = false;
+    /// the frame has been localized
+    bool isLocalized = false;
+  };
+
+  /// Accumulated timings (in ms) and status counters over all the localized frames
+  struct SequenceStats
+  {
+    std::size_t nbFrames = 0;
+    std::size_t nbLocalizedFrames = 0;
+    std::size_t nbTrackingAttempts = 0;
+    std::size_t nbTrackedFrames = 0;
+    double retrievalTime = 0.0;
+    double matchingTime = 0.0;
+    double resectionTime = 0.0;
+  };
+
+  /**
+   * @brief Mutable state of the localization of a sequence of frames from one camera:
+   * the last localized frames, the previous pose for the tracking mode and the timings.
+   *
+   * The reconstruction, the regions and the database are only read during the
+   * localization, so several sessions can be localized concurrently with the same localizer.
+   */
+  struct Session
+  {
+    Session()
+      : frameBuffer(5)
+    { }
+
+    /// last localized frames, for the frame buffer matching
+    BoundedBuffer<FrameData> frameBuffer;
+    /// pose and intrinsics of the previous localized frame, for the tracking mode
+    bool hasPreviousPose = false;
+    geometry::Pose3 previousPose;
+    camera::PinholeRadialK3 previousIntrinsics;
+    /// timings and status of the last localized frame
+    FrameStats lastFrameStats;
+    /// accumulated timings and status counters over all the localized frames
+    SequenceStats sequenceStats;
   };
   
 public:
@@ -149,6 +215,31 @@ public:
                 camera::PinholeRadialK3 &queryIntrinsics,
                 LocalizationResult & localizationResult,
                 const std::string& imagePath = std::string()) override;
+
+  /**
+   * @brief Localize the features of a query image within a session. The localizer
+   * is not modified, so it can be called concurrently from several threads as long
+   * as each thread uses its own session.
+   *
+   * @param[in] queryRegions The input features of the query image
+   * @param[in] imageSize The size of the input image
+   * @param[in] param The parameters for the localization.
+   * @param[in] useInputIntrinsics Uses the \p queryIntrinsics as known calibration.
+   * @param[in,out] queryIntrinsics Intrinsic parameters of the camera, they are used if the
+   * flag useInputIntrinsics is set to true, otherwise they are estimated from the correspondences.
+   * @param[out] localizationResult The localization result containing the pose and the associations.
+   * @param[in,out] session The state of the sequence the query image belongs to.
+   * @param[in] imagePath Optional complete path to the image, used only for debugging purposes.
+   * @return  true if the image has been successfully localized.
+   */
+  bool localize(const feature::MapRegionsPerDesc & queryRegions,
+                const std::pair<std::size_t, std::size_t> &imageSize,
+                const Parameters &param,
+                bool useInputIntrinsics,
+                camera::PinholeRadialK3 &queryIntrinsics,
+                LocalizationResult & localizationResult,
+                Session &session,
+                const std::string& imagePath = std::string()) const;
   
   
   bool localizeRig(const std::vector<image::Image<unsigned char> > & vec_imageGrey,
@@ -200,6 +291,7 @@ public:
    * @param[out] pose The camera pose
    * @param[out] resection_data the 2D-3D correspondences used to compute the pose
    * @param[out] associationIDs the ids of the 2D-3D correspondences used to compute the pose
+   * @param[in,out] session The state of the sequence the query image belongs to
    * @return true if the localization is successful
    */
   bool localizeFirstBestResult(const feature::MapRegionsPerDesc & queryRegions,
@@ -208,7 +300,8 @@ public:
                                bool useInputIntrinsics,
                                camera::PinholeRadialK3 &queryIntrinsics,
                                LocalizationResult &localizationResult,
-                               const std::string& imagePath = std::string());
+                               Session &session,
+                               const std::string& imagePath = std::string()) const;
 
   /**
    * @brief Try to localize an image in the database: it queries the database to 
@@ -225,6 +318,7 @@ public:
    * @param[out] pose The camera pose
    * @param[out] resection_data the 2D-3D correspondences used to compute the pose
    * @param[out] associationIDs the ids of the 2D-3D correspondences used to compute the pose
+   * @param[in,out] session The state of the sequence the query image belongs to
    * @return true if the localization is successful
    */
   bool localizeAllResults(const feature::MapRegionsPerDesc & queryRegions,
@@ -233,7 +327,8 @@ public:
                           bool useInputIntrinsics,
                           camera::PinholeRadialK3 &queryIntrinsics,
                           LocalizationResult &localizationResult,
-                          const std::string& imagePath = std::string());
+                          Session &session,
+                          const std::string& imagePath = std::string()) const;
   
   
   /**
@@ -263,7 +358,119 @@ public:
                           std::vector<voctree::DocMatch>& out_matchedImages,
                           const std::string& imagePath = std::string()) const;
 
+  /**
+   * @brief Select the reconstructed views that see the most landmarks visible from a given pose.
+   *
+   * The views are culled by the angle between their optical axis and the one of the pose,
+   * then their landmarks are tested against the frustum of the pose by chunks: only the
+   * landmarks of the chunks crossing the frustum boundary are projected in the image.
+   *
+   * @param[in] pose The pose of the camera (typically the pose of the previous frame)
+   * @param[in] intrinsics The intrinsics of the camera
+   * @param[in] nbViews The maximum number of views to select
+   * @param[out] out_selectedViews The selected views, the score is the opposite of the
+   * number of visible landmarks so that the best views come first as for a voctree query
+   */
+  void selectViewsFromPose(const geometry::Pose3& pose,
+                           const camera::PinholeRadialK3& intrinsics,
+                           std::size_t nbViews,
+                           std::vector<voctree::DocMatch>& out_selectedViews) const;
+
+  /// Get the timings and status of the last localized frame
+  const FrameStats& getLastFrameStats() const
+  {
+    return _session.lastFrameStats;
+  }
+
+  /// Get the accumulated timings and status counters over all the localized frames
+  const SequenceStats& getSequenceStats() const
+  {
+    return _session.sequenceStats;
+  }
+
+  /// Forget the previous pose: the next frame is localized with the voctree retrieval
+  void resetTemporalPrior()
+  {
+    _session.hasPreviousPose = false;
+  }
+
 private:
+  /**
+   * @brief Localize an image from the views that see the landmarks visible from
+   * the pose of the previous frame (tracking mode).
+   *
+   * @return true if the image has been localized with at least
+   * \p param._temporalPriorMinInliers inliers
+   */
+  bool localizeTemporalPrior(const feature::MapRegionsPerDesc & queryRegions,
+                             const std::pair<std::size_t, std::size_t> imageSize,
+                             const Parameters &param,
+                             bool useInputIntrinsics,
+                             camera::PinholeRadialK3 &queryIntrinsics,
+                             LocalizationResult &localizationResult,
+                             Session &session,
+                             const std::string& imagePath = std::string()) const;
+
+  /**
+   * @brief Match the query image with the given views, collect all the 2D-3D
+   * associations and estimate the pose with them.
+   *
+   * @param[in] queryRegions The input features of the query image
+   * @param[in] imageSize The size of the input image
+   * @param[in] param The parameters for the localization
+   * @param[in] useInputIntrinsics Uses the \p queryIntrinsics as known calibration
+   * @param[in,out] queryIntrinsics Intrinsic parameters of the camera
+   * @param[in] matchedImages The views to match, in order of priority
+   * @param[out] localizationResult The localization result
+   * @param[in] imagePath Optional complete path to the image, used only for debugging purposes.
+   * @param[in,out] session The state of the sequence the query image belongs to
+   * @return true if the localization is successful
+   */
+  bool localizeFromViews(const feature::MapRegionsPerDesc & queryRegions,
+                         const std::pair<std::size_t, std::size_t> imageSize,
+                         const Parameters &param,
+                         bool useInputIntrinsics,
+                         camera::PinholeRadialK3 &queryIntrinsics,
+                         const std::vector<voctree::DocMatch>& matchedImages,
+                         LocalizationResult &localizationResult,
+                         Session &session,
+                         const std::string& imagePath = std::string()) const;
+
+  /**
+   * @brief Query the vocabulary tree database with the query image.
+   *
+   * @param[in] queryRegions The input features of the query image
+   * @param[in] param The parameters for the localization
+   * @param[out] out_matchedImages The \p param._numResults most similar images
+   */
+  void queryDatabase(const feature::MapRegionsPerDesc & queryRegions,
+                     const Parameters &param,
+                     std::vector<voctree::DocMatch>& out_matchedImages) const;
+
+  /**
+   * @brief Retrieve matches to the given views of the database.
+   * @see getAllAssociations
+   */
+  void getAssociationsFromViews(const feature::MapRegionsPerDesc & queryRegions,
+                                const std::pair<std::size_t, std::size_t> &imageSize,
+                                const Parameters &param,
+                                bool useInputIntrinsics,
+                                const camera::PinholeRadialK3 &queryIntrinsics,
+                                const std::vector<voctree::DocMatch>& matchedImages,
+                                OccurenceMap & out_occurences,
+                                Mat &out_pt2D,
+                                Mat &out_pt3D,
+                                std::vector<feature::EImageDescriberType>& out_descTypes,
+                                const BoundedBuffer<FrameData>& frameBuffer,
+                                const std::string& imagePath = std::string()) const;
+
+  /**
+   * @brief Build the visibility index used by the tracking mode: the 3D points
+   * of the reconstructed regions of each view, grouped in small bounding spheres
+   * to cull them by chunks.
+   */
+  void buildVisibilityIndex();
+
   /**
    * @brief Load the vocabulary tree.
 
@@ -311,6 +518,7 @@ private:
                       robustEstimation::ERobustEstimator estimator = robustEstimation::ERobustEstimator::ACRANSAC) const;
   
   void getAssociationsFromBuffer(matching::RegionsDatabaseMatcherPerDesc& matchers,
+                                 const BoundedBuffer<FrameData>& frameBuffer,
                                  const std::pair<std::size_t, std::size_t> imageSize,
                                  const Parameters &param,
                                  bool useInputIntrinsics,
@@ -350,10 +558,46 @@ public:
   /// the original dataset
   voctree::Database _database;
   
-  /// Last frames buffer
-  BoundedBuffer<FrameData> _frameBuffer;
-
   matching::EMatcherType _matcherType = matching::ANN_L2;
+
+private:
+
+  /// Bounding sphere of consecutive landmarks of a view
+  struct LandmarksChunk
+  {
+    Vec3 center;
+    double radius;
+    /// range of the landmarks in ViewLandmarks::points
+    Mat::Index begin;
+    Mat::Index end;
+  };
+
+  /// 3D points seen by a reconstructed view
+  struct ViewLandmarks
+  {
+    IndexT viewId;
+    /// optical axis of the view in world coordinates
+    Vec3 opticalAxis;
+    /// the landmarks, sorted along a Morton curve so that the chunks are compact
+    Mat3X points;
+    /// bounding sphere of all the landmarks
+    LandmarksChunk bounds;
+    /// bounding spheres of at most 64 landmarks
+    std::vector<LandmarksChunk> chunks;
+  };
+
+  /// visibility index: the landmarks seen by each reconstructed view
+  std::vector<ViewLandmarks> _landmarksPerView;
+
+  /// state of the sequence localized through the ILocalizer interface
+  Session _session;
+
+  /// state of each camera of the rig localized independently (localizeRig_naive),
+  /// the sessions are not copyable so they are not stored in a vector
+  std::deque<Session> _rigSessions;
+
+  /// feature extractors of each camera of the rig, to describe the images concurrently
+  std::vector<std::vector<std::unique_ptr<feature::ImageDescriber>>> _rigImageDescribers;
 };
 
 /**
@@ -0,0 +1,184 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "VoctreeLocalizer.hpp"
+#include "localizerTestScene.hpp"
+
+#include <cmath>
+#include <set>
+#include <vector>
+
+#define BOOST_TEST_MODULE VoctreeLocalizer
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::localization;
+
+/**
+ * @brief Count the landmarks of the scene projected inside the image of a camera.
+ */
+std::size_t countVisibleLandmarks(const sfm::SfMData& sfmData, const geometry::Pose3& pose, const camera::PinholeRadialK3& intrinsics)
+{
+  std::size_t nbVisible = 0;
+  for(const auto& landmark : sfmData.GetLandmarks())
+  {
+    if(pose.depth(landmark.second.X) <= 0.0)
+      continue;
+    const Vec2 x = intrinsics.project(pose, landmark.second.X);
+    if(x(0) >= 0.0 && x(0) < intrinsics.w() && x(1) >= 0.0 && x(1) < intrinsics.h())
+      ++nbVisible;
+  }
+  return nbVisible;
+}
+
+VoctreeLocalizer::Parameters getTrackingParameters()
+{
+  VoctreeLocalizer::Parameters param;
+  param._algorithm = VoctreeLocalizer::Algorithm::AllResults;
+  param._numResults = 4;
+  param._ccTagUseCuda = false;
+  param._errorMax = 4.0;
+  param._matchingError = 4.0;
+  param._useTemporalPrior = true;
+  param._temporalPriorNbViews = 4;
+  return param;
+}
+
+BOOST_AUTO_TEST_CASE(VoctreeLocalizer_selectViewsFromPose_opticalAxis)
+{
+  // 8 views every 45 degrees, all the landmarks are seen by all the views
+  const std::size_t nbViews = 8;
+  const std::size_t nbPoints = 100;
+  const LocalizerTestScene scene(nbViews, nbPoints);
+  const VoctreeLocalizer localizer(scene.sfmDataFilepath, scene.folder, scene.voctreeFilepath, "", {scene.descType});
+  BOOST_REQUIRE(localizer.isInit());
+
+  // from the pose of the view 0, the landmarks of all the views are in the image,
+  // only the views 7, 0 and 1 are within 60 degrees of its optical axis
+  const geometry::Pose3 pose = scene.getRingPose(0.0);
+  const camera::PinholeRadialK3 intrinsics = scene.getIntrinsics();
+  BOOST_REQUIRE_EQUAL(countVisibleLandmarks(scene.sfmData, pose, intrinsics), nbPoints);
+
+  std::vector<voctree::DocMatch> selectedViews;
+  localizer.selectViewsFromPose(pose, intrinsics, nbViews, selectedViews);
+
+  std::set<IndexT> selectedViewIds;
+  for(const voctree::DocMatch& view : selectedViews)
+  {
+    selectedViewIds.insert(view.id);
+    BOOST_CHECK_EQUAL(view.score, -static_cast<float>(nbPoints));
+  }
+  BOOST_CHECK(selectedViewIds == std::set<IndexT>({7, 0, 1}));
+
+  // the number of selected views is bounded
+  localizer.selectViewsFromPose(pose, intrinsics, 2, selectedViews);
+  BOOST_CHECK_EQUAL(selectedViews.size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(VoctreeLocalizer_selectViewsFromPose_projections)
+{
+  const std::size_t nbViews = 8;
+  const std::size_t nbPoints = 100;
+  const LocalizerTestScene scene(nbViews, nbPoints);
+  const VoctreeLocalizer localizer(scene.sfmDataFilepath, scene.folder, scene.voctreeFilepath, "", {scene.descType});
+  BOOST_REQUIRE(localizer.isInit());
+
+  const geometry::Pose3 pose = scene.getRingPose(0.0);
+  const camera::PinholeRadialK3 intrinsics = scene.getIntrinsics();
+
+  // same principal point with a quarter of the image: only a part of the landmarks is inside
+  const camera::PinholeRadialK3 croppedIntrinsics(intrinsics.w() / 2, intrinsics.h() / 2, intrinsics.focal(), intrinsics.principal_point()(0), intrinsics.principal_point()(1));
+  const std::size_t nbVisible = countVisibleLandmarks(scene.sfmData, pose, croppedIntrinsics);
+  BOOST_REQUIRE_GE(nbVisible, 5);
+  BOOST_REQUIRE_LT(nbVisible, nbPoints);
+
+  std::vector<voctree::DocMatch> selectedViews;
+  localizer.selectViewsFromPose(pose, croppedIntrinsics, nbViews, selectedViews);
+  BOOST_CHECK_EQUAL(selectedViews.size(), 3);
+  for(const voctree::DocMatch& view : selectedViews)
+    BOOST_CHECK_EQUAL(view.score, -static_cast<float>(nbVisible));
+
+  // too few landmarks inside the image to localize from these views
+  const camera::PinholeRadialK3 tinyIntrinsics(10, 10, intrinsics.focal(), intrinsics.principal_point()(0), intrinsics.principal_point()(1));
+  BOOST_REQUIRE_LT(countVisibleLandmarks(scene.sfmData, pose, tinyIntrinsics), 5);
+  localizer.selectViewsFromPose(pose, tinyIntrinsics, nbViews, selectedViews);
+  BOOST_CHECK(selectedViews.empty());
+}
+
+BOOST_AUTO_TEST_CASE(VoctreeLocalizer_selectViewsFromPose_chunks)
+{
+  // enough landmarks per view to split them in many chunks
+  const std::size_t nbViews = 8;
+  const std::size_t nbPoints = 1000;
+  const LocalizerTestScene scene(nbViews, nbPoints);
+  const VoctreeLocalizer localizer(scene.sfmDataFilepath, scene.folder, scene.voctreeFilepath, "", {scene.descType});
+  BOOST_REQUIRE(localizer.isInit());
+
+  const camera::PinholeRadialK3 intrinsics = scene.getIntrinsics();
+  const double w = intrinsics.w();
+  const double h = intrinsics.h();
+
+  // the chunks are inside, outside or across the frustum boundary depending on the pose and the image
+  for(const double angle : {0.0, 0.1, 0.3})
+  {
+    const geometry::Pose3 pose = scene.getRingPose(angle);
+    for(const double ratio : {1.0, 0.5, 0.2})
+    {
+      for(const Vec2& principalPoint : {Vec2(0.5 * w, 0.5 * h), Vec2(0.1 * w, 0.3 * h), Vec2(0.8 * w, 0.9 * h)})
+      {
+        const camera::PinholeRadialK3 croppedIntrinsics(w * ratio, h * ratio, intrinsics.focal(), principalPoint(0) * ratio, principalPoint(1) * ratio);
+        const std::size_t nbVisible = countVisibleLandmarks(scene.sfmData, pose, croppedIntrinsics);
+
+        std::vector<voctree::DocMatch> selectedViews;
+        localizer.selectViewsFromPose(pose, croppedIntrinsics, nbViews, selectedViews);
+        BOOST_CHECK_EQUAL(selectedViews.empty(), nbVisible < 5);
+        for(const voctree::DocMatch& view : selectedViews)
+          BOOST_CHECK_EQUAL(view.score, -static_cast<float>(nbVisible));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(VoctreeLocalizer_temporalPrior)
+{
+  const std::size_t nbViews = 8;
+  const std::size_t nbPoints = 100;
+  const LocalizerTestScene scene(nbViews, nbPoints);
+  const VoctreeLocalizer localizer(scene.sfmDataFilepath, scene.folder, scene.voctreeFilepath, "", {scene.descType});
+  BOOST_REQUIRE(localizer.isInit());
+
+  // the previous frame is close to the query, between the views 0 and 1
+  const geometry::Pose3 previousPose = scene.getRingPose(0.2);
+  const geometry::Pose3 queryPose = scene.getRingPose(0.25);
+  const feature::MapRegionsPerDesc queryRegions = scene.createQueryRegions(queryPose);
+
+  for(const bool isTrackingExpected : {true, false})
+  {
+    VoctreeLocalizer::Parameters param = getTrackingParameters();
+    // the tracking cannot reach more inliers than the number of landmarks
+    param._temporalPriorMinInliers = isTrackingExpected ? 10 : nbPoints + 1;
+
+    VoctreeLocalizer::Session session;
+    session.hasPreviousPose = true;
+    session.previousPose = previousPose;
+    session.previousIntrinsics = scene.getIntrinsics();
+
+    camera::PinholeRadialK3 queryIntrinsics = scene.getIntrinsics();
+    LocalizationResult result;
+    BOOST_CHECK(localizer.localize(queryRegions, scene.getImageSize(), param, true, queryIntrinsics, result, session));
+
+    // without enough inliers, the frame is localized by the voctree retrieval
+    const VoctreeLocalizer::FrameStats& stats = session.lastFrameStats;
+    BOOST_CHECK(stats.isTrackingAttempt);
+    BOOST_CHECK_EQUAL(stats.isTracked, isTrackingExpected);
+    BOOST_CHECK(stats.isLocalized);
+    BOOST_CHECK_EQUAL(session.sequenceStats.nbTrackingAttempts, 1);
+    BOOST_CHECK_EQUAL(session.sequenceStats.nbTrackedFrames, isTrackingExpected ? 1 : 0);
+
+    BOOST_CHECK(result.isValid());
+    BOOST_CHECK_SMALL((result.getPose().center() - queryPose.center()).norm(), 1e-2);
+    BOOST_CHECK(session.hasPreviousPose);
+  }
+}
@@ -0,0 +1,165 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/camera/PinholeRadial.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/feature/regionsFactory.hpp>
+#include <aliceVision/geometry/Pose3.hpp>
+#include <aliceVision/multiview/NViewDataSet.hpp>
+#include <aliceVision/sfm/SfMData.hpp>
+#include <aliceVision/sfm/sfmDataIO.hpp>
+#include <aliceVision/sfm/utils/syntheticScene.hpp>
+#include <aliceVision/voctree/TreeBuilder.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+namespace localization {
+
+/**
+ * @brief Synthetic reconstruction written on disk to initialize a VoctreeLocalizer.
+ *
+ * The views are on a ring around random landmarks (NRealisticCamerasRing), each landmark
+ * has a random SIFT_FLOAT descriptor shared by all its observations, so the query features
+ * created from any pose match the reconstruction exactly. The vocabulary tree is trained
+ * on the landmark descriptors. The files are removed with the scene.
+ */
+struct LocalizerTestScene
+{
+  typedef feature::SIFT_Float_Regions RegionsT;
+  typedef RegionsT::DescriptorT DescriptorT;
+
+  /**
+   * @param[in] nbViews The number of views of the ring
+   * @param[in] nbPoints The number of landmarks, all of them are seen by all the views
+   */
+  LocalizerTestScene(std::size_t nbViews, std::size_t nbPoints)
+    : config(1000, 1000, 500, 500, 1.5, 0.0)
+  {
+    namespace bfs = boost::filesystem;
+
+    folder = (bfs::temp_directory_path() / bfs::unique_path("localizerTestScene_%%%%-%%%%-%%%%")).string();
+    bfs::create_directories(folder);
+
+    const NViewDataSet dataset = NRealisticCamerasRing(nbViews, nbPoints, config);
+    sfmData = sfm::getInputScene(dataset, config, camera::PINHOLE_CAMERA_RADIAL3);
+    for(auto& landmark : sfmData.structure)
+      landmark.second.descType = descType;
+
+    // a distinct descriptor per landmark
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<float> distribution(0.f, 255.f);
+    descriptors.resize(nbPoints);
+    for(DescriptorT& descriptor : descriptors)
+      for(std::size_t i = 0; i < descriptor.size(); ++i)
+        descriptor[i] = distribution(generator);
+
+    // the features of each view are its observations, the feature index is the landmark index
+    const std::string descTypeName = feature::EImageDescriberType_enumToString(descType);
+    for(const auto& viewPair : sfmData.GetViews())
+    {
+      const IndexT viewId = viewPair.first;
+      RegionsT regions;
+      regions.Features().resize(nbPoints);
+      regions.Descriptors().resize(nbPoints);
+      for(const auto& landmark : sfmData.GetLandmarks())
+      {
+        const sfm::Observation& observation = landmark.second.observations.at(viewId);
+        regions.Features()[observation.id_feat] = feature::SIOPointFeature(observation.x(0), observation.x(1), 1.f, 0.f);
+        regions.Descriptors()[observation.id_feat] = descriptors[landmark.first];
+      }
+      const std::string basename = (bfs::path(folder) / (std::to_string(viewId) + "." + descTypeName)).string();
+      regions.Save(basename + ".feat", basename + ".desc");
+    }
+
+    sfmDataFilepath = (bfs::path(folder) / "sfmData.sfm").string();
+    sfm::Save(sfmData, sfmDataFilepath, sfm::ESfMData::ALL);
+
+    // the descriptor type of the tree is given by its extension
+    voctree::TreeBuilder<DescriptorT> builder(DescriptorT(0));
+    builder.kmeans().setRestarts(1);
+    builder.build(descriptors, 4, 2);
+    voctreeFilepath = (bfs::path(folder) / ("voctree." + descTypeName + ".tree")).string();
+    builder.tree().save(voctreeFilepath);
+  }
+
+  ~LocalizerTestScene()
+  {
+    boost::filesystem::remove_all(folder);
+  }
+
+  LocalizerTestScene(const LocalizerTestScene&) = delete;
+  LocalizerTestScene& operator=(const LocalizerTestScene&) = delete;
+
+  /// Get the intrinsics shared by all the views
+  camera::PinholeRadialK3 getIntrinsics() const
+  {
+    return camera::PinholeRadialK3(getImageSize().first, getImageSize().second, config._fx, config._cx, config._cy);
+  }
+
+  std::pair<std::size_t, std::size_t> getImageSize() const
+  {
+    return std::make_pair(2 * config._cx, 2 * config._cy);
+  }
+
+  /**
+   * @brief Get a pose on the ring of the views, looking at the center of the scene.
+   * @param[in] angle The position on the ring in radian, the view i is at i * 2 * PI / nbViews
+   */
+  geometry::Pose3 getRingPose(double angle) const
+  {
+    const Vec3 center = config._dist * Vec3(std::sin(angle), 0.0, std::cos(angle));
+    return geometry::Pose3(LookAt(-center), center);
+  }
+
+  /**
+   * @brief Create the features of a query image: the landmarks projected in the image of a pose.
+   * @param[in] pose The pose of the query camera
+   * @return the regions of the query image
+   */
+  feature::MapRegionsPerDesc createQueryRegions(const geometry::Pose3& pose) const
+  {
+    const camera::PinholeRadialK3 intrinsics = getIntrinsics();
+    std::unique_ptr<RegionsT> regions(new RegionsT);
+
+    for(const auto& landmark : sfmData.GetLandmarks())
+    {
+      if(pose.depth(landmark.second.X) <= 0.0)
+        continue;
+      const Vec2 x = intrinsics.project(pose, landmark.second.X);
+      if(x(0) < 0.0 || x(0) >= intrinsics.w() || x(1) < 0.0 || x(1) >= intrinsics.h())
+        continue;
+      regions->Features().emplace_back(x(0), x(1), 1.f, 0.f);
+      regions->Descriptors().push_back(descriptors[landmark.first]);
+    }
+
+    feature::MapRegionsPerDesc regionsPerDesc;
+    regionsPerDesc[descType].reset(regions.release());
+    return regionsPerDesc;
+  }
+
+  feature::EImageDescriberType descType = feature::EImageDescriberType::SIFT_FLOAT;
+  NViewDatasetConfigurator config;
+  sfm::SfMData sfmData;
+  /// descriptor of each landmark
+  std::vector<DescriptorT> descriptors;
+  std::string folder;
+  std::string sfmDataFilepath;
+  std::string voctreeFilepath;
+};
+
+} // namespace localization
+} // namespace aliceVision
@@ -10,7 +10,7 @@
 #include <aliceVision/rig/ResidualError.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/Timer.hpp>
-
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/stats.hpp>
@@ -431,7 +431,8 @@ bool refineRigPose(const std::vector<geometry::Pose3 > &vec_subPoses,
   options.sparse_linear_algebra_library_type = aliceVision_options._sparse_linear_algebra_library_type;
   options.minimizer_progress_to_stdout = aliceVision_options._bVerbose;
   options.logging_type = ceres::SILENT;
-  options.num_threads = 1;//aliceVision_options._nbThreads;
+  // evaluate the residual blocks of the rig in parallel
+  options.num_threads = omp_get_max_threads();
   options.num_linear_solver_threads = 1;//aliceVision_options._nbThreads;
   
   // Solve BA
@@ -574,7 +575,8 @@ bool refineRigPose(const std::vector<Mat> &pts2d,
   options.sparse_linear_algebra_library_type = aliceVision_options._sparse_linear_algebra_library_type;
   options.minimizer_progress_to_stdout = true;
   //options.logging_type = ceres::SILENT;
-  options.num_threads = 1;//aliceVision_options._nbThreads;
+  // evaluate the residual blocks of the rig in parallel
+  options.num_threads = omp_get_max_threads();
   options.num_linear_solver_threads = 1;//aliceVision_options._nbThreads;
   
   // Solve BA
@@ -717,8 +719,9 @@ std::pair<double, bool> computeInliers(const std::vector<Mat> &vec_pts2d,
   
   std::vector<std::vector<std::size_t> > vec_newInliers(numCams);
 
-  // compute the reprojection error for inliers (just debugging purposes)
-  for(std::size_t camID = 0; camID < numCams; ++camID)
+  // the cameras are independent, evaluate their residuals in parallel
+  #pragma omp parallel for schedule(dynamic) reduction(+:rmse, numInliers, numAdded, numRemoved)
+  for(int camID = 0; camID < static_cast<int>(numCams); ++camID)
   {
     const std::size_t numPts = vec_pts2d[camID].cols();
     
@@ -735,19 +738,27 @@ std::pair<double, bool> computeInliers(const std::vector<Mat> &vec_pts2d,
     auto &currInliers = vec_newInliers[camID];
     const auto &oldInliers = vec_inliers[camID];
     currInliers.reserve(numPts);
+
+    // mark the previous inliers
+    std::vector<char> wasInlier(numPts, 0);
+    for(const std::size_t i : oldInliers)
+    {
+      assert(i < numPts);
+      assert(!wasInlier[i]);
+      wasInlier[i] = 1;
+    }
     
     for(std::size_t i = 0; i < numPts; ++i)
     {
       // check whether the current point was an inlier
-      const auto occ = std::count(oldInliers.begin(), oldInliers.end(), i);
-      assert(occ == 0 || occ == 1);
+      const bool occ = wasInlier[i];
       
       if(sqrErrors(i) < squareThreshold)
       {
         currInliers.push_back(i);
         
         // if it was not an inlier mark it as added one
-        if(occ == 0)
+        if(!occ)
           ++numAdded;
         
         rmse += sqrErrors(i);
@@ -756,7 +767,7 @@ std::pair<double, bool> computeInliers(const std::vector<Mat> &vec_pts2d,
       else
       {
          // if it was an inlier mark it as removed one
-         if(occ == 1)
+         if(occ)
           ++numRemoved;       
       }
     }
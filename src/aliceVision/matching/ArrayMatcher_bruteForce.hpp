@@ -8,15 +8,29 @@
 #include "aliceVision/numeric/numeric.hpp"
 #include "aliceVision/matching/ArrayMatcher.hpp"
 #include "aliceVision/matching/metric.hpp"
+#include "aliceVision/matching/BlockedL2Search.hpp"
 #include "aliceVision/stl/indexedSort.hpp"
 #include <aliceVision/config.hpp>
+#include <algorithm>
 #include <memory>
 #include <iostream>
+#include <type_traits>
 
 namespace aliceVision {
 namespace matching {
 
+/// Metrics computing the squared L2 distance, searched with the blocked engines
+template<typename Metric>
+struct isSquaredL2Metric : std::false_type {};
+template<typename T>
+struct isSquaredL2Metric<L2_Simple<T> > : std::true_type {};
+template<typename T>
+struct isSquaredL2Metric<L2_Vectorized<T> > : std::true_type {};
+
 // By default compute square(L2 distance).
+// Squared L2 metrics use the blocked engines of BlockedL2Search.hpp:
+// unsigned char descriptors with exact 16 bits integer dot products,
+// the other types with matrix products.
 template < typename Scalar = float, typename Metric = L2_Simple<Scalar> >
 class ArrayMatcher_bruteForce  : public ArrayMatcher<Scalar, Metric>
 {
@@ -38,11 +52,21 @@ class ArrayMatcher_bruteForce  : public ArrayMatcher<Scalar, Metric>
    * \return True if success.
    */
   bool Build(const Scalar * dataset, int nbRows, int dimension) {
+    _blockedUInt8.clear();
+    _blockedGEMM.clear();
     if (nbRows < 1) {
       memMapping.reset(nullptr);
       return false;
     }
     memMapping.reset(new Eigen::Map<BaseMat>( (Scalar*)dataset, nbRows, dimension) );
+
+    if (isSquaredL2Metric<Metric>::value)
+    {
+      if (std::is_same<Scalar, unsigned char>::value && BlockedL2Search_UInt8::isSupported(dimension))
+        _blockedUInt8.build(*memMapping);
+      else
+        _blockedGEMM.build(*memMapping);
+    }
     return true;
   }
 
@@ -62,6 +86,17 @@ class ArrayMatcher_bruteForce  : public ArrayMatcher<Scalar, Metric>
     if (memMapping.get() == nullptr)
       return false;
 
+    if (isSquaredL2Metric<Metric>::value)
+    {
+      IndMatches indices;
+      std::vector<DistanceType> distances;
+      if (!SearchNeighbours(query, 1, &indices, &distances, 1))
+        return false;
+      *indice = indices.front()._j;
+      *distance = distances.front();
+      return true;
+    }
+
       //matrix representation of the input data;
       Eigen::Map<BaseMat> mat_query((Scalar*)query, 1, (*memMapping).cols() );
       Metric metric;
@@ -114,11 +149,21 @@ class ArrayMatcher_bruteForce  : public ArrayMatcher<Scalar, Metric>
 
     //matrix representation of the input data;
     Eigen::Map<BaseMat> mat_query((Scalar*)query, nbQuery, (*memMapping).cols());
-    Metric metric;
 
     pvec_distances->resize(nbQuery * NN);
     pvec_indices->resize(nbQuery * NN);
 
+    if (isSquaredL2Metric<Metric>::value && NN > 0)
+    {
+      if (_blockedUInt8.isBuilt())
+        exportNeighbours(_blockedUInt8, mat_query, NN, *pvec_indices, *pvec_distances);
+      else
+        exportNeighbours(_blockedGEMM, mat_query, NN, *pvec_indices, *pvec_distances);
+      return true;
+    }
+
+    Metric metric;
+
     #pragma omp parallel for schedule(dynamic)
     for (int queryIndex=0; queryIndex < nbQuery; ++queryIndex) 
     {
@@ -149,8 +194,44 @@ class ArrayMatcher_bruteForce  : public ArrayMatcher<Scalar, Metric>
 
 private:
   typedef Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> BaseMat;
+
+  /// blocked search type of the non unsigned char descriptors
+  typedef typename std::conditional<std::is_same<Scalar, float>::value, float, double>::type GEMMType;
+
+  /**
+   * @brief Run a blocked search and export the neighbors with the Metric distances.
+   * @param[in] engine The blocked search engine
+   * @param[in] queries The queries
+   * @param[in] NN The number of neighbors
+   * @param[out] out_indices The (query, neighbor) indices
+   * @param[out] out_distances The Metric distances
+   */
+  template<typename Engine>
+  void exportNeighbours(const Engine& engine,
+                        const Eigen::Map<BaseMat>& queries,
+                        std::size_t NN,
+                        IndMatches& out_indices,
+                        std::vector<DistanceType>& out_distances) const
+  {
+    std::vector<std::pair<typename Engine::DistanceT, int> > neighbours;
+    engine.search(queries, NN, neighbours);
+
+    Metric metric;
+    #pragma omp parallel for
+    for (int i = 0; i < static_cast<int>(neighbours.size()); ++i)
+    {
+      const int queryIndex = i / NN;
+      const int dataIndex = neighbours[i].second;
+      out_distances[i] = metric(queries.row(queryIndex).data(), (*memMapping).row(dataIndex).data(), (*memMapping).cols());
+      out_indices[i] = IndMatch(queryIndex, dataIndex);
+    }
+  }
+
   /// Use a memory mapping in order to avoid memory re-allocation
   std::unique_ptr< Eigen::Map<BaseMat> > memMapping;
+  /// Squared L2 search engines
+  BlockedL2Search_UInt8 _blockedUInt8;
+  BlockedL2Search_GEMM<GEMMType> _blockedGEMM;
 };
 
 }  // namespace matching
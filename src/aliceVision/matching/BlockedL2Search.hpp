@@ -0,0 +1,463 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/config.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+#include <emmintrin.h>
+#endif
+
+namespace aliceVision {
+namespace matching {
+
+/**
+ * @brief Insert a neighbor in a list of the NN smallest (distance, index) pairs sorted by distance.
+ * A neighbor is inserted after the neighbors of equal distance, so the first index wins the ties.
+ * @param[in,out] best The NN sorted pairs
+ * @param[in] NN The number of neighbors
+ * @param[in] distance The neighbor distance
+ * @param[in] index The neighbor index
+ */
+template<typename DistanceT>
+inline void insertNeighbour(std::pair<DistanceT, int>* best, std::size_t NN, DistanceT distance, int index)
+{
+  if(!(distance < best[NN - 1].first))
+    return;
+  std::size_t k = NN - 1;
+  for(; k > 0 && distance < best[k - 1].first; --k)
+    best[k] = best[k - 1];
+  best[k] = std::make_pair(distance, index);
+}
+
+/**
+ * @brief Squared L2 nearest neighbors search by blocks of queries and tiles of the dataset.
+ *
+ * The distances are computed as |q|^2 + |d|^2 - 2 q.d, the dot products of a
+ * block of queries with a tile of the dataset being a matrix product.
+ * The NN smallest distances of each query are selected tile by tile,
+ * so the distances to the whole dataset are never stored.
+ */
+template<typename ComputeT>
+class BlockedL2Search_GEMM
+{
+public:
+  typedef ComputeT DistanceT;
+
+  /// number of queries processed together
+  static const int queryBlockSize = 64;
+  /// number of dataset rows compared to a block of queries at once
+  static const int dataTileSize = 1024;
+
+  bool isBuilt() const
+  {
+    return _data.rows() > 0;
+  }
+
+  void clear()
+  {
+    _data.resize(0, 0);
+    _norms.resize(0);
+  }
+
+  /**
+   * @brief Copy the dataset in the computation type and compute its norms.
+   * @param[in] dataset The dataset, one row per element
+   */
+  template<typename DatasetT>
+  void build(const DatasetT& dataset)
+  {
+    _data = dataset.template cast<ComputeT>();
+    _norms = _data.rowwise().squaredNorm();
+  }
+
+  /**
+   * @brief Search the NN nearest neighbors of each query.
+   * @param[in] queries The queries, one row per query
+   * @param[in] NN The number of neighbors, lower or equal to the dataset size
+   * @param[out] out_neighbours The NN (distance, index) pairs of each query, sorted by distance
+   */
+  template<typename QueriesT>
+  void search(const QueriesT& queries, std::size_t NN, std::vector<std::pair<DistanceT, int> >& out_neighbours) const
+  {
+    const int nbQuery = queries.rows();
+    const int nbData = _data.rows();
+    const int nbBlocks = (nbQuery + queryBlockSize - 1) / queryBlockSize;
+
+    out_neighbours.assign(nbQuery * NN, std::make_pair(std::numeric_limits<DistanceT>::max(), -1));
+
+    #pragma omp parallel
+    {
+      Matrix queryBlock;
+      Matrix tile;
+      Vector queryNorms;
+
+      #pragma omp for schedule(dynamic)
+      for(int block = 0; block < nbBlocks; ++block)
+      {
+        const int queryBegin = block * queryBlockSize;
+        const int blockSize = std::min(queryBlockSize, nbQuery - queryBegin);
+
+        queryBlock = queries.middleRows(queryBegin, blockSize).template cast<ComputeT>();
+        queryNorms = queryBlock.rowwise().squaredNorm();
+
+        for(int dataBegin = 0; dataBegin < nbData; dataBegin += dataTileSize)
+        {
+          const int tileSize = std::min(dataTileSize, nbData - dataBegin);
+          tile.noalias() = queryBlock * _data.middleRows(dataBegin, tileSize).transpose();
+
+          for(int q = 0; q < blockSize; ++q)
+          {
+            std::pair<DistanceT, int>* best = &out_neighbours[(queryBegin + q) * NN];
+            for(int d = 0; d < tileSize; ++d)
+              insertNeighbour(best, NN, queryNorms(q) + _norms(dataBegin + d) - 2 * tile(q, d), dataBegin + d);
+          }
+        }
+      }
+    }
+  }
+
+private:
+  typedef Eigen::Matrix<ComputeT, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
+  typedef Eigen::Matrix<ComputeT, Eigen::Dynamic, 1> Vector;
+
+  Matrix _data;
+  Vector _norms;
+};
+/**
+ * @brief Dot products of 16 queries with a panel of 16 dataset rows.
+ *
+ * The values are 16 bits integers grouped by pairs: a query pair is packed in a 32 bits integer,
+ * a panel stores the pair k of its 16 rows contiguously, so the multiply-add of a broadcasted
+ * query pair with the panel pair k accumulates the 16 rows without horizontal sums.
+ * @param[in] query The first query, the 16 queries are contiguous
+ * @param[in] panel The panel of 16 dataset rows
+ * @param[in] nbPairs The number of pairs of values of a row
+ * @param[out] out_dots The 16x16 dot products (query major)
+ */
+inline void dotProducts16x16(const std::int32_t* query, const std::int16_t* panel, int nbPairs, std::int32_t* out_dots)
+{
+#if defined(__AVX512BW__)
+  // one register for the 16 rows of each query
+  __m512i acc[16];
+  for(int q = 0; q < 16; ++q)
+    acc[q] = _mm512_setzero_si512();
+
+  for(int k = 0; k < nbPairs; ++k)
+  {
+    const __m512i d = _mm512_loadu_si512(panel + 32 * k);
+    for(int q = 0; q < 16; ++q)
+    {
+      const __m512i x = _mm512_set1_epi32(query[q * nbPairs + k]);
+#if defined(__AVX512VNNI__)
+      acc[q] = _mm512_dpwssd_epi32(acc[q], x, d);
+#else
+      acc[q] = _mm512_add_epi32(acc[q], _mm512_madd_epi16(x, d));
+#endif
+    }
+  }
+
+  for(int q = 0; q < 16; ++q)
+    _mm512_storeu_si512(out_dots + 16 * q, acc[q]);
+#elif defined(__AVX2__)
+  // passes of 4 queries, to keep the accumulators in registers
+  for(int q = 0; q < 16; q += 4)
+  {
+    const std::int32_t* x0 = query + q * nbPairs;
+    const std::int32_t* x1 = x0 + nbPairs;
+    const std::int32_t* x2 = x1 + nbPairs;
+    const std::int32_t* x3 = x2 + nbPairs;
+    __m256i acc00 = _mm256_setzero_si256(), acc01 = acc00, acc10 = acc00, acc11 = acc00;
+    __m256i acc20 = acc00, acc21 = acc00, acc30 = acc00, acc31 = acc00;
+
+    for(int k = 0; k < nbPairs; ++k)
+    {
+      const __m256i d0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(panel + 32 * k));
+      const __m256i d1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(panel + 32 * k + 16));
+      __m256i x = _mm256_set1_epi32(x0[k]);
+      acc00 = _mm256_add_epi32(acc00, _mm256_madd_epi16(x, d0));
+      acc01 = _mm256_add_epi32(acc01, _mm256_madd_epi16(x, d1));
+      x = _mm256_set1_epi32(x1[k]);
+      acc10 = _mm256_add_epi32(acc10, _mm256_madd_epi16(x, d0));
+      acc11 = _mm256_add_epi32(acc11, _mm256_madd_epi16(x, d1));
+      x = _mm256_set1_epi32(x2[k]);
+      acc20 = _mm256_add_epi32(acc20, _mm256_madd_epi16(x, d0));
+      acc21 = _mm256_add_epi32(acc21, _mm256_madd_epi16(x, d1));
+      x = _mm256_set1_epi32(x3[k]);
+      acc30 = _mm256_add_epi32(acc30, _mm256_madd_epi16(x, d0));
+      acc31 = _mm256_add_epi32(acc31, _mm256_madd_epi16(x, d1));
+    }
+
+    __m256i* out = reinterpret_cast<__m256i*>(out_dots + 16 * q);
+    _mm256_storeu_si256(out, acc00);
+    _mm256_storeu_si256(out + 1, acc01);
+    _mm256_storeu_si256(out + 2, acc10);
+    _mm256_storeu_si256(out + 3, acc11);
+    _mm256_storeu_si256(out + 4, acc20);
+    _mm256_storeu_si256(out + 5, acc21);
+    _mm256_storeu_si256(out + 6, acc30);
+    _mm256_storeu_si256(out + 7, acc31);
+  }
+#elif ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+  // passes of 4 queries and 8 rows, to keep the accumulators in registers
+  for(int q = 0; q < 16; q += 4)
+  {
+    const std::int32_t* x0 = query + q * nbPairs;
+    const std::int32_t* x1 = x0 + nbPairs;
+    const std::int32_t* x2 = x1 + nbPairs;
+    const std::int32_t* x3 = x2 + nbPairs;
+    for(int half = 0; half < 2; ++half)
+    {
+      __m128i acc00 = _mm_setzero_si128(), acc01 = acc00, acc10 = acc00, acc11 = acc00;
+      __m128i acc20 = acc00, acc21 = acc00, acc30 = acc00, acc31 = acc00;
+
+      for(int k = 0; k < nbPairs; ++k)
+      {
+        const __m128i d0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(panel + 32 * k + 16 * half));
+        const __m128i d1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(panel + 32 * k + 16 * half + 8));
+        __m128i x = _mm_set1_epi32(x0[k]);
+        acc00 = _mm_add_epi32(acc00, _mm_madd_epi16(x, d0));
+        acc01 = _mm_add_epi32(acc01, _mm_madd_epi16(x, d1));
+        x = _mm_set1_epi32(x1[k]);
+        acc10 = _mm_add_epi32(acc10, _mm_madd_epi16(x, d0));
+        acc11 = _mm_add_epi32(acc11, _mm_madd_epi16(x, d1));
+        x = _mm_set1_epi32(x2[k]);
+        acc20 = _mm_add_epi32(acc20, _mm_madd_epi16(x, d0));
+        acc21 = _mm_add_epi32(acc21, _mm_madd_epi16(x, d1));
+        x = _mm_set1_epi32(x3[k]);
+        acc30 = _mm_add_epi32(acc30, _mm_madd_epi16(x, d0));
+        acc31 = _mm_add_epi32(acc31, _mm_madd_epi16(x, d1));
+      }
+
+      __m128i* out = reinterpret_cast<__m128i*>(out_dots + 16 * q + 8 * half);
+      _mm_storeu_si128(out, acc00);
+      _mm_storeu_si128(out + 1, acc01);
+      _mm_storeu_si128(out + 4, acc10);
+      _mm_storeu_si128(out + 5, acc11);
+      _mm_storeu_si128(out + 8, acc20);
+      _mm_storeu_si128(out + 9, acc21);
+      _mm_storeu_si128(out + 12, acc30);
+      _mm_storeu_si128(out + 13, acc31);
+    }
+  }
+#else
+  for(int q = 0; q < 16; ++q)
+  {
+    for(int r = 0; r < 16; ++r)
+    {
+      std::int32_t sum = 0;
+      for(int k = 0; k < nbPairs; ++k)
+      {
+        const std::int32_t pair = query[q * nbPairs + k];
+        sum += std::int32_t(std::int16_t(pair & 0xFFFF)) * panel[32 * k + 2 * r]
+             + std::int32_t(std::int16_t(pair >> 16)) * panel[32 * k + 2 * r + 1];
+      }
+      out_dots[16 * q + r] = sum;
+    }
+  }
+#endif
+}
+
+/**
+ * @brief Insert the rows of a panel closer to a query than its current NN neighbors.
+ * The distances are |q|^2 + |d|^2 - 2 q.d, the rows farther than the current neighbors being rejected all at once.
+ * @param[in,out] best The NN sorted neighbors of the query
+ * @param[in] NN The number of neighbors
+ * @param[in] queryNorm The query squared norm
+ * @param[in] dataNorms The squared norms of the 16 rows
+ * @param[in] dots The dot products of the query with the 16 rows
+ * @param[in] nbRows The number of rows to consider (the panel padding rows are skipped)
+ * @param[in] dataBegin The index of the first row
+ */
+inline void insertPanelNeighbours(std::pair<std::int32_t, int>* best, std::size_t NN, std::int32_t queryNorm,
+                                  const std::int32_t* dataNorms, const std::int32_t* dots, int nbRows, int dataBegin)
+{
+  std::int32_t distances[16];
+#if defined(__AVX512BW__)
+  const __m512i d = _mm512_sub_epi32(_mm512_add_epi32(_mm512_set1_epi32(queryNorm), _mm512_loadu_si512(dataNorms)),
+                                     _mm512_slli_epi32(_mm512_loadu_si512(dots), 1));
+  const unsigned int mask = _mm512_cmplt_epi32_mask(d, _mm512_set1_epi32(best[NN - 1].first));
+  // most panels are farther than the current neighbors
+  if((mask & ((1u << nbRows) - 1)) == 0)
+    return;
+  _mm512_storeu_si512(distances, d);
+#elif defined(__AVX2__)
+  const __m256i queryNorms = _mm256_set1_epi32(queryNorm);
+  const __m256i threshold = _mm256_set1_epi32(best[NN - 1].first);
+  unsigned int mask = 0;
+  for(int i = 0; i < 2; ++i)
+  {
+    const __m256i norms = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dataNorms + 8 * i));
+    const __m256i products = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dots + 8 * i));
+    const __m256i d = _mm256_sub_epi32(_mm256_add_epi32(queryNorms, norms), _mm256_slli_epi32(products, 1));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(distances + 8 * i), d);
+    mask |= static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(threshold, d)))) << (8 * i);
+  }
+  // most panels are farther than the current neighbors
+  if((mask & ((1u << nbRows) - 1)) == 0)
+    return;
+#else
+  for(int r = 0; r < 16; ++r)
+    distances[r] = queryNorm + dataNorms[r] - 2 * dots[r];
+#endif
+  for(int r = 0; r < nbRows; ++r)
+    insertNeighbour(best, NN, distances[r], dataBegin + r);
+}
+
+/**
+ * @brief Squared L2 nearest neighbors search for unsigned char descriptors.
+ *
+ * Same blocked search as BlockedL2Search_GEMM, the dot products being computed
+ * exactly with 16 bits integer multiply-add instructions on 16 queries and 16 rows at once.
+ * The dataset is stored in panels of 16 rows (see dotProducts16x16), padded with zeros.
+ */
+class BlockedL2Search_UInt8
+{
+public:
+  typedef std::int32_t DistanceT;
+
+  /// number of queries processed together (multiple of 16)
+  static const int queryBlockSize = 64;
+  /// number of dataset rows of a panel
+  static const int panelSize = 16;
+
+  /**
+   * @brief Check if the squared distances of a given dimension fit in the distance type.
+   * @param[in] dimension The descriptors length
+   */
+  static bool isSupported(int dimension)
+  {
+    return 2.0 * dimension * 255.0 * 255.0 < double(std::numeric_limits<DistanceT>::max());
+  }
+
+  bool isBuilt() const
+  {
+    return _nbData > 0;
+  }
+
+  void clear()
+  {
+    _nbData = 0;
+    _panels.clear();
+    _norms.clear();
+  }
+
+  /**
+   * @brief Convert the dataset to panels of 16 bits integers and compute its norms.
+   * @param[in] dataset The dataset, one row per element
+   */
+  template<typename DatasetT>
+  void build(const DatasetT& dataset)
+  {
+    _nbData = dataset.rows();
+    _dimension = dataset.cols();
+    _nbPairs = (_dimension + 1) / 2;
+
+    const int nbPanels = (_nbData + panelSize - 1) / panelSize;
+    _panels.assign(nbPanels * _nbPairs * 2 * panelSize, 0);
+    _norms.assign(nbPanels * panelSize, 0);
+    for(int i = 0; i < _nbData; ++i)
+    {
+      std::int16_t* panel = &_panels[(i / panelSize) * _nbPairs * 2 * panelSize];
+      const int r = i % panelSize;
+      DistanceT norm = 0;
+      for(int k = 0; k < _dimension; ++k)
+      {
+        const std::int16_t value = dataset(i, k);
+        panel[(k / 2) * 2 * panelSize + 2 * r + k % 2] = value;
+        norm += DistanceT(value) * value;
+      }
+      _norms[i] = norm;
+    }
+  }
+
+  /**
+   * @brief Search the NN nearest neighbors of each query.
+   * @param[in] queries The queries, one row per query
+   * @param[in] NN The number of neighbors, lower or equal to the dataset size
+   * @param[out] out_neighbours The NN (distance, index) pairs of each query, sorted by distance
+   */
+  template<typename QueriesT>
+  void search(const QueriesT& queries, std::size_t NN, std::vector<std::pair<DistanceT, int> >& out_neighbours) const
+  {
+    const int nbQuery = queries.rows();
+    const int nbBlocks = (nbQuery + queryBlockSize - 1) / queryBlockSize;
+    const int panelLength = _nbPairs * 2 * panelSize;
+
+    out_neighbours.assign(nbQuery * NN, std::make_pair(std::numeric_limits<DistanceT>::max(), -1));
+
+    #pragma omp parallel
+    {
+      std::vector<std::int32_t> queryBlock(queryBlockSize * _nbPairs, 0);
+      std::vector<DistanceT> queryNorms(queryBlockSize, 0);
+      std::vector<std::pair<DistanceT, int> > paddingNeighbours(16 * NN, std::make_pair(std::numeric_limits<DistanceT>::max(), -1));
+      std::vector<std::pair<DistanceT, int>*> best(queryBlockSize);
+      std::int32_t dots[16 * panelSize];
+
+      #pragma omp for schedule(dynamic)
+      for(int block = 0; block < nbBlocks; ++block)
+      {
+        const int queryBegin = block * queryBlockSize;
+        const int blockSize = std::min(queryBlockSize, nbQuery - queryBegin);
+        const int paddedBlockSize = (blockSize + 15) / 16 * 16;
+
+        // pack the pairs of values of the queries, the padding queries use a local list
+        std::fill(queryBlock.begin(), queryBlock.begin() + paddedBlockSize * _nbPairs, 0);
+        for(int q = 0; q < paddedBlockSize; ++q)
+        {
+          best[q] = (q < blockSize) ? &out_neighbours[(queryBegin + q) * NN] : &paddingNeighbours[(q % 16) * NN];
+          if(q >= blockSize)
+            continue;
+          std::int32_t* row = &queryBlock[q * _nbPairs];
+          DistanceT norm = 0;
+          for(int k = 0; k < _dimension; ++k)
+          {
+            const std::int32_t value = queries(queryBegin + q, k);
+            row[k / 2] |= (k % 2) ? (value << 16) : value;
+            norm += value * value;
+          }
+          queryNorms[q] = norm;
+        }
+
+        for(int dataBegin = 0; dataBegin < _nbData; dataBegin += panelSize)
+        {
+          const std::int16_t* panel = &_panels[(dataBegin / panelSize) * panelLength];
+          const DistanceT* dataNorms = &_norms[dataBegin];
+          // the padding rows of the last panel are skipped
+          const int nbRows = std::min(panelSize, _nbData - dataBegin);
+
+          for(int q = 0; q < paddedBlockSize; q += 16)
+          {
+            dotProducts16x16(&queryBlock[q * _nbPairs], panel, _nbPairs, dots);
+            for(int i = 0; i < 16; ++i)
+              insertPanelNeighbours(best[q + i], NN, queryNorms[q + i], dataNorms, &dots[i * panelSize], nbRows, dataBegin);
+          }
+        }
+      }
+    }
+  }
+
+private:
+  int _nbData = 0;
+  int _dimension = 0;
+  int _nbPairs = 0;
+  /// dataset panels of 16 rows (see dotProducts16x16)
+  std::vector<std::int16_t> _panels;
+  /// dataset norms, padded to a multiple of 16 rows
+  std::vector<DistanceT> _norms;
+};
+
+} // namespace matching
+} // namespace aliceVision
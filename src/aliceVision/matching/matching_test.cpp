@@ -8,6 +8,7 @@
 #include "aliceVision/matching/ArrayMatcher_kdtreeFlann.hpp"
 #include "aliceVision/matching/ArrayMatcher_cascadeHashing.hpp"
 #include <iostream>
+#include <random>
 
 #define BOOST_TEST_MODULE matching
 #include <boost/test/included/unit_test.hpp>
@@ -80,6 +81,72 @@ BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForce_Simple_Dim4)
   BOOST_CHECK_SMALL(static_cast<double>(fDistance), 1e-8); //distance
 }
 
+/**
+ * @brief Check the blocked brute force search against an exhaustive search
+ *        on a dataset spanning several tiles and several query blocks.
+ */
+template<typename Scalar, typename Metric>
+void checkBruteForceBlocks(int dimension, double maxValue)
+{
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<double> value(0.0, maxValue);
+
+  const int nbData = 2500;
+  const int nbQuery = 150;
+  const std::size_t NN = 2;
+  std::vector<Scalar> data(nbData * dimension), query(nbQuery * dimension);
+  for(Scalar& v : data)
+    v = static_cast<Scalar>(value(gen));
+  for(Scalar& v : query)
+    v = static_cast<Scalar>(value(gen));
+
+  ArrayMatcher_bruteForce<Scalar, Metric> matcher;
+  BOOST_CHECK( matcher.Build(&data[0], nbData, dimension) );
+
+  IndMatches indices;
+  std::vector<typename Metric::ResultType> distances;
+  BOOST_CHECK( matcher.SearchNeighbours(&query[0], nbQuery, &indices, &distances, NN) );
+  BOOST_CHECK_EQUAL(nbQuery * NN, indices.size());
+
+  Metric metric;
+  for(int q = 0; q < nbQuery; ++q)
+  {
+    std::vector<std::pair<double, int> > reference(nbData);
+    for(int i = 0; i < nbData; ++i)
+    {
+      double distance = 0.0;
+      for(int k = 0; k < dimension; ++k)
+        distance += Square(double(query[q * dimension + k]) - double(data[i * dimension + k]));
+      reference[i] = std::make_pair(distance, i);
+    }
+    std::partial_sort(reference.begin(), reference.begin() + NN, reference.end());
+
+    for(std::size_t k = 0; k < NN; ++k)
+    {
+      const IndMatch& match = indices[q * NN + k];
+      BOOST_CHECK_EQUAL(q, match._i);
+      BOOST_CHECK_CLOSE(reference[k].first, double(distances[q * NN + k]), 1e-4);
+      // returned distances are the metric distances
+      BOOST_CHECK_EQUAL(metric(&query[q * dimension], &data[match._j * dimension], dimension), distances[q * NN + k]);
+    }
+    BOOST_CHECK_EQUAL(reference[0].second, indices[q * NN]._j);
+  }
+
+  int nIndice = -1;
+  typename Metric::ResultType distance = -1;
+  BOOST_CHECK( matcher.SearchNeighbour(&query[0], &nIndice, &distance) );
+  BOOST_CHECK_EQUAL(indices[0]._j, nIndice);
+  BOOST_CHECK_EQUAL(distances[0], distance);
+}
+
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForce_Blocks)
+{
+  checkBruteForceBlocks<unsigned char, L2_Vectorized<unsigned char> >(128, 255.0);
+  checkBruteForceBlocks<unsigned char, L2_Simple<unsigned char> >(256, 255.0);
+  checkBruteForceBlocks<unsigned char, L2_Simple<unsigned char> >(37, 255.0);
+  checkBruteForceBlocks<float, L2_Vectorized<float> >(64, 1.0);
+}
+
 BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_kdtreeFlann_Simple__NN)
 {
   const float array[] = {0, 1, 2, 5, 6};
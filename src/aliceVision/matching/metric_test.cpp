@@ -5,7 +5,9 @@
 
 #include "aliceVision/matching/metric.hpp"
 #include <iostream>
+#include <random>
 #include <string>
+#include <vector>
 
 #define BOOST_TEST_MODULE matchingMetric
 #include <boost/test/included/unit_test.hpp>
@@ -42,6 +44,29 @@ BOOST_AUTO_TEST_CASE(Metric_L2_Vectorized)
   BOOST_CHECK_EQUAL(168, DistanceT<L2_Vectorized<double> >());
 }
 
+BOOST_AUTO_TEST_CASE(Metric_L2_Vectorized_uchar_descriptors)
+{
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> dist(0, 255);
+
+  // descriptor sizes with and without remainder
+  for(const std::size_t size : {128, 131, 7})
+  {
+    std::vector<unsigned char> a(size), b(size);
+    for(std::size_t i = 0; i < size; ++i)
+    {
+      a[i] = dist(gen);
+      b[i] = dist(gen);
+    }
+    BOOST_CHECK_EQUAL(L2_Simple<unsigned char>()(a.data(), b.data(), size),
+                      L2_Vectorized<unsigned char>()(a.data(), b.data(), size));
+  }
+
+  // maximal distance
+  const std::vector<unsigned char> zeros(128, 0), ones(128, 255);
+  BOOST_CHECK_EQUAL(128.f * 255.f * 255.f, L2_Vectorized<unsigned char>()(zeros.data(), ones.data(), 128));
+}
+
 BOOST_AUTO_TEST_CASE(Metric_HAMMING_BITSET)
 {
   std::bitset<8> a(std::string("01010101"));
@@ -0,0 +1,47 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "GeometricFilter.hpp"
+
+#include <aliceVision/system/Logger.hpp>
+
+#include <fstream>
+
+namespace aliceVision {
+namespace matchingImageCollection {
+
+bool GeometricFilter::exportStatistics(const std::string& filename, const std::string& modelName) const
+{
+  std::ofstream os(filename, std::ios::app);
+  if(!os.is_open())
+  {
+    ALICEVISION_LOG_DEBUG("Unable to open the geometric filter stat file '" << filename << "'.");
+    return false;
+  }
+  os.seekp(0, std::ios::end); //put the cursor at the end
+
+  if(os.tellp() == 0)
+  {
+    // If the file does't exist: add a header.
+    os << "Model\tViewI\tViewJ\tPutatives\tInliers\tInlierRatio\tStrongSupport\tPrecision\tTime(s)\n";
+  }
+
+  for(const GeometricFilterPairStats& pairStats : _pairStats)
+  {
+    os << modelName << "\t"
+       << pairStats.pair.first << "\t"
+       << pairStats.pair.second << "\t"
+       << pairStats.nbPutativeMatches << "\t"
+       << pairStats.nbInliers << "\t"
+       << pairStats.inlierRatio() << "\t"
+       << pairStats.hasStrongSupport << "\t"
+       << pairStats.precision << "\t"
+       << pairStats.time << "\n";
+  }
+  return true;
+}
+
+} // namespace matchingImageCollection
+} // namespace aliceVision
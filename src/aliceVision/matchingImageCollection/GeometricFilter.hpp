@@ -10,11 +10,16 @@
 #include "aliceVision/feature/RegionsPerView.hpp"
 #include "aliceVision/matching/IndMatch.hpp"
 #include "aliceVision/matchingImageCollection/GeometricFilterMatrix.hpp"
+#include "aliceVision/system/Timer.hpp"
+#include "aliceVision/system/Tracing.hpp"
 
 #include "dependencies/stlplus3/filesystemSimplified/file_system.hpp"
 
 #include <boost/progress.hpp>
 
+#include <algorithm>
+#include <numeric>
+#include <string>
 #include <vector>
 #include <map>
 
@@ -23,6 +28,24 @@ namespace matchingImageCollection {
 
 using namespace aliceVision::matching;
 
+/// Robust model estimation statistics of one image pair
+struct GeometricFilterPairStats
+{
+  Pair pair;
+  std::size_t nbPutativeMatches = 0;
+  std::size_t nbInliers = 0;
+  bool hasStrongSupport = false;
+  /// a contrario precision of the estimated model (upper bound if the estimation failed)
+  double precision = 0.0;
+  /// estimation time in seconds
+  double time = 0.0;
+
+  double inlierRatio() const
+  {
+    return (nbPutativeMatches > 0) ? nbInliers / static_cast<double>(nbPutativeMatches) : 0.0;
+  }
+};
+
 /// Allow to keep only geometrically coherent matches
 /// -> It discards pairs that do not lead to a valid robust model estimation
 struct GeometricFilter
@@ -44,10 +67,22 @@ struct GeometricFilter
 
   const PairwiseMatches & Get_geometric_matches() const {return _map_GeometricMatches;}
 
+  /// Statistics of the pairs processed by the last Robust_model_estimation call (in pair order)
+  const std::vector<GeometricFilterPairStats> & Get_pair_statistics() const {return _pairStats;}
+
+  /**
+   * @brief Append the statistics of the last robust model estimation to a tab separated file.
+   * @param[in] filename The statistics file path
+   * @param[in] modelName The name of the estimated geometric model
+   * @return true if the file has been written
+   */
+  bool exportStatistics(const std::string& filename, const std::string& modelName) const;
+
   // Data
   const sfm::SfMData * _sfm_data;
   const feature::RegionsPerView & _regionsPerView;
   PairwiseMatches _map_GeometricMatches;
+  std::vector<GeometricFilterPairStats> _pairStats;
 };
 
 template<typename GeometryFunctor>
@@ -57,23 +92,56 @@ void GeometricFilter::Robust_model_estimation(
   const bool b_guided_matching,
   const double d_distance_ratio)
 {
+  // the pair spans of the worker threads are nested in this one
+  ALICEVISION_TRACE_SCOPE("geometricFilter");
+
+  // Flatten the pairs to process, in the putative_matches order
+  struct PairJob
+  {
+    Pair pair;
+    const MatchesPerDescType * putativeMatches;
+  };
+  std::vector<PairJob> jobs;
+  jobs.reserve(putative_matches.size());
+  _pairStats.assign(putative_matches.size(), GeometricFilterPairStats());
+
+  for(const auto& putativeMatchesPerPair : putative_matches)
+  {
+    _pairStats[jobs.size()].pair = putativeMatchesPerPair.first;
+    _pairStats[jobs.size()].nbPutativeMatches = putativeMatchesPerPair.second.getNbAllMatches();
+    jobs.push_back({putativeMatchesPerPair.first, &putativeMatchesPerPair.second});
+  }
+
+  // The robust estimation cost grows with the number of putative matches:
+  // process the most expensive pairs first to balance the threads workload
+  std::vector<std::size_t> schedule(jobs.size());
+  std::iota(schedule.begin(), schedule.end(), 0);
+  std::stable_sort(schedule.begin(), schedule.end(), [&](std::size_t a, std::size_t b)
+  {
+    return _pairStats[a].nbPutativeMatches > _pairStats[b].nbPutativeMatches;
+  });
+
+  // Each pair writes its inliers in its own slot
+  std::vector<MatchesPerDescType> inliersPerPair(jobs.size());
+
   boost::progress_display my_progress_bar( putative_matches.size() );
-  
+
   #pragma omp parallel for schedule(dynamic)
-  for (int i = 0; i < (int)putative_matches.size(); ++i)
+  for (int s = 0; s < (int)schedule.size(); ++s)
   {
-    PairwiseMatches::const_iterator iter = putative_matches.begin();
-    advance(iter,i);
-
-    Pair current_pair = iter->first;
-    const MatchesPerDescType & putativeMatchesPerType = iter->second;
-    const Pair& imagePair = iter->first;
+    const std::size_t i = schedule[s];
+    const Pair& imagePair = jobs[i].pair;
+    const MatchesPerDescType & putativeMatchesPerType = *jobs[i].putativeMatches;
+    GeometricFilterPairStats& pairStats = _pairStats[i];
+    ALICEVISION_TRACE_SCOPE("geometricFilter.pair", imagePair);
+    system::Timer timer;
 
     //-- Apply the geometric filter (robust model estimation)
     {
       MatchesPerDescType inliers;
       GeometryFunctor geometricFilter = functor; // use a copy since we are in a multi-thread context
       const EstimationStatus state = geometricFilter.geometricEstimation(_sfm_data, _regionsPerView, imagePair, putativeMatchesPerType, inliers);
+      pairStats.precision = geometricFilter.m_dPrecision_robust;
       if (state.hasStrongSupport)
       {
         if (b_guided_matching)
@@ -83,17 +151,25 @@ void GeometricFilter::Robust_model_estimation(
           //ALICEVISION_LOG_DEBUG("#before/#after: " << putative_inliers.size() << "/" << guided_geometric_inliers.size());
           std::swap(inliers, guided_geometric_inliers);
         }
-        #pragma omp critical
-        {
-          _map_GeometricMatches.insert(std::make_pair(current_pair, std::move(inliers)));
-        }
+        pairStats.hasStrongSupport = true;
+        pairStats.nbInliers = inliers.getNbAllMatches();
+        inliersPerPair[i] = std::move(inliers);
       }
     }
+    pairStats.time = timer.elapsed();
+
     #pragma omp critical
     {
       ++my_progress_bar;
     }
   }
+
+  // Gather the valid pairs, already sorted by pair
+  for(std::size_t i = 0; i < jobs.size(); ++i)
+  {
+    if(_pairStats[i].hasStrongSupport)
+      _map_GeometricMatches.emplace_hint(_map_GeometricMatches.end(), jobs[i].pair, std::move(inliersPerPair[i]));
+  }
 }
 
 } // namespace aliceVision
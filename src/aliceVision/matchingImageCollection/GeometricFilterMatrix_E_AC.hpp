@@ -9,6 +9,7 @@
 #include "aliceVision/multiview/essentialKernelSolver.hpp"
 #include "aliceVision/multiview/essential.hpp"
 #include "aliceVision/robustEstimation/ACRansac.hpp"
+#include "aliceVision/robustEstimation/ACRansacFast.hpp"
 #include "aliceVision/robustEstimation/ACRansacKernelAdaptator.hpp"
 #include "aliceVision/robustEstimation/guidedMatching.hpp"
 #include <limits>
@@ -92,7 +93,7 @@ struct GeometricFilterMatrix_E_AC : public GeometricFilterMatrix
     const double upper_bound_precision = Square(m_dPrecision);
 
     std::vector<size_t> inliers;
-    const std::pair<double,double> ACRansacOut = ACRANSAC(kernel, inliers, m_stIteration, &m_E, upper_bound_precision);
+    const std::pair<double,double> ACRansacOut = ACRANSAC_Fast(kernel, inliers, m_stIteration, &m_E, upper_bound_precision);
 
     if (inliers.empty())
       return EstimationStatus(false, false);
@@ -158,9 +159,9 @@ struct GeometricFilterMatrix_E_AC : public GeometricFilterMatrix
       Mat3 F;
       FundamentalFromEssential(m_E, ptrPinhole_I->K(), ptrPinhole_J->K(), &F);
 
-      robustEstimation::GuidedMatching<Mat3,
-            aliceVision::fundamental::kernel::EpipolarDistanceError>(
-            //aliceVision::fundamental::kernel::SymmetricEpipolarDistanceError>(
+      robustEstimation::GuidedMatching_Grid<Mat3,
+            aliceVision::fundamental::kernel::EpipolarDistanceError,
+            robustEstimation::EpipolarSearchRegion>(
         F,
         cam_I, regionsPerView.getAllRegions(viewId_I),
         cam_J, regionsPerView.getAllRegions(viewId_J),
@@ -12,6 +12,7 @@
 #include "aliceVision/multiview/essential.hpp"
 #include "aliceVision/robustEstimation/estimators.hpp"
 #include "aliceVision/robustEstimation/ACRansac.hpp"
+#include "aliceVision/robustEstimation/ACRansacFast.hpp"
 #include "aliceVision/robustEstimation/ACRansacKernelAdaptator.hpp"
 #include "aliceVision/robustEstimation/LORansac.hpp"
 #include "aliceVision/robustEstimation/LORansacKernelAdaptor.hpp"
@@ -170,7 +171,7 @@ struct GeometricFilterMatrix_F_AC: public GeometricFilterMatrix
         // Robustly estimate the Fundamental matrix with A Contrario ransac
         const double upper_bound_precision = Square(m_dPrecision);
         const std::pair<double,double> ACRansacOut =
-          ACRANSAC(kernel, out_inliers, m_stIteration, &m_F, upper_bound_precision);
+          ACRANSAC_Fast(kernel, out_inliers, m_stIteration, &m_F, upper_bound_precision);
 
         if(out_inliers.empty())
           return std::make_pair(false, KernelType::MINIMUM_SAMPLES);
@@ -251,8 +252,9 @@ struct GeometricFilterMatrix_F_AC: public GeometricFilterMatrix
           sfmData->GetIntrinsics().at(view_J->getIntrinsicId()).get() : nullptr;
 
       // Check the features correspondences that agree in the geometric and photometric domain
-      robustEstimation::GuidedMatching<Mat3,
-                                     fundamental::kernel::EpipolarDistanceError>(
+      robustEstimation::GuidedMatching_Grid<Mat3,
+                                     fundamental::kernel::EpipolarDistanceError,
+                                     robustEstimation::EpipolarSearchRegion>(
         m_F,
         cam_I, // camera::IntrinsicBase
         regionsPerView.getAllRegions(viewId_I), // feature::Regions
@@ -7,6 +7,7 @@
 
 #include "aliceVision/multiview/homographyKernelSolver.hpp"
 #include "aliceVision/robustEstimation/ACRansac.hpp"
+#include "aliceVision/robustEstimation/ACRansacFast.hpp"
 #include "aliceVision/robustEstimation/ACRansacKernelAdaptator.hpp"
 #include "aliceVision/robustEstimation/guidedMatching.hpp"
 
@@ -74,7 +75,7 @@ struct GeometricFilterMatrix_H_AC : public GeometricFilterMatrix
     const double upper_bound_precision = Square(m_dPrecision);
 
     std::vector<size_t> inliers;
-    const std::pair<double,double> ACRansacOut = ACRANSAC(kernel, inliers, m_stIteration, &m_H, upper_bound_precision);
+    const std::pair<double,double> ACRansacOut = ACRANSAC_Fast(kernel, inliers, m_stIteration, &m_H, upper_bound_precision);
 
     if (inliers.empty())
       return EstimationStatus(false, false);
@@ -221,8 +222,8 @@ struct GeometricFilterMatrix_H_AC : public GeometricFilterMatrix
           createMatricesWithUndistortFeatures(cam_I, pointsFeaturesI, xI);
           createMatricesWithUndistortFeatures(cam_J, pointsFeaturesJ, xJ);
 
-          robustEstimation::GuidedMatching
-            <Mat3, aliceVision::homography::kernel::AsymmetricError>(
+          robustEstimation::GuidedMatching_Grid
+            <Mat3, aliceVision::homography::kernel::AsymmetricError, robustEstimation::HomographySearchRegion>(
             m_H, xI, xJ, Square(m_dPrecision_robust), localMatches);
 
           // Remove matches that have the same (X,Y) coordinates
@@ -234,8 +235,8 @@ struct GeometricFilterMatrix_H_AC : public GeometricFilterMatrix
       else
       {
         // Filtering based on region positions and regions descriptors
-        robustEstimation::GuidedMatching
-          <Mat3, aliceVision::homography::kernel::AsymmetricError>(
+        robustEstimation::GuidedMatching_Grid
+          <Mat3, aliceVision::homography::kernel::AsymmetricError, robustEstimation::HomographySearchRegion>(
           m_H,
           cam_I, regionsPerView.getAllRegions(viewId_I),
           cam_J, regionsPerView.getAllRegions(viewId_J),
@@ -0,0 +1,145 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/sfm/SfMData.hpp"
+#include "aliceVision/sfm/View.hpp"
+#include "aliceVision/feature/regionsFactory.hpp"
+#include "aliceVision/matchingImageCollection/GeometricFilter.hpp"
+#include "aliceVision/matchingImageCollection/geometricFilterUtils.hpp"
+#include "aliceVision/matchingImageCollection/GeometricFilterMatrix_H_AC.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE GeometricFilter
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::matchingImageCollection;
+
+static const std::size_t nbViews = 10;
+static const std::size_t nbFeatures = 200;
+static const feature::EImageDescriberType descType = feature::EImageDescriberType::SIFT;
+
+/**
+ * @brief Create views related by homographies: the feature k of each view is the image of the
+ * same plane point. Each pair has its own number of putative matches and of inliers, the other
+ * putative matches link unrelated features.
+ */
+void createHomographyScene(sfm::SfMData& sfmData, feature::RegionsPerView& regionsPerView, PairwiseMatches& putativeMatches)
+{
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> position(0.0, 1000.0);
+  std::uniform_real_distribution<double> perturbation(-0.1, 0.1);
+
+  std::vector<Vec2> planePoints(nbFeatures);
+  for(Vec2& point : planePoints)
+    point = Vec2(position(generator), position(generator));
+
+  for(IndexT viewId = 0; viewId < nbViews; ++viewId)
+  {
+    sfmData.views.emplace(viewId, std::make_shared<sfm::View>("", viewId, UndefinedIndexT, viewId, 1000, 1000));
+
+    Mat3 H;
+    H << 1.0 + perturbation(generator), perturbation(generator), 100.0 * perturbation(generator),
+         perturbation(generator), 1.0 + perturbation(generator), 100.0 * perturbation(generator),
+         1e-4 * perturbation(generator), 1e-4 * perturbation(generator), 1.0;
+
+    std::unique_ptr<feature::SIFT_Regions> regions(new feature::SIFT_Regions);
+    regions->Features().resize(nbFeatures);
+    regions->Descriptors().resize(nbFeatures);
+    for(std::size_t k = 0; k < nbFeatures; ++k)
+    {
+      const Vec3 x = H * planePoints[k].homogeneous();
+      regions->Features()[k] = feature::SIOPointFeature(x(0) / x(2), x(1) / x(2), 1.f, 0.f);
+    }
+    regionsPerView.getData()[viewId][descType] = std::move(regions);
+  }
+
+  std::uniform_int_distribution<std::size_t> featureIndex(0, nbFeatures - 1);
+  for(IndexT i = 0; i < nbViews; ++i)
+  {
+    for(IndexT j = i + 1; j < nbViews; ++j)
+    {
+      // from a few inliers (rejected pair) to a few outliers
+      const std::size_t nbPutatives = 20 + featureIndex(generator) % (nbFeatures - 20);
+      const std::size_t nbInliers = std::min(nbPutatives, (i + j) % 4 == 0 ? std::size_t(3) : nbPutatives / 2 + featureIndex(generator) % (nbPutatives / 2));
+
+      std::vector<std::size_t> features(nbFeatures);
+      std::iota(features.begin(), features.end(), 0);
+      std::shuffle(features.begin(), features.end(), generator);
+
+      IndMatches& matches = putativeMatches[std::make_pair(i, j)][descType];
+      for(std::size_t m = 0; m < nbPutatives; ++m)
+      {
+        const std::size_t k = features[m];
+        matches.emplace_back(k, (m < nbInliers) ? k : (k + 1 + featureIndex(generator) % (nbFeatures - 1)) % nbFeatures);
+      }
+    }
+  }
+}
+
+/// Sort the matches of each descriptor type, the inliers order depends on the robust estimation
+void sortMatches(MatchesPerDescType& matchesPerDesc)
+{
+  for(auto& matches : matchesPerDesc)
+    std::sort(matches.second.begin(), matches.second.end());
+}
+
+BOOST_AUTO_TEST_CASE(GeometricFilter_flattenedPairs)
+{
+  sfm::SfMData sfmData;
+  feature::RegionsPerView regionsPerView;
+  PairwiseMatches putativeMatches;
+  createHomographyScene(sfmData, regionsPerView, putativeMatches);
+
+  const GeometricFilterMatrix_H_AC functor(std::numeric_limits<double>::infinity(), 2048);
+
+  // reference: each pair filtered one after the other
+  PairwiseMatches referenceMatches;
+  for(const auto& putativeMatchesPerPair : putativeMatches)
+  {
+    GeometricFilterMatrix_H_AC geometricFilter = functor;
+    MatchesPerDescType inliers;
+    const EstimationStatus state = geometricFilter.geometricEstimation(&sfmData, regionsPerView, putativeMatchesPerPair.first, putativeMatchesPerPair.second, inliers);
+    if(state.hasStrongSupport)
+      referenceMatches[putativeMatchesPerPair.first] = inliers;
+  }
+  BOOST_REQUIRE(!referenceMatches.empty());
+  BOOST_REQUIRE_LT(referenceMatches.size(), putativeMatches.size());
+
+  GeometricFilter geometricFilter(&sfmData, regionsPerView);
+  geometricFilter.Robust_model_estimation(functor, putativeMatches);
+
+  // same pairs and same inliers
+  PairwiseMatches geometricMatches = geometricFilter.Get_geometric_matches();
+  BOOST_REQUIRE_EQUAL(geometricMatches.size(), referenceMatches.size());
+  for(auto& referencePair : referenceMatches)
+  {
+    const auto it = geometricMatches.find(referencePair.first);
+    BOOST_REQUIRE(it != geometricMatches.end());
+    sortMatches(referencePair.second);
+    sortMatches(it->second);
+    BOOST_CHECK(it->second == referencePair.second);
+  }
+
+  // the statistics of each pair, in pair order
+  const std::vector<GeometricFilterPairStats>& pairStats = geometricFilter.Get_pair_statistics();
+  BOOST_REQUIRE_EQUAL(pairStats.size(), putativeMatches.size());
+  std::size_t i = 0;
+  for(const auto& putativeMatchesPerPair : putativeMatches)
+  {
+    const GeometricFilterPairStats& stats = pairStats[i++];
+    BOOST_CHECK(stats.pair == putativeMatchesPerPair.first);
+    BOOST_CHECK_EQUAL(stats.nbPutativeMatches, putativeMatchesPerPair.second.getNbAllMatches());
+
+    const auto it = referenceMatches.find(putativeMatchesPerPair.first);
+    BOOST_CHECK_EQUAL(stats.hasStrongSupport, it != referenceMatches.end());
+    BOOST_CHECK_EQUAL(stats.nbInliers, (it != referenceMatches.end()) ? it->second.getNbAllMatches() : 0);
+  }
+}
@@ -9,6 +9,7 @@
 #include <aliceVision/matching/ArrayMatcher_cascadeHashing.hpp>
 #include <aliceVision/matching/RegionsMatcher.hpp>
 #include <aliceVision/matchingImageCollection/IImageCollectionMatcher.hpp>
+#include <aliceVision/system/Tracing.hpp>
 #include <aliceVision/config.hpp>
 
 #include <dependencies/stlplus3/filesystemSimplified/file_system.hpp>
@@ -36,6 +37,7 @@ void ImageCollectionMatcher_generic::Match(
   feature::EImageDescriberType descType,
   matching::PairwiseMatches & map_PutativesMatches)const // the pairwise photometric corresponding points
 {
+  ALICEVISION_TRACE_SCOPE("matching");
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_OPENMP)
   ALICEVISION_LOG_DEBUG("Using the OPENMP thread interface");
 #endif
@@ -67,12 +69,14 @@ void ImageCollectionMatcher_generic::Match(
     }
 
     // Initialize the matching interface
+    ALICEVISION_TRACE_SCOPE("matching.view", I);
     matching::RegionsDatabaseMatcher matcher(_matcherType, regionsI);
 
     #pragma omp parallel for schedule(dynamic) if(b_multithreaded_pair_search)
     for (int j = 0; j < (int)indexToCompare.size(); ++j)
     {
       const size_t J = indexToCompare[j];
+      ALICEVISION_TRACE_SCOPE("matching.pair", Pair(I, J));
 
       const feature::Regions &regionsJ = regionsPerView.getRegions(J, descType);
       if (regionsJ.RegionCount() == 0
@@ -134,6 +134,29 @@ bool loadPairs(const std::string &sFileName,
   return true;
 }
 
+namespace {
+
+/// Write the pairs grouped by consecutive first image, one line per image: I J K L
+template <typename PairIterator>
+void writePairsPerView(std::ostream& stream, PairIterator begin, PairIterator end)
+{
+  while(begin != end)
+  {
+    const IndexT I = begin->first;
+    stream << I;
+    for(; begin != end && begin->first == I; ++begin)
+      stream << ' ' << begin->second;
+    stream << '\n';
+  }
+}
+
+} // namespace
+
+void writePairs(std::ostream& stream, const PairVec& pairs)
+{
+  writePairsPerView(stream, pairs.begin(), pairs.end());
+}
+
 bool savePairs(const std::string &sFileName, const PairSet & pairs)
 {
   std::ofstream outStream(sFileName.c_str());
@@ -141,11 +164,7 @@ bool savePairs(const std::string &sFileName, const PairSet & pairs)
     ALICEVISION_LOG_WARNING("savePairs: Impossible to open the output specified file: \"" << sFileName << "\".");
     return false;
   }
-  for (PairSet::const_iterator iterP = pairs.begin();
-    iterP != pairs.end(); ++iterP)
-  {
-    outStream << iterP->first << ' ' << iterP->second << '\n';
-  }
+  writePairsPerView(outStream, pairs.begin(), pairs.end());
   bool bOk = !outStream.bad();
   outStream.close();
   return bOk;
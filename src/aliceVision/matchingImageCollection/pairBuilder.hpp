@@ -9,6 +9,7 @@
 #include <aliceVision/sfm/SfMData.hpp>
 
 #include <algorithm>
+#include <ostream>
 
 namespace aliceVision {
 
@@ -27,9 +28,12 @@ bool loadPairs(
      int rangeStart=-1,
      int rangeSize=0);
 
-/// Save a set of PairSet to a file (one pair per line)
-/// I J
-/// I K
+/// Write pairs sorted by first image to a stream, in the loadPairs format (one line per image)
+/// I J K L (pair that link I)
+void writePairs(std::ostream& stream, const PairVec& pairs);
+
+/// Save a set of PairSet to a file, in the loadPairs format (one line per image)
+/// I J K L (pair that link I)
 bool savePairs(const std::string &sFileName, const PairSet & pairs);
 
 }; // namespace aliceVision
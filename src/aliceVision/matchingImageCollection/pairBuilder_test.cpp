@@ -10,6 +10,7 @@
 #include <iostream>
 #include <algorithm>
 #include <memory>
+#include <sstream>
 
 #define BOOST_TEST_MODULE matchingImageCollectionPairBuilder
 #include <boost/test/included/unit_test.hpp>
@@ -124,3 +125,25 @@ BOOST_AUTO_TEST_CASE(matchingImageCollection_IO)
   BOOST_CHECK( loadPairs("pairsT_IO.txt", loaded_Pairs));
   BOOST_CHECK( std::equal(loaded_Pairs.begin(), loaded_Pairs.end(), pairSetGTsorted.begin()) );
 }
+
+BOOST_AUTO_TEST_CASE(IO_pairsPerView)
+{
+  PairVec pairs;
+  pairs.emplace_back(0, 1);
+  pairs.emplace_back(0, 2);
+  pairs.emplace_back(0, 3);
+  pairs.emplace_back(2, 3);
+
+  // one line per view I
+  std::ostringstream stream;
+  writePairs(stream, pairs);
+  BOOST_CHECK_EQUAL(stream.str(), "0 1 2 3\n2 3\n");
+
+  BOOST_CHECK( savePairs("pairsPerView_IO.txt", PairSet(pairs.begin(), pairs.end())));
+
+  // the range counts the views
+  PairSet loaded_Pairs;
+  BOOST_CHECK( loadPairs("pairsPerView_IO.txt", loaded_Pairs, 1, 1));
+  BOOST_CHECK_EQUAL(loaded_Pairs.size(), 1);
+  BOOST_CHECK(loaded_Pairs.count(std::make_pair(2, 3)));
+}
@@ -5,6 +5,7 @@
 
 #include "l1.hpp"
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #ifdef ALICEVISION_ROTATION_AVERAGING_WITH_BOOST
 #include <boost/graph/adjacency_list.hpp>
@@ -28,6 +29,9 @@
 #include "ceres/ceres.h"
 #include "ceres/rotation.h"
 
+#include <Eigen/SparseCholesky>
+#include <Eigen/IterativeLinearSolvers>
+
 #include <map>
 #include <queue>
 #include <stdint.h>
@@ -42,6 +46,90 @@ namespace aliceVision   {
 namespace rotationAveraging  {
 namespace l1  {
 
+// Solver of the normal equations (At * diag(w) * A) * x = rhs
+// Dense matrices: LDLT decomposition of the dense normal matrix
+template<typename MATRIX_TYPE>
+class NormalEquationsSolver
+{
+public:
+  typedef Eigen::Matrix<REAL, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
+  typedef Eigen::Matrix<REAL, Eigen::Dynamic, 1> Vector;
+
+  bool compute(const MATRIX_TYPE& A, const MATRIX_TYPE& At, const Vector& w)
+  {
+    _solver.compute(At*(w.asDiagonal()*A));
+    return _solver.info() == Eigen::Success;
+  }
+
+  bool solve(const Vector& rhs, Vector& x) const
+  {
+    x = _solver.solve(rhs);
+    return _solver.info() == Eigen::Success;
+  }
+
+private:
+  Eigen::LDLT<Matrix> _solver;
+};
+
+// Sparse matrices: sparse Cholesky decomposition of the sparse normal matrix.
+// The pattern of the normal matrix does not depend on the weights,
+// so its symbolic analysis is done once for all the iterations.
+// Badly conditioned matrices are factorized with a small diagonal shift,
+// conjugate gradient is used if the decomposition still fails.
+template<>
+class NormalEquationsSolver< Eigen::SparseMatrix<REAL, Eigen::ColMajor> >
+{
+public:
+  typedef Eigen::SparseMatrix<REAL, Eigen::ColMajor> SparseMatrix;
+  typedef Eigen::Matrix<REAL, Eigen::Dynamic, 1> Vector;
+
+  bool compute(const SparseMatrix& A, const SparseMatrix& At, const Vector& w)
+  {
+    _H = At*(w.asDiagonal()*A);
+    if (_H.nonZeros() != _nonZeros) {
+      _ldlt.analyzePattern(_H);
+      _nonZeros = _H.nonZeros();
+    }
+    _ldlt.setShift(REAL(0));
+    _ldlt.factorize(_H);
+    if (_ldlt.info() != Eigen::Success) {
+      REAL maxDiagonal(0);
+      for (SparseMatrix::Index i = 0; i < _H.outerSize(); ++i)
+        maxDiagonal = std::max(maxDiagonal, std::abs(_H.coeff(i, i)));
+      _ldlt.setShift(REAL(1e-12) * maxDiagonal);
+      _ldlt.factorize(_H);
+    }
+    _useCG = (_ldlt.info() != Eigen::Success);
+    if (_useCG) {
+      _cg.compute(_H);
+      return _cg.info() == Eigen::Success;
+    }
+    return true;
+  }
+
+  bool solve(const Vector& rhs, Vector& x)
+  {
+    if (!_useCG) {
+      x = _ldlt.solve(rhs);
+      return _ldlt.info() == Eigen::Success;
+    }
+    // warm start from the previous solution
+    const Vector b(rhs);
+    if (x.size() != b.size())
+      x.setZero(b.size());
+    x = _cg.solveWithGuess(b, Vector(x));
+    // a non converged solution is still a descent direction
+    return _cg.info() != Eigen::NumericalIssue;
+  }
+
+private:
+  SparseMatrix _H;
+  SparseMatrix::Index _nonZeros = -1;
+  Eigen::SimplicialLDLT<SparseMatrix> _ldlt;
+  Eigen::ConjugateGradient<SparseMatrix> _cg;
+  bool _useCG = false;
+};
+
 // Minimum l1 error approximation:
 //
 // Let A be a M x N matrix with full rank. Given y of R^M, the problem
@@ -65,7 +153,6 @@ inline bool TRobustRegressionL1PD(
   Eigen::Matrix<REAL, Eigen::Dynamic, 1>& xp,
   REAL pdtol, unsigned pdmaxiter)
 {
-  typedef Eigen::Matrix<REAL, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
   typedef Eigen::Matrix<REAL, Eigen::Dynamic, 1> Vector;
   const unsigned M = (unsigned)y.size();
   const unsigned N = (unsigned)xp.size();
@@ -98,7 +185,7 @@ inline bool TRobustRegressionL1PD(
   Vector w2(M), sig1(M), sig2(M), sigx(M), dx(N), up(N), Atdv(N);
   Vector Axp(M), Atvp(M);
   Vector &Adx(sigx), &du(w2), &w1p(dx);
-  Matrix H11p(N,N);
+  NormalEquationsSolver<MATRIX_TYPE> H11pSolver;
   Vector &dlamu1(tmpM3), &dlamu2(tmpM4);
   for (unsigned pditer=0; pditer<pdmaxiter; ++pditer) {
     // surrogate duality gap
@@ -125,11 +212,13 @@ inline bool TRobustRegressionL1PD(
     sig2 = tmpM1 - tmpM2;
     sigx = sig1 - sig2.cwiseAbs2().cwiseQuotient(sig1);
 
-    H11p = At*(Eigen::DiagonalMatrix<REAL,Eigen::Dynamic>(sigx)*A);
     w1p = At*(tmpM4 - tmpM3 - (sig2.cwiseQuotient(sig1).cwiseProduct(w2)));
 
-    // optimized solver as A is positive definite and symmetric
-    dx = H11p.ldlt().solve(w1p);
+    // optimized solver as H11p = At*diag(sigx)*A is positive definite and symmetric
+    if (!H11pSolver.compute(A, At, sigx) || !H11pSolver.solve(w1p, dx)) {
+      xp = x;
+      return false;
+    }
 
     Adx = A*dx;
 
@@ -230,12 +319,14 @@ inline bool TIterativelyReweightedLeastSquares(
   Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x,
   REAL sigma, REAL eps)
 {
-  typedef Eigen::Matrix<REAL, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
   typedef Eigen::Matrix<REAL, Eigen::Dynamic, 1> Vector;
   const unsigned m = (unsigned)b.size();
   const unsigned n = (unsigned)x.size();
   assert(A.rows() == m && A.cols() == n);
 
+  const MATRIX_TYPE At(A.transpose());
+  NormalEquationsSolver<MATRIX_TYPE> solver;
+
   // iterate optimization till the desired precision is reached
   Vector xp(n), e(m);
   const REAL sigmaSq(Square(sigma));
@@ -246,20 +337,18 @@ inline bool TIterativelyReweightedLeastSquares(
     // compute error vector
     e = A*x-b;
     // compute robust errors using the Huber-like loss function
-    for (unsigned i=0; i<m; ++i) {
+    #pragma omp parallel for
+    for (int i=0; i<(int)m; ++i) {
       REAL& err = e(i);
       const REAL errSq(Square(err));
       err = sigmaSq / (errSq + sigmaSq);
     }
     // solve the linear system using l2 norm
-    const MATRIX_TYPE AtF(A.transpose()*e.asDiagonal());
-    const Eigen::LDLT<Matrix> solver(AtF*A); // compute the Cholesky decomposition
-    if (solver.info() != Eigen::Success) {
+    if (!solver.compute(A, At, e)) { // compute the Cholesky decomposition
       ALICEVISION_LOG_WARNING("error: decomposing linear system failed");
       return false;
     }
-    x = solver.solve(AtF*b);
-    if (solver.info() != Eigen::Success) {
+    if (!solver.solve(At*e.cwiseProduct(b), x)) {
       ALICEVISION_LOG_WARNING("error: solving linear system failed");
       return false;
     }
@@ -432,7 +521,8 @@ unsigned int FilterRelativeRotations(
   assert(threshold >= 0);
   // compute errors for each relative rotation
   std::vector<float> errors(RelRs.size());
-  for(int r= 0; r<RelRs.size(); ++r) {
+  #pragma omp parallel for
+  for(int r= 0; r<(int)RelRs.size(); ++r) {
     const RelativeRotation& relR = RelRs[r];
     const Matrix3x3& Ri = Rs[relR.i];
     const Matrix3x3& Rj = Rs[relR.j];
@@ -484,7 +574,8 @@ REAL RelRotationAvgError(const RelativeRotations& RelRs, const Matrix3x3Arr& Rs,
   return boost::accumulators::mean(acc);
 #else
   std::vector<REAL> vec_err(RelRs.size(), REAL(0.0));
-  for(int i=0; i < RelRs.size(); ++i) {
+  #pragma omp parallel for
+  for(int i=0; i < (int)RelRs.size(); ++i) {
     const RelativeRotation& relR = RelRs[i];
     vec_err[i] = aliceVision::FrobeniusNorm(relR.Rij  - (Rs[relR.j]*Rs[relR.i].transpose()));
   }
@@ -603,7 +694,8 @@ inline void _FillErrorMatrix(
   const Matrix3x3Arr& Rs,
   Eigen::Matrix<REAL,Eigen::Dynamic,1>& b)
 {
-  for (size_t r = 0; r < RelRs.size(); ++r) {
+  #pragma omp parallel for
+  for (int r = 0; r < (int)RelRs.size(); ++r) {
     const RelativeRotation& relR = RelRs[r];
     const Matrix3x3& Ri = Rs[relR.i];
     const Matrix3x3& Rj = Rs[relR.j];
@@ -621,11 +713,12 @@ inline void _CorrectMatrix(
   const size_t nMainViewID,
   Matrix3x3Arr& Rs)
 {
-  for (size_t r = 0; r < Rs.size(); ++r) {
-    if (r == nMainViewID)
+  #pragma omp parallel for
+  for (int r = 0; r < (int)Rs.size(); ++r) {
+    if (r == (int)nMainViewID)
       continue;
     Matrix3x3& Ri = Rs[r];
-    const size_t i = (r<nMainViewID ? r : r-1);
+    const size_t i = (r<(int)nMainViewID ? r : r-1);
     aliceVision::Vec3 eRid = aliceVision::Vec3(x.block<3,1>(3*i,0));
     const Mat3 eRi;
     ceres::AngleAxisToRotationMatrix((const double*)eRid.data(), (double*)eRi.data());
@@ -640,7 +733,8 @@ bool RefineRotationsAvgL1IRLS(
   const RelativeRotations& RelRs,
   Matrix3x3Arr& Rs,
   const size_t nMainViewID,
-  REAL sigma)
+  REAL sigma,
+  unsigned int* nbIterations)
 {
   assert(!RelRs.empty() && !Rs.empty());
   assert(Rs[nMainViewID] == Matrix3x3::Identity());
@@ -702,6 +796,9 @@ bool RefineRotationsAvgL1IRLS(
     << " to " << fMeanAfter << "(" << fMinAfter << "min,"<< fMaxAfter<< "max)\n"
     << " in " << iter1 << "+" << iter2 << "=" << iter1+iter2 << " iterations");
 
+  if (nbIterations)
+    *nbIterations = iter1 + iter2;
+
   return true;
 } // RefineRotationsAvgL1IRLS
 
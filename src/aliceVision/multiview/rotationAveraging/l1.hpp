@@ -60,12 +60,14 @@ bool GlobalRotationsRobust(
  * @param[out] Rs output global rotation matrices
  * @param[in] nMainViewID Id of the image considered as Identity (unit rotation)
  * @param[in] sigma factor
+ * @param[out] nbIterations (optional) number of L1RA and IRLS iterations
  */
 bool RefineRotationsAvgL1IRLS(
   const RelativeRotations& RelRs,
   Matrix3x3Arr& Rs,
   const size_t nMainViewID,
-  REAL sigma=aliceVision::D2R(5));
+  REAL sigma=aliceVision::D2R(5),
+  unsigned int* nbIterations = nullptr);
 
 /**
  * @brief Sort relative rotation as inlier, outlier rotations.
@@ -91,7 +93,7 @@ bool RobustRegressionL1PD(
   Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x,
   REAL pdtol=1e-3, unsigned pdmaxiter=50);
 
-// L1RA [1] for sparse A matrix
+// L1RA [1] for sparse A matrix (sparse Cholesky of the normal equations)
 bool RobustRegressionL1PD(
   const Eigen::SparseMatrix<REAL, Eigen::ColMajor>& A,
   const Eigen::Matrix<REAL, Eigen::Dynamic, 1>& b,
@@ -105,7 +107,7 @@ bool IterativelyReweightedLeastSquares(
   Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x,
   REAL sigma, REAL eps=1e-5);
 
-/// IRLS [1] for sparse A matrix
+/// IRLS [1] for sparse A matrix (sparse Cholesky of the normal equations)
 bool IterativelyReweightedLeastSquares(
   const Eigen::SparseMatrix<REAL, Eigen::ColMajor>& A,
   const Eigen::Matrix<REAL, Eigen::Dynamic, 1>& b,
@@ -4,6 +4,7 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "aliceVision/multiview/rotationAveraging/l2.hpp"
+#include "aliceVision/multiview/rotationAveraging/l1.hpp"
 #include <aliceVision/config.hpp>
 #include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/system/Logger.hpp>
@@ -14,6 +15,8 @@
 #include <ceres/ceres.h>
 #include <ceres/rotation.h>
 
+#include <Eigen/SparseCholesky>
+
 #ifdef _MSC_VER
 #pragma warning( once : 4267 ) //warning C4267: 'argument' : conversion from 'size_t' to 'const int', possible loss of data
 #endif
@@ -72,26 +75,22 @@ bool compare_first_abs(std::pair<double, Vec> const &x, std::pair<double, Vec> c
 // vector.add( RelativeRotation(1,2, R12) );
 // vector.add( RelativeRotation(0,2, R02) );
 //
-bool L2RotationAveraging( size_t nCamera,
-  const RelativeRotations& vec_relativeRot,
-  // Output
-  std::vector<Mat3> & vec_ApprRotMatrix)
+// Number of cameras above which the sparse formulation is used
+static const std::size_t sparseMinNbCameras = 500;
+
+// Setup the action matrix: encode the constraints weight * ( rj - Rij * ri ) = 0
+// (6.62 Martinec Thesis page 100)
+sMat RelativeRotationsMatrix(size_t nCamera, const RelativeRotations& vec_relativeRot)
 {
   const size_t nRotationEstimation = vec_relativeRot.size();
-  //--
-  // Setup the Action Matrix
-  //--
   std::vector<Eigen::Triplet<double> > tripletList;
   tripletList.reserve(nRotationEstimation*12); // 3*3 + 3
-  //-- Encode constraint (6.62 Martinec Thesis page 100):
   sMat::Index cpt = 0;
   for(RelativeRotations::const_iterator
     iter = vec_relativeRot.begin();
     iter != vec_relativeRot.end();
     iter++, cpt++)
   {
-   const RelativeRotation & Elem = *iter;
-
    //-- Encode weight * ( rj - Rij * ri ) = 0
    const size_t i = iter->i;
    const size_t j = iter->j;
@@ -116,7 +115,50 @@ bool L2RotationAveraging( size_t nCamera,
   // nCamera * 3 because each columns have 3 elements.
   sMat A(nRotationEstimation*3, 3*nCamera);
   A.setFromTriplets(tripletList.begin(), tripletList.end());
-  tripletList.clear();
+  return A;
+}
+
+//--
+// Search the closest matrix :
+//  - From the 3 nullspace vectors get back column and reconstruct Rotation matrix
+//  - Enforce the orthogonality constraint
+//     (approximate rotation in the Frobenius norm using SVD).
+//--
+void NullspaceToRotations(
+  size_t nCamera,
+  const Vec & NullspaceVector0,
+  const Vec & NullspaceVector1,
+  const Vec & NullspaceVector2,
+  std::vector<Mat3> & vec_ApprRotMatrix)
+{
+  vec_ApprRotMatrix.resize(nCamera);
+  #pragma omp parallel for
+  for(int i=0; i < (int)nCamera; ++i)
+  {
+    Mat3 Rotation;
+    Rotation << NullspaceVector0.segment(3 * i, 3),
+                NullspaceVector1.segment(3 * i, 3),
+                NullspaceVector2.segment(3 * i, 3);
+
+    //-- Compute the closest SVD rotation matrix
+    vec_ApprRotMatrix[i] = ClosestSVDRotationMatrix(Rotation);
+  }
+  // Force R0 to be Identity
+  const Mat3 R0T = vec_ApprRotMatrix[0].transpose();
+  for(size_t i = 0; i < nCamera; ++i) {
+    vec_ApprRotMatrix[i] *= R0T;
+  }
+}
+
+bool L2RotationAveraging( size_t nCamera,
+  const RelativeRotations& vec_relativeRot,
+  // Output
+  std::vector<Mat3> & vec_ApprRotMatrix)
+{
+  if (nCamera > sparseMinNbCameras)
+    return L2RotationAveraging_Sparse(nCamera, vec_relativeRot, vec_ApprRotMatrix);
+
+  const sMat A = RelativeRotationsMatrix(nCamera, vec_relativeRot);
 
   sMat AtAsparse = A.transpose() * A;
   const Mat AtA = Mat(AtAsparse); // convert to dense
@@ -146,37 +188,68 @@ bool L2RotationAveraging( size_t nCamera,
     }
     std::stable_sort(eigs.begin(), eigs.end(), &compare_first_abs);
 
-    const Vec & NullspaceVector0 = eigs[0].second;
-    const Vec & NullspaceVector1 = eigs[1].second;
-    const Vec & NullspaceVector2 = eigs[2].second;
-
-    //--
-    // Search the closest matrix :
-    //  - From solution of SVD get back column and reconstruct Rotation matrix
-    //  - Enforce the orthogonality constraint
-    //     (approximate rotation in the Frobenius norm using SVD).
-    //--
-    vec_ApprRotMatrix.clear();
-    vec_ApprRotMatrix.reserve(nCamera);
-    for(size_t i=0; i < nCamera; ++i)
+    NullspaceToRotations(nCamera, eigs[0].second, eigs[1].second, eigs[2].second, vec_ApprRotMatrix);
+    return true;
+  }
+}
+
+bool L2RotationAveraging_Sparse( size_t nCamera,
+  const RelativeRotations& vec_relativeRot,
+  // Output
+  std::vector<Mat3> & vec_ApprRotMatrix,
+  unsigned int* nbIterations)
+{
+  if (nCamera < 2 || vec_relativeRot.empty())
+    return false;
+
+  const sMat A = RelativeRotationsMatrix(nCamera, vec_relativeRot);
+  sMat AtA = A.transpose() * A;
+
+  // Small shift of the diagonal, AtA is singular (its nullspace is the solution)
+  const double shift = 1e-8 * AtA.diagonal().cwiseAbs().maxCoeff();
+  for (sMat::Index i = 0; i < AtA.rows(); ++i)
+    AtA.coeffRef(i, i) += shift;
+
+  Eigen::SimplicialLDLT<sMat> solver(AtA);
+  if (solver.info() != Eigen::Success)
+    return false;
+
+  // Warm start from the rotations chained along the maximum spanning tree
+  std::vector<Mat3> vec_initialRotations(nCamera, Mat3::Identity());
+  l1::InitRotationsMST(vec_relativeRot, vec_initialRotations, 0);
+
+  Mat X(3 * nCamera, 3);
+  for (size_t i = 0; i < nCamera; ++i)
+    X.block<3,3>(3 * i, 0) = vec_initialRotations[i];
+  X = Eigen::HouseholderQR<Mat>(X).householderQ() * Mat::Identity(3 * nCamera, 3);
+
+  // Inverse subspace iteration: converge to the 3 smallest eigenvectors of AtA
+  const unsigned int maxIterations = 100;
+  unsigned int iter = 0;
+  for (; iter < maxIterations; ++iter)
+  {
+    Mat Y(3 * nCamera, 3);
+    for (int c = 0; c < 3; ++c)
+      Y.col(c) = solver.solve(X.col(c));
+    if (solver.info() != Eigen::Success)
+      return false;
+    Y = Eigen::HouseholderQR<Mat>(Y).householderQ() * Mat::Identity(3 * nCamera, 3);
+
+    // distance between the new subspace and the previous one
+    const double change = (Y - X * (X.transpose() * Y)).norm();
+    X.swap(Y);
+    if (change < 1e-10)
     {
-      Mat3 Rotation;
-      Rotation << NullspaceVector0.segment(3 * i, 3),
-                  NullspaceVector1.segment(3 * i, 3),
-                  NullspaceVector2.segment(3 * i, 3);
-
-      //-- Compute the closest SVD rotation matrix
-      Rotation = ClosestSVDRotationMatrix(Rotation);
-      vec_ApprRotMatrix.push_back(Rotation);
+      ++iter;
+      break;
     }
-    // Force R0 to be Identity
-    const Mat3 R0T = vec_ApprRotMatrix[0].transpose();
-    for(size_t i = 0; i < nCamera; ++i) {
-      vec_ApprRotMatrix[i] *= R0T;
-    }
-
-    return true;
   }
+
+  if (nbIterations)
+    *nbIterations = iter;
+
+  NullspaceToRotations(nCamera, X.col(0), X.col(1), X.col(2), vec_ApprRotMatrix);
+  return true;
 }
 
 // Ceres Functor to minimize global rotation regarding fixed relative rotation
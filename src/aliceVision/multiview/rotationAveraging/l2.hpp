@@ -58,6 +58,17 @@ bool L2RotationAveraging( size_t nCamera,
   // Output
   std::vector<Mat3> & vec_ApprRotMatrix);
 
+//-- Sparse formulation of L2RotationAveraging, used for large graphs.
+//    The 3 smallest eigenvectors of the sparse normal matrix are found by
+//    inverse subspace iteration (sparse Cholesky decomposition),
+//    warm started from the rotations chained along the maximum spanning tree.
+//- nbIterations:          (optional) The number of inverse iterations
+bool L2RotationAveraging_Sparse( size_t nCamera,
+  const RelativeRotations& vec_relativeRot,
+  // Output
+  std::vector<Mat3> & vec_ApprRotMatrix,
+  unsigned int* nbIterations = nullptr);
+
 // None linear refinement of the rotation using an angle-axis representation
 bool L2RotationAveraging_Refine(
   const RelativeRotations & vec_relativeRot,
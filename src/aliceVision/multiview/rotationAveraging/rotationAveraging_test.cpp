@@ -316,6 +316,42 @@ BOOST_AUTO_TEST_CASE ( rotationAveraging_RefineRotationsAvgL1IRLS_CompleteGraph_
   }
 }
 
+// The sparse and the dense L2 formulations find the same rotations
+BOOST_AUTO_TEST_CASE ( rotationAveraging_L2RotationAveraging_Sparse)
+{
+  const int iNviews = 60;
+  NViewDataSet d = NRealisticCamerasRing(iNviews, 5,
+    NViewDatasetConfigurator(1,1,0,0,5,0)); // Suppose a camera with Unit matrix as K
+
+  // Link each camera to the three next ones, with a small rotation noise
+  RelativeRotations vec_relativeRotEstimate;
+  for (std::size_t i = 0; i < iNviews; ++i)
+  {
+    for (std::size_t k = 1; k <= 3; ++k)
+    {
+      const std::size_t j = (i+k)%iNviews;
+      Mat3 Rrel;
+      Vec3 trel;
+      RelativeCameraMotion(d._R[i], d._t[i], d._R[j], d._t[j], &Rrel, &trel);
+      Rrel = RotationAroundX(D2R(0.1 * ((i+k)%3))) * Rrel;
+      vec_relativeRotEstimate.push_back(RelativeRotation(i, j, Rrel, 1));
+    }
+  }
+
+  std::vector<Mat3> vec_denseR, vec_sparseR;
+  BOOST_CHECK(L2RotationAveraging(iNviews, vec_relativeRotEstimate, vec_denseR));
+  unsigned int nbIterations = 0;
+  BOOST_CHECK(L2RotationAveraging_Sparse(iNviews, vec_relativeRotEstimate, vec_sparseR, &nbIterations));
+  BOOST_CHECK(nbIterations > 0);
+  BOOST_CHECK_EQUAL(iNviews, vec_sparseR.size());
+
+  // Both solutions are expressed in the first camera frame
+  for (std::size_t i = 0; i < iNviews; ++i)
+  {
+    BOOST_CHECK_SMALL(FrobeniusDistance(vec_denseR[i], vec_sparseR[i]), 1e-6);
+  }
+}
+
 /*
 template<typename TYPE, int N>
 inline REAL ComputePSNR(const Eigen::Matrix<REAL, N,1>& x0, const Eigen::Matrix<REAL, N,1>& x)
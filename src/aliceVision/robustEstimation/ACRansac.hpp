@@ -194,16 +194,19 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
 
   bool bACRansacMode = (precision == std::numeric_limits<double>::infinity());
 
+  std::vector<std::size_t> vec_sample(sizeSample); // Sample indices
+  std::vector<typename Kernel::Model> vec_models; // Up to max_models solutions
+  vec_models.reserve(Kernel::MAX_MODELS);
+
   // Main estimation loop.
   for (size_t iter=0; iter < nIter; ++iter)
   {
-    std::vector< std::size_t> vec_sample(sizeSample); // Sample indices
     if (bACRansacMode)
       UniformSample(sizeSample, vec_index, vec_sample); // Get random sample
     else
       UniformSample(sizeSample, nData, vec_sample); // Get random sample
 
-    std::vector<typename Kernel::Model> vec_models; // Up to max_models solutions
+    vec_models.clear();
     kernel.Fit(vec_sample, &vec_models);
 
     // Evaluate models
@@ -0,0 +1,416 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/robustEstimation/ACRansac.hpp>
+#include <aliceVision/robustEstimation/randSampling.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace aliceVision {
+namespace robustEstimation {
+
+/**
+ * @brief Evaluate the best NFA of the residuals of a model without sorting all of them.
+ *
+ * The residuals are distributed into log-spaced buckets with a counting sort.
+ * As the NFA of the k-th sorted residual grows with the residual value,
+ * the minimum and maximum residuals of each bucket give a lower bound
+ * of the NFA inside the bucket and the exact NFA at the end of the bucket.
+ * Only the buckets which may contain the best NFA are sorted, and the evaluation
+ * stops early if no bucket can beat the NFA of the current best model.
+ *
+ * The result is identical to bestNFA on fully sorted residuals.
+ * All the buffers are allocated once, in the constructor.
+ */
+class NFAHistogram
+{
+public:
+
+  /**
+   * @brief NFAHistogram constructor
+   * @param[in] nData The number of residuals
+   * @param[in] nBins The number of buckets
+   */
+  NFAHistogram(std::size_t nData, std::size_t nBins = 64)
+    : _nBins(std::max(nBins, std::size_t(1)))
+    , _bins(nData)
+    , _sortedIndexes(nData)
+    , _sortedResiduals(nData)
+    , _binBegin(_nBins + 1)
+    , _binPosition(_nBins)
+    , _binMin(_nBins)
+    , _binMax(_nBins)
+    , _binLowerBound(_nBins)
+  {}
+
+  /**
+   * @brief Find the best NFA of the residuals if it is lower than nfaToBeat.
+   *
+   * @param[in] residuals The residual of each data
+   * @param[in] startIndex The number of points required for estimation
+   * @param[in] logalpha0 The kernel log10 of alpha0
+   * @param[in] loge0 log10 of the number of tests
+   * @param[in] maxThreshold The maximum residual value
+   * @param[in] logc_n The log combi table (.,n)
+   * @param[in] logc_k The log combi table (k,.)
+   * @param[in] multError The kernel error multiplier
+   * @param[in] nfaToBeat The NFA of the current best model
+   * @param[out] best The best NFA and its number of inliers
+   * @param[out] errorMax The residual threshold associated to the best NFA
+   * @param[out] inliers The indexes of the data with a residual under the threshold
+   * @return true if a better NFA than nfaToBeat has been found
+   */
+  bool computeBestNFA(const std::vector<double>& residuals,
+                      std::size_t startIndex,
+                      double logalpha0,
+                      double loge0,
+                      double maxThreshold,
+                      const std::vector<float>& logc_n,
+                      const std::vector<float>& logc_k,
+                      double multError,
+                      double nfaToBeat,
+                      ErrorIndex& best,
+                      double& errorMax,
+                      std::vector<std::size_t>& inliers)
+  {
+    const std::size_t nData = residuals.size();
+    assert(nData <= _bins.size());
+
+    // range of the residuals under the max threshold
+    double minResidual = std::numeric_limits<double>::infinity();
+    double maxResidual = 0.0;
+    std::size_t nValid = 0;
+    for(std::size_t i = 0; i < nData; ++i)
+    {
+      const double r = residuals[i];
+      if(r <= maxThreshold)
+      {
+        minResidual = std::min(minResidual, r);
+        maxResidual = std::max(maxResidual, r);
+        ++nValid;
+      }
+    }
+    if(nValid <= startIndex)
+      return false;
+
+    // log-spaced buckets between the min and the max residuals
+    const double logMin = std::log(std::max(minResidual, std::numeric_limits<double>::min()));
+    const double logRange = std::log(std::max(maxResidual, std::numeric_limits<double>::min())) - logMin;
+    const double binScale = (logRange > 0.0) ? _nBins / logRange : 0.0;
+
+    std::fill(_binBegin.begin(), _binBegin.end(), 0);
+    std::fill(_binMin.begin(), _binMin.end(), std::numeric_limits<double>::infinity());
+    std::fill(_binMax.begin(), _binMax.end(), -std::numeric_limits<double>::infinity());
+
+    for(std::size_t i = 0; i < nData; ++i)
+    {
+      const double r = residuals[i];
+      if(r > maxThreshold)
+      {
+        _bins[i] = _nBins; // rejected
+        continue;
+      }
+      const double position = (r > 0.0) ? (std::log(r) - logMin) * binScale : 0.0;
+      const std::size_t bin = std::min(static_cast<std::size_t>(std::max(position, 0.0)), _nBins - 1);
+      _bins[i] = static_cast<std::uint32_t>(bin);
+      ++_binBegin[bin + 1];
+      _binMin[bin] = std::min(_binMin[bin], r);
+      _binMax[bin] = std::max(_binMax[bin], r);
+    }
+    for(std::size_t b = 0; b < _nBins; ++b)
+      _binBegin[b + 1] += _binBegin[b];
+
+    // Bounds of the NFA in each bucket:
+    // - the NFA at the last residual of a bucket is exact: it is the maximum of the bucket,
+    // - the minimum of the bucket gives a lower bound of the NFA for all the bucket ranks.
+    double upperBound = std::numeric_limits<double>::infinity();
+    for(std::size_t b = 0; b < _nBins; ++b)
+    {
+      _binLowerBound[b] = std::numeric_limits<double>::infinity();
+      const std::size_t kBegin = std::max(_binBegin[b] + 1, startIndex + 1);
+      const std::size_t kEnd = _binBegin[b + 1];
+      if(kBegin > kEnd)
+        continue;
+
+      const double logalphaMin = logalpha0 + multError * log10(_binMin[b] + std::numeric_limits<float>::epsilon());
+      for(std::size_t k = kBegin; k <= kEnd; ++k)
+        _binLowerBound[b] = std::min(_binLowerBound[b], nfa(logalphaMin, loge0, k, startIndex, logc_n, logc_k));
+
+      const double logalphaMax = logalpha0 + multError * log10(_binMax[b] + std::numeric_limits<float>::epsilon());
+      upperBound = std::min(upperBound, nfa(logalphaMax, loge0, kEnd, startIndex, logc_n, logc_k));
+    }
+
+    // Early exit: the hypothesis cannot beat the current best model
+    const double bound = std::min(upperBound, nfaToBeat);
+    bool isCandidate = false;
+    for(std::size_t b = 0; b < _nBins && !isCandidate; ++b)
+      isCandidate = _binLowerBound[b] < nfaToBeat && _binLowerBound[b] <= bound;
+    if(!isCandidate)
+      return false;
+
+    // Counting sort of the data indexes by bucket
+    {
+      _binPosition.assign(_binBegin.begin(), _binBegin.end() - 1);
+      for(std::size_t i = 0; i < nData; ++i)
+      {
+        const std::uint32_t bin = _bins[i];
+        if(bin < _nBins)
+          _sortedIndexes[_binPosition[bin]++] = i;
+      }
+    }
+
+    // Exact NFA in the candidate buckets only
+    best = ErrorIndex(std::numeric_limits<double>::infinity(), startIndex);
+    for(std::size_t b = 0; b < _nBins; ++b)
+    {
+      if(!(_binLowerBound[b] < nfaToBeat && _binLowerBound[b] <= bound && _binLowerBound[b] < best.first))
+        continue;
+
+      sortBin(residuals, b);
+
+      const std::size_t kBegin = std::max(_binBegin[b] + 1, startIndex + 1);
+      const std::size_t kEnd = _binBegin[b + 1];
+      for(std::size_t k = kBegin; k <= kEnd; ++k)
+      {
+        const double logalpha = logalpha0 + multError * log10(_sortedResiduals[k - 1] + std::numeric_limits<float>::epsilon());
+        const ErrorIndex index(nfa(logalpha, loge0, k, startIndex, logc_n, logc_k), k);
+        if(index.first < best.first)
+          best = index;
+      }
+    }
+
+    if(!(best.first < nfaToBeat))
+      return false;
+
+    // the inliers are the buckets before the best one and the best bucket sorted prefix
+    errorMax = _sortedResiduals[best.second - 1];
+    inliers.assign(_sortedIndexes.begin(), _sortedIndexes.begin() + best.second);
+    return true;
+  }
+
+private:
+
+  static double nfa(double logalpha,
+                    double loge0,
+                    std::size_t k,
+                    std::size_t startIndex,
+                    const std::vector<float>& logc_n,
+                    const std::vector<float>& logc_k)
+  {
+    return loge0 + logalpha * (double) (k - startIndex) + logc_n[k] + logc_k[k];
+  }
+
+  /// sort the data of a bucket by residual
+  void sortBin(const std::vector<double>& residuals, std::size_t b)
+  {
+    const auto begin = _sortedIndexes.begin() + _binBegin[b];
+    const auto end = _sortedIndexes.begin() + _binBegin[b + 1];
+    std::sort(begin, end, [&](std::size_t a, std::size_t c)
+    {
+      return ErrorIndex(residuals[a], a) < ErrorIndex(residuals[c], c);
+    });
+    for(std::size_t i = _binBegin[b]; i < _binBegin[b + 1]; ++i)
+      _sortedResiduals[i] = residuals[_sortedIndexes[i]];
+  }
+
+  std::size_t _nBins;
+  std::vector<std::uint32_t> _bins;
+  std::vector<std::size_t> _sortedIndexes;
+  std::vector<double> _sortedResiduals;
+  std::vector<std::size_t> _binBegin;
+  std::vector<std::size_t> _binPosition;
+  std::vector<double> _binMin;
+  std::vector<double> _binMax;
+  std::vector<double> _binLowerBound;
+};
+
+/**
+ * @brief Optimized ACRANSAC routine (ErrorThreshold, NFA)
+ *
+ * Same estimation as ACRANSAC, with:
+ * - the NFA evaluated by NFAHistogram instead of a full sort of the residuals,
+ * - the hypotheses which cannot beat the current best NFA discarded early,
+ * - all the scratch buffers allocated once,
+ * - a seedable random generator for reproducible results.
+ *
+ * @param[in] kernel model and metric object
+ * @param[out] vec_inliers points that fit the estimated model
+ * @param[in] nIter maximum number of consecutive iterations
+ * @param[out] model returned model if found
+ * @param[in] precision upper bound of the precision (squared error)
+ * @param[in] seed the random generator seed
+ * @param[in] bVerbose display console log
+ *
+ * @return (errorMax, minNFA)
+ */
+template<typename Kernel>
+std::pair<double, double> ACRANSAC_Fast(const Kernel &kernel,
+  std::vector<size_t> & vec_inliers,
+  size_t nIter = 1024,
+  typename Kernel::Model * model = nullptr,
+  double precision = std::numeric_limits<double>::infinity(),
+  std::mt19937::result_type seed = std::mt19937::default_seed,
+  bool bVerbose = false)
+{
+  vec_inliers.clear();
+
+  const size_t sizeSample = Kernel::MINIMUM_SAMPLES;
+  const size_t nData = kernel.NumSamples();
+  if (nData <= (size_t)sizeSample)
+    return std::make_pair(0.0,0.0);
+
+  const double maxThreshold = (precision==std::numeric_limits<double>::infinity()) ?
+    std::numeric_limits<double>::infinity() :
+    precision * kernel.normalizer2()(0,0) * kernel.normalizer2()(0,0);
+
+  std::vector<double> vec_residuals(nData);
+  NFAHistogram nfaHistogram(nData);
+
+  // Possible sampling indices [0,..,nData] (will change in the optimization phase)
+  std::vector<size_t> vec_index(nData);
+  std::iota(vec_index.begin(), vec_index.end(), 0);
+
+  // Precompute log combi
+  const double loge0 = log10((double)Kernel::MAX_MODELS * (nData-sizeSample));
+  std::vector<float> vec_logc_n, vec_logc_k;
+  makelogcombi(sizeSample, nData, vec_logc_k, vec_logc_n);
+
+  // Scratch buffers
+  std::vector<size_t> vec_sample(sizeSample);
+  std::vector<typename Kernel::Model> vec_models;
+  vec_models.reserve(Kernel::MAX_MODELS);
+  std::vector<size_t> vec_candidateInliers;
+  vec_candidateInliers.reserve(nData);
+  vec_inliers.reserve(nData);
+
+  std::mt19937 generator(seed);
+
+  // Output parameters
+  double minNFA = std::numeric_limits<double>::infinity();
+  double errorMax = std::numeric_limits<double>::infinity();
+
+  // Reserve 10% of iterations for focused sampling
+  size_t nIterReserve = nIter/10;
+  nIter -= nIterReserve;
+
+  bool bACRansacMode = (precision == std::numeric_limits<double>::infinity());
+
+  // Main estimation loop.
+  for (size_t iter=0; iter < nIter; ++iter)
+  {
+    UniformSample(sizeSample, vec_index, vec_sample, generator); // Get random sample
+
+    vec_models.clear();
+    kernel.Fit(vec_sample, &vec_models);
+
+    // Evaluate models
+    bool better = false;
+    for (size_t k = 0; k < vec_models.size(); ++k)
+    {
+      // Residuals computation
+      kernel.Errors(vec_models[k], vec_residuals);
+
+      if (!bACRansacMode)
+      {
+        unsigned int nInlier = 0;
+        for (size_t i = 0; i < nData; ++i)
+        {
+          if (vec_residuals[i] <= maxThreshold)
+            ++nInlier;
+        }
+        if (nInlier > 2.5 * sizeSample) // does the model is meaningful
+          bACRansacMode = true;
+      }
+      if (bACRansacMode)
+      {
+        // Most meaningful discrimination inliers/outliers
+        ErrorIndex best;
+        double candidateErrorMax;
+        if (nfaHistogram.computeBestNFA(
+          vec_residuals,
+          sizeSample,
+          kernel.logalpha0(),
+          loge0,
+          maxThreshold,
+          vec_logc_n,
+          vec_logc_k,
+          kernel.multError(),
+          minNFA,
+          best,
+          candidateErrorMax,
+          vec_candidateInliers))
+        {
+          // A better model was found
+          better = true;
+          minNFA = best.first;
+          vec_inliers.swap(vec_candidateInliers);
+          errorMax = candidateErrorMax; // Error threshold
+          if(model) *model = vec_models[k];
+
+          if(bVerbose)
+          {
+            ALICEVISION_LOG_DEBUG("  nfa=" << minNFA
+              << " inliers=" << best.second << "/" << nData
+              << " precisionNormalized=" << errorMax
+              << " precision=" << kernel.unormalizeError(errorMax)
+              << " (iter=" << iter
+              << ",sample=" << vec_sample
+              << ")");
+          }
+        }
+      } //if(bACRansacMode)
+    } //for(size_t k...
+
+    // Early exit test -> no meaningful model found after nIterReserve*2 iterations
+    if (!bACRansacMode && iter > nIterReserve*2)
+      break;
+
+    // ACRANSAC optimization: draw samples among best set of inliers so far
+    if (bACRansacMode && ((better && minNFA<0) || (iter+1==nIter && nIterReserve)))
+    {
+      if (vec_inliers.empty())
+      {
+        // No model found at all so far
+        ++nIter; // Continue to look for any model, even not meaningful
+        --nIterReserve;
+      }
+      else
+      {
+        // ACRANSAC optimization: draw samples among best set of inliers so far
+        vec_index = vec_inliers;
+        if(nIterReserve)
+        {
+          nIter = iter + 1 + nIterReserve;
+          nIterReserve = 0;
+        }
+      }
+    }
+  }
+
+  if(minNFA >= 0)
+    vec_inliers.clear();
+
+  if (!vec_inliers.empty())
+  {
+    if (model)
+      kernel.Unnormalize(model);
+    errorMax = kernel.unormalizeError(errorMax);
+  }
+
+  return std::make_pair(errorMax, minNFA);
+}
+
+} // namespace robustEstimation
+} // namespace aliceVision
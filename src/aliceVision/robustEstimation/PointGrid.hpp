@@ -0,0 +1,225 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/numeric/numeric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace aliceVision {
+namespace robustEstimation {
+
+/**
+ * @brief Uniform grid over a set of 2D points, used to retrieve
+ *        the points in the neighborhood of a location or of a line.
+ *
+ * The point indexes are stored cell by cell (counting sort), in ascending order inside each cell.
+ * Queries return a superset of the points inside the requested region:
+ * the exact criterion has to be evaluated by the caller.
+ */
+class PointGrid
+{
+public:
+
+  /**
+   * @brief PointGrid constructor
+   * @param[in] points The points to index
+   * @param[in] cellSize The requested size of a cell, increased if it leads to more cells than points
+   */
+  PointGrid(const std::vector<Vec2>& points, double cellSize)
+  {
+    if(points.empty())
+      return;
+
+    Vec2 maxPoint = points.front();
+    _origin = points.front();
+    for(const Vec2& point : points)
+    {
+      _origin = _origin.cwiseMin(point);
+      maxPoint = maxPoint.cwiseMax(point);
+    }
+    const Vec2 size = maxPoint - _origin;
+
+    // keep the number of cells in the order of the number of points
+    const double maxNbCells = 4.0 * points.size() + 4.0;
+    _cellSize = std::max(cellSize, std::sqrt(size.x() * size.y() / points.size()));
+    if(!(_cellSize > 0.0))
+      _cellSize = std::max(size.x(), size.y()) / maxNbCells;
+    if(!(_cellSize > 0.0))
+      _cellSize = 1.0;
+    while(nbCells(size.x()) * nbCells(size.y()) > maxNbCells)
+      _cellSize *= 2.0;
+    _nbCols = static_cast<int>(nbCells(size.x()));
+    _nbRows = static_cast<int>(nbCells(size.y()));
+
+    // counting sort of the points per cell
+    std::vector<IndexT> pointCells(points.size());
+    _cellBegin.assign(_nbCols * _nbRows + 1, 0);
+    for(std::size_t i = 0; i < points.size(); ++i)
+    {
+      pointCells[i] = cellIndex(clampCol(points[i].x()), clampRow(points[i].y()));
+      ++_cellBegin[pointCells[i] + 1];
+    }
+    for(std::size_t c = 1; c < _cellBegin.size(); ++c)
+      _cellBegin[c] += _cellBegin[c - 1];
+
+    std::vector<IndexT> position(_cellBegin.begin(), _cellBegin.end() - 1);
+    _indexes.resize(points.size());
+    for(std::size_t i = 0; i < points.size(); ++i)
+      _indexes[position[pointCells[i]]++] = i;
+  }
+
+  /**
+   * @brief Append the points of the cells overlapping an axis-aligned box.
+   * @param[in] minPoint The box lower corner
+   * @param[in] maxPoint The box upper corner
+   * @param[in,out] out_indexes The points indexes
+   */
+  void queryBox(const Vec2& minPoint, const Vec2& maxPoint, std::vector<IndexT>& out_indexes) const
+  {
+    if(_indexes.empty() || !isOverlapping(minPoint.x(), maxPoint.x(), _origin.x(), _nbCols) ||
+       !isOverlapping(minPoint.y(), maxPoint.y(), _origin.y(), _nbRows))
+      return;
+
+    const int colBegin = clampCol(minPoint.x());
+    const int colEnd = clampCol(maxPoint.x());
+    const int rowBegin = clampRow(minPoint.y());
+    const int rowEnd = clampRow(maxPoint.y());
+
+    for(int row = rowBegin; row <= rowEnd; ++row)
+    {
+      // cells of a row are contiguous
+      out_indexes.insert(out_indexes.end(),
+                         _indexes.begin() + _cellBegin[cellIndex(colBegin, row)],
+                         _indexes.begin() + _cellBegin[cellIndex(colEnd, row) + 1]);
+    }
+  }
+
+  /**
+   * @brief Append the points of the cells overlapping the band around a line.
+   * @param[in] line The line (a, b, c) with a.x + b.y + c = 0
+   * @param[in] halfWidth The maximum distance to the line
+   * @param[in,out] out_indexes The points indexes
+   */
+  void queryBand(const Vec3& line, double halfWidth, std::vector<IndexT>& out_indexes) const
+  {
+    const double a = line(0);
+    const double b = line(1);
+    const double c = line(2);
+    const double norm = std::hypot(a, b);
+
+    if(_indexes.empty() || norm == 0.0)
+      return;
+
+    if(std::abs(b) >= std::abs(a))
+    {
+      // mostly horizontal line: walk the columns
+      const double bandHeight = halfWidth * norm / std::abs(b);
+      for(int col = 0; col < _nbCols; ++col)
+      {
+        const double x0 = _origin.x() + col * _cellSize;
+        const double x1 = x0 + _cellSize;
+        const double y0 = -(a * x0 + c) / b;
+        const double y1 = -(a * x1 + c) / b;
+        const double yMin = std::min(y0, y1) - bandHeight;
+        const double yMax = std::max(y0, y1) + bandHeight;
+
+        if(!isOverlapping(yMin, yMax, _origin.y(), _nbRows))
+          continue;
+        for(int row = clampRow(yMin), rowEnd = clampRow(yMax); row <= rowEnd; ++row)
+          appendCell(cellIndex(col, row), out_indexes);
+      }
+    }
+    else
+    {
+      // mostly vertical line: walk the rows
+      const double bandWidth = halfWidth * norm / std::abs(a);
+      for(int row = 0; row < _nbRows; ++row)
+      {
+        const double y0 = _origin.y() + row * _cellSize;
+        const double y1 = y0 + _cellSize;
+        const double x0 = -(b * y0 + c) / a;
+        const double x1 = -(b * y1 + c) / a;
+        const double xMin = std::min(x0, x1) - bandWidth;
+        const double xMax = std::max(x0, x1) + bandWidth;
+
+        if(!isOverlapping(xMin, xMax, _origin.x(), _nbCols))
+          continue;
+        const int colBegin = clampCol(xMin);
+        const int colEnd = clampCol(xMax);
+        out_indexes.insert(out_indexes.end(),
+                           _indexes.begin() + _cellBegin[cellIndex(colBegin, row)],
+                           _indexes.begin() + _cellBegin[cellIndex(colEnd, row) + 1]);
+      }
+    }
+  }
+
+  double getCellSize() const
+  {
+    return _cellSize;
+  }
+
+  std::size_t getNbCells() const
+  {
+    return static_cast<std::size_t>(_nbCols) * _nbRows;
+  }
+
+private:
+
+  /// number of cells needed to cover an extent
+  inline double nbCells(double extent) const
+  {
+    return std::max(1.0, std::ceil(extent / _cellSize));
+  }
+
+  inline std::size_t cellIndex(int col, int row) const
+  {
+    return static_cast<std::size_t>(row) * _nbCols + col;
+  }
+
+  inline int clampCell(double value, double origin, int nbCells) const
+  {
+    const double cell = std::floor((value - origin) / _cellSize);
+    return static_cast<int>(std::min(std::max(cell, 0.0), nbCells - 1.0));
+  }
+
+  inline int clampCol(double x) const
+  {
+    return clampCell(x, _origin.x(), _nbCols);
+  }
+
+  inline int clampRow(double y) const
+  {
+    return clampCell(y, _origin.y(), _nbRows);
+  }
+
+  /// check if the [minValue, maxValue] range overlaps the grid along one axis
+  inline bool isOverlapping(double minValue, double maxValue, double origin, int nbCells) const
+  {
+    // the last cell contains the points on the grid upper border
+    return maxValue >= origin && minValue <= origin + nbCells * _cellSize;
+  }
+
+  inline void appendCell(std::size_t cell, std::vector<IndexT>& out_indexes) const
+  {
+    out_indexes.insert(out_indexes.end(), _indexes.begin() + _cellBegin[cell], _indexes.begin() + _cellBegin[cell + 1]);
+  }
+
+  Vec2 _origin = Vec2::Zero();
+  double _cellSize = 1.0;
+  int _nbCols = 0;
+  int _nbRows = 0;
+  /// first point of each cell in _indexes
+  std::vector<IndexT> _cellBegin;
+  /// points indexes sorted by cell
+  std::vector<IndexT> _indexes;
+};
+
+} // namespace robustEstimation
+} // namespace aliceVision
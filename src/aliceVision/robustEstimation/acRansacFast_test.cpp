@@ -0,0 +1,165 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <algorithm>
+#include <random>
+
+#include <aliceVision/robustEstimation/LineKernel.hpp>
+#include <aliceVision/robustEstimation/ACRansac.hpp>
+#include <aliceVision/robustEstimation/ACRansacFast.hpp>
+
+#include "lineTestGenerator.hpp"
+#include "acRansacTestKernel.hpp"
+
+#define BOOST_TEST_MODULE ACRansacFast
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::robustEstimation;
+using namespace std;
+
+/// Compare NFAHistogram with bestNFA on the sorted residuals
+void checkSameNFA(const std::vector<double>& residuals, double maxThreshold)
+{
+  const std::size_t nData = residuals.size();
+  const std::size_t sizeSample = 4;
+  const double logalpha0 = log10(M_PI / (1000.0 * 1000.0));
+  const double loge0 = log10(1.0 * (nData - sizeSample));
+  std::vector<float> logc_n, logc_k;
+  makelogcombi(sizeSample, nData, logc_k, logc_n);
+
+  std::vector<ErrorIndex> sortedResiduals(nData);
+  for(std::size_t i = 0; i < nData; ++i)
+    sortedResiduals[i] = ErrorIndex(residuals[i], i);
+  std::sort(sortedResiduals.begin(), sortedResiduals.end());
+  const ErrorIndex expected = bestNFA(sizeSample, logalpha0, sortedResiduals, loge0, maxThreshold, logc_n, logc_k);
+
+  NFAHistogram nfaHistogram(nData);
+  ErrorIndex best;
+  double errorMax;
+  std::vector<std::size_t> inliers;
+  const bool found = nfaHistogram.computeBestNFA(residuals, sizeSample, logalpha0, loge0, maxThreshold, logc_n, logc_k, 1.0,
+                                                 std::numeric_limits<double>::infinity(), best, errorMax, inliers);
+
+  BOOST_CHECK_EQUAL(found, expected.first < std::numeric_limits<double>::infinity());
+  if(!found)
+    return;
+
+  BOOST_CHECK_EQUAL(expected.first, best.first);
+  BOOST_CHECK_EQUAL(expected.second, best.second);
+  BOOST_CHECK_EQUAL(sortedResiduals[expected.second - 1].first, errorMax);
+
+  std::vector<std::size_t> expectedInliers;
+  for(std::size_t i = 0; i < expected.second; ++i)
+    expectedInliers.push_back(sortedResiduals[i].second);
+  std::sort(expectedInliers.begin(), expectedInliers.end());
+  std::sort(inliers.begin(), inliers.end());
+  BOOST_CHECK(expectedInliers == inliers);
+
+  // a hypothesis cannot beat itself
+  BOOST_CHECK(!nfaHistogram.computeBestNFA(residuals, sizeSample, logalpha0, loge0, maxThreshold, logc_n, logc_k, 1.0,
+                                           best.first, best, errorMax, inliers));
+}
+
+BOOST_AUTO_TEST_CASE(NFAHistogram_SameAsBestNFA)
+{
+  std::mt19937 gen(0);
+  std::normal_distribution<> inlierDistribution(0.0, 2.0);
+  std::uniform_real_distribution<> outlierDistribution(0.0, 1000.0);
+
+  for(const std::size_t nData : {5, 50, 500, 5000})
+  {
+    for(const double outlierRatio : {0.0, 0.3, 0.7, 0.95})
+    {
+      std::vector<double> residuals(nData);
+      for(std::size_t i = 0; i < nData; ++i)
+      {
+        const double r = (i < outlierRatio * nData) ? outlierDistribution(gen) : inlierDistribution(gen);
+        residuals[i] = r * r;
+      }
+      std::shuffle(residuals.begin(), residuals.end(), gen);
+
+      checkSameNFA(residuals, std::numeric_limits<double>::infinity());
+      checkSameNFA(residuals, 16.0);
+    }
+  }
+
+  // constant residuals: a single bucket
+  checkSameNFA(std::vector<double>(100, 1.0), std::numeric_limits<double>::infinity());
+  // exact inliers
+  std::vector<double> residuals(100, 0.0);
+  std::fill(residuals.begin() + 60, residuals.end(), 1e4);
+  checkSameNFA(residuals, std::numeric_limits<double>::infinity());
+}
+
+BOOST_AUTO_TEST_CASE(ACRansacFast_LineFitter_RealisticCase)
+{
+  const std::size_t NbPoints = 1000;
+  const double outlierRatio = .5;
+  const double noise = 0.5;
+  Vec2 GTModel;
+  GTModel << -2.0, 6.3;
+
+  std::mt19937 gen(42);
+  Mat2X xy(2, NbPoints);
+  std::vector<std::size_t> vec_inliersGT;
+  generateLine(NbPoints, outlierRatio, noise, GTModel, gen, xy, vec_inliersGT);
+
+  ACRANSACOneViewKernel<LineSolver, pointToLineError, Vec2> lineKernel(xy, NbPoints, NbPoints);
+
+  std::vector<std::size_t> vec_inliers;
+  Vec2 line;
+  const std::pair<double, double> ret = ACRANSAC(lineKernel, vec_inliers, 300, &line);
+
+  std::vector<std::size_t> vec_inliersFast;
+  Vec2 lineFast;
+  const std::pair<double, double> retFast = ACRANSAC_Fast(lineKernel, vec_inliersFast, 300, &lineFast);
+
+  // same quality than the reference implementation
+  BOOST_CHECK(retFast.second < 0);
+  BOOST_CHECK_CLOSE(ret.second, retFast.second, 5.0);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_inliers.size()) - vec_inliersFast.size(), NbPoints * 0.02);
+  // the model is estimated from a minimal sample, the intercept is less accurate than the slope
+  BOOST_CHECK_SMALL(GTModel[0] - lineFast[0], 2.0);
+  BOOST_CHECK_SMALL(GTModel[1] - lineFast[1], 0.01);
+}
+
+BOOST_AUTO_TEST_CASE(ACRansacFast_Seed)
+{
+  const std::size_t NbPoints = 200;
+  Vec2 GTModel;
+  GTModel << 1.0, 0.5;
+
+  std::mt19937 gen(7);
+  Mat2X xy(2, NbPoints);
+  std::vector<std::size_t> vec_inliersGT;
+  generateLine(NbPoints, 0.4, 0.2, GTModel, gen, xy, vec_inliersGT);
+
+  ACRANSACOneViewKernel<LineSolver, pointToLineError, Vec2> lineKernel(xy, NbPoints, NbPoints);
+
+  // the same seed gives the same result
+  std::vector<std::size_t> vec_inliersA, vec_inliersB;
+  Vec2 lineA, lineB;
+  const std::pair<double, double> retA = ACRANSAC_Fast(lineKernel, vec_inliersA, 300, &lineA, std::numeric_limits<double>::infinity(), 12345);
+  const std::pair<double, double> retB = ACRANSAC_Fast(lineKernel, vec_inliersB, 300, &lineB, std::numeric_limits<double>::infinity(), 12345);
+
+  BOOST_CHECK_EQUAL(retA.first, retB.first);
+  BOOST_CHECK_EQUAL(retA.second, retB.second);
+  BOOST_CHECK(vec_inliersA == vec_inliersB);
+  BOOST_CHECK_EQUAL(lineA[0], lineB[0]);
+  BOOST_CHECK_EQUAL(lineA[1], lineB[1]);
+}
+
+BOOST_AUTO_TEST_CASE(ACRansacFast_TooFewPoints)
+{
+  Vec2 xy;
+  xy << 1, 2;
+  ACRANSACOneViewKernel<LineSolver, pointToLineError, Vec2> lineKernel(xy, 12, 12);
+  std::vector<std::size_t> vec_inliers;
+  ACRANSAC_Fast(lineKernel, vec_inliers);
+
+  BOOST_CHECK_EQUAL(0, vec_inliers.size());
+}
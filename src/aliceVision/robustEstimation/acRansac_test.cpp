@@ -12,6 +12,7 @@
 #include <glog/logging.h>
 
 #include "lineTestGenerator.hpp"
+#include "acRansacTestKernel.hpp"
 #include "dependencies/vectorGraphics/svgDrawer.hpp"
 
 #define BOOST_TEST_MODULE ACRansac
@@ -24,97 +25,6 @@ using namespace aliceVision;
 using namespace aliceVision::robustEstimation;
 using namespace std;
 
-/// ACRansac Kernel for line estimation
-
-template <typename SolverArg,
-typename ErrorArg,
-typename ModelArg >
-class ACRANSACOneViewKernel
-{
-public:
-  typedef SolverArg Solver;
-  typedef ModelArg Model;
-
-  ACRANSACOneViewKernel(const Mat &x1, int w1, int h1)
-    : x1_(x1), N1_(Mat3::Identity()), logalpha0_(0.0)
-  {
-    assert(2 == x1_.rows());
-
-    // Model error as point to line error
-    // Ratio of containing diagonal image rectangle over image area
-    const double D = sqrt(w1 * w1 * 1.0 + h1 * h1); // diameter
-    const double A = w1 * h1; // area
-    logalpha0_ = log10(2.0 * D / A / 1.0);
-  }
-
-  enum
-  {
-    MINIMUM_SAMPLES = Solver::MINIMUM_SAMPLES
-  };
-
-  enum
-  {
-    MAX_MODELS = Solver::MAX_MODELS
-  };
-
-  void Fit(const std::vector<std::size_t> &samples, std::vector<Model> *models) const
-  {
-    const Mat sampled_xs = ExtractColumns(x1_, samples);
-    Solver::Solve(sampled_xs, models);
-  }
-
-  double Error(std::size_t sample, const Model &model) const
-  {
-    return ErrorArg::Error(model, x1_.col(sample));
-  }
-
-  void Errors(const Model &model, std::vector<double> & vec_errors) const
-  {
-    for(std::size_t sample = 0; sample < x1_.cols(); ++sample)
-      vec_errors[sample] = ErrorArg::Error(model, x1_.col(sample));
-  }
-
-  std::size_t NumSamples() const
-  {
-    return x1_.cols();
-  }
-
-  void Unnormalize(Model * model) const
-  {
-    // Model is left unchanged
-  }
-
-  double logalpha0() const
-  {
-    return logalpha0_;
-  }
-
-  double multError() const
-  {
-    return 0.5;
-  }
-
-  Mat3 normalizer1() const
-  {
-    return Mat3::Identity();
-  }
-
-  Mat3 normalizer2() const
-  {
-    return Mat3::Identity();
-  }
-
-  double unormalizeError(double val) const
-  {
-    return sqrt(val);
-  }
-
-private:
-  Mat x1_;
-  Mat3 N1_;
-  double logalpha0_;
-};
-
 // Test ACRANSAC with the AC-adapted Line kernel in a noise/outlier free dataset
 
 BOOST_AUTO_TEST_CASE(RansacLineFitter_OutlierFree)
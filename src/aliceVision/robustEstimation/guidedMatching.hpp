@@ -11,7 +11,10 @@
 
 #include "aliceVision/feature/Regions.hpp"
 #include "aliceVision/camera/IntrinsicBase.hpp"
+#include "aliceVision/robustEstimation/PointGrid.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 namespace aliceVision {
@@ -280,6 +283,236 @@ void GuidedMatching(
   }
 }
 
+/**
+ * @brief Distance to the model prediction used to query the PointGrid.
+ * Slightly larger than the error threshold to be robust to rounding,
+ * the exact error is evaluated on the retrieved candidates.
+ * @param[in] errorTh The squared error threshold
+ * @return the search radius in pixels
+ */
+inline double guidedMatchingSearchRadius(double errorTh)
+{
+  return std::sqrt(errorTh) * (1.0 + 1e-6) + 1e-6;
+}
+
+/**
+ * @brief Search region of a point transfer error (i.e. homography::kernel::AsymmetricError):
+ * the right points around the left point transferred by the model.
+ */
+struct HomographySearchRegion
+{
+  static void getCandidates(const Mat3& H,
+                            const Vec2& xLeft,
+                            double errorTh,
+                            const PointGrid& grid,
+                            std::vector<IndexT>& out_candidates)
+  {
+    const Vec3 x = H * Vec3(xLeft(0), xLeft(1), 1.0);
+    if(x(2) == 0.0)
+      return;
+    const Vec2 predicted = x.head<2>() / x(2);
+    const Vec2 radius = Vec2::Constant(guidedMatchingSearchRadius(errorTh));
+    grid.queryBox(predicted - radius, predicted + radius, out_candidates);
+  }
+};
+
+/**
+ * @brief Search region of a point to epipolar line error (i.e. fundamental::kernel::EpipolarDistanceError):
+ * the right points around the epipolar line of the left point.
+ */
+struct EpipolarSearchRegion
+{
+  static void getCandidates(const Mat3& F,
+                            const Vec2& xLeft,
+                            double errorTh,
+                            const PointGrid& grid,
+                            std::vector<IndexT>& out_candidates)
+  {
+    grid.queryBand(F * Vec3(xLeft(0), xLeft(1), 1.0), guidedMatchingSearchRadius(errorTh), out_candidates);
+  }
+};
+
+/**
+ * @brief Guided Matching (features only) with a spatial index:
+ * Same result as GuidedMatching, but the right points are stored in a PointGrid
+ * and only the points of the search region of each left point are evaluated.
+ *
+ * @param[in] mod The model
+ * @param[in] xLeft The left data points
+ * @param[in] xRight The right data points
+ * @param[in] errorTh Maximal authorized error threshold (squared)
+ * @param[out] out_validMatches Output corresponding index
+ */
+template<
+  typename ModelArg,        // The used model type
+  typename ErrorArg,        // The metric to compute distance to the model
+  typename SearchRegionArg> // The region of the right image where the error can be under the threshold
+void GuidedMatching_Grid(
+  const ModelArg & mod,
+  const Mat & xLeft,
+  const Mat & xRight,
+  double errorTh,
+  matching::IndMatches & out_validMatches)
+{
+  assert(xLeft.rows() == 2 && xRight.rows() == 2);
+
+  std::vector<Vec2> rightPoints(xRight.cols());
+  for(Mat::Index j = 0; j < xRight.cols(); ++j)
+    rightPoints[j] = xRight.col(j);
+
+  const PointGrid grid(rightPoints, std::sqrt(errorTh));
+  std::vector<IndexT> candidates;
+
+  for(Mat::Index i = 0; i < xLeft.cols(); ++i)
+  {
+    const Vec2 xL = xLeft.col(i);
+
+    candidates.clear();
+    SearchRegionArg::getCandidates(mod, xL, errorTh, grid, candidates);
+    // keep the exhaustive search order to select the same point in case of equality
+    std::sort(candidates.begin(), candidates.end());
+
+    double min = std::numeric_limits<double>::max();
+    matching::IndMatch match;
+    for(const IndexT j : candidates)
+    {
+      const double err = ErrorArg::Error(mod, xL, rightPoints[j]);
+      if(err < errorTh && err < min)
+      {
+        min = err;
+        match = matching::IndMatch(i, j);
+      }
+    }
+    if(min < errorTh)
+      out_validMatches.push_back(match);
+  }
+
+  // Remove duplicates (when multiple points at same position exist)
+  matching::IndMatch::getDeduplicated(out_validMatches);
+}
+
+/**
+ * @brief Get the regions positions, undistorted if a valid camera is given.
+ * @param[in] cam Optional camera (can be NULL)
+ * @param[in] regions The regions
+ * @param[out] out_positions The regions positions
+ */
+inline void getUndistortedRegionsPositions(const camera::IntrinsicBase * cam,
+                                           const feature::Regions & regions,
+                                           std::vector<Vec2> & out_positions)
+{
+  out_positions.resize(regions.RegionCount());
+  if(cam && cam->isValid())
+  {
+    for(std::size_t i = 0; i < regions.RegionCount(); ++i)
+      out_positions[i] = cam->get_ud_pixel(regions.GetRegionPosition(i));
+  }
+  else
+  {
+    for(std::size_t i = 0; i < regions.RegionCount(); ++i)
+      out_positions[i] = regions.GetRegionPosition(i);
+  }
+}
+
+/**
+ * @brief Guided Matching (features + descriptors with distance ratio) with a spatial index:
+ * Same result as GuidedMatching, but the right regions are stored in a PointGrid
+ * and only the regions of the search region of each left region are evaluated.
+ * The descriptor distances of the geometrically valid candidates are computed in one batch.
+ *
+ * @param[in] mod The model
+ * @param[in] camL Optional camera (in order to undistord on the fly feature positions, can be NULL)
+ * @param[in] lRegions regions (point features & corresponding descriptors)
+ * @param[in] camR Optional camera (in order to undistord on the fly feature positions, can be NULL)
+ * @param[in] rRegions regions (point features & corresponding descriptors)
+ * @param[in] errorTh Maximal authorized error threshold (squared)
+ * @param[in] distRatio Maximal authorized distance ratio
+ * @param[out] out_matches Output corresponding index
+ */
+template<
+  typename ModelArg,        // The used model type
+  typename ErrorArg,        // The metric to compute distance to the model
+  typename SearchRegionArg> // The region of the right image where the error can be under the threshold
+void GuidedMatching_Grid(
+  const ModelArg & mod,
+  const camera::IntrinsicBase * camL,
+  const feature::Regions & lRegions,
+  const camera::IntrinsicBase * camR,
+  const feature::Regions & rRegions,
+  double errorTh,
+  double distRatio,
+  matching::IndMatches & out_matches)
+{
+  std::vector<Vec2> lRegionsPos;
+  std::vector<Vec2> rRegionsPos;
+  getUndistortedRegionsPositions(camL, lRegions, lRegionsPos);
+  getUndistortedRegionsPositions(camR, rRegions, rRegionsPos);
+
+  const PointGrid grid(rRegionsPos, std::sqrt(errorTh));
+  std::vector<IndexT> candidates;
+  std::vector<IndexT> validCandidates;
+  std::vector<double> descDistances;
+
+  for(std::size_t i = 0; i < lRegions.RegionCount(); ++i)
+  {
+    candidates.clear();
+    SearchRegionArg::getCandidates(mod, lRegionsPos[i], errorTh, grid, candidates);
+    // keep the exhaustive search order to select the same region in case of equality
+    std::sort(candidates.begin(), candidates.end());
+
+    validCandidates.clear();
+    for(const IndexT j : candidates)
+    {
+      // Compute the geometric error: error to the model
+      if(ErrorArg::Error(mod, lRegionsPos[i], rRegionsPos[j]) < errorTh)
+        validCandidates.push_back(j);
+    }
+    if(validCandidates.size() < 2)
+      continue; // the distance ratio cannot be valid
+
+    lRegions.SquaredDescriptorDistances(i, &rRegions, validCandidates, descDistances);
+
+    distanceRatio<double> dR;
+    for(std::size_t k = 0; k < validCandidates.size(); ++k)
+      dR.update(validCandidates[k], descDistances[k]);
+
+    // Add correspondence only iff the distance ratio is valid
+    if(dR.isValid(distRatio))
+      out_matches.emplace_back(i, dR.idx);
+  }
+
+  // Remove duplicates (when multiple points at same position exist)
+  matching::IndMatch::getDeduplicated(out_matches);
+}
+
+/**
+ * @brief Guided Matching (features + descriptors with distance ratio) with a spatial index,
+ * for all the common describer types.
+ */
+template<
+  typename ModelArg,        // The used model type
+  typename ErrorArg,        // The metric to compute distance to the model
+  typename SearchRegionArg> // The region of the right image where the error can be under the threshold
+void GuidedMatching_Grid(
+  const ModelArg & mod, // The model
+  const camera::IntrinsicBase * camL, // Optional camera (in order to undistord on the fly feature positions, can be NULL)
+  const feature::MapRegionsPerDesc & lRegions,  // regions (point features & corresponding descriptors)
+  const camera::IntrinsicBase * camR, // Optional camera (in order to undistord on the fly feature positions, can be NULL)
+  const feature::MapRegionsPerDesc & rRegions,  // regions (point features & corresponding descriptors)
+  double errorTh,       // Maximal authorized error threshold
+  double distRatio,     // Maximal authorized distance ratio
+  matching::MatchesPerDescType & out_matchesPerDesc) // Ouput corresponding index
+{
+  const std::vector<feature::EImageDescriberType> descTypes = getCommonDescTypes(lRegions, rRegions);
+  if(descTypes.empty())
+    return;
+
+  for(const feature::EImageDescriberType descType: descTypes)
+  {
+    GuidedMatching_Grid<ModelArg, ErrorArg, SearchRegionArg>(mod, camL, *lRegions.at(descType), camR, *rRegions.at(descType), errorTh, distRatio, out_matchesPerDesc[descType]);
+  }
+}
+
 /// Compute a bucket index from an epipolar point
 ///  (the one that is closer to image border intersection)
 inline unsigned int pix_to_bucket(const Vec2i &x, int W, int H)
@@ -333,6 +566,18 @@ inline bool line_to_endPoints(const Vec3 & line, int W, int H, Vec2 & x0, Vec2 &
   return true;
 }
 
+/**
+ * @brief Buffers of GuidedMatching_Fundamental_Fast.
+ * Reuse them between calls (i.e. one instance per thread) to avoid the allocations.
+ */
+struct GuidedMatchingFundamentalBuffers
+{
+  /// left points indexes per epipolar line bucket
+  std::vector<std::vector<IndexT>> buckets;
+  /// best right points per left point
+  std::vector<distanceRatio<double>> distanceRatios;
+};
+
 /// Guided Matching (features + descriptors with distance ratio):
 /// Cluster correspondences per epipolar line (faster than exhaustive search).
 ///   Keep the best corresponding points for the given model under the
@@ -354,7 +599,8 @@ void GuidedMatching_Fundamental_Fast(
   const int widthR, const int heightR,
   double errorTh,       // Maximal authorized error threshold (consider it's a square threshold)
   double distRatio,     // Maximal authorized distance ratio
-  matching::IndMatches & vec_corresponding_index) // Ouput corresponding index
+  matching::IndMatches & vec_corresponding_index, // Ouput corresponding index
+  GuidedMatchingFundamentalBuffers & buffers) // Reused buffers
 {
   // Looking for the corresponding points that have to satisfy:
   //   1. a geometric distance below the provided Threshold
@@ -381,7 +627,11 @@ void GuidedMatching_Fundamental_Fast(
   typedef std::vector<Bucket_vec> Buckets_vec;
   const int nb_buckets = 2 * (widthR + heightR - 2);
 
-  Buckets_vec buckets(nb_buckets);
+  // keep the buckets capacity
+  Buckets_vec & buckets = buffers.buckets;
+  buckets.resize(nb_buckets);
+  for(Bucket_vec & bucket : buckets)
+    bucket.clear();
   for(std::size_t i = 0; i < lRegions.RegionCount(); ++i)
   {
     // Compute epipolar line
@@ -398,7 +648,8 @@ void GuidedMatching_Fundamental_Fast(
   }
 
   // For each point in right image, find if there is good candidates.
-  std::vector<distanceRatio<double > > dR(lRegions.RegionCount());
+  std::vector<distanceRatio<double > > & dR = buffers.distanceRatios;
+  dR.assign(lRegions.RegionCount(), distanceRatio<double>());
   for(std::size_t j = 0; j < rRegions.RegionCount(); ++j)
   {
     // According the point:
@@ -454,5 +705,24 @@ void GuidedMatching_Fundamental_Fast(
   }
 }
 
+/// Guided Matching (features + descriptors with distance ratio) per epipolar line, with temporary buffers.
+template<typename ErrorArg> // The used model type
+void GuidedMatching_Fundamental_Fast(
+  const Mat3 & FMat,    // The fundamental matrix
+  const Vec3 & epipole2,// Epipole2 (camera center1 in image plane2; must not be normalized)
+  const camera::IntrinsicBase * camL, // Optional camera (in order to undistord on the fly feature positions, can be NULL)
+  const feature::Regions & lRegions,  // regions (point features & corresponding descriptors)
+  const camera::IntrinsicBase * camR, // Optional camera (in order to undistord on the fly feature positions, can be NULL)
+  const feature::Regions & rRegions,  // regions (point features & corresponding descriptors)
+  const int widthR, const int heightR,
+  double errorTh,       // Maximal authorized error threshold (consider it's a square threshold)
+  double distRatio,     // Maximal authorized distance ratio
+  matching::IndMatches & vec_corresponding_index) // Ouput corresponding index
+{
+  GuidedMatchingFundamentalBuffers buffers;
+  GuidedMatching_Fundamental_Fast<ErrorArg>(FMat, epipole2, camL, lRegions, camR, rRegions,
+    widthR, heightR, errorTh, distRatio, vec_corresponding_index, buffers);
+}
+
 } // namespace robustEstimation
 } // namespace aliceVision
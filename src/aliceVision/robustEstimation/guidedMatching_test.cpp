@@ -0,0 +1,224 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/robustEstimation/guidedMatching.hpp>
+#include <aliceVision/robustEstimation/PointGrid.hpp>
+
+#include <random>
+#include <set>
+
+#define BOOST_TEST_MODULE guidedMatching
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::robustEstimation;
+
+/// Homography transfer error (squared)
+struct TransferError
+{
+  static double Error(const Mat3& H, const Vec2& x1, const Vec2& x2)
+  {
+    const Vec3 x = H * Vec3(x1(0), x1(1), 1.0);
+    return (x2 - x.head<2>() / x(2)).squaredNorm();
+  }
+};
+
+/// Point to epipolar line error (squared)
+struct EpipolarError
+{
+  static double Error(const Mat3& F, const Vec2& x1, const Vec2& x2)
+  {
+    const Vec3 line = F * Vec3(x1(0), x1(1), 1.0);
+    return Square(line.dot(Vec3(x2(0), x2(1), 1.0))) / line.head<2>().squaredNorm();
+  }
+};
+
+typedef feature::ScalarRegions<feature::SIOPointFeature, unsigned char, 128> TestRegions;
+
+Mat3 makeHomography()
+{
+  Mat3 H;
+  H << 1.1, 0.05, 20.0,
+       -0.03, 0.95, -15.0,
+       1e-5, -2e-5, 1.0;
+  return H;
+}
+
+Mat3 makeFundamental()
+{
+  Mat3 K;
+  K << 1000.0, 0.0, 500.0,
+       0.0, 1000.0, 500.0,
+       0.0, 0.0, 1.0;
+  const Mat3 R = Eigen::AngleAxisd(0.1, Vec3(0.2, 1.0, 0.1).normalized()).toRotationMatrix();
+  const Vec3 t(1.0, 0.2, 0.1);
+  Mat3 tx;
+  tx << 0.0, -t(2), t(1),
+        t(2), 0.0, -t(0),
+        -t(1), t(0), 0.0;
+  return K.inverse().transpose() * tx * R * K.inverse();
+}
+
+/**
+ * @brief Left points and right points: half of the right points are left points transferred by H with noise.
+ */
+void makePoints(const Mat3& H, std::size_t nbPoints, std::mt19937& gen, Mat& xLeft, Mat& xRight)
+{
+  std::uniform_real_distribution<double> position(0.0, 1000.0);
+  std::normal_distribution<double> noise(0.0, 1.0);
+
+  xLeft.resize(2, nbPoints);
+  xRight.resize(2, nbPoints);
+  for(std::size_t i = 0; i < nbPoints; ++i)
+  {
+    xLeft.col(i) << position(gen), position(gen);
+    if(i % 2)
+    {
+      const Vec3 x = H * Vec3(xLeft(0, i), xLeft(1, i), 1.0);
+      xRight.col(i) = x.head<2>() / x(2) + Vec2(noise(gen), noise(gen));
+    }
+    else
+    {
+      xRight.col(i) << position(gen), position(gen);
+    }
+  }
+  // duplicated positions
+  xRight.col(1) = xRight.col(3);
+}
+
+BOOST_AUTO_TEST_CASE(PointGrid_queries)
+{
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<double> position(0.0, 1000.0);
+  std::uniform_real_distribution<double> direction(-1.0, 1.0);
+
+  std::vector<Vec2> points(5000);
+  for(Vec2& point : points)
+    point << position(gen), position(gen);
+
+  for(const double cellSize : {0.0, 2.0, 50.0})
+  {
+    const PointGrid grid(points, cellSize);
+    BOOST_CHECK(grid.getNbCells() <= 4 * points.size() + 4);
+
+    for(int q = 0; q < 50; ++q)
+    {
+      const Vec2 center(position(gen), position(gen));
+      const double radius = 20.0;
+      const Vec3 line(direction(gen), direction(gen), -1000.0 * direction(gen));
+
+      std::vector<IndexT> boxIndexes, bandIndexes;
+      grid.queryBox(center - Vec2::Constant(radius), center + Vec2::Constant(radius), boxIndexes);
+      grid.queryBand(line, radius, bandIndexes);
+
+      const std::set<IndexT> boxSet(boxIndexes.begin(), boxIndexes.end());
+      const std::set<IndexT> bandSet(bandIndexes.begin(), bandIndexes.end());
+      // no duplicates
+      BOOST_CHECK_EQUAL(boxSet.size(), boxIndexes.size());
+      BOOST_CHECK_EQUAL(bandSet.size(), bandIndexes.size());
+
+      // all the points in the regions are retrieved
+      for(std::size_t i = 0; i < points.size(); ++i)
+      {
+        if((points[i] - center).lpNorm<Eigen::Infinity>() <= radius)
+          BOOST_CHECK(boxSet.count(i));
+        if(std::abs(line.dot(Vec3(points[i](0), points[i](1), 1.0))) / line.head<2>().norm() <= radius)
+          BOOST_CHECK(bandSet.count(i));
+      }
+    }
+  }
+
+  // degenerated point sets
+  const PointGrid emptyGrid(std::vector<Vec2>(), 1.0);
+  std::vector<IndexT> indexes;
+  emptyGrid.queryBox(Vec2::Zero(), Vec2::Constant(10.0), indexes);
+  BOOST_CHECK(indexes.empty());
+
+  const PointGrid sameGrid(std::vector<Vec2>(10, Vec2(5.0, 5.0)), 0.0);
+  sameGrid.queryBox(Vec2::Zero(), Vec2::Constant(10.0), indexes);
+  BOOST_CHECK_EQUAL(10, indexes.size());
+}
+
+BOOST_AUTO_TEST_CASE(GuidedMatching_Grid_features)
+{
+  std::mt19937 gen(1);
+  Mat xLeft, xRight;
+
+  const Mat3 H = makeHomography();
+  makePoints(H, 3000, gen, xLeft, xRight);
+  for(const double errorTh : {0.5, 4.0, 100.0})
+  {
+    matching::IndMatches matches, gridMatches;
+    GuidedMatching<Mat3, TransferError>(H, xLeft, xRight, errorTh, matches);
+    GuidedMatching_Grid<Mat3, TransferError, HomographySearchRegion>(H, xLeft, xRight, errorTh, gridMatches);
+    BOOST_CHECK(!matches.empty());
+    BOOST_CHECK(matches == gridMatches);
+  }
+
+  const Mat3 F = makeFundamental();
+  for(const double errorTh : {0.5, 4.0})
+  {
+    matching::IndMatches matches, gridMatches;
+    GuidedMatching<Mat3, EpipolarError>(F, xLeft, xRight, errorTh, matches);
+    GuidedMatching_Grid<Mat3, EpipolarError, EpipolarSearchRegion>(F, xLeft, xRight, errorTh, gridMatches);
+    BOOST_CHECK(!matches.empty());
+    BOOST_CHECK(matches == gridMatches);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GuidedMatching_Grid_regions)
+{
+  std::mt19937 gen(2);
+  std::uniform_int_distribution<int> descValue(0, 255);
+  std::uniform_int_distribution<int> descNoise(-5, 5);
+
+  const Mat3 H = makeHomography();
+  Mat xLeft, xRight;
+  makePoints(H, 2000, gen, xLeft, xRight);
+
+  TestRegions lRegions, rRegions;
+  for(Mat::Index i = 0; i < xLeft.cols(); ++i)
+  {
+    TestRegions::DescriptorT rDesc, lDesc;
+    for(std::size_t k = 0; k < 128; ++k)
+    {
+      rDesc[k] = descValue(gen);
+      // similar descriptors for the inliers
+      lDesc[k] = (i % 2) ? std::min(std::max(rDesc[k] + descNoise(gen), 0), 255) : descValue(gen);
+    }
+    lRegions.Features().emplace_back(xLeft(0, i), xLeft(1, i));
+    rRegions.Features().emplace_back(xRight(0, i), xRight(1, i));
+    lRegions.Descriptors().push_back(lDesc);
+    rRegions.Descriptors().push_back(rDesc);
+  }
+
+  // batched descriptor distances
+  {
+    const std::vector<IndexT> indexes = {0, 5, 3};
+    std::vector<double> distances;
+    lRegions.SquaredDescriptorDistances(1, &rRegions, indexes, distances);
+    BOOST_CHECK_EQUAL(indexes.size(), distances.size());
+    for(std::size_t k = 0; k < indexes.size(); ++k)
+      BOOST_CHECK_EQUAL(lRegions.SquaredDescriptorDistance(1, &rRegions, indexes[k]), distances[k]);
+  }
+
+  for(const double errorTh : {4.0, 400.0})
+  {
+    matching::IndMatches matches, gridMatches;
+    GuidedMatching<Mat3, TransferError>(H, nullptr, lRegions, nullptr, rRegions, errorTh, Square(0.8), matches);
+    GuidedMatching_Grid<Mat3, TransferError, HomographySearchRegion>(H, nullptr, lRegions, nullptr, rRegions, errorTh, Square(0.8), gridMatches);
+    BOOST_CHECK(!matches.empty());
+    BOOST_CHECK(matches == gridMatches);
+  }
+
+  const Mat3 F = makeFundamental();
+  {
+    matching::IndMatches matches, gridMatches;
+    GuidedMatching<Mat3, EpipolarError>(F, nullptr, lRegions, nullptr, rRegions, 16.0, Square(0.8), matches);
+    GuidedMatching_Grid<Mat3, EpipolarError, EpipolarSearchRegion>(F, nullptr, lRegions, nullptr, rRegions, 16.0, Square(0.8), gridMatches);
+    BOOST_CHECK(matches == gridMatches);
+  }
+}
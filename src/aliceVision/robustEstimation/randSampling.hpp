@@ -11,6 +11,8 @@
 #include <cstdlib>
 #include <random>
 #include <cassert>
+#include <numeric>
+#include <vector>
 
 namespace aliceVision {
 namespace robustEstimation{
@@ -154,5 +156,37 @@ inline void UniformSample(std::size_t sampleSize,
   }
 }
 
+/**
+ * @brief Generate a random sequence containing a sampling without replacement of
+ * of the elements of the input vector, using the given random generator.
+ * Designed for the small minimal samples of the robust estimators: the sample
+ * buffer is reused and the uniqueness is checked by a linear search.
+ *
+ * @param[in] sampleSize The size of the sample to generate.
+ * @param[in] elements The possible data indices (without duplicates).
+ * @param[out] sample The random sample of sizeSample indices.
+ * @param[in,out] generator The random generator.
+ */
+template<typename RandomGeneratorT>
+inline void UniformSample(std::size_t sampleSize,
+                          const std::vector<std::size_t>& elements,
+                          std::vector<std::size_t>& sample,
+                          RandomGeneratorT& generator)
+{
+  assert(sampleSize <= elements.size());
+  std::uniform_int_distribution<std::size_t> distribution(0, elements.size() - 1);
+  sample.resize(sampleSize);
+  for(std::size_t i = 0; i < sampleSize; ++i)
+  {
+    std::size_t element;
+    do
+    {
+      element = elements[distribution(generator)];
+    }
+    while(std::find(sample.begin(), sample.begin() + i, element) != sample.begin() + i);
+    sample[i] = element;
+  }
+}
+
 } // namespace robustEstimation
 } // namespace aliceVision
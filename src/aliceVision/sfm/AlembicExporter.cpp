@@ -9,7 +9,10 @@
 
 #include <Alembic/AbcGeom/All.h>
 #include <Alembic/AbcCoreOgawa/All.h>
-#include <numeric>
+
+#include <algorithm>
+#include <string>
+#include <vector>
 
 namespace aliceVision {
 namespace sfm {
@@ -55,51 +58,67 @@ struct AlembicExporter::DataImpl
   Alembic::AbcGeom::OUInt32Property _propIntrinsicId;
   Alembic::AbcGeom::OStringProperty _mvgIntrinsicType;
   Alembic::AbcGeom::ODoubleArrayProperty _mvgIntrinsicParams;
-};
 
+  /// intrinsics of the last keyframe of the animated camera
+  float _lastSensorWidth_mm = 0.f;
+  std::vector<::uint32_t> _lastSensorSize_pix;
+  IndexT _lastIntrinsicId = UndefinedIndexT;
+  std::string _lastIntrinsicType;
+  std::vector<double> _lastIntrinsicParams;
+
+  /// maximum number of landmarks per point cloud
+  std::size_t _landmarksChunkSize = 1000000;
+  /// number of point clouds already written
+  std::size_t _nbPointClouds = 0;
+};
 
-AlembicExporter::AlembicExporter(const std::string &filename)
-: _data(new DataImpl(filename))
-{ }
-
-AlembicExporter::~AlembicExporter()
-{
-}
+namespace {
 
-void AlembicExporter::addPoints(const sfm::Landmarks &landmarks, bool withVisibility)
+/**
+ * @brief Buffers of a chunk of landmarks, reused from one chunk to the next
+ */
+struct LandmarksChunk
 {
-  if(landmarks.empty())
-    return;
-
-  // Fill vector with the values taken from AliceVision 
   std::vector<V3f> positions;
   std::vector<Imath::C3f> colors;
   std::vector<Alembic::Util::uint32_t> descTypes;
-  positions.reserve(landmarks.size());
-  descTypes.reserve(landmarks.size());
-
-  // For all the 3d points in the hash_map
-  for(const auto landmark : landmarks)
+  std::vector<Alembic::Util::uint64_t> ids;
+  std::vector<::uint32_t> visibilitySize;
+  // Use std::vector<::uint32_t> and std::vector<float> instead of std::vector<V2i> and std::vector<V2f>
+  // Because Maya don't import them correctly
+  std::vector<::uint32_t> visibilityIds;
+  std::vector<float> featPos2d;
+
+  void clear()
   {
-    const aliceVision::Vec3& pt = landmark.second.X;
-    const aliceVision::image::RGBColor& color = landmark.second.rgb;
-    positions.emplace_back(pt[0], pt[1], pt[2]);
-    colors.emplace_back(color.r()/255.f, color.g()/255.f, color.b()/255.f);
-    descTypes.emplace_back(static_cast<Alembic::Util::uint8_t>(landmark.second.descType));
+    positions.clear();
+    colors.clear();
+    descTypes.clear();
+    ids.clear();
+    visibilitySize.clear();
+    visibilityIds.clear();
+    featPos2d.clear();
   }
+};
 
-  std::vector<Alembic::Util::uint64_t> ids(positions.size());
-  std::iota(begin(ids), end(ids), 0);
-
-  OPoints partsOut(_data->_mvgPointCloud, "particleShape1");
+/**
+ * @brief Write a chunk of landmarks as a point cloud
+ * @param[in] parent The Alembic parent node
+ * @param[in] name The name of the point cloud
+ * @param[in] chunk The landmarks data
+ * @param[in] withVisibility Write the observations of the landmarks
+ */
+void writeLandmarksChunk(OObject& parent, const std::string& name, const LandmarksChunk& chunk, bool withVisibility)
+{
+  OPoints partsOut(parent, name);
   OPointsSchema &pSchema = partsOut.getSchema();
 
-  OPointsSchema::Sample psamp(std::move(V3fArraySample(positions)), std::move(UInt64ArraySample(ids)));
+  OPointsSchema::Sample psamp(V3fArraySample(chunk.positions), UInt64ArraySample(chunk.ids));
   pSchema.set(psamp);
 
   OCompoundProperty arbGeom = pSchema.getArbGeomParams();
 
-  C3fArraySample cval_samp(&colors[0], colors.size());
+  C3fArraySample cval_samp(&chunk.colors[0], chunk.colors.size());
   OC3fGeomParam::Sample color_samp(cval_samp, kVertexScope);
 
   OC3fGeomParam rgbOut(arbGeom, "color", false, kVertexScope, 1);
@@ -108,54 +127,95 @@ void AlembicExporter::addPoints(const sfm::Landmarks &landmarks, bool withVisibi
   OCompoundProperty userProps = pSchema.getUserProperties();
 
   OUInt32ArrayProperty descTypeOut(userProps, "mvg_describerType");
-  descTypeOut.set(descTypes);
+  descTypeOut.set(chunk.descTypes);
 
   if(withVisibility)
   {
-    std::vector<::uint32_t> visibilitySize;
-    visibilitySize.reserve(positions.size());
-    for(const auto landmark : landmarks)
-    {
-      visibilitySize.emplace_back(landmark.second.observations.size());
-    }
-    std::size_t nbObservations = std::accumulate(visibilitySize.begin(), visibilitySize.end(), 0);
-    
-    // Use std::vector<::uint32_t> and std::vector<float> instead of std::vector<V2i> and std::vector<V2f>
-    // Because Maya don't import them correctly
-    std::vector<::uint32_t> visibilityIds;
-    visibilityIds.reserve(nbObservations*2);
-    std::vector<float>featPos2d;
-    featPos2d.reserve(nbObservations*2);
-
-    for(sfm::Landmarks::const_iterator itLandmark = landmarks.cbegin(), itLandmarkEnd = landmarks.cend();
-       itLandmark != itLandmarkEnd; ++itLandmark)
+    OUInt32ArrayProperty propVisibilitySize( userProps, "mvg_visibilitySize" );
+    propVisibilitySize.set(chunk.visibilitySize);
+
+    // (viewID, featID)
+    OUInt32ArrayProperty propVisibilityIds( userProps, "mvg_visibilityIds" );
+    propVisibilityIds.set(chunk.visibilityIds);
+
+    // Feature position (x,y)
+    OFloatArrayProperty propFeatPos2d( userProps, "mvg_visibilityFeatPos" );
+    propFeatPos2d.set(chunk.featPos2d);
+  }
+}
+
+} // namespace
+
+
+AlembicExporter::AlembicExporter(const std::string &filename)
+: _data(new DataImpl(filename))
+{ }
+
+AlembicExporter::~AlembicExporter()
+{
+}
+
+void AlembicExporter::addPoints(const sfm::Landmarks &landmarks, bool withVisibility)
+{
+  if(landmarks.empty())
+    return;
+
+  const std::size_t chunkSize = (_data->_landmarksChunkSize > 0) ? std::min(_data->_landmarksChunkSize, landmarks.size()) : landmarks.size();
+
+  LandmarksChunk chunk;
+  chunk.positions.reserve(chunkSize);
+  chunk.colors.reserve(chunkSize);
+  chunk.descTypes.reserve(chunkSize);
+  chunk.ids.reserve(chunkSize);
+  if(withVisibility)
+    chunk.visibilitySize.reserve(chunkSize);
+
+  // Fill the chunk with the values taken from AliceVision and write it when it is full
+  std::size_t landmarkIndex = 0;
+  for(const auto& landmark : landmarks)
+  {
+    const aliceVision::Vec3& pt = landmark.second.X;
+    const aliceVision::image::RGBColor& color = landmark.second.rgb;
+    chunk.positions.emplace_back(pt[0], pt[1], pt[2]);
+    chunk.colors.emplace_back(color.r()/255.f, color.g()/255.f, color.b()/255.f);
+    chunk.descTypes.emplace_back(static_cast<Alembic::Util::uint8_t>(landmark.second.descType));
+    // unique in the whole scene
+    chunk.ids.emplace_back(landmarkIndex++);
+
+    if(withVisibility)
     {
-      const sfm::Observations& observations = itLandmark->second.observations;
-      for(const auto vObs: observations )
+      const sfm::Observations& observations = landmark.second.observations;
+      chunk.visibilitySize.emplace_back(observations.size());
+      for(const auto& vObs : observations)
       {
         const sfm::Observation& obs = vObs.second;
         // (View ID, Feature ID)
-        visibilityIds.emplace_back(vObs.first);
-        visibilityIds.emplace_back(obs.id_feat);
+        chunk.visibilityIds.emplace_back(vObs.first);
+        chunk.visibilityIds.emplace_back(obs.id_feat);
         // Feature 2D position (x, y))
-        featPos2d.emplace_back(obs.x[0]);
-        featPos2d.emplace_back(obs.x[1]);
+        chunk.featPos2d.emplace_back(obs.x[0]);
+        chunk.featPos2d.emplace_back(obs.x[1]);
       }
     }
 
-    OUInt32ArrayProperty propVisibilitySize( userProps, "mvg_visibilitySize" );
-    propVisibilitySize.set(visibilitySize);
-
-    // (viewID, featID)
-    OUInt32ArrayProperty propVisibilityIds( userProps, "mvg_visibilityIds" );
-    propVisibilityIds.set(visibilityIds);
-
-    // Feature position (x,y)
-    OFloatArrayProperty propFeatPos2d( userProps, "mvg_visibilityFeatPos" );
-    propFeatPos2d.set(featPos2d);
+    if(chunk.positions.size() == chunkSize || landmarkIndex == landmarks.size())
+    {
+      ++_data->_nbPointClouds;
+      writeLandmarksChunk(_data->_mvgPointCloud, "particleShape" + std::to_string(_data->_nbPointClouds), chunk, withVisibility);
+      chunk.clear();
+    }
   }
 }
 
+void AlembicExporter::setLandmarksChunkSize(std::size_t chunkSize)
+{
+  _data->_landmarksChunkSize = chunkSize;
+}
+
+std::size_t AlembicExporter::getLandmarksChunkSize() const
+{
+  return _data->_landmarksChunkSize;
+}
 
 void AlembicExporter::appendCameraRig(IndexT rigId,
                                       IndexT rigPoseId,
@@ -391,6 +451,12 @@ void AlembicExporter::initAnimatedCamera(const std::string& cameraName)
   _data->_mvgIntrinsicType = OStringProperty(userProps, "mvg_intrinsicType", tsp);
   // Intrinsic parameters
   _data->_mvgIntrinsicParams = ODoubleArrayProperty(userProps, "mvg_intrinsicParams", tsp);
+
+  _data->_lastSensorWidth_mm = 0.f;
+  _data->_lastSensorSize_pix.clear();
+  _data->_lastIntrinsicId = UndefinedIndexT;
+  _data->_lastIntrinsicType.clear();
+  _data->_lastIntrinsicParams.clear();
 }
 
 void AlembicExporter::addCameraKeyframe(const geometry::Pose3 &pose,
@@ -400,6 +466,8 @@ void AlembicExporter::addCameraKeyframe(const geometry::Pose3 &pose,
                                           const IndexT id_intrinsic,
                                           const float sensorWidth_mm)
 {
+  const bool isFirstKeyframe = (_data->_xform.getSchema().getNumSamples() == 0);
+
   const aliceVision::Mat3 R = pose.rotation();
   const aliceVision::Vec3 center = pose.center();
   // POSE
@@ -434,14 +502,53 @@ void AlembicExporter::addCameraKeyframe(const geometry::Pose3 &pose,
   // Attach it to the schema of the OXform
   _data->_xform.getSchema().set(xformsample);
   
-  // Camera intrinsic parameters
-  CameraSample camSample;
-
   // Take the max of the image size to handle the case where the image is in portrait mode 
   const float imgWidth = cam->w();
   const float imgHeight = cam->h();
   const float sensorWidth_pix = std::max(imgWidth, imgHeight);
   const float sensorHeight_pix = std::min(imgWidth, imgHeight);
+  std::vector<::uint32_t> sensorSize_pix = {::uint32_t(sensorWidth_pix), ::uint32_t(sensorHeight_pix)};
+  const std::string intrinsicType = cam->getTypeStr();
+  std::vector<double> intrinsicParams = cam->getParams();
+
+  // The intrinsics are usually constant along the sequence,
+  // in that case the previous samples are referenced instead of being written again
+  const bool sameIntrinsics = !isFirstKeyframe &&
+                              sensorWidth_mm == _data->_lastSensorWidth_mm &&
+                              sensorSize_pix == _data->_lastSensorSize_pix &&
+                              intrinsicType == _data->_lastIntrinsicType &&
+                              intrinsicParams == _data->_lastIntrinsicParams;
+
+  // Set custom attributes
+  // Image path
+  _data->_imagePlane.set(imagePath);
+
+  // View id
+  _data->_propViewId.set(id_view);
+
+  // Intrinsic id
+  if(!isFirstKeyframe && id_intrinsic == _data->_lastIntrinsicId)
+  {
+    _data->_propIntrinsicId.setFromPrevious();
+  }
+  else
+  {
+    _data->_propIntrinsicId.set(id_intrinsic);
+    _data->_lastIntrinsicId = id_intrinsic;
+  }
+
+  if(sameIntrinsics)
+  {
+    _data->_propSensorSize_pix.setFromPrevious();
+    _data->_mvgIntrinsicType.setFromPrevious();
+    _data->_mvgIntrinsicParams.setFromPrevious();
+    _data->_camObj.getSchema().setFromPrevious();
+    return;
+  }
+
+  // Camera intrinsic parameters
+  CameraSample camSample;
+
   //const float imgRatio = sensorHeight_pix / sensorWidth_pix;
   const float focalLength_pix = cam->focal();
   //const float sensorHeight_mm = sensorWidth_mm * imgRatio;
@@ -459,25 +566,19 @@ void AlembicExporter::addCameraKeyframe(const geometry::Pose3 &pose,
   camSample.setVerticalAperture(vaperture_cm);
   
   // Add sensor width (largest image side) in pixels as custom property
-  std::vector<::uint32_t> sensorSize_pix = {::uint32_t(sensorWidth_pix), ::uint32_t(sensorHeight_pix)};
   _data->_propSensorSize_pix.set(sensorSize_pix);
-  
-  // Set custom attributes
-  // Image path
-  _data->_imagePlane.set(imagePath);
-
-  // View id
-  _data->_propViewId.set(id_view);
-  // Intrinsic id
-  _data->_propIntrinsicId.set(id_intrinsic);
   // Intrinsic type
-  _data->_mvgIntrinsicType.set(cam->getTypeStr());
+  _data->_mvgIntrinsicType.set(intrinsicType);
   // Intrinsic parameters
-  std::vector<double> intrinsicParams = cam->getParams();
   _data->_mvgIntrinsicParams.set(intrinsicParams);
   
   // Attach intrinsic parameters to camera object
   _data->_camObj.getSchema().set(camSample);
+
+  _data->_lastSensorWidth_mm = sensorWidth_mm;
+  _data->_lastSensorSize_pix.swap(sensorSize_pix);
+  _data->_lastIntrinsicType = intrinsicType;
+  _data->_lastIntrinsicParams.swap(intrinsicParams);
 }
 
 void AlembicExporter::jumpKeyframe(const std::string &imagePath)
@@ -491,6 +592,13 @@ void AlembicExporter::jumpKeyframe(const std::string &imagePath)
   {
     _data->_xform.getSchema().setFromPrevious();
     _data->_camObj.getSchema().setFromPrevious();
+    // keep the samples of the custom properties aligned with the keyframes
+    _data->_propSensorSize_pix.setFromPrevious();
+    _data->_imagePlane.set(imagePath);
+    _data->_propViewId.setFromPrevious();
+    _data->_propIntrinsicId.setFromPrevious();
+    _data->_mvgIntrinsicType.setFromPrevious();
+    _data->_mvgIntrinsicParams.setFromPrevious();
   }
 }
 
@@ -27,11 +27,28 @@ public:
 
   /**
    * @brief Add a set of 3D points from a SFM scene
+   *
+   * The points are streamed in point clouds of at most getLandmarksChunkSize() points,
+   * so the temporary buffers do not depend on the size of the scene.
+   *
    * @param[in] points The 3D points to add
+   * @param[in] withVisibility Add the observations of the 3D points
    */
   void addPoints(const sfm::Landmarks &points,
                  bool withVisibility=true);
 
+  /**
+   * @brief Set the maximum number of 3D points written in a single point cloud
+   * @param[in] chunkSize The maximum number of 3D points per point cloud (0 for no limit)
+   */
+  void setLandmarksChunkSize(std::size_t chunkSize);
+
+  /**
+   * @brief Get the maximum number of 3D points written in a single point cloud
+   * @return the maximum number of 3D points per point cloud (0 for no limit)
+   */
+  std::size_t getLandmarksChunkSize() const;
+
 
   /**
    * @brief Add a camera rig
@@ -93,6 +110,9 @@ public:
   
   /**
    * @brief Add a keyframe to the animated camera
+   *
+   * The intrinsics properties that did not change since the previous keyframe
+   * are written as references to the previous samples.
    * 
    * @param[in] pose The camera pose
    * @param[in] cam The camera intrinsics parameters
@@ -110,6 +130,7 @@ public:
   
   /**
    * @brief Register keyframe on the previous values
+   * @param[in] imagePath The image path of the keyframe
    */
   void jumpKeyframe(const std::string &imagePath = std::string());
   
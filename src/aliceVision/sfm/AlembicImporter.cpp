@@ -83,7 +83,10 @@ bool readPointCloud(IObject iObj, M44d mat, sfm::SfMData &sfmdata, sfm::ESfMData
 
   IPoints points(iObj, kWrapExisting);
   IPointsSchema& ms = points.getSchema();
-  P3fArraySamplePtr positions = ms.getValue().getPositions();
+
+  // only read the positions, the ids of the points are not used
+  P3fArraySamplePtr positions;
+  ms.getPositionsProperty().get(positions);
 
   ICompoundProperty userProps = getAbcUserProperties(ms);
   ICompoundProperty arbGeom = ms.getArbGeomParams();
@@ -134,7 +137,8 @@ bool readPointCloud(IObject iObj, M44d mat, sfm::SfMData &sfmdata, sfm::ESfMData
     }
   }
 
-  if(userProps &&
+  if((flags_part & sfm::ESfMData::OBSERVATIONS) &&
+     userProps &&
      userProps.getPropertyHeader("mvg_visibilitySize") &&
      userProps.getPropertyHeader("mvg_visibilityIds") &&
      userProps.getPropertyHeader("mvg_visibilityFeatPos")
@@ -508,14 +512,18 @@ bool readXform(IXform& xform, M44d& mat, sfm::SfMData& sfmData, sfm::ESfMData fl
 }
 
 // Top down read of 3d objects
-void visitObject(IObject iObj, M44d mat, sfm::SfMData &sfmdata, sfm::ESfMData flags_part)
+// The point clouds are only located if the structure is not requested
+void visitObject(IObject iObj, M44d mat, sfm::SfMData &sfmdata, sfm::ESfMData flags_part, std::vector<IObject>& skippedPointClouds)
 {
   // ALICEVISION_LOG_DEBUG("ABC visit: " << iObj.getFullName());
   
   const MetaData& md = iObj.getMetaData();
-  if(IPoints::matches(md) && (flags_part & sfm::ESfMData::STRUCTURE))
+  if(IPoints::matches(md))
   {
-    readPointCloud(iObj, mat, sfmdata, flags_part);
+    if(flags_part & sfm::ESfMData::STRUCTURE)
+      readPointCloud(iObj, mat, sfmdata, flags_part);
+    else
+      skippedPointClouds.push_back(iObj);
   }
   else if(IXform::matches(md))
   {
@@ -537,7 +545,7 @@ void visitObject(IObject iObj, M44d mat, sfm::SfMData &sfmdata, sfm::ESfMData fl
   // Recurse
   for(size_t i = 0; i < iObj.getNumChildren(); i++)
   {
-    visitObject(iObj.getChild(i), mat, sfmdata, flags_part);
+    visitObject(iObj.getChild(i), mat, sfmdata, flags_part, skippedPointClouds);
   }
 }
 
@@ -549,6 +557,8 @@ struct AlembicImporter::DataImpl
   }
   
   IObject _rootEntity;
+  /// point clouds skipped by the last populate
+  std::vector<IObject> _skippedPointClouds;
 };
 
 AlembicImporter::AlembicImporter(const std::string &filename)
@@ -583,10 +593,26 @@ void AlembicImporter::populate(sfm::SfMData &sfmdata, sfm::ESfMData flags_part)
 
   // TODO : handle the case where the archive wasn't correctly opened
   M44d xformMat;
-  visitObject(_objImpl->_rootEntity, xformMat, sfmdata, flags_part);
+  _objImpl->_skippedPointClouds.clear();
+  visitObject(_objImpl->_rootEntity, xformMat, sfmdata, flags_part, _objImpl->_skippedPointClouds);
 
   // TODO: fusion of common intrinsics
 }
 
+void AlembicImporter::populateStructure(sfm::SfMData &sfmdata, bool withObservations)
+{
+  const sfm::ESfMData flags_part = withObservations ? sfm::ESfMData(sfm::ESfMData::STRUCTURE | sfm::ESfMData::OBSERVATIONS) : sfm::ESfMData::STRUCTURE;
+
+  for(const IObject& pointCloud : _objImpl->_skippedPointClouds)
+    readPointCloud(pointCloud, M44d(), sfmdata, flags_part);
+
+  _objImpl->_skippedPointClouds.clear();
+}
+
+std::size_t AlembicImporter::getNbSkippedPointClouds() const
+{
+  return _objImpl->_skippedPointClouds.size();
+}
+
 } // namespace sfm
 } // namespace aliceVision
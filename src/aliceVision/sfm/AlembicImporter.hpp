@@ -8,6 +8,7 @@
 #include <aliceVision/sfm/SfMData.hpp>
 #include <aliceVision/sfm/sfmDataIO.hpp>
 
+#include <memory>
 #include <string>
 
 namespace aliceVision {
@@ -19,8 +20,28 @@ public:
   explicit AlembicImporter(const std::string &filename);
   ~AlembicImporter();
 
+  /**
+   * @brief Import the Alembic scene
+   * If the structure is not requested, the point clouds are located but not read,
+   * they can be imported later with populateStructure.
+   * @param[in,out] sfmdata The SfMData container to fill
+   * @param[in] flags_part The elements to import
+   */
   void populate(sfm::SfMData &sfmdata, sfm::ESfMData flags_part = sfm::ESfMData::ALL);
 
+  /**
+   * @brief Import the point clouds skipped by the last populate
+   * @param[in,out] sfmdata The SfMData container to fill
+   * @param[in] withObservations Import the observations of the 3D points
+   */
+  void populateStructure(sfm::SfMData &sfmdata, bool withObservations = true);
+
+  /**
+   * @brief Get the number of point clouds skipped by the last populate
+   * @return the number of point clouds not imported yet
+   */
+  std::size_t getNbSkippedPointClouds() const;
+
 private:
   
   struct DataImpl;
@@ -4,11 +4,16 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/Tracing.hpp>
 #include <aliceVision/config.hpp>
 #include <aliceVision/alicevision_omp.hpp>
 
 #include "ceres/rotation.h"
 
+#include <exception>
+#include <fstream>
+
 namespace aliceVision {
 namespace sfm {
 
@@ -133,6 +138,9 @@ void addPose(ceres::Problem& problem,
   }
 }
 
+const std::size_t BundleAdjustmentCeres::BA_options::kMaxNbPosesDenseBA;
+const std::size_t BundleAdjustmentCeres::BA_options::kMaxNbPosesSparseBA;
+
 BundleAdjustmentCeres::BA_options::BA_options(const bool bVerbose, bool bmultithreaded)
   :_bVerbose(bVerbose)
 {
@@ -151,6 +159,7 @@ BundleAdjustmentCeres::BA_options::BA_options(const bool bVerbose, bool bmultith
 void BundleAdjustmentCeres::BA_options::setDenseBA()
 {
   // Default configuration use a DENSE representation
+  _useAutomaticSolver = false;
   _preconditioner_type = ceres::JACOBI;
   _linear_solver_type = ceres::DENSE_SCHUR;
     ALICEVISION_LOG_DEBUG("BundleAdjustmentCeres: DENSE_SCHUR");
@@ -158,6 +167,7 @@ void BundleAdjustmentCeres::BA_options::setDenseBA()
 
 void BundleAdjustmentCeres::BA_options::setSparseBA()
 {
+  _useAutomaticSolver = false;
   _preconditioner_type = ceres::JACOBI;
   // If Sparse linear solver are available
   // Descending priority order by efficiency (SUITE_SPARSE > CX_SPARSE > EIGEN_SPARSE)
@@ -186,6 +196,48 @@ void BundleAdjustmentCeres::BA_options::setSparseBA()
   }
 }
 
+void BundleAdjustmentCeres::BA_options::setAutomaticBA()
+{
+  setDenseBA();
+  _useAutomaticSolver = true;
+}
+
+void BundleAdjustmentCeres::BA_options::selectLinearSolver(std::size_t nbPoses)
+{
+  const bool useAutomaticSolver = _useAutomaticSolver;
+  const bool isSparseAvailable = ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::SUITE_SPARSE) ||
+                                 ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::CX_SPARSE) ||
+                                 ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::EIGEN_SPARSE);
+
+  if(nbPoses <= kMaxNbPosesDenseBA)
+  {
+    setDenseBA();
+  }
+  else if(nbPoses <= kMaxNbPosesSparseBA && isSparseAvailable)
+  {
+    setSparseBA();
+  }
+  else
+  {
+    // The reduced camera matrix is too large to be factorized:
+    // solve it with preconditioned conjugate gradients.
+    _linear_solver_type = ceres::ITERATIVE_SCHUR;
+    if (ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::SUITE_SPARSE))
+    {
+      // the visibility based preconditioners need SuiteSparse
+      _sparse_linear_algebra_library_type = ceres::SUITE_SPARSE;
+      _preconditioner_type = ceres::CLUSTER_JACOBI;
+      ALICEVISION_LOG_DEBUG("BundleAdjustmentCeres: ITERATIVE_SCHUR, CLUSTER_JACOBI");
+    }
+    else
+    {
+      _preconditioner_type = ceres::SCHUR_JACOBI;
+      ALICEVISION_LOG_DEBUG("BundleAdjustmentCeres: ITERATIVE_SCHUR, SCHUR_JACOBI");
+    }
+  }
+  _useAutomaticSolver = useAutomaticSolver;
+}
+
 
 BundleAdjustmentCeres::BundleAdjustmentCeres(
   BundleAdjustmentCeres::BA_options options)
@@ -196,6 +248,9 @@ bool BundleAdjustmentCeres::Adjust(
   SfMData & sfm_data,     // the SfM scene to refine
   BA_Refine refineOptions)
 {
+  ALICEVISION_TRACE_SCOPE("sfm.bundleAdjustment", sfm_data.GetLandmarks().size());
+  system::Timer totalTimer;
+  _statistics = BA_statistics();
   // Ensure we are not using incompatible options:
   //  - BA_REFINE_INTRINSICS_OPTICALCENTER_ALWAYS and BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA cannot be used at the same time
   assert(!((refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_ALWAYS) && (refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA)));
@@ -210,6 +265,7 @@ bool BundleAdjustmentCeres::Adjust(
   //----------
 
   ceres::Problem problem;
+  ceres::ParameterBlockOrdering* ordering = new ceres::ParameterBlockOrdering;
 
   // Data wrapper for refinement:
   HashMap<IndexT, std::vector<double> > map_poses;
@@ -221,6 +277,7 @@ bool BundleAdjustmentCeres::Adjust(
     const Pose3& pose = itPose->second;
 
     addPose(problem, refineOptions, pose, map_poses[indexPose]);
+    ordering->AddElementToGroup(&map_poses[indexPose][0], 1);
   }
 
   // Setup rig sub-poses
@@ -239,6 +296,7 @@ bool BundleAdjustmentCeres::Adjust(
         continue;
 
       addPose(problem, refineOptions, rigSubPose.pose, map_subposes[rigId][subPoseId]);
+      ordering->AddElementToGroup(&map_subposes[rigId][subPoseId][0], 1);
     }
   }
 
@@ -280,6 +338,7 @@ bool BundleAdjustmentCeres::Adjust(
 
     double * parameter_block = &map_intrinsics[idIntrinsics][0];
     problem.AddParameterBlock(parameter_block, map_intrinsics[idIntrinsics].size());
+    ordering->AddElementToGroup(parameter_block, 1);
     if (!refineIntrinsics)
     {
       // Nothing to refine in the intrinsics,
@@ -366,53 +425,110 @@ bool BundleAdjustmentCeres::Adjust(
 
 
   // For all visibility add reprojections errors:
+  // The residual blocks are created in parallel in a pre-sized array, then added to the problem in the structure order.
+  struct ResidualBlock
+  {
+    ceres::CostFunction* costFunction = nullptr;
+    double* intrinsicBlock = nullptr;
+    double* poseBlock = nullptr;
+    double* subposeBlock = nullptr; // rig views only
+    double* landmarkBlock = nullptr;
+  };
+
+  std::vector<Landmark*> landmarks;
+  std::vector<std::size_t> firstResidualBlocks; // index of the first residual block of each landmark
+  landmarks.reserve(sfm_data.structure.size());
+  firstResidualBlocks.reserve(sfm_data.structure.size() + 1);
+  firstResidualBlocks.push_back(0);
   for(auto& landmarkIt: sfm_data.structure)
   {
-    const Observations & observations = landmarkIt.second.observations;
-    // Iterate over 2D observation associated to the 3D landmark
-    for (const auto& observationIt: observations)
-    {
-      // Build the residual block corresponding to the track observation:
-      const View * view = sfm_data.views.at(observationIt.first).get();
+    landmarks.push_back(&landmarkIt.second);
+    firstResidualBlocks.push_back(firstResidualBlocks.back() + landmarkIt.second.observations.size());
+  }
 
-      // Each Residual block takes a point and a camera as input and outputs a 2
-      // dimensional residual. Internally, the cost function stores the observed
-      // image location and compares the reprojection against the observation.
+  std::vector<ResidualBlock> residualBlocks(firstResidualBlocks.back());
+  std::exception_ptr exception;
 
-      if(view->isPartOfRig())
+  #pragma omp parallel for num_threads(_aliceVision_options._nbThreads)
+  for(int i = 0; i < landmarks.size(); ++i)
+  {
+    try
+    {
+      Landmark& landmark = *landmarks[i];
+      std::size_t r = firstResidualBlocks[i];
+      // Iterate over 2D observation associated to the 3D landmark
+      for (const auto& observationIt: landmark.observations)
       {
-        ceres::CostFunction* costFunction = createRigCostFunctionFromIntrinsics(sfm_data.intrinsics[view->getIntrinsicId()].get(), observationIt.second.x);
+        // Build the residual block corresponding to the track observation:
+        const View * view = sfm_data.views.at(observationIt.first).get();
+        IntrinsicBase * intrinsic = sfm_data.intrinsics.at(view->getIntrinsicId()).get();
+        ResidualBlock& residualBlock = residualBlocks[r++];
+
+        // Each Residual block takes a point and a camera as input and outputs a 2
+        // dimensional residual. Internally, the cost function stores the observed
+        // image location and compares the reprojection against the observation.
+        if(view->isPartOfRig())
+        {
+          residualBlock.costFunction = createRigCostFunctionFromIntrinsics(intrinsic, observationIt.second.x);
+          assert(sfm_data.getRig(*view).getSubPose(view->getSubPoseId()).status != ERigSubPoseStatus::UNINITIALIZED);
+          residualBlock.subposeBlock = &map_subposes.at(view->getRigId()).at(view->getSubPoseId())[0]; // subpose of the cameras rig
+        }
+        else
+        {
+          residualBlock.costFunction = createCostFunctionFromIntrinsics(intrinsic, observationIt.second.x);
+        }
+        residualBlock.intrinsicBlock = &map_intrinsics.at(view->getIntrinsicId())[0];
+        residualBlock.poseBlock = &map_poses.at(view->getPoseId())[0];
+        residualBlock.landmarkBlock = landmark.X.data(); //Do we need to copy 3D point to avoid false motion, if failure ?
+      }
+    }
+    catch(...)
+    {
+      #pragma omp critical(bundleAdjustmentException)
+      exception = std::current_exception();
+    }
+  }
 
-        const Rig& rig = sfm_data.getRig(*view);
-        const RigSubPose& rigSubPose = rig.getSubPose(view->getSubPoseId());
-        assert(rigSubPose.status != ERigSubPoseStatus::UNINITIALIZED);
+  if(exception)
+  {
+    for(const ResidualBlock& residualBlock : residualBlocks)
+      delete residualBlock.costFunction;
+    delete p_LossFunction;
+    delete ordering;
+    std::rethrow_exception(exception);
+  }
 
-        double* subpose_ptr = &map_subposes.at(view->getRigId()).at(view->getSubPoseId())[0];
+  for(const ResidualBlock& residualBlock : residualBlocks)
+  {
+    if(residualBlock.subposeBlock != nullptr)
+      problem.AddResidualBlock(residualBlock.costFunction, p_LossFunction,
+        residualBlock.intrinsicBlock, residualBlock.poseBlock, residualBlock.subposeBlock, residualBlock.landmarkBlock);
+    else
+      problem.AddResidualBlock(residualBlock.costFunction, p_LossFunction,
+        residualBlock.intrinsicBlock, residualBlock.poseBlock, residualBlock.landmarkBlock);
+  }
 
-        problem.AddResidualBlock(
-          costFunction,
-          p_LossFunction,
-          &map_intrinsics[view->getIntrinsicId()][0],
-          &map_poses[view->getPoseId()][0],
-          subpose_ptr, // subpose of the cameras rig
-          landmarkIt.second.X.data()); //Do we need to copy 3D point to avoid false motion, if failure ?
-      }
-      else
-      {
-        ceres::CostFunction* costFunction = createCostFunctionFromIntrinsics(sfm_data.intrinsics[view->getIntrinsicId()].get(), observationIt.second.x);
-
-        problem.AddResidualBlock(
-          costFunction,
-          p_LossFunction,
-          &map_intrinsics[view->getIntrinsicId()][0],
-          &map_poses[view->getPoseId()][0],
-          landmarkIt.second.X.data()); //Do we need to copy 3D point to avoid false motion, if failure ?
-      }
-    }
+  // The landmarks are eliminated first by the Schur complement solvers
+  for(std::size_t i = 0; i < landmarks.size(); ++i)
+  {
+    if(landmarks[i]->observations.empty())
+      continue;
+    ordering->AddElementToGroup(landmarks[i]->X.data(), 0);
     if (!(refineOptions & BA_REFINE_STRUCTURE))
-      problem.SetParameterBlockConstant(landmarkIt.second.X.data());
+      problem.SetParameterBlockConstant(landmarks[i]->X.data());
   }
 
+  _statistics._numPoses = map_poses.size();
+  for(const auto& rigIt : map_subposes)
+    _statistics._numPoses += rigIt.second.size();
+  _statistics._numIntrinsics = map_intrinsics.size();
+  _statistics._numLandmarks = landmarks.size();
+  _statistics._numResidualBlocks = residualBlocks.size();
+  _statistics._problemTime = totalTimer.elapsed();
+
+  if(_aliceVision_options._useAutomaticSolver)
+    _aliceVision_options.selectLinearSolver(_statistics._numPoses);
+
   // Configure a BA engine and run it
   //  Make Ceres automatically detect the bundle structure.
   ceres::Solver::Options options;
@@ -423,13 +539,30 @@ bool BundleAdjustmentCeres::Adjust(
   options.logging_type = ceres::SILENT;
   options.num_threads = _aliceVision_options._nbThreads;
   options.num_linear_solver_threads = _aliceVision_options._nbThreads;
+  if(ceres::IsSchurType(options.linear_solver_type))
+    options.linear_solver_ordering.reset(ordering);
+  else
+    delete ordering;
 
   // Solve BA
   ceres::Solver::Summary summary;
-  ceres::Solve(options, &problem, &summary);
+  {
+    ALICEVISION_TRACE_SCOPE("sfm.bundleAdjustment.solve", _statistics._numResidualBlocks);
+    ceres::Solve(options, &problem, &summary);
+  }
   if (_aliceVision_options._bCeres_Summary)
     ALICEVISION_LOG_DEBUG(summary.FullReport());
 
+  _statistics._linearSolverType = summary.linear_solver_type_used;
+  _statistics._preconditionerType = summary.preconditioner_type_used;
+  _statistics._preprocessorTime = summary.preprocessor_time_in_seconds;
+  _statistics._linearSolverTime = summary.linear_solver_time_in_seconds;
+  _statistics._minimizerTime = summary.minimizer_time_in_seconds;
+  _statistics._numSuccessfullIterations = summary.num_successful_steps;
+  _statistics._numUnsuccessfullIterations = summary.num_unsuccessful_steps;
+  _statistics._RMSEinitial = std::sqrt(summary.initial_cost / summary.num_residuals);
+  _statistics._RMSEfinal = std::sqrt(summary.final_cost / summary.num_residuals);
+
   // If no error, get back refined parameters
   if (!summary.IsSolutionUsable())
   {
@@ -451,6 +584,9 @@ bool BundleAdjustmentCeres::Adjust(
       " Initial RMSE: " << std::sqrt( summary.initial_cost / summary.num_residuals) << "\n"
       " Final RMSE: " << std::sqrt( summary.final_cost / summary.num_residuals) << "\n"
       " Time (s): " << summary.total_time_in_seconds << "\n"
+      " Problem construction time (s): " << _statistics._problemTime << "\n"
+      " Linear solver: " << ceres::LinearSolverTypeToString(summary.linear_solver_type_used)
+                         << ", " << ceres::PreconditionerTypeToString(summary.preconditioner_type_used) << "\n"
       );
   }
 
@@ -496,9 +632,54 @@ bool BundleAdjustmentCeres::Adjust(
       sfm_data.intrinsics[intrinsicsV.first]->updateFromParams(intrinsicsV.second);
     }
   }
+  _statistics._totalTime = totalTimer.elapsed();
   return true;
 }
 
+bool BundleAdjustmentCeres::exportStatistics(const std::string& filename) const
+{
+  std::ofstream os;
+  os.open(filename, std::ios::app);
+  if (!os.is_open())
+  {
+    ALICEVISION_LOG_DEBUG("Unable to open the Bundle adjustment stat file '" << filename << "'.");
+    return false;
+  }
+  os.seekp(0, std::ios::end); //put the cursor at the end
+
+  if (os.tellp() == 0) // 'tellp' return the cursor's position
+  {
+    // If the file does't exist: add a header.
+    const std::vector<std::string> header = {
+      "Poses", "Intrinsics", "Landmarks", "ResidualBlocks",
+      "LinearSolver", "Preconditioner",
+      "Problem(s)", "Preprocessor(s)", "LinearSolver(s)", "Minimizer(s)", "Total(s)",
+      "SuccessIter", "BadIter", "InitRMSE", "FinalRMSE"};
+
+    for (const std::string& head : header)
+      os << head << "\t";
+    os << "\n";
+  }
+
+  os << _statistics._numPoses << "\t"
+     << _statistics._numIntrinsics << "\t"
+     << _statistics._numLandmarks << "\t"
+     << _statistics._numResidualBlocks << "\t"
+     << ceres::LinearSolverTypeToString(_statistics._linearSolverType) << "\t"
+     << ceres::PreconditionerTypeToString(_statistics._preconditionerType) << "\t"
+     << _statistics._problemTime << "\t"
+     << _statistics._preprocessorTime << "\t"
+     << _statistics._linearSolverTime << "\t"
+     << _statistics._minimizerTime << "\t"
+     << _statistics._totalTime << "\t"
+     << _statistics._numSuccessfullIterations << "\t"
+     << _statistics._numUnsuccessfullIterations << "\t"
+     << _statistics._RMSEinitial << "\t"
+     << _statistics._RMSEfinal << "\n";
+
+  return os.good();
+}
+
 } // namespace sfm
 } // namespace aliceVision
 
@@ -28,13 +28,60 @@ class BundleAdjustmentCeres : public BundleAdjustment
     ceres::LinearSolverType _linear_solver_type;
     ceres::PreconditionerType _preconditioner_type;
     ceres::SparseLinearAlgebraLibraryType _sparse_linear_algebra_library_type;
+    /// select the linear solver from the problem size in Adjust
+    bool _useAutomaticSolver;
 
     BA_options(const bool bVerbose = true, bool bmultithreaded = true);
     void setDenseBA();
     void setSparseBA();
+
+    /**
+     * @brief Select the linear solver and the preconditioner from the size of each problem.
+     * @see selectLinearSolver
+     */
+    void setAutomaticBA();
+
+    /**
+     * @brief Select the linear solver and the preconditioner from the number of poses:
+     * - DENSE_SCHUR up to kMaxNbPosesDenseBA poses
+     * - SPARSE_SCHUR up to kMaxNbPosesSparseBA poses, if a sparse library is available
+     * - ITERATIVE_SCHUR otherwise, with the CLUSTER_JACOBI preconditioner if SuiteSparse
+     *   is available and SCHUR_JACOBI otherwise
+     * @param[in] nbPoses The number of poses of the problem
+     */
+    void selectLinearSolver(std::size_t nbPoses);
+
+    static const std::size_t kMaxNbPosesDenseBA = 100;
+    static const std::size_t kMaxNbPosesSparseBA = 1000;
   };
+
+  /// Contains the sizes and timings of the last BA performed.
+  struct BA_statistics
+  {
+    std::size_t _numPoses = 0;                  ///< The num. of poses & rig sub-poses
+    std::size_t _numIntrinsics = 0;             ///< The num. of intrinsics
+    std::size_t _numLandmarks = 0;              ///< The num. of landmarks
+    std::size_t _numResidualBlocks = 0;         ///< The num. of residual blocks
+
+    ceres::LinearSolverType _linearSolverType = ceres::DENSE_SCHUR;   ///< The linear solver used by Ceres
+    ceres::PreconditionerType _preconditionerType = ceres::JACOBI;    ///< The preconditioner used by Ceres
+
+    double _problemTime = 0.0;                  ///< The time spent to build the Ceres problem (s)
+    double _preprocessorTime = 0.0;             ///< The time spent by the Ceres preprocessor (s)
+    double _linearSolverTime = 0.0;             ///< The time spent in the linear solver (s)
+    double _minimizerTime = 0.0;                ///< The time spent in the minimizer (s)
+    double _totalTime = 0.0;                    ///< The time spent in Adjust (s)
+
+    std::size_t _numSuccessfullIterations = 0;  ///< The number of successful iterations
+    std::size_t _numUnsuccessfullIterations = 0;///< The number of unsuccessful iterations
+
+    double _RMSEinitial = 0.0;                  ///< sqrt(initial_cost / num_residuals)
+    double _RMSEfinal = 0.0;                    ///< sqrt(final_cost / num_residuals)
+  };
+
   private:
     BA_options _aliceVision_options;
+    BA_statistics _statistics;
 
   public:
   BundleAdjustmentCeres(BundleAdjustmentCeres::BA_options options = BA_options());
@@ -45,6 +92,16 @@ class BundleAdjustmentCeres : public BundleAdjustment
   bool Adjust(
     SfMData & sfm_data,
     BA_Refine refineOptions = BA_REFINE_ALL);
+
+  /// Return the statistics of the last BA performed
+  const BA_statistics& getStatistics() const {return _statistics;}
+
+  /**
+   * @brief Append the statistics of the last BA performed to a tab-separated file.
+   * @param[in] filename The statistics file, a header is written if the file is empty
+   * @return true if the statistics have been written
+   */
+  bool exportStatistics(const std::string& filename) const;
 };
 
 } // namespace sfm
@@ -8,11 +8,17 @@
 #include <aliceVision/stl/mapUtils.hpp>
 #include <aliceVision/types.hpp>
 #include <aliceVision/geometry/HalfPlane.hpp>
+#include <aliceVision/geometry/AABBTree.hpp>
+#include <aliceVision/system/Logger.hpp>
 #include <aliceVision/config.hpp>
 
 #include <boost/progress.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <initializer_list>
 
 namespace aliceVision {
 namespace sfm {
@@ -70,49 +76,105 @@ void FrustumFilter::initFrustum(const SfMData & sfm_data)
 PairSet FrustumFilter::getFrustumIntersectionPairs() const
 {
   PairSet pairs;
-  // List active view Id
+  streamFrustumIntersectionPairs([&pairs](const PairVec& chunkPairs)
+  {
+    // chunks are sorted: insert at the end of the set
+    for(const Pair& pair : chunkPairs)
+      pairs.emplace_hint(pairs.end(), pair);
+  });
+  return pairs;
+}
+
+void FrustumFilter::streamFrustumIntersectionPairs(const std::function<void(const PairVec&)>& callback,
+                                                   std::size_t chunkSize) const
+{
+  // List active view Id, sorted to output (I < J) pairs
   std::vector<IndexT> viewIds;
-  viewIds.reserve(z_near_z_far_perView.size());
-  std::transform(z_near_z_far_perView.begin(), z_near_z_far_perView.end(),
+  viewIds.reserve(frustum_perView.size());
+  std::transform(frustum_perView.begin(), frustum_perView.end(),
     std::back_inserter(viewIds), stl::RetrieveKey());
+  std::sort(viewIds.begin(), viewIds.end());
+
+  const std::size_t nbViews = viewIds.size();
+  chunkSize = std::max(chunkSize, std::size_t(1));
 
-  boost::progress_display my_progress_bar(
-    viewIds.size() * (viewIds.size()-1)/2,
-    std::cout, "\nCompute frustum intersection\n");
+  // Bounding volume hierarchy over the frustums bounding boxes
+  std::vector<const Frustum*> frustums(nbViews);
+  std::vector<AABB> boxes(nbViews);
 
-  // Exhaustive comparison (use the fact that the intersect function is symmetric)
   #pragma omp parallel for
-  for (int i = 0; i < (int)viewIds.size(); ++i)
+  for(int i = 0; i < (int)nbViews; ++i)
+  {
+    frustums[i] = &frustum_perView.at(viewIds[i]);
+    frustums[i]->bounds(boxes[i].min, boxes[i].max);
+  }
+
+  const AABBTree tree(boxes);
+
+  boost::progress_display my_progress_bar(nbViews, std::cout, "\nCompute frustum intersection\n");
+
+  std::size_t nbIntersectionTests = 0;
+  std::size_t nbPairs = 0;
+  std::vector<PairVec> pairsPerView(std::min(chunkSize, nbViews));
+  PairVec chunkPairs;
+
+  for(std::size_t chunkBegin = 0; chunkBegin < nbViews; chunkBegin += chunkSize)
   {
-    for (size_t j = i+1; j < viewIds.size(); ++j)
+    const std::size_t chunkEnd = std::min(chunkBegin + chunkSize, nbViews);
+
+    #pragma omp parallel
     {
-      if (frustum_perView.at(viewIds[i]).intersect(frustum_perView.at(viewIds[j])))
+      std::vector<IndexT> candidates;
+
+      #pragma omp for schedule(dynamic) reduction(+:nbIntersectionTests)
+      for(int i = (int)chunkBegin; i < (int)chunkEnd; ++i)
       {
-        #pragma omp critical
+        PairVec& viewPairs = pairsPerView[i - chunkBegin];
+        viewPairs.clear();
+
+        candidates.clear();
+        tree.query(boxes[i], candidates);
+        std::sort(candidates.begin(), candidates.end());
+
+        // the intersect function is symmetric: only test the next views
+        for(const IndexT j : candidates)
         {
-          pairs.insert(std::make_pair(viewIds[i], viewIds[j]));
+          if(j <= (IndexT)i)
+            continue;
+          ++nbIntersectionTests;
+          if(frustums[i]->intersect(*frustums[j]))
+            viewPairs.emplace_back(viewIds[i], viewIds[j]);
         }
       }
-      // Progress bar update
-      #pragma omp critical
-      {
-        ++my_progress_bar;
-      }
     }
+
+    chunkPairs.clear();
+    for(std::size_t i = chunkBegin; i < chunkEnd; ++i)
+      chunkPairs.insert(chunkPairs.end(), pairsPerView[i - chunkBegin].begin(), pairsPerView[i - chunkBegin].end());
+    nbPairs += chunkPairs.size();
+
+    callback(chunkPairs);
+    my_progress_bar += chunkEnd - chunkBegin;
   }
-  return pairs;
+
+  ALICEVISION_LOG_INFO("Frustum intersection:" << std::endl
+    << "\t- # views: " << nbViews << std::endl
+    << "\t- # exact intersection tests: " << nbIntersectionTests
+    << " / " << nbViews * (nbViews - std::min(nbViews, std::size_t(1))) / 2 << " pairs" << std::endl
+    << "\t- # intersecting pairs: " << nbPairs);
 }
 
 // Export defined frustum in PLY file for viewing
 bool FrustumFilter::export_Ply(const std::string & filename) const
 {
-  std::ofstream of(filename.c_str());
+  std::ofstream of(filename.c_str(), std::ios::binary);
   if (!of.is_open())
     return false;
   // Vertex count evaluation
   // Faces count evaluation
   size_t vertex_count = 0;
   size_t face_count = 0;
+  size_t face_indices_count = 0;
   for (FrustumsT::const_iterator it = frustum_perView.begin();
     it != frustum_perView.end(); ++it)
   {
@@ -120,16 +182,18 @@ bool FrustumFilter::export_Ply(const std::string & filename) const
     {
       vertex_count += 5;
       face_count += 5; // 4 triangles + 1 quad
+      face_indices_count += 4 * 3 + 4;
     }
     else // truncated
     {
       vertex_count += 8;
       face_count += 6; // 6 quads
+      face_indices_count += 6 * 4;
     }
   }
 
   of << "ply" << '\n'
-    << "format ascii 1.0" << '\n'
+    << "format binary_little_endian 1.0" << '\n'
     << "element vertex " << vertex_count << '\n'
     << "property float x" << '\n'
     << "property float y" << '\n'
@@ -138,40 +202,66 @@ bool FrustumFilter::export_Ply(const std::string & filename) const
     << "property list uchar int vertex_index" << '\n'
     << "end_header" << '\n';
 
+  // Encode the vertices and the faces in a single buffer
+  std::vector<char> buffer;
+  buffer.reserve(vertex_count * 3 * sizeof(float) + face_count + face_indices_count * sizeof(std::int32_t));
+
+  const auto pushLittleEndian = [&buffer](std::uint32_t bits, std::size_t size)
+  {
+    for (std::size_t i = 0; i < size; ++i)
+      buffer.push_back(static_cast<char>((bits >> (8 * i)) & 0xFF));
+  };
+
   // Export frustums points
   for (FrustumsT::const_iterator it = frustum_perView.begin();
     it != frustum_perView.end(); ++it)
   {
     const std::vector<Vec3> & points = it->second.frustum_points();
     for (int i=0; i < points.size(); ++i)
-      of << points[i].transpose() << '\n';
+    {
+      for (int j = 0; j < 3; ++j)
+      {
+        const float value = static_cast<float>(points[i](j));
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        pushLittleEndian(bits, sizeof(bits));
+      }
+    }
   }
 
   // Export frustums faces
   IndexT count = 0;
+  const auto pushFace = [&](std::initializer_list<IndexT> indices)
+  {
+    pushLittleEndian(indices.size(), 1);
+    for (const IndexT index : indices)
+      pushLittleEndian(count + index, sizeof(std::int32_t));
+  };
+
   for (FrustumsT::const_iterator it = frustum_perView.begin();
     it != frustum_perView.end(); ++it)
   {
     if (it->second.isInfinite()) // infinite frustum: drawn normalized cone: 4 faces
     {
-      of << "3 " << count + 0 << ' ' << count + 1 << ' ' << count + 2 << '\n'
-        << "3 " << count + 0 << ' ' << count + 2 << ' ' << count + 3 << '\n'
-        << "3 " << count + 0 << ' ' << count + 3 << ' ' << count + 4 << '\n'
-        << "3 " << count + 0 << ' ' << count + 4 << ' ' << count + 1 << '\n'
-        << "4 " << count + 1 << ' ' << count + 2 << ' ' << count + 3 << ' ' << count + 4 << '\n';
+      pushFace({0, 1, 2});
+      pushFace({0, 2, 3});
+      pushFace({0, 3, 4});
+      pushFace({0, 4, 1});
+      pushFace({1, 2, 3, 4});
       count += 5;
     }
     else // truncated frustum: 6 faces
     {
-      of << "4 " << count + 0 << ' ' << count + 1 << ' ' << count + 2 << ' ' << count + 3 << '\n'
-        << "4 " << count + 0 << ' ' << count + 1 << ' ' << count + 5 << ' ' << count + 4 << '\n'
-        << "4 " << count + 1 << ' ' << count + 5 << ' ' << count + 6 << ' ' << count + 2 << '\n'
-        << "4 " << count + 3 << ' ' << count + 7 << ' ' << count + 6 << ' ' << count + 2 << '\n'
-        << "4 " << count + 0 << ' ' << count + 4 << ' ' << count + 7 << ' ' << count + 3 << '\n'
-        << "4 " << count + 4 << ' ' << count + 5 << ' ' << count + 6 << ' ' << count + 7 << '\n';
+      pushFace({0, 1, 2, 3});
+      pushFace({0, 1, 5, 4});
+      pushFace({1, 5, 6, 2});
+      pushFace({3, 7, 6, 2});
+      pushFace({0, 4, 7, 3});
+      pushFace({4, 5, 6, 7});
       count += 8;
     }
   }
+  of.write(buffer.data(), buffer.size());
   of.flush();
   bool bOk = of.good();
   of.close();
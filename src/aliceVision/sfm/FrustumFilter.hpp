@@ -8,6 +8,8 @@
 #include "aliceVision/types.hpp"
 #include "aliceVision/geometry/Frustum.hpp"
 
+#include <functional>
+
 namespace aliceVision {
 namespace sfm {
 
@@ -29,6 +31,17 @@ public:
   // Return intersecting View frustum pairs
   PairSet getFrustumIntersectionPairs() const;
 
+  /**
+   * @brief Compute the intersecting View frustum pairs without keeping them in memory.
+   * The candidate pairs are selected with a bounding volume hierarchy over the frustums bounding boxes,
+   * then checked with the exact frustum intersection.
+   * @param[in] callback Called with the sorted pairs (I < J) of each chunk, in ascending order,
+   *            all the pairs of a view I are in the same chunk
+   * @param[in] chunkSize Number of views I processed in parallel for each chunk
+   */
+  void streamFrustumIntersectionPairs(const std::function<void(const PairVec&)>& callback,
+                                      std::size_t chunkSize = 1024) const;
+
   // Export defined frustum in PLY file for viewing
   bool export_Ply(const std::string & filename) const;
 
@@ -0,0 +1,115 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/sfm/FrustumFilter.hpp"
+#include "aliceVision/sfm/SfMData.hpp"
+#include "aliceVision/camera/Pinhole.hpp"
+#include "aliceVision/geometry/Frustum.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE FrustumFilter
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::sfm;
+
+static const int width = 1000;
+static const int height = 800;
+
+/**
+ * @brief Create views with random orientations and centers, some of them without pose.
+ */
+void createRandomScene(std::size_t nbViews, unsigned int seed, SfMData& sfmData)
+{
+  std::mt19937 generator(seed);
+  std::normal_distribution<double> normal;
+  std::uniform_real_distribution<double> position(-10.0, 10.0);
+  std::uniform_real_distribution<double> focal(400.0, 1500.0);
+
+  for(IndexT viewId = 0; viewId < nbViews; ++viewId)
+  {
+    // sparse view ids
+    const IndexT id = 3 * viewId + 1;
+    sfmData.intrinsics.emplace(id, std::make_shared<camera::Pinhole>(width, height, focal(generator), width / 2.0, height / 2.0));
+    sfmData.views.emplace(id, std::make_shared<View>("", id, id, id, width, height));
+    if(viewId % 10 == 9)
+      continue;
+
+    const Mat3 R = Eigen::Quaterniond(normal(generator), normal(generator), normal(generator), normal(generator)).normalized().toRotationMatrix();
+    const Vec3 C(position(generator), position(generator), position(generator));
+    sfmData.setPose(*sfmData.views.at(id), geometry::Pose3(R, C));
+  }
+}
+
+/**
+ * @brief Test all the pairs of posed views with the exact frustum intersection.
+ */
+PairSet computeExhaustivePairs(const SfMData& sfmData, double zNear, double zFar)
+{
+  std::vector<std::pair<IndexT, geometry::Frustum>> frustums;
+  for(const auto& viewPair : sfmData.GetViews())
+  {
+    const View& view = *viewPair.second;
+    if(!sfmData.IsPoseAndIntrinsicDefined(&view))
+      continue;
+    const camera::Pinhole* cam = dynamic_cast<const camera::Pinhole*>(sfmData.GetIntrinsicPtr(view.getIntrinsicId()));
+    const geometry::Pose3 pose = sfmData.getPose(view);
+    if(zNear == -1.)
+      frustums.emplace_back(view.getViewId(), geometry::Frustum(cam->w(), cam->h(), cam->K(), pose.rotation(), pose.center()));
+    else
+      frustums.emplace_back(view.getViewId(), geometry::Frustum(cam->w(), cam->h(), cam->K(), pose.rotation(), pose.center(), zNear, zFar));
+  }
+
+  PairSet pairs;
+  for(std::size_t i = 0; i < frustums.size(); ++i)
+    for(std::size_t j = i + 1; j < frustums.size(); ++j)
+      if(frustums[i].second.intersect(frustums[j].second))
+        pairs.emplace(std::min(frustums[i].first, frustums[j].first), std::max(frustums[i].first, frustums[j].first));
+  return pairs;
+}
+
+BOOST_AUTO_TEST_CASE(FrustumFilter_pairsEqualExhaustivePairs)
+{
+  const std::size_t nbViews = 40;
+
+  // infinite frustums, then truncated frustums overlapping or not
+  for(const std::pair<double, double>& nearFar : {std::make_pair(-1., -1.), std::make_pair(0.1, 4.0), std::make_pair(0.5, 12.0)})
+  {
+    for(unsigned int seed = 0; seed < 3; ++seed)
+    {
+      SfMData sfmData;
+      createRandomScene(nbViews, seed, sfmData);
+
+      const PairSet expectedPairs = computeExhaustivePairs(sfmData, nearFar.first, nearFar.second);
+      BOOST_CHECK(!expectedPairs.empty());
+
+      const FrustumFilter frustumFilter(sfmData, nearFar.first, nearFar.second);
+      const PairSet pairs = frustumFilter.getFrustumIntersectionPairs();
+      BOOST_CHECK(pairs == expectedPairs);
+
+      // the streamed pairs are the same, sorted and grouped by view I whatever the chunk size
+      for(const std::size_t chunkSize : {std::size_t(1), std::size_t(7), std::size_t(1000)})
+      {
+        PairVec streamedPairs;
+        bool isValidChunk = true;
+        frustumFilter.streamFrustumIntersectionPairs([&](const PairVec& chunkPairs)
+        {
+          if(!chunkPairs.empty() && !streamedPairs.empty() && chunkPairs.front().first <= streamedPairs.back().first)
+            isValidChunk = false;
+          streamedPairs.insert(streamedPairs.end(), chunkPairs.begin(), chunkPairs.end());
+        }, chunkSize);
+
+        BOOST_CHECK(isValidChunk);
+        BOOST_CHECK(std::is_sorted(streamedPairs.begin(), streamedPairs.end()));
+        BOOST_CHECK(PairSet(streamedPairs.begin(), streamedPairs.end()) == expectedPairs);
+        BOOST_CHECK_EQUAL(streamedPairs.size(), expectedPairs.size());
+      }
+    }
+  }
+}
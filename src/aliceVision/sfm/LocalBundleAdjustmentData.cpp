@@ -5,7 +5,6 @@
 
 #include "LocalBundleAdjustmentData.hpp"
 #include "aliceVision/stl/stl.hpp"
-#include "lemon/bfs.h"
 
 #include <fstream>
 
@@ -14,14 +13,14 @@ namespace sfm {
 
 LocalBundleAdjustmentData::LocalBundleAdjustmentData(const SfMData& sfm_data)
 {
+  resetParametersCounter();
+
   for (const auto& it : sfm_data.intrinsics)
   {
     _focalLengthsHistory[it.first];
     _focalLengthsHistory.at(it.first).push_back(std::make_pair(0, sfm_data.GetIntrinsicPtr(it.first)->getParams().at(0)));
     _mapFocalIsConstant[it.first];
     _mapFocalIsConstant.at(it.first) = false; 
-    
-    resetParametersCounter();
   }
 }
 
@@ -29,12 +28,10 @@ std::map<int, std::size_t> LocalBundleAdjustmentData::getDistancesHistogram() co
 {
   std::map<int, std::size_t> hist;
   
-  for (const auto& x : _mapDistancePerViewId)
+  for (std::size_t node = 0; node < _viewIdPerNode.size(); ++node)
   {
-    if (hist.find(x.second) == hist.end())
-      hist[x.second] = 1;
-    else
-      hist.at(x.second)++;
+    if (_viewIdPerNode[node] != UndefinedIndexT)
+      ++hist[_distancePerNode[node]];
   }
   
   return hist;
@@ -42,31 +39,27 @@ std::map<int, std::size_t> LocalBundleAdjustmentData::getDistancesHistogram() co
 
 void LocalBundleAdjustmentData::setAllParametersToRefine(const SfMData& sfm_data)
 {
-  _mapDistancePerViewId.clear();
-  _mapDistancePerPoseId.clear();
-  _mapLBAStatePerPoseId.clear();
+  resetGraphDistances();
   _mapLBAStatePerIntrinsicId.clear();
-  _mapLBAStatePerLandmarkId.clear();
   resetParametersCounter();
   
   // -- Poses
   for (Poses::const_iterator itPose = sfm_data.GetPoses().begin(); itPose != sfm_data.GetPoses().end(); ++itPose)
   {
-    _mapLBAStatePerPoseId[itPose->first] = EState::refined;
-    _parametersCounter.at(std::make_pair(EParameter::pose, EState::refined))++;
+    _statePerPose[getPoseIndex(itPose->first)] = EState::refined;
+    _parametersCounter[EParameter::pose][EState::refined]++;
   }
   // -- Instrinsics
   for(const auto& itIntrinsic: sfm_data.GetIntrinsics())
   {
     _mapLBAStatePerIntrinsicId[itIntrinsic.first] = EState::refined;
-    _parametersCounter.at(std::make_pair(EParameter::intrinsic, EState::refined))++;
+    _parametersCounter[EParameter::intrinsic][EState::refined]++;
   }
   // -- Landmarks
+  _statePerLandmark.clear();
   for(const auto& itLandmark: sfm_data.structure)
-  {
-    _mapLBAStatePerLandmarkId[itLandmark.first] = EState::refined;
-    _parametersCounter.at(std::make_pair(EParameter::landmark, EState::refined))++;
-  }
+    _statePerLandmark[itLandmark.first] = EState::refined;
+  _parametersCounter[EParameter::landmark][EState::refined] = sfm_data.structure.size();
 }
 
 void LocalBundleAdjustmentData::saveFocallengthsToHistory(const SfMData& sfm_data)
@@ -149,12 +142,24 @@ bool LocalBundleAdjustmentData::removeViewsToTheGraph(const std::set<IndexT>& re
   std::size_t numRemovedNode = 0;
   for (const IndexT& viewId : removedViewsId)
   {
-    auto it = _mapNodePerViewId.find(viewId);
-    if (it != _mapNodePerViewId.end())
+    auto it = _nodePerViewId.find(viewId);
+    if (it != _nodePerViewId.end())
     {
-      _graph.erase(it->second); // this function erase a node with its incident arcs
-      _mapNodePerViewId.erase(it->first);
-      _mapViewIdPerNode.erase(it->second);
+      // erase the node with its incident edges
+      const std::size_t node = it->second;
+      for (const std::size_t adjacentNode : _adjacencyPerNode[node])
+      {
+        std::vector<std::size_t>& adjacency = _adjacencyPerNode[adjacentNode];
+        adjacency.erase(std::find(adjacency.begin(), adjacency.end(), node));
+        _intrinsicEdges.erase(std::make_pair(std::min(node, adjacentNode), std::max(node, adjacentNode)));
+      }
+      _nbEdges -= _adjacencyPerNode[node].size();
+      _adjacencyPerNode[node].clear();
+      _adjacencyPerNode[node].shrink_to_fit();
+      _viewIdPerNode[node] = UndefinedIndexT;
+      _distancePerNode[node] = -1;
+      _nodePerViewId.erase(it);
+      --_nbNodes;
 
       numRemovedNode++;
       ALICEVISION_LOG_DEBUG("The view #" << viewId << " has been successfully removed to the distance graph.");
@@ -168,36 +173,65 @@ bool LocalBundleAdjustmentData::removeViewsToTheGraph(const std::set<IndexT>& re
 
 int LocalBundleAdjustmentData::getPoseDistance(const IndexT poseId) const
 {
-  if (_mapDistancePerPoseId.find(poseId) == _mapDistancePerPoseId.end())
+  const auto it = _poseIndexes.find(poseId);
+  if (it == _poseIndexes.end())
   {
-    ALICEVISION_LOG_DEBUG("The pose #" << poseId << " does not exist in the '_mapDistancePerPoseId' (map size: " << _mapDistancePerPoseId.size() << ") \n");
+    ALICEVISION_LOG_DEBUG("The pose #" << poseId << " does not exist in the graph (num. of poses: " << _poseIndexes.size() << ") \n");
     return -1;
   }
-  return _mapDistancePerPoseId.at(poseId);
+  return _distancePerPose[it->second];
 }
 
 int LocalBundleAdjustmentData::getViewDistance(const IndexT viewId) const
 {
-  if (_mapDistancePerViewId.find(viewId) == _mapDistancePerViewId.end())
+  const auto it = _nodePerViewId.find(viewId);
+  if (it == _nodePerViewId.end())
   {
-    ALICEVISION_LOG_DEBUG("Cannot get the graph-distance of the view #" << viewId << ": does not exist in the '_mapDistancePerViewId':\n");
+    ALICEVISION_LOG_DEBUG("Cannot get the graph-distance of the view #" << viewId << ": does not exist in the graph.\n");
     return -1;
   }
-  return _mapDistancePerViewId.at(viewId);
+  return _distancePerNode[it->second];
 }
 
 void LocalBundleAdjustmentData::resetParametersCounter()
 {
-  _parametersCounter.clear();
-  _parametersCounter[std::make_pair(EParameter::pose, EState::refined)] = 0;
-  _parametersCounter[std::make_pair(EParameter::pose, EState::constant)] = 0;
-  _parametersCounter[std::make_pair(EParameter::pose, EState::ignored)] = 0;
-  _parametersCounter[std::make_pair(EParameter::intrinsic, EState::refined)] = 0;
-  _parametersCounter[std::make_pair(EParameter::intrinsic, EState::constant)] = 0;
-  _parametersCounter[std::make_pair(EParameter::intrinsic, EState::ignored)] = 0;
-  _parametersCounter[std::make_pair(EParameter::landmark, EState::refined)] = 0;
-  _parametersCounter[std::make_pair(EParameter::landmark, EState::constant)] = 0;
-  _parametersCounter[std::make_pair(EParameter::landmark, EState::ignored)] = 0;
+  for (auto& counters : _parametersCounter)
+    counters.fill(0);
+}
+
+std::size_t LocalBundleAdjustmentData::getPoseIndex(const IndexT poseId)
+{
+  const auto it = _poseIndexes.find(poseId);
+  if (it != _poseIndexes.end())
+    return it->second;
+
+  const std::size_t poseIndex = _poseIndexes.size();
+  _poseIndexes[poseId] = poseIndex;
+  _distancePerPose.push_back(-1);
+  _statePerPose.push_back(EState::ignored);
+  return poseIndex;
+}
+
+bool LocalBundleAdjustmentData::addEdge(const std::size_t nodeA, const std::size_t nodeB)
+{
+  std::vector<std::size_t>& adjacencyA = _adjacencyPerNode[nodeA];
+  if (nodeA == nodeB || std::find(adjacencyA.begin(), adjacencyA.end(), nodeB) != adjacencyA.end())
+    return false;
+
+  adjacencyA.push_back(nodeB);
+  _adjacencyPerNode[nodeB].push_back(nodeA);
+  ++_nbEdges;
+  return true;
+}
+
+void LocalBundleAdjustmentData::resetGraphDistances()
+{
+  for (const std::size_t node : _reachedNodes)
+    _distancePerNode[node] = -1;
+  for (const std::size_t poseIndex : _reachedPoses)
+    _distancePerPose[poseIndex] = -1;
+  _reachedNodes.clear();
+  _reachedPoses.clear();
 }
 
 void LocalBundleAdjustmentData::updateGraphWithNewViews(
@@ -219,7 +253,7 @@ void LocalBundleAdjustmentData::updateGraphWithNewViews(
   // Identify the views we need to add to the graph:
   std::set<IndexT> addedViewsId;
   
-  if (_graph.maxNodeId() + 1 == 0) // the graph is empty: add all the poses of the scene 
+  if (_nbNodes == 0) // the graph is empty (or all its views were removed): add all the poses of the scene
   {
     ALICEVISION_LOG_DEBUG("|- The graph is empty: initial pair & new view(s) added.");
     for (const auto & x : sfm_data.GetViews())
@@ -239,7 +273,7 @@ void LocalBundleAdjustmentData::updateGraphWithNewViews(
   {
     // Check if the node does not already exist in the graph
     // It happens when multiple local BA are run successively, with no new reconstructed views.
-    if (_mapNodePerViewId.find(viewId) != _mapNodePerViewId.end())
+    if (_nodePerViewId.find(viewId) != _nodePerViewId.end())
     {
       ALICEVISION_LOG_DEBUG("Cannot add the view #" << viewId << " to the graph: already exists in the graph.");
       continue;
@@ -252,16 +286,20 @@ void LocalBundleAdjustmentData::updateGraphWithNewViews(
       continue;
     }
      
-    lemon::ListGraph::Node newNode = _graph.addNode();
-    _mapNodePerViewId[viewId] = newNode;  
-    _mapViewIdPerNode[newNode] = viewId;
+    const std::size_t newNode = _viewIdPerNode.size();
+    _nodePerViewId[viewId] = newNode;
+    _viewIdPerNode.push_back(viewId);
+    _poseIndexPerNode.push_back(getPoseIndex(sfm_data.GetViews().at(viewId)->getPoseId()));
+    _adjacencyPerNode.emplace_back();
+    _distancePerNode.push_back(-1);
+    ++_nbNodes;
     ++nbAddedNodes;
   }
   
   // Check consistency between the map/graph & the scene   
-  if (_mapNodePerViewId.size() != sfm_data.GetPoses().size())
+  if (_nbNodes != sfm_data.GetPoses().size())
     ALICEVISION_LOG_WARNING("The number of poses in the map (summarizing the graph content) "
-                            "and in the scene is different (" << _mapNodePerViewId.size() << " vs. " << sfm_data.GetPoses().size() << ")");
+                            "and in the scene is different (" << _nbNodes << " vs. " << sfm_data.GetPoses().size() << ")");
 
   // -------------------------- 
   // -- Add edges to the graph
@@ -274,76 +312,74 @@ void LocalBundleAdjustmentData::updateGraphWithNewViews(
     
     for(const auto& x: nbSharedLandmarksPerImagesPair)
     {
-      if(x.second > kMinNbOfMatches) // ensure a minimum number of landmarks in common to consider the link
-      {
-        _graph.addEdge(_mapNodePerViewId.at(x.first.first), _mapNodePerViewId.at(x.first.second));
+      // ensure a minimum number of landmarks in common to consider the link
+      if(x.second > kMinNbOfMatches && addEdge(_nodePerViewId.at(x.first.first), _nodePerViewId.at(x.first.second)))
         numAddedEdges++;
-      }
     }
   }
   
   ALICEVISION_LOG_DEBUG("|- The distances graph has been completed with " << nbAddedNodes<< " nodes & " << numAddedEdges << " edges.");
-  ALICEVISION_LOG_DEBUG("|- It contains " << _graph.maxNodeId() + 1 << " nodes & " << _graph.maxEdgeId() + 1 << " edges");                   
+  ALICEVISION_LOG_DEBUG("|- It contains " << _nbNodes << " nodes & " << _nbEdges << " edges");                   
 }
 
 void LocalBundleAdjustmentData::computeGraphDistances(const SfMData& sfm_data, const std::set<IndexT>& newReconstructedViews)
 { 
   ALICEVISION_LOG_DEBUG("Computing graph-distances...");
-  // reset the maps
-  _mapDistancePerViewId.clear();
-  _mapDistancePerPoseId.clear();
-  
-  // -- Setup Breadth First Search using Lemon
-  lemon::Bfs<lemon::ListGraph> bfs(_graph);
-  bfs.init();
-  
-  // -- Add source views for the bfs visit of the _graph
+  // reset the distances of the previous BFS only
+  resetGraphDistances();
+
+  // -- Add source views for the bfs visit of the graph
   for(const IndexT viewId: newReconstructedViews)
   {
-    auto it = _mapNodePerViewId.find(viewId);
-    if (it == _mapNodePerViewId.end())
+    auto it = _nodePerViewId.find(viewId);
+    if (it == _nodePerViewId.end())
       ALICEVISION_LOG_WARNING("The reconstructed view #" << viewId << " cannot be added as source for the BFS: does not exist in the graph.");
-    else
-      bfs.addSource(it->second);
+    else if (_distancePerNode[it->second] != 0)
+    {
+      _distancePerNode[it->second] = 0;
+      _reachedNodes.push_back(it->second);
+    }
   }
-  bfs.start();
-  
-  // -- Handle bfs results (distances)
-  for(const auto& x : _mapNodePerViewId) // each node in the graph
+
+  // -- Breadth First Search, up to the distance D+1: the farther views are ignored by the Local BA
+  const int maxDistance = static_cast<int>(_graphDistanceLimit) + 1;
+  for(std::size_t i = 0; i < _reachedNodes.size(); ++i) // _reachedNodes is the BFS queue
   {
-    auto& node = x.second;
-    int d = -1; 
-    
-    if (bfs.reached(node))
+    const std::size_t node = _reachedNodes[i];
+    const int d = _distancePerNode[node];
+    if (d >= maxDistance)
+      continue;
+
+    for(const std::size_t adjacentNode : _adjacencyPerNode[node])
     {
-      d = bfs.dist(node);
-      // dist(): "If node v is not reached from the root(s), then the return value of this function is undefined."
-      // This is why the distance is previously set to -1.
+      if (_distancePerNode[adjacentNode] == -1)
+      {
+        _distancePerNode[adjacentNode] = d + 1;
+        _reachedNodes.push_back(adjacentNode);
+      }
     }
-    _mapDistancePerViewId[x.first] = d;
   }
   
-  // -- Re-mapping from <ViewId, distance> to <PoseId, distance>:
-  for(auto x: _mapDistancePerViewId)
+  // -- Re-mapping from <View, distance> to <Pose, distance>:
+  for(const std::size_t node : _reachedNodes)
   {
-    // Get the poseId of the camera no. viewId
-    IndexT idPose = sfm_data.GetViews().at(x.first)->getPoseId(); // PoseId of a resected camera
-    
-    auto poseIt = _mapDistancePerPoseId.find(idPose);
+    const std::size_t poseIndex = _poseIndexPerNode[node];
+    int& poseDistance = _distancePerPose[poseIndex];
     // If multiple views share the same pose
-    if(poseIt != _mapDistancePerPoseId.end())
-      poseIt->second = std::min(poseIt->second, x.second);
+    if (poseDistance == -1)
+    {
+      poseDistance = _distancePerNode[node];
+      _reachedPoses.push_back(poseIndex);
+    }
     else
-      _mapDistancePerPoseId[idPose] = x.second;
+      poseDistance = std::min(poseDistance, _distancePerNode[node]);
   } 
 }
 
 void LocalBundleAdjustmentData::convertDistancesToLBAStates(const SfMData & sfm_data)
 {
-  // reset the maps
-  _mapLBAStatePerPoseId.clear();
+  // reset the states
   _mapLBAStatePerIntrinsicId.clear();
-  _mapLBAStatePerLandmarkId.clear();
   resetParametersCounter();
   
   const std::size_t kWindowSize = 25;   // nb of the last value in which compute the variation
@@ -368,23 +404,16 @@ void LocalBundleAdjustmentData::convertDistancesToLBAStates(const SfMData & sfm_
   // -- Poses
   for (Poses::const_iterator itPose = sfm_data.GetPoses().begin(); itPose != sfm_data.GetPoses().end(); ++itPose)
   {
-    const IndexT poseId = itPose->first;
-    int dist = getPoseDistance(poseId);
+    const std::size_t poseIndex = getPoseIndex(itPose->first);
+    const int dist = _distancePerPose[poseIndex];
+    EState state = EState::ignored; // [-inf; 0[ U [D+2; +inf.[  (-1: not connected to the new views)
     if (dist >= 0 && dist <= _graphDistanceLimit) // [0; D]
-    {
-      _mapLBAStatePerPoseId[poseId] = EState::refined;
-      _parametersCounter.at(std::make_pair(EParameter::pose, EState::refined))++;
-    }
+      state = EState::refined;
     else if (dist == _graphDistanceLimit + 1)  // {D+1}
-    {
-      _mapLBAStatePerPoseId[poseId] = EState::constant;
-      _parametersCounter.at(std::make_pair(EParameter::pose, EState::constant))++;
-    }
-    else // [-inf; 0[ U [D+2; +inf.[  (-1: not connected to the new views)
-    {
-      _mapLBAStatePerPoseId[poseId] = EState::ignored;
-      _parametersCounter.at(std::make_pair(EParameter::pose, EState::ignored))++;
-    }
+      state = EState::constant;
+
+    _statePerPose[poseIndex] = state;
+    _parametersCounter[EParameter::pose][state]++;
   }
   
   // -- Instrinsics
@@ -395,37 +424,38 @@ void LocalBundleAdjustmentData::convertDistancesToLBAStates(const SfMData & sfm_
     if (isFocalLengthConstant(itIntrinsic.first))
     {
       _mapLBAStatePerIntrinsicId[itIntrinsic.first] = EState::constant;
-      _parametersCounter.at(std::make_pair(EParameter::intrinsic, EState::constant))++;
+      _parametersCounter[EParameter::intrinsic][EState::constant]++;
     }
     else
     {
       _mapLBAStatePerIntrinsicId[itIntrinsic.first] = EState::refined;
-      _parametersCounter.at(std::make_pair(EParameter::intrinsic, EState::refined))++;
+      _parametersCounter[EParameter::intrinsic][EState::refined]++;
     }
   }
   
   // -- Landmarks
+  _statePerLandmark.clear();
+
   for(const auto& itLandmark: sfm_data.structure)
   {
-    const IndexT landmarkId = itLandmark.first;
-    const Observations & observations = itLandmark.second.observations;
-    
-    _mapLBAStatePerLandmarkId[landmarkId] = EState::ignored;
-    _parametersCounter.at(std::make_pair(EParameter::landmark, EState::ignored))++;
-    
-    
-    for(const auto& observationIt: observations)
+    _statePerLandmark[itLandmark.first] = EState::ignored;
+
+    for(const auto& observationIt: itLandmark.second.observations)
     {
-      int dist = getViewDistance(observationIt.first);
+      const auto nodeIt = _nodePerViewId.find(observationIt.first);
+      if (nodeIt == _nodePerViewId.end())
+        continue;
+
+      const int dist = _distancePerNode[nodeIt->second];
       if(dist >= 0 && dist <= _graphDistanceLimit) // [0; D]
       {
-        _mapLBAStatePerLandmarkId[landmarkId] = EState::refined;
-        _parametersCounter.at(std::make_pair(EParameter::landmark, EState::refined))++;
-        _parametersCounter.at(std::make_pair(EParameter::landmark, EState::ignored))--;
+        _statePerLandmark[itLandmark.first] = EState::refined;
+        _parametersCounter[EParameter::landmark][EState::refined]++;
         break;
       }
     }
   }
+  _parametersCounter[EParameter::landmark][EState::ignored] = sfm_data.structure.size() - _parametersCounter[EParameter::landmark][EState::refined];
 }
 
 std::map<Pair, std::size_t> LocalBundleAdjustmentData::countSharedLandmarksPerImagesPair(
@@ -435,30 +465,19 @@ std::map<Pair, std::size_t> LocalBundleAdjustmentData::countSharedLandmarksPerIm
 {
   std::map<Pair, std::size_t> map_imagesPair_nbSharedLandmarks;
   
-  // Get landmarks id. of all the reconstructed 3D points (: landmarks)
-  // TODO: avoid copy and use boost::transform_iterator
-  std::set<IndexT> landmarkIds;
-  std::transform(sfm_data.GetLandmarks().begin(), sfm_data.GetLandmarks().end(),
-                 std::inserter(landmarkIds, landmarkIds.begin()),
-                 stl::RetrieveKey());
-  
   for(const auto& viewId: newViewsId)
   {
     // Get all the tracks of the new added view
     const aliceVision::track::TrackIdSet& newView_trackIds = map_tracksPerView.at(viewId);
     
-    // Keep the reconstructed tracks (with an associated landmark)
-    std::vector<IndexT> newView_landmarks; // all landmarks (already reconstructed) visible from the new view
-    
-    newView_landmarks.reserve(newView_trackIds.size());
-    std::set_intersection(newView_trackIds.begin(), newView_trackIds.end(),
-                          landmarkIds.begin(), landmarkIds.end(),
-                          std::back_inserter(newView_landmarks));
-    
-    // Retrieve the common track Ids
-    for(const auto& landmarkId: newView_landmarks)
+    // Retrieve the common track Ids, from the reconstructed tracks (with an associated landmark) of the new view
+    for(const auto& trackId: newView_trackIds)
     {
-      for(const auto& observations: sfm_data.structure.at(landmarkId).observations)
+      const auto landmarkIt = sfm_data.structure.find(trackId);
+      if(landmarkIt == sfm_data.structure.end())
+        continue;
+
+      for(const auto& observations: landmarkIt->second.observations)
       {
         if (observations.first == viewId) continue; // do not compare an observation with itself
         
@@ -581,39 +600,46 @@ void LocalBundleAdjustmentData::drawGraph(const SfMData& sfm_data, const std::st
   
   // -- Node
   dotStream << "  node [ shape=ellipse, penwidth=5.0, fontname=Helvetica, fontsize=40 ];" << "\n";
-  for(lemon::ListGraph::NodeIt n(_graph); n!=lemon::INVALID; ++n)
+  for(std::size_t n = 0; n < _viewIdPerNode.size(); ++n)
   {
-    IndexT viewId = _mapViewIdPerNode[n];
-    int viewDist = _mapDistancePerViewId[viewId];
+    const IndexT viewId = _viewIdPerNode[n];
+    if (viewId == UndefinedIndexT) // removed node
+      continue;
+    const int viewDist = _distancePerNode[n];
     
     std::string color = ", color=";
     if (viewDist == 0) color += "red";
     else if (viewDist == 1 ) color += "green";
     else if (viewDist == 2 ) color += "blue";
     else color += "black";
-    dotStream << "  n" << _graph.id(n)
+    dotStream << "  n" << n
               << " [ label=\"" << viewId << ": D" << viewDist << " K" << sfm_data.GetViews().at(viewId)->getIntrinsicId() << "\"" << color << "]; " << "\n";
   }
   
   // -- Edge
   dotStream << "  edge [ shape=ellipse, fontname=Helvetica, fontsize=5, color=black ];" << "\n";
-  for(lemon::ListGraph::EdgeIt e(_graph); e!=lemon::INVALID; ++e)
+  for(std::size_t u = 0; u < _adjacencyPerNode.size(); ++u)
   {
-    dotStream << "  n" << _graph.id(_graph.u(e)) << " -> " << " n" << _graph.id(_graph.v(e));
-    if (_intrinsicEdgesId.find(_graph.id(e)) != _intrinsicEdgesId.end())
-      dotStream << " [color=red]\n";
-    else
-      dotStream << "\n";
+    for(const std::size_t v : _adjacencyPerNode[u])
+    {
+      if (v < u) // each edge once
+        continue;
+      dotStream << "  n" << u << " -> " << " n" << v;
+      if (_intrinsicEdges.find(std::make_pair(u, v)) != _intrinsicEdges.end())
+        dotStream << " [color=red]\n";
+      else
+        dotStream << "\n";
+    }
   }
   dotStream << "}" << "\n";
   
-  const std::string dotFilepath = stlplus::create_filespec(dir, "/graph_" + std::to_string(_mapViewIdPerNode.size())  + "_" + nameComplement + ".dot");
+  const std::string dotFilepath = stlplus::create_filespec(dir, "/graph_" + std::to_string(_nbNodes)  + "_" + nameComplement + ".dot");
   std::ofstream dotFile;
   dotFile.open(dotFilepath);
   dotFile.write(dotStream.str().c_str(), dotStream.str().length());
   dotFile.close();
   
-  ALICEVISION_LOG_DEBUG("The graph '"<< dir << "/graph_" << std::to_string(_mapViewIdPerNode.size()) << "_" << nameComplement << ".dot' has been saved.");
+  ALICEVISION_LOG_DEBUG("The graph '"<< dir << "/graph_" << std::to_string(_nbNodes) << "_" << nameComplement << ".dot' has been saved.");
 }
 
 std::size_t LocalBundleAdjustmentData::addIntrinsicEdgesToTheGraph(const SfMData& sfm_data, const std::set<IndexT>& newReconstructedViews)
@@ -628,7 +654,7 @@ std::size_t LocalBundleAdjustmentData::addIntrinsicEdgesToTheGraph(const SfMData
     if (isFocalLengthConstant(newViewIntrinsicId)) // do not add edges for a consisitent intrinsic
       continue;
     
-    for (const auto& x : _mapNodePerViewId) // for each view in the graph
+    for (const auto& x : _nodePerViewId) // for each view in the graph
     {
       if (newViewId == x.first)  // do not compare a view with itself
         continue; 
@@ -637,12 +663,14 @@ std::size_t LocalBundleAdjustmentData::addIntrinsicEdgesToTheGraph(const SfMData
       
       if (oldViewIntrinsicId == newViewIntrinsicId)
       {
-        IndexT minId = std::min(x.first, newViewId);
-        IndexT maxId = std::max(x.first, newViewId);
-        
-        lemon::ListGraph::Edge edge = _graph.addEdge(_mapNodePerViewId[minId], _mapNodePerViewId[maxId]);
-        _intrinsicEdgesId.insert(_graph.id(edge));
-        numAddedEdges++;
+        const std::size_t nodeA = _nodePerViewId.at(newViewId);
+        const std::size_t nodeB = x.second;
+
+        if (addEdge(nodeA, nodeB))
+        {
+          _intrinsicEdges.insert(std::make_pair(std::min(nodeA, nodeB), std::max(nodeA, nodeB)));
+          numAddedEdges++;
+        }
       }
     }
   }
@@ -651,11 +679,15 @@ std::size_t LocalBundleAdjustmentData::addIntrinsicEdgesToTheGraph(const SfMData
 
 void LocalBundleAdjustmentData::removeIntrinsicEdgesToTheGraph()
 {
-  for(int edgeId : _intrinsicEdgesId)
+  for(const auto& edge : _intrinsicEdges)
   {
-    _graph.erase(_graph.fromId(edgeId, lemon::ListGraph::Edge()));
+    std::vector<std::size_t>& adjacencyA = _adjacencyPerNode[edge.first];
+    std::vector<std::size_t>& adjacencyB = _adjacencyPerNode[edge.second];
+    adjacencyA.erase(std::find(adjacencyA.begin(), adjacencyA.end(), edge.second));
+    adjacencyB.erase(std::find(adjacencyB.begin(), adjacencyB.end(), edge.first));
+    --_nbEdges;
   }
-  _intrinsicEdgesId.clear();
+  _intrinsicEdges.clear();
 }
 
 } // namespace sfm
@@ -9,6 +9,9 @@
 #include "aliceVision/types.hpp"
 #include "aliceVision/track/Track.hpp"
 
+#include <array>
+#include <vector>
+
 namespace aliceVision {
 namespace sfm {
 
@@ -29,15 +32,25 @@ public:
 
   /// Return the number of posed views for each graph-distance <distance, numViews>
   std::map<int, std::size_t> getDistancesHistogram() const;
+
+  /// @brief Return the distance between a specific pose and the new posed views.
+  /// @param[in] poseId is the index of the poseId
+  /// @details Return \c -1 if the pose is not connected to any new posed view.
+  int getPoseDistance(const IndexT poseId) const;
+  
+  /// @brief Return the distance between a specific view and the new posed views.
+  /// @param[in] viewId is the index of the view
+  /// @details Return \c -1 if the view is not connected to any new posed view.
+  int getViewDistance(const IndexT viewId) const;
     
   /// Return the \c EState for a specific pose.
-  EState getPoseState(const IndexT poseId) const           {return _mapLBAStatePerPoseId.at(poseId);}
+  EState getPoseState(const IndexT poseId) const           {return _statePerPose.at(_poseIndexes.at(poseId));}
  
   /// Return the \c EState for a specific intrinsic.
   EState getIntrinsicState(const IndexT intrinsicId) const {return _mapLBAStatePerIntrinsicId.at(intrinsicId);}
 
   /// Return the \c EState for a specific landmark.
-  EState getLandmarkState(const IndexT landmarkId) const   {return _mapLBAStatePerLandmarkId.at(landmarkId);}
+  EState getLandmarkState(const IndexT landmarkId) const   {return _statePerLandmark.at(landmarkId);}
   
   /// Return the number of refined poses.
   std::size_t getNumOfRefinedPoses() const        {return getNumberOf(EParameter::pose, EState::refined);}
@@ -108,6 +121,8 @@ public:
   /// @brief Compute the intragraph-distance between all the nodes of the graph (posed views) and the newly resected
   /// views.
   /// @details The graph-distances are computed using a Breadth-first Search (BFS) method.
+  /// The BFS stops at the distance D+1 (\c _graphDistanceLimit + 1): the farther views are ignored by the
+  /// Local BA, so their distance is set to -1. Only the views reached by the previous BFS are reset.
   /// @param[in] sfm_data contains all the information about the reconstruction, notably the posed views
   /// @param[in] newReconstructedViews The list of the newly resected views used (used as source in the BFS algorithm)
   void computeGraphDistances(const SfMData& sfm_data, const std::set<IndexT> &newReconstructedViews);
@@ -142,16 +157,6 @@ private:
     intrinsic,  ///< The intrinsic
     landmark    ///< The landmark
   };
-  
-  /// @brief Return the distance between a specific pose and the new posed views.
-  /// @param[in] poseId is the index of the poseId
-  /// @details Return \c -1 if the pose is not connected to any new posed view.
-  int getPoseDistance(const IndexT poseId) const;
-  
-  /// @brief Return the distance between a specific view and the new posed views.
-  /// @param[in] viewId is the index of the view
-  /// @details Return \c -1 if the view is not connected to any new posed view.
-  int getViewDistance(const IndexT viewId) const;
       
   /// @brief All the values of the structure counting the number of parameters \c EParameter being in a specific state \c EState
   /// are set to 0.
@@ -168,7 +173,17 @@ private:
   void drawGraph(const SfMData &sfm_data, const std::string& dir, const std::string& nameComplement = "");
 
   /// Return the number of parameters \c EParameter being in the \c EState state.
-  std::size_t getNumberOf(EParameter param, EState state) const {return _parametersCounter.at(std::make_pair(param, state));}
+  std::size_t getNumberOf(EParameter param, EState state) const {return _parametersCounter[param][state];}
+
+  /// @brief Return the dense index of a pose, a new index is created for an unknown pose.
+  std::size_t getPoseIndex(const IndexT poseId);
+
+  /// @brief Add an edge between two nodes of the graph, if they are not already adjacent.
+  /// @return true if the edge has been added
+  bool addEdge(const std::size_t nodeA, const std::size_t nodeB);
+
+  /// @brief Reset the graph-distances of the nodes and poses reached by the last BFS.
+  void resetGraphDistances();
   
   /// @brief Compute, for each camera the variation of the last \a windowSize values of the focal length.
   /// If the focal lenght variations are considered as enought constant the function updates \a _mapFocalIsConstant.
@@ -183,6 +198,7 @@ private:
   void checkFocalLengthsConsistency(const std::size_t windowSize, const double stdevPercentageLimit);
   
   /// @brief Count the number of shared landmarks between all the new views and each already resected cameras.
+  /// @details Only the observations of the landmarks seen by the new views are visited.
   /// @param[in] sfm_data
   /// @param[in] map_tracksPerView
   /// @param[in] newViewsId A set with the views index that we want to count matches with resected cameras. 
@@ -217,31 +233,44 @@ private:
   // The bundle adjustment will be processed on the closest poses only.
   // ------------------------
   
-  /// A graph where nodes are poses and an edge exists when 2 poses shared at least 'kMinNbOfMatches' matches.
-  lemon::ListGraph _graph; 
-  
   /// The graph-distance limit setting the Active region (default value: 1)
   std::size_t _graphDistanceLimit = 1;
-  
+
+  // A graph where nodes are posed views and an edge exists when 2 views shared at least 'kMinNbOfMatches' matches.
+  // The nodes are indexed by their order of insertion. A removed node keeps its index, with no view and no edge.
+
   /// Associates each view (indexed by its viewId) to its corresponding node in the graph.
-  std::map<IndexT, lemon::ListGraph::Node> _mapNodePerViewId;
-  /// Associates each node (in the graph) to its corresponding view.
-  std::map<lemon::ListGraph::Node, IndexT> _mapViewIdPerNode;
-    
+  HashMap<IndexT, std::size_t> _nodePerViewId;
+  /// Associates each node to its corresponding view (UndefinedIndexT: removed node).
+  std::vector<IndexT> _viewIdPerNode;
+  /// Associates each node to the dense index of the pose of its view.
+  std::vector<std::size_t> _poseIndexPerNode;
+  /// Adjacent nodes of each node.
+  std::vector<std::vector<std::size_t>> _adjacencyPerNode;
+  /// Number of nodes & edges in the graph.
+  std::size_t _nbNodes = 0;
+  std::size_t _nbEdges = 0;
+
+  /// Associates each pose (indexed by its poseId) to a dense index.
+  HashMap<IndexT, std::size_t> _poseIndexes;
+
   /// Store the graph-distances from the new views (0: is a new view, -1: is not connected to the new views)
-  std::map<IndexT, int> _mapDistancePerViewId;
+  std::vector<int> _distancePerNode;
   /// Store the graph-distances from the new poses (0: is a new pose, -1: is not connected to the new poses)
-  std::map<IndexT, int> _mapDistancePerPoseId;
-  
-  /// Store the \c EState of each pose in the scene.
-  std::map<IndexT, EState> _mapLBAStatePerPoseId;
+  std::vector<int> _distancePerPose;
+  /// Nodes & poses with a graph-distance, reset by the next BFS.
+  std::vector<std::size_t> _reachedNodes;
+  std::vector<std::size_t> _reachedPoses;
+
+  /// Store the \c EState of each pose in the scene, by dense pose index.
+  std::vector<EState> _statePerPose;
   /// Store the \c EState of each intrinsic in the scene.
   std::map<IndexT, EState> _mapLBAStatePerIntrinsicId;
   /// Store the \c EState of each landmark in the scene.
-  std::map<IndexT, EState> _mapLBAStatePerLandmarkId;
-  
+  HashMap<IndexT, EState> _statePerLandmark;
+
   /// Store the number of parameter \c EParameter in a specific state \c EState
-  std::map<std::pair<EParameter, EState>, int> _parametersCounter;
+  std::array<std::array<std::size_t, 3>, 3> _parametersCounter;
   
   // ------------------------
   // - Intrinsics data -
@@ -266,9 +295,9 @@ private:
   /// <IntrinsicId, isConsideredAsConstant>
   std::map<IndexT, bool> _mapFocalIsConstant; 
   
-  /// @brief Store the Lemon index of the edges added thanks to the intrinsics "the intrinsic-edges" 
+  /// @brief Store the nodes pairs of the edges added thanks to the intrinsics "the intrinsic-edges" 
   /// @details (no longer used)
-  std::set<int> _intrinsicEdgesId; 
+  std::set<std::pair<std::size_t, std::size_t>> _intrinsicEdges; 
   
   /// Output path where Local BA outputs will be saved
   std::string _outFolder;
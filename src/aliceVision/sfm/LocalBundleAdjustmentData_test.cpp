@@ -0,0 +1,133 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LocalBundleAdjustmentData.hpp"
+#include <aliceVision/camera/Pinhole.hpp>
+
+#include <memory>
+
+#define BOOST_TEST_MODULE LocalBundleAdjustmentData
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::sfm;
+
+static const std::size_t nbViews = 6;
+static const std::size_t nbLandmarksPerPair = 60;
+
+/**
+ * @brief Set the pose of a view and add its observations to the landmarks,
+ * as the sequential SfM does when a view is resected.
+ */
+void addPose(SfMData& sfmData, const track::TracksPerView& tracksPerView, IndexT viewId)
+{
+  sfmData.setPose(*sfmData.views.at(viewId), geometry::Pose3(Mat3::Identity(), Vec3(viewId, 0.0, 0.0)));
+  for(const std::size_t landmarkId : tracksPerView.at(viewId))
+    sfmData.structure.at(landmarkId).observations[viewId] = Observation(Vec2(500.0, 500.0), landmarkId);
+}
+
+/**
+ * @brief Create a chain of views: the views i and i+1 share their own landmarks, so the
+ * co-visibility graph is the path 0 - 1 - ... - nbViews-1. Only the first views are posed.
+ */
+void createChainScene(std::size_t nbPosedViews, SfMData& sfmData, track::TracksPerView& tracksPerView)
+{
+  sfmData.intrinsics.emplace(0, std::make_shared<camera::Pinhole>(1000, 1000, 1000.0, 500.0, 500.0));
+  for(IndexT viewId = 0; viewId < nbViews; ++viewId)
+  {
+    sfmData.views.emplace(viewId, std::make_shared<View>("", viewId, 0, viewId, 1000, 1000));
+    tracksPerView[viewId];
+  }
+
+  IndexT landmarkId = 0;
+  for(IndexT viewId = 0; viewId + 1 < nbViews; ++viewId)
+  {
+    for(std::size_t i = 0; i < nbLandmarksPerPair; ++i, ++landmarkId)
+    {
+      sfmData.structure[landmarkId].X = Vec3(viewId + 0.5, 0.0, 10.0);
+      tracksPerView[viewId].push_back(landmarkId);
+      tracksPerView[viewId + 1].push_back(landmarkId);
+    }
+  }
+
+  for(IndexT viewId = 0; viewId < nbPosedViews; ++viewId)
+    addPose(sfmData, tracksPerView, viewId);
+}
+
+BOOST_AUTO_TEST_CASE(LocalBundleAdjustmentData_addViews)
+{
+  SfMData sfmData;
+  track::TracksPerView tracksPerView;
+  createChainScene(4, sfmData, tracksPerView);
+
+  LocalBundleAdjustmentData lbaData(sfmData);
+  lbaData.setGraphDistanceLimit(nbViews);
+
+  // the graph is empty: all the posed views are added
+  lbaData.updateGraphWithNewViews(sfmData, tracksPerView, {3});
+  lbaData.computeGraphDistances(sfmData, {3});
+  for(IndexT viewId = 0; viewId < 4; ++viewId)
+    BOOST_CHECK_EQUAL(lbaData.getViewDistance(viewId), 3 - viewId);
+  BOOST_CHECK_EQUAL(lbaData.getViewDistance(4), -1);
+  BOOST_CHECK_EQUAL(lbaData.getViewDistance(5), -1);
+
+  // the new views are linked to the existing nodes
+  addPose(sfmData, tracksPerView, 4);
+  addPose(sfmData, tracksPerView, 5);
+  lbaData.updateGraphWithNewViews(sfmData, tracksPerView, {4, 5});
+  lbaData.computeGraphDistances(sfmData, {5});
+  for(IndexT viewId = 0; viewId < nbViews; ++viewId)
+    BOOST_CHECK_EQUAL(lbaData.getViewDistance(viewId), 5 - viewId);
+
+  // adding the same views again does not change the graph
+  lbaData.updateGraphWithNewViews(sfmData, tracksPerView, {4, 5});
+  lbaData.computeGraphDistances(sfmData, {0});
+  for(IndexT viewId = 0; viewId < nbViews; ++viewId)
+    BOOST_CHECK_EQUAL(lbaData.getViewDistance(viewId), viewId);
+
+  // the BFS stops at the distance limit + 1
+  lbaData.setGraphDistanceLimit(1);
+  lbaData.computeGraphDistances(sfmData, {0});
+  const std::map<int, std::size_t> histogram = lbaData.getDistancesHistogram();
+  BOOST_CHECK_EQUAL(histogram.at(0), 1);
+  BOOST_CHECK_EQUAL(histogram.at(1), 1);
+  BOOST_CHECK_EQUAL(histogram.at(2), 1);
+  BOOST_CHECK_EQUAL(histogram.at(-1), 3);
+}
+
+BOOST_AUTO_TEST_CASE(LocalBundleAdjustmentData_removeViews)
+{
+  SfMData sfmData;
+  track::TracksPerView tracksPerView;
+  createChainScene(nbViews, sfmData, tracksPerView);
+
+  LocalBundleAdjustmentData lbaData(sfmData);
+  lbaData.setGraphDistanceLimit(nbViews);
+  lbaData.updateGraphWithNewViews(sfmData, tracksPerView, {});
+
+  // removing a view disconnects the chain
+  BOOST_CHECK(lbaData.removeViewsToTheGraph({2}));
+  BOOST_CHECK(!lbaData.removeViewsToTheGraph({2}));
+  lbaData.computeGraphDistances(sfmData, {0});
+  BOOST_CHECK_EQUAL(lbaData.getViewDistance(0), 0);
+  BOOST_CHECK_EQUAL(lbaData.getViewDistance(1), 1);
+  BOOST_CHECK_EQUAL(lbaData.getViewDistance(2), -1);
+  BOOST_CHECK_EQUAL(lbaData.getViewDistance(3), -1);
+  BOOST_CHECK_EQUAL(lbaData.getDistancesHistogram().at(-1), 3);
+
+  // the view is added back with its edges
+  lbaData.updateGraphWithNewViews(sfmData, tracksPerView, {2});
+  lbaData.computeGraphDistances(sfmData, {2});
+  BOOST_CHECK_EQUAL(lbaData.getViewDistance(0), 2);
+  BOOST_CHECK_EQUAL(lbaData.getViewDistance(5), 3);
+
+  // once all the views are removed, the graph is seeded again with all the posed views
+  BOOST_CHECK(lbaData.removeViewsToTheGraph({0, 1, 2, 3, 4, 5}));
+  BOOST_CHECK(lbaData.getDistancesHistogram().empty());
+  lbaData.updateGraphWithNewViews(sfmData, tracksPerView, {});
+  lbaData.computeGraphDistances(sfmData, {0});
+  for(IndexT viewId = 0; viewId < nbViews; ++viewId)
+    BOOST_CHECK_EQUAL(lbaData.getViewDistance(viewId), viewId);
+}
@@ -3,6 +3,7 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file,
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
+#include "AlembicExporter.hpp"
 #include "AlembicImporter.hpp"
 #include "SfMData.hpp"
 #include "sfmDataIO.hpp"
@@ -275,3 +276,49 @@ BOOST_AUTO_TEST_CASE(AlembicImporter_importExport) {
     }
 
 }
+
+//-----------------
+// Test summary:
+//-----------------
+// - Create a random scene
+// - Export to Alembic with the landmarks split in several point clouds
+// - Import all the scene
+// - Import the cameras, then the skipped point clouds
+//-----------------
+BOOST_AUTO_TEST_CASE(AlembicImporter_chunkedLandmarks) {
+
+    const SfMData sfmData = createTestScene(5, 50, 1, 2, true);
+
+    const std::string abcFile = "chunkedLandmarks.abc";
+    {
+        AlembicExporter exporter(abcFile);
+        exporter.setLandmarksChunkSize(7);
+        BOOST_CHECK_EQUAL(exporter.getLandmarksChunkSize(), 7);
+        exporter.add(sfmData, ALL);
+    }
+
+    // the point clouds are merged back
+    {
+        SfMData sfmAbc;
+        AlembicImporter importer(abcFile);
+        importer.populate(sfmAbc, ALL);
+        BOOST_CHECK_EQUAL(importer.getNbSkippedPointClouds(), 0);
+        BOOST_CHECK(sfmData == sfmAbc);
+    }
+
+    // the cameras are imported without reading the points
+    {
+        SfMData sfmAbc;
+        AlembicImporter importer(abcFile);
+        importer.populate(sfmAbc, ESfMData(VIEWS | INTRINSICS | EXTRINSICS));
+        BOOST_CHECK(sfmAbc.structure.empty());
+        BOOST_CHECK_EQUAL(importer.getNbSkippedPointClouds(), 8);
+        BOOST_CHECK_EQUAL(sfmData.views.size(), sfmAbc.views.size());
+        BOOST_CHECK_EQUAL(sfmData.GetPoses().size(), sfmAbc.GetPoses().size());
+        BOOST_CHECK_EQUAL(sfmData.intrinsics.size(), sfmAbc.intrinsics.size());
+
+        importer.populateStructure(sfmAbc);
+        BOOST_CHECK_EQUAL(importer.getNbSkippedPointClouds(), 0);
+        BOOST_CHECK(sfmData == sfmAbc);
+    }
+}
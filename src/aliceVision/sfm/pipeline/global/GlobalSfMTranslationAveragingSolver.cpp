@@ -9,7 +9,6 @@
 #include "aliceVision/sfm/sfmDataIO.hpp"
 #include "aliceVision/sfm/BundleAdjustmentCeres.hpp"
 #include "aliceVision/sfm/pipeline/global/reindexGlobalSfM.hpp"
-#include "aliceVision/sfm/pipeline/global/MutexSet.hpp"
 #include "aliceVision/matching/IndMatch.hpp"
 #include "aliceVision/multiview/translationAveraging/common.hpp"
 #include "aliceVision/multiview/translationAveraging/solver.hpp"
@@ -17,6 +16,7 @@
 #include "aliceVision/track/Track.hpp"
 #include "aliceVision/stl/stl.hpp"
 #include "aliceVision/system/Timer.hpp"
+#include "aliceVision/system/MemoryInfo.hpp"
 #include "aliceVision/linearProgramming/linearProgramming.hpp"
 #include "aliceVision/multiview/essential.hpp"
 #include "aliceVision/multiview/conditioning.hpp"
@@ -31,6 +31,8 @@
 
 #include <boost/progress.hpp>
 
+#include <atomic>
+
 namespace aliceVision{
 namespace sfm{
 
@@ -326,10 +328,13 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
   std::set<IndexT> set_pose_ids;
   std::transform(map_globalR.begin(), map_globalR.end(),
     std::inserter(set_pose_ids, set_pose_ids.begin()), stl::RetrieveKey());
-  // List shared correspondences (pairs) between poses
-  for (const auto & match_iterator : pairwiseMatches)
+  // List shared correspondences (pairs) between poses,
+  // and index the pairwise matches per pose pair once for all the triplets
+  PosePairMatchesIndex posePairMatches;
+  for (matching::PairwiseMatches::const_iterator match_iterator = pairwiseMatches.begin();
+       match_iterator != pairwiseMatches.end(); ++match_iterator)
   {
-    const Pair pair = match_iterator.first;
+    const Pair pair = match_iterator->first;
     const View * v1 = sfm_data.GetViews().at(pair.first).get();
     const View * v2 = sfm_data.GetViews().at(pair.second).get();
 
@@ -340,6 +345,7 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
     {
       rotation_pose_id_graph.insert(
         std::make_pair(v1->getPoseId(), v2->getPoseId()));
+      posePairMatches[std::minmax(v1->getPoseId(), v2->getPoseId())].push_back(match_iterator);
     }
   }
   // List putative triplets (from global rotations Ids)
@@ -347,45 +353,18 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
     graph::tripletListing(rotation_pose_id_graph);
   ALICEVISION_LOG_DEBUG("#Triplets: " << vec_triplets.size());
 
+  const double timeTripletListing = timerLP_triplet.elapsed();
+
   {
     // Compute triplets of translations
     // Avoid to cover each edge of the graph by using an edge coverage algorithm
     // An estimated triplets of translation mark three edges as estimated.
 
     //-- precompute the number of track per triplet:
-    HashMap<IndexT, IndexT> map_tracksPerTriplets;
-
-    #pragma omp parallel for schedule(dynamic)
-    for (int i = 0; i < (int)vec_triplets.size(); ++i)
-    {
-      // List matches that belong to the triplet of poses
-      const graph::Triplet & triplet = vec_triplets[i];
-      matching::PairwiseMatches map_triplet_matches;
-      const std::set<IndexT> set_triplet_pose_ids = {triplet.i, triplet.j, triplet.k};
-      // List shared correspondences (pairs) between the triplet poses
-      for (const auto & match_iterator : pairwiseMatches)
-      {
-        const Pair pair = match_iterator.first;
-        const View * v1 = sfm_data.GetViews().at(pair.first).get();
-        const View * v2 = sfm_data.GetViews().at(pair.second).get();
-        if (// Consider the pair iff it is supported by the triplet graph & 2 different pose id
-            (v1->getPoseId() != v2->getPoseId())
-            && set_triplet_pose_ids.count(v1->getPoseId())
-            && set_triplet_pose_ids.count(v2->getPoseId()))
-        {
-          map_triplet_matches.insert( match_iterator );
-        }
-      }
-      // Compute tracks:
-      {
-        aliceVision::track::TracksBuilder tracksBuilder;
-        tracksBuilder.Build(map_triplet_matches);
-        tracksBuilder.Filter(3);
+    std::vector<std::size_t> vec_tracksPerTriplet;
+    CountTracksPerTriplet(sfm_data, pairwiseMatches, vec_triplets, vec_tracksPerTriplet);
 
-        #pragma omp critical
-        map_tracksPerTriplets[i] = tracksBuilder.NbTracks(); //count the # of matches in the UF tree
-      }
-    }
+    const double timeTracksCount = timerLP_triplet.elapsed() - timeTripletListing;
 
     typedef Pair myEdge;
 
@@ -403,26 +382,48 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
     std::vector<myEdge > vec_edges;
     std::transform(map_tripletIds_perEdge.begin(), map_tripletIds_perEdge.end(), std::back_inserter(vec_edges), stl::RetrieveKey());
 
-    aliceVision::sfm::MutexSet<myEdge> m_mutexSet;
+    // Estimated edges, shared by the threads without lock (vec_edges is sorted)
+    std::vector<std::atomic<bool> > vec_isEdgeEstimated(vec_edges.size());
+    for (std::atomic<bool> & isEdgeEstimated : vec_isEdgeEstimated)
+      isEdgeEstimated = false;
+    std::atomic<std::size_t> nbEstimatedEdges(0);
+
+    const auto isEdgeEstimated = [&](const myEdge & edge)
+    {
+      const auto it = std::lower_bound(vec_edges.begin(), vec_edges.end(), edge);
+      return vec_isEdgeEstimated[std::distance(vec_edges.begin(), it)].load();
+    };
+    const auto setEdgeEstimated = [&](const myEdge & edge)
+    {
+      const auto it = std::lower_bound(vec_edges.begin(), vec_edges.end(), edge);
+      if (!vec_isEdgeEstimated[std::distance(vec_edges.begin(), it)].exchange(true))
+        ++nbEstimatedEdges;
+    };
 
     boost::progress_display my_progress_bar(
       vec_edges.size(),
       std::cout,
       "\nRelative translations computation (edge coverage algorithm)\n");
+    std::atomic<std::size_t> nbProcessedEdges(0);
 
-    // set number of threads, 1 if openMP is not enabled  
+    // set number of threads, 1 if openMP is not enabled
+    // each thread keeps its own estimates and matches, merged after the edges coverage
     std::vector<translationAveraging::RelativeInfoVec> initial_estimates(omp_get_max_threads());
+    std::vector<matching::PairwiseMatches> newpairMatches_perThread(omp_get_max_threads());
     const bool bVerbose = false;
 
     #pragma omp parallel for schedule(dynamic)
-    for (int k = 0; k < vec_edges.size(); ++k)
+    for (int k = 0; k < static_cast<int>(vec_edges.size()); ++k)
     {
       const myEdge & edge = vec_edges[k];
-      #pragma omp critical
-      {
-        ++my_progress_bar;
-      }
-      if (m_mutexSet.count(edge) == 0 && m_mutexSet.size() != vec_edges.size())
+      const int thread_id = omp_get_thread_num();
+
+      // the progress bar is only displayed by the master thread
+      const std::size_t nbProcessed = ++nbProcessedEdges;
+      if (thread_id == 0)
+        my_progress_bar += nbProcessed - my_progress_bar.count();
+
+      if (!isEdgeEstimated(edge) && nbEstimatedEdges != vec_edges.size())
       {
         // Find the triplets that support the given edge
         const auto & vec_possibleTripletIndexes = map_tripletIds_perEdge.at(edge);
@@ -431,7 +432,7 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
         std::vector<size_t> vec_commonTracksPerTriplets;
         for (const size_t triplet_index : vec_possibleTripletIndexes)
         {
-          vec_commonTracksPerTriplets.push_back(map_tracksPerTriplets[triplet_index]);
+          vec_commonTracksPerTriplets.push_back(vec_tracksPerTriplet[triplet_index]);
         }
 
         using namespace stl::indexed_sort;
@@ -449,9 +450,9 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
           const graph::Triplet & triplet = vec_triplets[triplet_index];
 
           // If the triplet is already estimated by another thread; try the next one
-          if (m_mutexSet.count(Pair(triplet.i, triplet.j)) &&
-              m_mutexSet.count(Pair(triplet.i, triplet.k)) &&
-              m_mutexSet.count(Pair(triplet.j, triplet.k)))
+          if (isEdgeEstimated(Pair(triplet.i, triplet.j)) &&
+              isEdgeEstimated(Pair(triplet.i, triplet.k)) &&
+              isEdgeEstimated(Pair(triplet.j, triplet.k)))
           {
             break;
           }
@@ -470,7 +471,7 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
               sfm_data,
               map_globalR,
               normalizedFeaturesPerView,
-              pairwiseMatches,
+              posePairMatches,
               triplet,
               vec_tis,
               dPrecision,
@@ -481,9 +482,9 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
           if (bTriplet_estimation)
           {
             // Since new translation edges have been computed, mark their corresponding edges as estimated
-            m_mutexSet.insert(std::make_pair(triplet.i, triplet.j));
-            m_mutexSet.insert(std::make_pair(triplet.j, triplet.k));
-            m_mutexSet.insert(std::make_pair(triplet.i, triplet.k));
+            setEdgeEstimated(std::make_pair(triplet.i, triplet.j));
+            setEdgeEstimated(std::make_pair(triplet.j, triplet.k));
+            setEdgeEstimated(std::make_pair(triplet.i, triplet.k));
 
             // Compute the triplet relative motions (IJ, JK, IK)
             {
@@ -508,9 +509,6 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
               Vec3 tik;
               RelativeCameraMotion(RI, ti, RK, tk, &Rik, &tik);
 
-              // set number of threads, 1 if openMP is not enabled
-              const int thread_id = omp_get_thread_num();
-
               initial_estimates[thread_id].emplace_back(
                 std::make_pair(triplet.i, triplet.j), std::make_pair(Rij, tij));
               initial_estimates[thread_id].emplace_back(
@@ -518,40 +516,36 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
               initial_estimates[thread_id].emplace_back(
                 std::make_pair(triplet.i, triplet.k), std::make_pair(Rik, tik));
 
-              //--- ATOMIC
-              #pragma omp critical
+              // Add inliers as valid pairwise matches
+              for (std::vector<size_t>::const_iterator iterInliers = vec_inliers.begin();
+                iterInliers != vec_inliers.end(); ++iterInliers)
               {
-                // Add inliers as valid pairwise matches
-                for (std::vector<size_t>::const_iterator iterInliers = vec_inliers.begin();
-                  iterInliers != vec_inliers.end(); ++iterInliers)
+                using namespace aliceVision::track;
+                TracksMap::iterator it_tracks = pose_triplet_tracks.begin();
+                std::advance(it_tracks, *iterInliers);
+                const Track & track = it_tracks->second;
+
+                // create pairwise matches from inlier track
+                for (size_t index_I = 0; index_I < track.featPerView.size() ; ++index_I)
                 {
-                  using namespace aliceVision::track;
-                  TracksMap::iterator it_tracks = pose_triplet_tracks.begin();
-                  std::advance(it_tracks, *iterInliers);
-                  const Track & track = it_tracks->second;
+                  Track::FeatureIdPerView::const_iterator iter_I = track.featPerView.begin();
+                  std::advance(iter_I, index_I);
 
-                  // create pairwise matches from inlier track
-                  for (size_t index_I = 0; index_I < track.featPerView.size() ; ++index_I)
+                  // extract camera indexes
+                  const size_t id_view_I = iter_I->first;
+                  const size_t id_feat_I = iter_I->second;
+
+                  // loop on subtracks
+                  for (size_t index_J = index_I+1; index_J < track.featPerView.size() ; ++index_J)
                   {
-                    Track::FeatureIdPerView::const_iterator iter_I = track.featPerView.begin();
-                    std::advance(iter_I, index_I);
+                    Track::FeatureIdPerView::const_iterator iter_J = track.featPerView.begin();
+                    std::advance(iter_J, index_J);
 
                     // extract camera indexes
-                    const size_t id_view_I = iter_I->first;
-                    const size_t id_feat_I = iter_I->second;
-
-                    // loop on subtracks
-                    for (size_t index_J = index_I+1; index_J < track.featPerView.size() ; ++index_J)
-                    {
-                      Track::FeatureIdPerView::const_iterator iter_J = track.featPerView.begin();
-                      std::advance(iter_J, index_J);
+                    const size_t id_view_J = iter_J->first;
+                    const size_t id_feat_J = iter_J->second;
 
-                      // extract camera indexes
-                      const size_t id_view_J = iter_J->first;
-                      const size_t id_feat_J = iter_J->second;
-
-                      newpairMatches[std::make_pair(id_view_I, id_view_J)][track.descType].emplace_back(id_feat_I, id_feat_J);
-                    }
+                    newpairMatches_perThread[thread_id][std::make_pair(id_view_I, id_view_J)][track.descType].emplace_back(id_feat_I, id_feat_J);
                   }
                 }
               }
@@ -563,14 +557,49 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
         }
       }
     }
+    my_progress_bar += vec_edges.size() - my_progress_bar.count();
+
     // Merge thread estimates
-    for (const auto vec : initial_estimates)
+    for (const auto & vec : initial_estimates)
     {
-      for (const auto val : vec)
+      for (const auto & val : vec)
       {
         vec_initialEstimates.emplace_back(val);
       }
     }
+    // Merge thread matches
+    for (const matching::PairwiseMatches & threadMatches : newpairMatches_perThread)
+    {
+      for (const auto & pairMatches : threadMatches)
+      {
+        for (const auto & descMatches : pairMatches.second)
+        {
+          matching::IndMatches & matches = newpairMatches[pairMatches.first][descMatches.first];
+          matches.insert(matches.end(), descMatches.second.begin(), descMatches.second.end());
+        }
+      }
+    }
+
+    const double timeEdgesCoverage = timerLP_triplet.elapsed() - timeTripletListing - timeTracksCount;
+
+    // size of the pose pair index, the triplets and their track counts
+    std::size_t indexSize = vec_triplets.capacity() * sizeof(graph::Triplet) + vec_tracksPerTriplet.capacity() * sizeof(std::size_t);
+    for (const auto & posePair : posePairMatches)
+      indexSize += sizeof(posePair) + posePair.second.capacity() * sizeof(matching::PairwiseMatches::const_iterator);
+    for (const auto & edge : map_tripletIds_perEdge)
+      indexSize += sizeof(edge) + edge.second.capacity() * sizeof(size_t);
+
+    const system::MemoryInfo memoryInfo = system::getMemoryInfo();
+
+    ALICEVISION_LOG_INFO("Triplets stage:\n"
+      "\t- #pose pairs: " << posePairMatches.size() << "\n"
+      "\t- #triplets: " << vec_triplets.size() << "\n"
+      "\t- #edges: " << vec_edges.size() << "\n"
+      "\t- pose pairs and triplets listing: " << timeTripletListing << " s\n"
+      "\t- tracks per triplet: " << timeTracksCount << " s\n"
+      "\t- edges coverage: " << timeEdgesCoverage << " s\n"
+      "\t- pose pairs and triplets index size: " << indexSize / (1024 * 1024) << " MB\n"
+      "\t- used memory: " << (memoryInfo.totalRam - memoryInfo.freeRam) / (1024 * 1024) << " MB");
   }
 
 
@@ -586,12 +615,85 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
       "-------------------------------");
 }
 
+void GlobalSfMTranslationAveragingSolver::CountTracksPerTriplet(
+  const SfMData & sfm_data,
+  const matching::PairwiseMatches & pairwiseMatches,
+  const std::vector<graph::Triplet> & vec_triplets,
+  std::vector<std::size_t> & out_tracksPerTriplet) const
+{
+  // Compute the tracks of the whole scene once
+  track::TracksMap tracks;
+  {
+    track::TracksBuilder tracksBuilder;
+    tracksBuilder.Build(pairwiseMatches);
+    tracksBuilder.Filter(3);
+    tracksBuilder.ExportToSTL(tracks);
+  }
+
+  // List the visible tracks per pose (sorted track ids)
+  std::map<IndexT, std::vector<std::size_t> > tracksPerPose;
+  {
+    std::vector<IndexT> trackPoses;
+    for (const auto & trackIt : tracks)
+    {
+      trackPoses.clear();
+      for (const auto & featIt : trackIt.second.featPerView)
+        trackPoses.push_back(sfm_data.GetViews().at(featIt.first)->getPoseId());
+      std::sort(trackPoses.begin(), trackPoses.end());
+      trackPoses.erase(std::unique(trackPoses.begin(), trackPoses.end()), trackPoses.end());
+
+      if (trackPoses.size() < 3)
+        continue;
+      for (const IndexT poseId : trackPoses)
+        tracksPerPose[poseId].push_back(trackIt.first);
+    }
+  }
+  tracks.clear();
+
+  // Count the tracks common to the three poses of each triplet
+  out_tracksPerTriplet.assign(vec_triplets.size(), 0);
+
+  #pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < (int)vec_triplets.size(); ++i)
+  {
+    const graph::Triplet & triplet = vec_triplets[i];
+    const auto itI = tracksPerPose.find(triplet.i);
+    const auto itJ = tracksPerPose.find(triplet.j);
+    const auto itK = tracksPerPose.find(triplet.k);
+    if (itI == tracksPerPose.end() || itJ == tracksPerPose.end() || itK == tracksPerPose.end())
+      continue;
+
+    // intersection of the three sorted lists
+    const std::vector<std::size_t> & tracksI = itI->second;
+    const std::vector<std::size_t> & tracksJ = itJ->second;
+    const std::vector<std::size_t> & tracksK = itK->second;
+    auto a = tracksI.begin();
+    auto b = tracksJ.begin();
+    auto c = tracksK.begin();
+    std::size_t nbCommonTracks = 0;
+    while (a != tracksI.end() && b != tracksJ.end() && c != tracksK.end())
+    {
+      const std::size_t trackId = std::max(*a, std::max(*b, *c));
+      if (*a == trackId && *b == trackId && *c == trackId)
+      {
+        ++nbCommonTracks;
+        ++a; ++b; ++c;
+        continue;
+      }
+      a = std::lower_bound(a, tracksI.end(), trackId);
+      b = std::lower_bound(b, tracksJ.end(), trackId);
+      c = std::lower_bound(c, tracksK.end(), trackId);
+    }
+    out_tracksPerTriplet[i] = nbCommonTracks;
+  }
+}
+
 // Robust estimation and refinement of a translation and 3D points of an image triplets.
 bool GlobalSfMTranslationAveragingSolver::Estimate_T_triplet(
   const SfMData & sfm_data,
   const HashMap<IndexT, Mat3> & map_globalR,
   const feature::FeaturesPerView & normalizedFeaturesPerView,
-  const matching::PairwiseMatches & pairwiseMatches,
+  const PosePairMatchesIndex & posePairMatches,
   const graph::Triplet & poses_id,
   std::vector<Vec3> & vec_tis,
   double & dPrecision, // UpperBound of the precision found by the AContrario estimator
@@ -599,26 +701,25 @@ bool GlobalSfMTranslationAveragingSolver::Estimate_T_triplet(
   aliceVision::track::TracksMap & tracks,
   const std::string & sOutDirectory) const
 {
-  // List matches that belong to the triplet of poses
-  matching::PairwiseMatches map_triplet_matches;
-  const std::set<IndexT> set_pose_ids = {poses_id.i, poses_id.j, poses_id.k};
-  // List shared correspondences (pairs) between poses
-  for (const auto & match_iterator : pairwiseMatches)
+  // List matches that belong to the triplet of poses (referenced, not copied)
+  std::vector<matching::PairwiseMatches::const_iterator> triplet_matches;
+  const Pair posePairs[3] = {Pair(poses_id.i, poses_id.j), Pair(poses_id.i, poses_id.k), Pair(poses_id.j, poses_id.k)};
+  for (const Pair & posePair : posePairs)
   {
-    const Pair & pair = match_iterator.first;
-    const View * v1 = sfm_data.GetViews().at(pair.first).get();
-    const View * v2 = sfm_data.GetViews().at(pair.second).get();
-    if (// Consider the pair iff it is supported by the triplet graph & 2 different pose id
-        (v1->getPoseId() != v2->getPoseId())
-        && set_pose_ids.count(v1->getPoseId())
-        && set_pose_ids.count(v2->getPoseId()))
-    {
-      map_triplet_matches.insert( match_iterator );
-    }
+    const auto itPosePair = posePairMatches.find(posePair);
+    if (itPosePair == posePairMatches.end())
+      continue;
+    triplet_matches.insert(triplet_matches.end(), itPosePair->second.begin(), itPosePair->second.end());
   }
+  // keep the view pairs order of the pairwise matches: the track ids do not depend on the pose pairs
+  std::sort(triplet_matches.begin(), triplet_matches.end(),
+    [](const matching::PairwiseMatches::const_iterator & a, const matching::PairwiseMatches::const_iterator & b)
+    {
+      return a->first < b->first;
+    });
 
   aliceVision::track::TracksBuilder tracksBuilder;
-  tracksBuilder.Build(map_triplet_matches);
+  tracksBuilder.Build(triplet_matches);
   tracksBuilder.Filter(3);
   tracksBuilder.ExportToSTL(tracks);
 
@@ -705,11 +806,11 @@ bool GlobalSfMTranslationAveragingSolver::Estimate_T_triplet(
   tiny_scene.poses[poses_id.k] = Pose3(vec_global_R_Triplet[2], -vec_global_R_Triplet[2].transpose() * vec_tis[2]);
 
   // insert views used by the relative pose pairs
-  for (const auto & pairIterator : map_triplet_matches )
+  for (const matching::PairwiseMatches::const_iterator & pairIterator : triplet_matches )
   {
     // initialize camera indexes
-    const IndexT I = pairIterator.first.first;
-    const IndexT J = pairIterator.first.second;
+    const IndexT I = pairIterator->first.first;
+    const IndexT J = pairIterator->first.second;
 
     // add views
     tiny_scene.views.insert(*sfm_data.GetViews().find(I));
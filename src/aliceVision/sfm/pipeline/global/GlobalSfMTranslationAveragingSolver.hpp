@@ -26,6 +26,9 @@ class GlobalSfMTranslationAveragingSolver
 {
   translationAveraging::RelativeInfoVec m_vec_initialRijTijEstimates;
 
+  /// Pairwise matches of each pose pair (the smallest pose id first)
+  typedef std::map<Pair, std::vector<matching::PairwiseMatches::const_iterator> > PosePairMatchesIndex;
+
 public:
 
   /// Use features in normalized camera frames
@@ -63,12 +66,26 @@ private:
     translationAveraging::RelativeInfoVec & vec_initialEstimates,
     matching::PairwiseMatches & newpairMatches);
 
+  /**
+   * @brief Count the tracks seen by the three poses of each triplet.
+   * The tracks are built once from all the pairwise matches and shared by all the triplets.
+   * @param[in] sfm_data The scene
+   * @param[in] pairwiseMatches The pairwise matches
+   * @param[in] vec_triplets The pose triplets
+   * @param[out] out_tracksPerTriplet The number of tracks of each triplet
+   */
+  void CountTracksPerTriplet(
+    const SfMData & sfm_data,
+    const matching::PairwiseMatches & pairwiseMatches,
+    const std::vector<graph::Triplet> & vec_triplets,
+    std::vector<std::size_t> & out_tracksPerTriplet) const;
+
   // Robust estimation and refinement of a translation and 3D points of an image triplets.
   bool Estimate_T_triplet(
     const SfMData & sfm_data,
     const HashMap<IndexT, Mat3> & map_globalR,
     const feature::FeaturesPerView & normalizedFeaturesPerView,
-    const matching::PairwiseMatches & matches_provider,
+    const PosePairMatchesIndex & posePairMatches,
     const graph::Triplet & poses_id,
     std::vector<Vec3> & vec_tis,
     double & dPrecision, // UpperBound of the precision found by the AContrario estimator
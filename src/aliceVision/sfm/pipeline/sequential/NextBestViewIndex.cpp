@@ -0,0 +1,194 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "NextBestViewIndex.hpp"
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace sfm {
+
+void NextBestViewIndex::build(const track::TracksPerView& tracksPerView,
+                              const track::TracksPyramidPerView& tracksPyramidPerView,
+                              const std::vector<int>& pyramidWeights)
+{
+  _pyramidDepth = pyramidWeights.size();
+  _pyramidWeights = pyramidWeights;
+  _nbCells = 0;
+
+  _viewIndexes.clear();
+  _viewIds.clear();
+  _ranking.clear();
+  _reconstructedTracks.clear();
+  _modifiedViews.clear();
+  _epoch = 0;
+
+  // views with tracks
+  std::size_t maxTrackId = 0;
+  for(const auto& viewTracks : tracksPerView)
+  {
+    if(viewTracks.second.empty())
+      continue;
+    _viewIndexes[viewTracks.first] = _viewIds.size();
+    _viewIds.push_back(viewTracks.first);
+    maxTrackId = std::max(maxTrackId, *std::max_element(viewTracks.second.begin(), viewTracks.second.end()));
+  }
+
+  // number of observations per track
+  _trackObservations.assign(maxTrackId + 2, 0);
+  for(const auto& viewTracks : tracksPerView)
+  {
+    for(const std::size_t trackId : viewTracks.second)
+      ++_trackObservations[trackId + 1];
+  }
+  for(std::size_t i = 1; i < _trackObservations.size(); ++i)
+    _trackObservations[i] += _trackObservations[i - 1];
+
+  // pyramid cells of each observation, grouped by track
+  const std::size_t nbObservations = _trackObservations.back();
+  _observationViews.resize(nbObservations);
+  _observationCells.resize(nbObservations * _pyramidDepth);
+  std::vector<std::size_t> nextObservation(_trackObservations.begin(), _trackObservations.end() - 1);
+
+  for(std::size_t v = 0; v < _viewIds.size(); ++v)
+  {
+    const IndexT viewId = _viewIds[v];
+    const auto& trackIds = tracksPerView.at(viewId);
+    const auto& tracksPyramid = tracksPyramidPerView.at(viewId);
+
+    for(const std::size_t trackId : trackIds)
+    {
+      const std::size_t observation = nextObservation[trackId]++;
+      _observationViews[observation] = static_cast<std::uint32_t>(v);
+      for(std::size_t level = 0; level < _pyramidDepth; ++level)
+      {
+        const std::size_t cell = tracksPyramid.at(trackId * _pyramidDepth + level);
+        if(cell > std::numeric_limits<std::uint16_t>::max())
+          throw std::out_of_range("NextBestViewIndex: too many pyramid cells.");
+        _observationCells[observation * _pyramidDepth + level] = static_cast<std::uint16_t>(cell);
+        _nbCells = std::max(_nbCells, cell + 1);
+      }
+    }
+  }
+
+  const std::size_t nbViews = _viewIds.size();
+  _nbReconstructedTracks.assign(nbViews, 0);
+  _scores.assign(nbViews, 0);
+  _rankedScores.assign(nbViews, 0);
+  _cellCounts.assign(nbViews, std::vector<std::uint32_t>());
+  _isViewModified.assign(nbViews, 0);
+
+  _isReconstructed.assign(maxTrackId + 1, 0);
+  _trackEpoch.assign(maxTrackId + 1, 0);
+
+  for(const IndexT viewId : _viewIds)
+    _ranking.emplace(0, viewId);
+
+  ALICEVISION_LOG_DEBUG("Next best view index: " << nbViews << " views, " << nbObservations << " observations.");
+}
+
+void NextBestViewIndex::update(const Landmarks& landmarks)
+{
+  ++_epoch;
+
+  // new landmarks
+  for(const auto& landmark : landmarks)
+  {
+    const std::size_t trackId = landmark.first;
+    if(trackId >= _isReconstructed.size())
+      continue;
+    _trackEpoch[trackId] = _epoch;
+    if(!_isReconstructed[trackId])
+    {
+      _isReconstructed[trackId] = 1;
+      _reconstructedTracks.push_back(trackId);
+      updateTrack(trackId, 1);
+    }
+  }
+
+  // removed landmarks
+  for(std::size_t i = 0; i < _reconstructedTracks.size();)
+  {
+    const std::size_t trackId = _reconstructedTracks[i];
+    if(_trackEpoch[trackId] == _epoch)
+    {
+      ++i;
+      continue;
+    }
+    _isReconstructed[trackId] = 0;
+    updateTrack(trackId, -1);
+    _reconstructedTracks[i] = _reconstructedTracks.back();
+    _reconstructedTracks.pop_back();
+  }
+
+  // update the ranking of the modified views
+  for(const std::size_t v : _modifiedViews)
+  {
+    _isViewModified[v] = 0;
+    if(_rankedScores[v] == _scores[v])
+      continue;
+    _ranking.erase(RankedView(_rankedScores[v], _viewIds[v]));
+    _ranking.emplace(_scores[v], _viewIds[v]);
+    _rankedScores[v] = _scores[v];
+  }
+  _modifiedViews.clear();
+}
+
+void NextBestViewIndex::updateTrack(std::size_t trackId, int sign)
+{
+  for(std::size_t observation = _trackObservations[trackId]; observation < _trackObservations[trackId + 1]; ++observation)
+  {
+    const std::size_t v = _observationViews[observation];
+    std::vector<std::uint32_t>& cellCounts = _cellCounts[v];
+    if(cellCounts.empty())
+      cellCounts.assign(_nbCells, 0);
+
+    const std::uint16_t* cells = &_observationCells[observation * _pyramidDepth];
+    if(sign > 0)
+    {
+      ++_nbReconstructedTracks[v];
+      for(std::size_t level = 0; level < _pyramidDepth; ++level)
+      {
+        // a new cell is occupied
+        if(cellCounts[cells[level]]++ == 0)
+          _scores[v] += _pyramidWeights[level];
+      }
+    }
+    else
+    {
+      --_nbReconstructedTracks[v];
+      for(std::size_t level = 0; level < _pyramidDepth; ++level)
+      {
+        // the cell is now empty
+        if(--cellCounts[cells[level]] == 0)
+          _scores[v] -= _pyramidWeights[level];
+      }
+    }
+
+    if(!_isViewModified[v])
+    {
+      _isViewModified[v] = 1;
+      _modifiedViews.push_back(v);
+    }
+  }
+}
+
+std::size_t NextBestViewIndex::getNbReconstructedTracks(IndexT viewId) const
+{
+  const auto it = _viewIndexes.find(viewId);
+  return (it == _viewIndexes.end()) ? 0 : _nbReconstructedTracks[it->second];
+}
+
+std::size_t NextBestViewIndex::getScore(IndexT viewId) const
+{
+  const auto it = _viewIndexes.find(viewId);
+  return (it == _viewIndexes.end()) ? 0 : _scores[it->second];
+}
+
+} // namespace sfm
+} // namespace aliceVision
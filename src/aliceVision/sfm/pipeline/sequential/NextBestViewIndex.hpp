@@ -0,0 +1,123 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/sfm/SfMData.hpp>
+#include <aliceVision/stl/FlatMap.hpp>
+#include <aliceVision/track/Track.hpp>
+#include <aliceVision/types.hpp>
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Incremental index of the next best view scores of the sequential SfM.
+ *
+ * The score of a view is the weighted number of pyramid grid cells
+ * occupied by its reconstructed tracks (see ReconstructionEngine_sequentialSfM::computeImageScore).
+ * The index keeps the number of reconstructed tracks in each pyramid cell of each view,
+ * so the scores only need to be updated for the tracks added to or removed from the reconstruction.
+ * The views are ranked by decreasing score, then by increasing view id.
+ */
+class NextBestViewIndex
+{
+public:
+
+  /// Ranked view: <score, viewId>
+  typedef std::pair<std::size_t, IndexT> RankedView;
+
+  struct RankedViewCompare
+  {
+    bool operator()(const RankedView& a, const RankedView& b) const
+    {
+      return (a.first != b.first) ? (a.first > b.first) : (a.second < b.second);
+    }
+  };
+
+  typedef std::set<RankedView, RankedViewCompare> Ranking;
+
+  NextBestViewIndex() = default;
+
+  /**
+   * @brief Build the index, without any reconstructed track.
+   * @param[in] tracksPerView The list of track ids per view
+   * @param[in] tracksPyramidPerView The pyramid cell index of each track in each view
+   * @param[in] pyramidWeights The weight of each pyramid level
+   */
+  void build(const track::TracksPerView& tracksPerView,
+             const track::TracksPyramidPerView& tracksPyramidPerView,
+             const std::vector<int>& pyramidWeights);
+
+  /**
+   * @brief Update the scores with the landmarks added or removed since the last update.
+   * @param[in] landmarks The landmarks of the reconstruction, with track ids as landmark ids
+   */
+  void update(const Landmarks& landmarks);
+
+  /// Views with at least one track, ranked by decreasing score
+  const Ranking& getRanking() const
+  {
+    return _ranking;
+  }
+
+  /// Get the number of reconstructed tracks in a view
+  std::size_t getNbReconstructedTracks(IndexT viewId) const;
+
+  /// Get the score of a view
+  std::size_t getScore(IndexT viewId) const;
+
+  /// Get the number of reconstructed tracks known by the index
+  std::size_t getNbReconstructedTracks() const
+  {
+    return _reconstructedTracks.size();
+  }
+
+private:
+
+  /// Add (+1) or remove (-1) a track to the scores of its views
+  void updateTrack(std::size_t trackId, int sign);
+
+  std::size_t _pyramidDepth = 0;
+  std::vector<int> _pyramidWeights;
+  /// number of cells of the pyramid of a view (all levels)
+  std::size_t _nbCells = 0;
+
+  // Views, by dense index
+  stl::flat_map<IndexT, std::size_t> _viewIndexes;
+  std::vector<IndexT> _viewIds;
+  std::vector<std::size_t> _nbReconstructedTracks;
+  std::vector<std::size_t> _scores;
+  /// scores of the views in the ranking
+  std::vector<std::size_t> _rankedScores;
+  /// number of reconstructed tracks in each pyramid cell, allocated on the first reconstructed track
+  std::vector<std::vector<std::uint32_t>> _cellCounts;
+  /// views whose score changed during the current update
+  std::vector<char> _isViewModified;
+  std::vector<std::size_t> _modifiedViews;
+
+  // Track observations, by track id: [_trackObservations[trackId], _trackObservations[trackId+1])
+  std::vector<std::size_t> _trackObservations;
+  /// dense view index of each observation
+  std::vector<std::uint32_t> _observationViews;
+  /// pyramid cell of each observation at each level
+  std::vector<std::uint16_t> _observationCells;
+
+  // Reconstructed tracks
+  std::vector<std::size_t> _reconstructedTracks;
+  std::vector<char> _isReconstructed;
+  /// last update in which each track was seen in the landmarks
+  std::vector<std::uint32_t> _trackEpoch;
+  std::uint32_t _epoch = 0;
+
+  Ranking _ranking;
+};
+
+} // namespace sfm
+} // namespace aliceVision
@@ -22,7 +22,9 @@
 #include "aliceVision/system/Timer.hpp"
 #include "aliceVision/system/cpu.hpp"
 #include "aliceVision/system/MemoryInfo.hpp"
+#include "aliceVision/system/Tracing.hpp"
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include "dependencies/htmlDoc/htmlDoc.hpp"
 
@@ -164,6 +166,8 @@ void ReconstructionEngine_sequentialSfM::RobustResectionOfImages(
   std::set<size_t>& set_reconstructedViewId,
   std::set<size_t>& set_rejectedViewId)
 {
+  // Maximum number of cameras added before a bundle adjustment,
+  // also used as the size of the batches of parallel resections
   static const std::size_t maxImagesPerGroup = 30;
 
   IndexT resectionId = 0;
@@ -207,66 +211,90 @@ void ReconstructionEngine_sequentialSfM::RobustResectionOfImages(
     const std::set<IndexT> prevReconstructedViews = _sfm_data.getValidViews();
 
     // add images to the 3D reconstruction
-    for (const size_t possible_resection_index: vec_possible_resection_indexes )
+    // The candidates are resected in parallel by batches against the scene, which is read-only meanwhile,
+    // then the successful resections are added to the scene in the candidates order.
+    bool isGroupFull = false;
+    for(std::size_t batchStart = 0; batchStart < vec_possible_resection_indexes.size() && !isGroupFull; batchStart += maxImagesPerGroup)
     {
-      const size_t currentIndex = imageIndex;
-      ++imageIndex;
+      const std::size_t batchSize = std::min(maxImagesPerGroup, vec_possible_resection_indexes.size() - batchStart);
+      std::vector<ResectionData> resections(batchSize);
+      std::vector<char> isResected(batchSize, 0);
 
+      #pragma omp parallel for schedule(dynamic)
+      for(int i = 0; i < static_cast<int>(batchSize); ++i)
       {
-        const View& view = *_sfm_data.views.at(possible_resection_index);
+        const IndexT viewId = vec_possible_resection_indexes[batchStart + i];
+        // Some views can become indirectly localized when the sub-pose becomes defined
+        if(_sfm_data.views.at(viewId)->isPartOfRig() && _sfm_data.IsPoseAndIntrinsicDefined(viewId))
+          continue;
+        isResected[i] = computeResection(viewId, resections[i]);
+      }
+
+      for(std::size_t i = 0; i < batchSize; ++i)
+      {
+        const size_t possible_resection_index = vec_possible_resection_indexes[batchStart + i];
+        const size_t currentIndex = imageIndex;
+        ++imageIndex;
 
-        if(view.isPartOfRig())
         {
-          // Some views can become indirectly localized when the sub-pose becomes defined
-          if(_sfm_data.IsPoseAndIntrinsicDefined(view.getViewId()))
+          const View& view = *_sfm_data.views.at(possible_resection_index);
+
+          if(view.isPartOfRig())
           {
-            ALICEVISION_LOG_DEBUG("Resection of image " << currentIndex << " ID=" << possible_resection_index << " was skipped." << std::endl
-                              << "RigID=" << view.getRigId() << " Sub-poseID=" << view.getSubPoseId()
-                              << " sub-pose and pose defined.");
-            set_remainingViewId.erase(possible_resection_index);
-            continue;
-          }
+            // Some views can become indirectly localized when the sub-pose becomes defined
+            if(_sfm_data.IsPoseAndIntrinsicDefined(view.getViewId()))
+            {
+              ALICEVISION_LOG_DEBUG("Resection of image " << currentIndex << " ID=" << possible_resection_index << " was skipped." << std::endl
+                                << "RigID=" << view.getRigId() << " Sub-poseID=" << view.getSubPoseId()
+                                << " sub-pose and pose defined.");
+              set_remainingViewId.erase(possible_resection_index);
+              continue;
+            }
 
-          // We cannot localize a view if it is part of an initialized RIG with unknown Rig Pose
-          const bool knownPose = _sfm_data.existsPose(view);
-          const Rig& rig = _sfm_data.getRig(view);
-          const RigSubPose& subpose = rig.getSubPose(view.getSubPoseId());
+            // We cannot localize a view if it is part of an initialized RIG with unknown Rig Pose
+            const bool knownPose = _sfm_data.existsPose(view);
+            const Rig& rig = _sfm_data.getRig(view);
+            const RigSubPose& subpose = rig.getSubPose(view.getSubPoseId());
 
-          if(rig.isInitialized() &&
-             !knownPose &&
-             (subpose.status == ERigSubPoseStatus::UNINITIALIZED))
-          {
-            ALICEVISION_LOG_DEBUG("Resection of image " << currentIndex << " ID=" << possible_resection_index << " was skipped." << std::endl
-                              << "RigID=" << view.getRigId() << " Sub-poseID=" << view.getSubPoseId()
-                              << " Rig initialized but unkown pose and sub-pose.");
-            set_remainingViewId.erase(possible_resection_index);
-            continue;
+            if(rig.isInitialized() &&
+               !knownPose &&
+               (subpose.status == ERigSubPoseStatus::UNINITIALIZED))
+            {
+              ALICEVISION_LOG_DEBUG("Resection of image " << currentIndex << " ID=" << possible_resection_index << " was skipped." << std::endl
+                                << "RigID=" << view.getRigId() << " Sub-poseID=" << view.getSubPoseId()
+                                << " Rig initialized but unkown pose and sub-pose.");
+              set_remainingViewId.erase(possible_resection_index);
+              continue;
+            }
           }
         }
-      }
 
-      const bool bResect = Resection(possible_resection_index);
+        const bool bResect = isResected[i];
+        logResection(resections[i], bResect);
 
-      bImageAdded |= bResect;
-      if (!bResect)
-      {
-        set_rejectedViewId.insert(possible_resection_index);
-        ALICEVISION_LOG_DEBUG("Resection of image " << currentIndex << " ID=" << possible_resection_index << " was not possible.");
-      }
-      else
-      {
-        set_reconstructedViewId.insert(possible_resection_index);
-        ALICEVISION_LOG_DEBUG("Resection of image: " << currentIndex << " ID=" << possible_resection_index << " succeed.");
-        _sfm_data.GetViews().at(possible_resection_index)->setResectionId(resectionId);
-        ++resectionId;
-      }
-      set_remainingViewId.erase(possible_resection_index);
+        bImageAdded |= bResect;
+        if (!bResect)
+        {
+          set_rejectedViewId.insert(possible_resection_index);
+          ALICEVISION_LOG_DEBUG("Resection of image " << currentIndex << " ID=" << possible_resection_index << " was not possible.");
+        }
+        else
+        {
+          updateScene(resections[i]);
+          set_reconstructedViewId.insert(possible_resection_index);
+          ALICEVISION_LOG_DEBUG("Resection of image: " << currentIndex << " ID=" << possible_resection_index << " succeed.");
+          _sfm_data.GetViews().at(possible_resection_index)->setResectionId(resectionId);
+          ++resectionId;
+        }
+        set_remainingViewId.erase(possible_resection_index);
 
-      // Limit to a maximum number of cameras added to ensure that
-      // we don't add too much data in one step without bundle adjustment.
-      if(_sfm_data.getValidViews().size() - prevReconstructedViews.size() > maxImagesPerGroup)
-      {
-        break;
+        // Limit to a maximum number of cameras added to ensure that
+        // we don't add too much data in one step without bundle adjustment.
+        if(_sfm_data.getValidViews().size() - prevReconstructedViews.size() > maxImagesPerGroup)
+        {
+          isGroupFull = true;
+          break;
+        }
       }
     }
     ALICEVISION_LOG_DEBUG("Resection of " << vec_possible_resection_indexes.size() << " new images took " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - chrono_start).count() << " msec.");
@@ -291,6 +319,8 @@ void ReconstructionEngine_sequentialSfM::RobustResectionOfImages(
 
     // triangulate
     triangulate(_sfm_data, prevReconstructedViews, newReconstructedViews);
+    ALICEVISION_TRACE_COUNTER("sfm.reconstructedViews", _sfm_data.getValidViews().size());
+    ALICEVISION_TRACE_COUNTER("sfm.landmarks", _sfm_data.GetLandmarks().size());
 
     if (bImageAdded)
     {
@@ -619,6 +649,8 @@ bool ReconstructionEngine_sequentialSfM::InitLandmarkTracks()
     ALICEVISION_LOG_DEBUG("Build tracks pyramid per view");
     computeTracksPyramidPerView(
             _map_tracksPerView, _map_tracks, _sfm_data.views, *_featuresPerView, _pyramidBase, _pyramidDepth, _map_featsPyramidPerView);
+    ALICEVISION_LOG_DEBUG("Build next best view index");
+    _nextBestViewIndex.build(_map_tracksPerView, _map_featsPyramidPerView, _pyramidWeights);
 
     {
       //-- Display stats :
@@ -1109,87 +1141,67 @@ std::size_t ReconstructionEngine_sequentialSfM::computeImageScore(std::size_t vi
 
 bool ReconstructionEngine_sequentialSfM::FindConnectedViews(
   std::vector<ViewConnectionScore>& out_connectedViews,
-  const std::set<size_t>& remainingViewIds) const
+  const std::set<size_t>& remainingViewIds)
 {
   out_connectedViews.clear();
 
   if (remainingViewIds.empty() || _sfm_data.GetLandmarks().empty())
     return false;
 
-  // Collect tracksIds
-  std::set<size_t> reconstructed_trackId;
-  std::transform(_sfm_data.GetLandmarks().begin(), _sfm_data.GetLandmarks().end(),
-    std::inserter(reconstructed_trackId, reconstructed_trackId.begin()),
-    stl::RetrieveKey());
-  
+  // Update the scores with the tracks added or removed since the last selection
+  _nextBestViewIndex.update(_sfm_data.GetLandmarks());
+
   const std::set<IndexT> reconstructedIntrinsics = _sfm_data.getReconstructedIntrinsics();
 
-#pragma omp parallel for
-  for (int i = 0; i < remainingViewIds.size(); ++i)
+  // The views are ranked by the image score, based on the number of matches to the 3D scene
+  // and the repartition of these features in the image.
+  for(const NextBestViewIndex::RankedView& rankedView : _nextBestViewIndex.getRanking())
   {
-    std::set<size_t>::const_iterator iter = remainingViewIds.cbegin();
-    std::advance(iter, i);
-    const size_t viewId = *iter;
-    const size_t intrinsicId = _sfm_data.GetViews().at(viewId)->getIntrinsicId();
-    const bool isIntrinsicsReconstructed = reconstructedIntrinsics.count(intrinsicId);
-
-    // Compute 2D - 3D possible content
-    aliceVision::track::TracksPerView::const_iterator tracksIdsIt = _map_tracksPerView.find(viewId);
-    if(tracksIdsIt == _map_tracksPerView.end())
+    const IndexT viewId = rankedView.second;
+    if(remainingViewIds.count(viewId) == 0)
       continue;
 
-    const aliceVision::track::TrackIdSet& set_tracksIds = tracksIdsIt->second;
-    if (set_tracksIds.empty())
-      continue;
+    const View& view = *_sfm_data.views.at(viewId);
+    const bool isIntrinsicsReconstructed = reconstructedIntrinsics.count(view.getIntrinsicId());
 
     // Check if the view is part of a rig
+    if(view.isPartOfRig())
     {
-      const View& view = *_sfm_data.views.at(viewId);
-
-      if(view.isPartOfRig())
+      // Some views can become indirectly localized when the sub-pose becomes defined
+      if(_sfm_data.IsPoseAndIntrinsicDefined(view.getViewId()))
       {
-        // Some views can become indirectly localized when the sub-pose becomes defined
-        if(_sfm_data.IsPoseAndIntrinsicDefined(view.getViewId()))
-        {
-          continue;
-        }
+        continue;
+      }
 
-        // We cannot localize a view if it is part of an initialized RIG with unknown Rig Pose
-        const bool knownPose = _sfm_data.existsPose(view);
-        const Rig& rig = _sfm_data.getRig(view);
-        const RigSubPose& subpose = rig.getSubPose(view.getSubPoseId());
+      // We cannot localize a view if it is part of an initialized RIG with unknown Rig Pose
+      const bool knownPose = _sfm_data.existsPose(view);
+      const Rig& rig = _sfm_data.getRig(view);
+      const RigSubPose& subpose = rig.getSubPose(view.getSubPoseId());
 
-        if(rig.isInitialized() &&
-           !knownPose &&
-           (subpose.status == ERigSubPoseStatus::UNINITIALIZED))
-        {
-          continue;
-        }
+      if(rig.isInitialized() &&
+         !knownPose &&
+         (subpose.status == ERigSubPoseStatus::UNINITIALIZED))
+      {
+        continue;
       }
     }
 
-    // Count the common possible putative point
-    //  with the already 3D reconstructed trackId
-    std::vector<size_t> vec_trackIdForResection;
-    vec_trackIdForResection.reserve(set_tracksIds.size());
-    std::set_intersection(set_tracksIds.begin(), set_tracksIds.end(),
-      reconstructed_trackId.begin(),
-      reconstructed_trackId.end(),
-      std::back_inserter(vec_trackIdForResection));
-    // Compute an image score based on the number of matches to the 3D scene
-    // and the repartition of these features in the image.
-    std::size_t score = computeImageScore(viewId, vec_trackIdForResection);
-#pragma omp critical
-    {
-      out_connectedViews.emplace_back(viewId, vec_trackIdForResection.size(), score, isIntrinsicsReconstructed);
-    }
+    // Number of common possible putative points with the already 3D reconstructed tracks
+    const std::size_t nbTracks = _nextBestViewIndex.getNbReconstructedTracks(viewId);
+#ifdef ALICEVISION_NEXTBESTVIEW_WITHOUT_SCORE
+    out_connectedViews.emplace_back(viewId, nbTracks, nbTracks, isIntrinsicsReconstructed);
+#else
+    out_connectedViews.emplace_back(viewId, nbTracks, rankedView.first, isIntrinsicsReconstructed);
+#endif
   }
 
-  // Sort by the image score
-  std::sort(out_connectedViews.begin(), out_connectedViews.end(),
+#ifdef ALICEVISION_NEXTBESTVIEW_WITHOUT_SCORE
+  // Sort by the number of matches to the 3D scene
+  std::stable_sort(out_connectedViews.begin(), out_connectedViews.end(),
       [](const ViewConnectionScore& t1, const ViewConnectionScore& t2) {
         return std::get<2>(t1) > std::get<2>(t2);
       });
+#endif
 
   return !out_connectedViews.empty();
 }
@@ -1197,7 +1209,7 @@ bool ReconstructionEngine_sequentialSfM::FindConnectedViews(
 
 bool ReconstructionEngine_sequentialSfM::FindNextImagesGroupForResection(
   std::vector<size_t> & out_selectedViewIds,
-  const std::set<size_t>& remainingViewIds) const
+  const std::set<size_t>& remainingViewIds)
 {
   out_selectedViewIds.clear();
   auto chrono_start = std::chrono::steady_clock::now();
@@ -1271,38 +1283,34 @@ bool ReconstructionEngine_sequentialSfM::FindNextImagesGroupForResection(
 }
 
 /**
- * @brief Add one image to the 3D reconstruction. To the resectioning of
- * the camera and triangulate all the new possible tracks.
- * @param[in] viewIndex: image index to add to the reconstruction.
+ * @brief Compute the resection of one image against the 3D reconstruction.
+ * @param[in] viewIndex: image index to localize.
  *
  * A. Compute 2D/3D matches
  * B. Look if intrinsic data is known or not
  * C. Do the resectioning: compute the camera pose.
  * D. Refine the pose of the found camera
- * E. Update the global scene with the new camera pose or rig pose/sub-pose
- * F. Update the observations into the global scene structure
- * G. Triangulate new possible 2D tracks
+ *
+ * The scene is not modified, see updateScene.
  */
-bool ReconstructionEngine_sequentialSfM::Resection(const std::size_t viewIndex)
+bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewIndex, ResectionData& resectionData) const
 {
+  ALICEVISION_TRACE_SCOPE("sfm.resection", viewIndex);
   using namespace track;
 
+  resectionData.viewId = viewIndex;
+
   // A. Compute 2D/3D matches
   // A1. list tracks ids used by the view
   const aliceVision::track::TrackIdSet& set_tracksIds = _map_tracksPerView.at(viewIndex);
 
   // A2. intersects the track list with the reconstructed
-  std::set<std::size_t> reconstructed_trackId;
-  std::transform(_sfm_data.GetLandmarks().begin(), _sfm_data.GetLandmarks().end(),
-    std::inserter(reconstructed_trackId, reconstructed_trackId.begin()),
-    stl::RetrieveKey());
-
-  // Get the ids of the already reconstructed tracks
   std::set<std::size_t> set_trackIdForResection;
-  std::set_intersection(set_tracksIds.begin(), set_tracksIds.end(),
-    reconstructed_trackId.begin(),
-    reconstructed_trackId.end(),
-    std::inserter(set_trackIdForResection, set_trackIdForResection.begin()));
+  for(const std::size_t trackId : set_tracksIds)
+  {
+    if(_sfm_data.GetLandmarks().count(trackId))
+      set_trackIdForResection.insert(trackId);
+  }
 
   if (set_trackIdForResection.empty())
   {
@@ -1313,7 +1321,7 @@ bool ReconstructionEngine_sequentialSfM::Resection(const std::size_t viewIndex)
 
   // Get back featId associated to a tracksID already reconstructed.
   // These 2D/3D associations will be used for the resection.
-  std::vector<TracksUtilsMap::FeatureId> vec_featIdForResection;
+  std::vector<TracksUtilsMap::FeatureId>& vec_featIdForResection = resectionData.featureIds;
   
   TracksUtilsMap::GetFeatureIdInViewPerTrack(_map_tracks,
     set_trackIdForResection,
@@ -1321,24 +1329,27 @@ bool ReconstructionEngine_sequentialSfM::Resection(const std::size_t viewIndex)
     &vec_featIdForResection);
 
   // Localize the image inside the SfM reconstruction
-  ImageLocalizerMatchData resection_data;
+  ImageLocalizerMatchData& resection_data = resectionData.matchData;
   resection_data.pt2D.resize(2, set_trackIdForResection.size());
   resection_data.pt3D.resize(3, set_trackIdForResection.size());
   resection_data.vec_descType.resize(set_trackIdForResection.size());
+  resectionData.trackIds.assign(set_trackIdForResection.begin(), set_trackIdForResection.end());
 
   // B. Look if intrinsic data is known or not
+  // Work on a copy of the intrinsic, the scene is read-only
   const View * view_I = _sfm_data.GetViews().at(viewIndex).get();
-  std::shared_ptr<camera::IntrinsicBase> optionalIntrinsic = _sfm_data.GetIntrinsicSharedPtr(view_I->getIntrinsicId());
+  std::shared_ptr<camera::IntrinsicBase> optionalIntrinsic;
+  {
+    const camera::IntrinsicBase* sceneIntrinsic = _sfm_data.GetIntrinsicPtr(view_I->getIntrinsicId());
+    if(sceneIntrinsic)
+      optionalIntrinsic.reset(sceneIntrinsic->clone());
+  }
 
-  std::size_t cpt = 0;
-  std::set<std::size_t>::const_iterator iterTrackId = set_trackIdForResection.begin();
-  for (std::vector<TracksUtilsMap::FeatureId>::const_iterator iterfeatId = vec_featIdForResection.begin();
-    iterfeatId != vec_featIdForResection.end();
-    ++iterfeatId, ++iterTrackId, ++cpt)
+  for (std::size_t cpt = 0; cpt < vec_featIdForResection.size(); ++cpt)
   {
-    const feature::EImageDescriberType descType = iterfeatId->first;
-    resection_data.pt3D.col(cpt) = _sfm_data.GetLandmarks().at(*iterTrackId).X;
-    resection_data.pt2D.col(cpt) = _featuresPerView->getFeatures(viewIndex, descType)[iterfeatId->second].coords().cast<double>();
+    const feature::EImageDescriberType descType = vec_featIdForResection[cpt].first;
+    resection_data.pt3D.col(cpt) = _sfm_data.GetLandmarks().at(resectionData.trackIds[cpt]).X;
+    resection_data.pt2D.col(cpt) = _featuresPerView->getFeatures(viewIndex, descType)[vec_featIdForResection[cpt].second].coords().cast<double>();
     resection_data.vec_descType.at(cpt) = descType;
   }
 
@@ -1347,32 +1358,14 @@ bool ReconstructionEngine_sequentialSfM::Resection(const std::size_t viewIndex)
     "-------------------------------\n"
     "-- Robust Resection of view: " << viewIndex);
 
-  geometry::Pose3 pose;
+  geometry::Pose3& pose = resectionData.pose;
   const bool bResection = sfm::SfMLocalizer::Localize(
       Pair(view_I->getWidth(), view_I->getHeight()),
       optionalIntrinsic.get(),
       resection_data,
       pose
     );
-
-  if (!_sLoggingFile.empty())
-  {
-    using namespace htmlDocument;
-    std::ostringstream os;
-    os << "Robust resection of view " << viewIndex << ": <br>";
-    _htmlDocStream->pushInfo(htmlMarkup("h4",os.str()));
-
-    os.str("");
-    os << std::endl
-      << "- Image path: " << view_I->getImagePath() << "<br>"
-      << "- Threshold: " << resection_data.error_max << "<br>"
-      << "- Resection status: " << (bResection ? "OK" : "FAILED") << "<br>"
-      << "- # points used for Resection: " << vec_featIdForResection.size() << "<br>"
-      << "- # points validated by robust estimation: " << resection_data.vec_inliers.size() << "<br>"
-      << "- % points validated: "
-      << resection_data.vec_inliers.size()/static_cast<float>(vec_featIdForResection.size()) << "<br>";
-    _htmlDocStream->pushInfo(os.str());
-  }
+  resectionData.isLocalizationRun = true;
 
   if (!bResection)
   {
@@ -1382,94 +1375,136 @@ bool ReconstructionEngine_sequentialSfM::Resection(const std::size_t viewIndex)
 
   // D. Refine the pose of the found camera.
   // We use a local scene with only the 3D points and the new camera.
+  camera::Pinhole * pinhole_cam = dynamic_cast<camera::Pinhole *>(optionalIntrinsic.get());
+  const bool b_new_intrinsic = (optionalIntrinsic == nullptr) || (pinhole_cam && !pinhole_cam->isValid());
+  // A valid pose has been found (try to refine it):
+  // If no valid intrinsic as input:
+  //  init a new one from the projection matrix decomposition
+  // Else use the existing one and consider it as constant.
+  if (b_new_intrinsic)
   {
-    camera::Pinhole * pinhole_cam = dynamic_cast<camera::Pinhole *>(optionalIntrinsic.get());
-    const bool b_new_intrinsic = (optionalIntrinsic == nullptr) || (pinhole_cam && !pinhole_cam->isValid());
-    // A valid pose has been found (try to refine it):
-    // If no valid intrinsic as input:
-    //  init a new one from the projection matrix decomposition
-    // Else use the existing one and consider it as constant.
-    if (b_new_intrinsic)
-    {
-      // setup a default camera model from the found projection matrix
-      Mat3 K, R;
-      Vec3 t;
-      KRt_From_P(resection_data.projection_matrix, &K, &R, &t);
+    // setup a default camera model from the found projection matrix
+    Mat3 K, R;
+    Vec3 t;
+    KRt_From_P(resection_data.projection_matrix, &K, &R, &t);
 
-      const double focal = (K(0,0) + K(1,1))/2.0;
-      const Vec2 principal_point(K(0,2), K(1,2));
+    const double focal = (K(0,0) + K(1,1))/2.0;
+    const Vec2 principal_point(K(0,2), K(1,2));
 
-      if(optionalIntrinsic == nullptr)
-      {
-        // Create the new camera intrinsic group
-        optionalIntrinsic = createPinholeIntrinsic(_camType, view_I->getWidth(), view_I->getHeight(), focal, principal_point(0), principal_point(1));
-      }
-      else if(pinhole_cam)
-      {
-        // Fill the uninitialized camera intrinsic group
-        pinhole_cam->setK(focal, principal_point(0), principal_point(1));
-      }
+    if(optionalIntrinsic == nullptr)
+    {
+      // Create the new camera intrinsic group
+      optionalIntrinsic = createPinholeIntrinsic(_camType, view_I->getWidth(), view_I->getHeight(), focal, principal_point(0), principal_point(1));
     }
-    const std::set<IndexT> reconstructedIntrinsics = _sfm_data.getReconstructedIntrinsics();
-    // If we use a camera intrinsic for the first time we need to refine it.
-    const bool intrinsicsFirstUsage = (reconstructedIntrinsics.count(view_I->getIntrinsicId()) == 0);
-
-    if(!sfm::SfMLocalizer::RefinePose(
-      optionalIntrinsic.get(), pose,
-      resection_data, true, b_new_intrinsic || intrinsicsFirstUsage))
+    else if(pinhole_cam)
     {
-      ALICEVISION_LOG_DEBUG("Resection of view " << viewIndex << " failed during pose refinement.");
-      return false;
+      // Fill the uninitialized camera intrinsic group
+      pinhole_cam->setK(focal, principal_point(0), principal_point(1));
     }
+  }
+  const std::set<IndexT> reconstructedIntrinsics = _sfm_data.getReconstructedIntrinsics();
+  // If we use a camera intrinsic for the first time we need to refine it.
+  const bool intrinsicsFirstUsage = (reconstructedIntrinsics.count(view_I->getIntrinsicId()) == 0);
 
-    // E. Update the global scene with the new found camera pose, intrinsic (if not defined)
+  resectionData.intrinsic = optionalIntrinsic;
+  resectionData.isNewIntrinsic = b_new_intrinsic;
+  resectionData.isIntrinsicRefined = b_new_intrinsic || intrinsicsFirstUsage;
 
-    // update the view pose or rig pose/sub-pose
-    _map_ACThreshold.insert(std::make_pair(viewIndex, resection_data.error_max));
+  if(!sfm::SfMLocalizer::RefinePose(
+    optionalIntrinsic.get(), pose,
+    resection_data, true, resectionData.isIntrinsicRefined))
+  {
+    ALICEVISION_LOG_DEBUG("Resection of view " << viewIndex << " failed during pose refinement.");
+    return false;
+  }
+  return true;
+}
 
-    const View& view = *_sfm_data.views.at(viewIndex);
-    _sfm_data.setPose(view, pose);
+/**
+ * E. Update the global scene with the new found camera pose, intrinsic (if not defined)
+ * F. Update the observations into the global scene structure
+ */
+void ReconstructionEngine_sequentialSfM::updateScene(const ResectionData& resectionData)
+{
+  const IndexT viewIndex = resectionData.viewId;
+  const View& view = *_sfm_data.views.at(viewIndex);
+  const std::shared_ptr<camera::IntrinsicBase> sceneIntrinsic = _sfm_data.GetIntrinsicSharedPtr(view.getIntrinsicId());
 
-    if (b_new_intrinsic)
+  // E. Update the global scene with the new found camera pose, intrinsic (if not defined)
+  if(sceneIntrinsic == nullptr)
+  {
+    // Since the view have not yet an intrinsic group before, create a new one
+    IndexT new_intrinsic_id = 0;
+    if (!_sfm_data.GetIntrinsics().empty())
     {
-      // Since the view have not yet an intrinsic group before, create a new one
-      IndexT new_intrinsic_id = 0;
-      if (!_sfm_data.GetIntrinsics().empty())
-      {
-        // Since some intrinsic Id already exists,
-        //  we have to create a new unique identifier following the existing one
-        std::set<IndexT> existing_intrinsicId;
-          std::transform(_sfm_data.GetIntrinsics().begin(), _sfm_data.GetIntrinsics().end(),
-          std::inserter(existing_intrinsicId, existing_intrinsicId.begin()),
-          stl::RetrieveKey());
-        new_intrinsic_id = (*existing_intrinsicId.rbegin())+1;
-      }
-      _sfm_data.views.at(viewIndex).get()->setIntrinsicId(new_intrinsic_id);
-      _sfm_data.intrinsics[new_intrinsic_id]= optionalIntrinsic;
+      // Since some intrinsic Id already exists,
+      //  we have to create a new unique identifier following the existing one
+      std::set<IndexT> existing_intrinsicId;
+        std::transform(_sfm_data.GetIntrinsics().begin(), _sfm_data.GetIntrinsics().end(),
+        std::inserter(existing_intrinsicId, existing_intrinsicId.begin()),
+        stl::RetrieveKey());
+      new_intrinsic_id = (*existing_intrinsicId.rbegin())+1;
     }
+    _sfm_data.views.at(viewIndex).get()->setIntrinsicId(new_intrinsic_id);
+    _sfm_data.intrinsics[new_intrinsic_id] = resectionData.intrinsic;
   }
+  else if(resectionData.isIntrinsicRefined &&
+          _sfm_data.getReconstructedIntrinsics().count(view.getIntrinsicId()) == 0)
+  {
+    // Keep the intrinsic refined by the first added view using it
+    sceneIntrinsic->assign(*resectionData.intrinsic);
+  }
+
+  // update the view pose or rig pose/sub-pose
+  _map_ACThreshold.insert(std::make_pair(viewIndex, resectionData.matchData.error_max));
+  _sfm_data.setPose(view, resectionData.pose);
 
   // F. Update the observations into the global scene structure
   // - Add the new 2D observations to the reconstructed tracks
-  iterTrackId = set_trackIdForResection.begin();
-  for (std::size_t i = 0; i < resection_data.pt2D.cols(); ++i, ++iterTrackId)
+  const ImageLocalizerMatchData& resection_data = resectionData.matchData;
+  for (std::size_t i = 0; i < resection_data.pt2D.cols(); ++i)
   {
     const Vec3 X = resection_data.pt3D.col(i);
     const Vec2 x = resection_data.pt2D.col(i);
-    const Vec2 residual = optionalIntrinsic->residual(pose, X, x);
+    const Vec2 residual = resectionData.intrinsic->residual(resectionData.pose, X, x);
     if (residual.norm() < resection_data.error_max &&
-        pose.depth(X) > 0)
+        resectionData.pose.depth(X) > 0)
     {
       // Inlier, add the point to the reconstructed track
-      _sfm_data.structure[*iterTrackId].observations[viewIndex] = Observation(x, vec_featIdForResection[i].second);
+      _sfm_data.structure[resectionData.trackIds[i]].observations[viewIndex] = Observation(x, resectionData.featureIds[i].second);
     }
   }
+}
 
-  return true;
+void ReconstructionEngine_sequentialSfM::logResection(const ResectionData& resectionData, bool success)
+{
+  if (_sLoggingFile.empty() || !resectionData.isLocalizationRun)
+    return;
+
+  using namespace htmlDocument;
+  const View& view = *_sfm_data.views.at(resectionData.viewId);
+  const ImageLocalizerMatchData& resection_data = resectionData.matchData;
+  const std::size_t nbPoints = resectionData.featureIds.size();
+
+  std::ostringstream os;
+  os << "Robust resection of view " << resectionData.viewId << ": <br>";
+  _htmlDocStream->pushInfo(htmlMarkup("h4",os.str()));
+
+  os.str("");
+  os << std::endl
+    << "- Image path: " << view.getImagePath() << "<br>"
+    << "- Threshold: " << resection_data.error_max << "<br>"
+    << "- Resection status: " << (success ? "OK" : "FAILED") << "<br>"
+    << "- # points used for Resection: " << nbPoints << "<br>"
+    << "- # points validated by robust estimation: " << resection_data.vec_inliers.size() << "<br>"
+    << "- % points validated: "
+    << resection_data.vec_inliers.size()/static_cast<float>(nbPoints) << "<br>";
+  _htmlDocStream->pushInfo(os.str());
 }
 
 void ReconstructionEngine_sequentialSfM::triangulate(SfMData& scene, const std::set<IndexT>& previousReconstructedViews, const std::set<IndexT>& newReconstructedViews)
 {
+  ALICEVISION_TRACE_SCOPE("sfm.triangulate", newReconstructedViews.size());
   {
     std::vector<IndexT> intersection;
     std::set_intersection(
@@ -1482,173 +1517,233 @@ void ReconstructionEngine_sequentialSfM::triangulate(SfMData& scene, const std::
     assert(intersection.empty());
   }
 
-  std::set<IndexT> reconstructedViews;
-  reconstructedViews.insert(previousReconstructedViews.begin(), previousReconstructedViews.end());
-  reconstructedViews.insert(newReconstructedViews.begin(), newReconstructedViews.end());
+  // Reconstructed views, by dense index in the sorted view ids
+  struct ReconstructedView
+  {
+    Pose3 pose;
+    const IntrinsicBase* intrinsic;
+    Mat34 P;
+    double acThreshold;
+    bool isNew;
+  };
+
+  std::vector<IndexT> reconstructedViewIds;
+  reconstructedViewIds.reserve(previousReconstructedViews.size() + newReconstructedViews.size());
+  std::merge(previousReconstructedViews.begin(), previousReconstructedViews.end(),
+             newReconstructedViews.begin(), newReconstructedViews.end(),
+             std::back_inserter(reconstructedViewIds));
+
+  std::vector<ReconstructedView> reconstructedViews(reconstructedViewIds.size());
+  for(std::size_t v = 0; v < reconstructedViewIds.size(); ++v)
+  {
+    const IndexT viewId = reconstructedViewIds[v];
+    const View& view = *scene.GetViews().at(viewId);
+    ReconstructedView& reconstructedView = reconstructedViews[v];
+    reconstructedView.pose = scene.getPose(view);
+    reconstructedView.intrinsic = scene.GetIntrinsics().at(view.getIntrinsicId()).get();
+    reconstructedView.P = reconstructedView.intrinsic->get_projective_equivalent(reconstructedView.pose);
+    // TODO assert(acThresholdIt != _map_ACThreshold.end());
+    const auto acThresholdIt = _map_ACThreshold.find(viewId);
+    reconstructedView.acThreshold = (acThresholdIt != _map_ACThreshold.end()) ? acThresholdIt->second : 4.0;
+    reconstructedView.isNew = (newReconstructedViews.count(viewId) != 0);
+  }
 
-  #pragma omp parallel for schedule(dynamic)
-  for (ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(reconstructedViews.size()); ++i)
+  // Candidate tracks: the tracks seen by at least one new view
+  std::vector<std::size_t> candidateTracks;
+  for(const IndexT viewId : newReconstructedViews)
   {
-    std::set<IndexT>::const_iterator iter = reconstructedViews.begin();
-    std::advance(iter, i);
-    const IndexT indexPrev = *iter;
+    const auto tracksIt = _map_tracksPerView.find(viewId);
+    if(tracksIt != _map_tracksPerView.end())
+      candidateTracks.insert(candidateTracks.end(), tracksIt->second.begin(), tracksIt->second.end());
+  }
+  std::sort(candidateTracks.begin(), candidateTracks.end());
+  candidateTracks.erase(std::unique(candidateTracks.begin(), candidateTracks.end()), candidateTracks.end());
 
-    for(IndexT indexNew: newReconstructedViews)
-    {
-      if(indexPrev == indexNew)
-        continue;
+  // Observation of a candidate track in a reconstructed view
+  struct TrackObservation
+  {
+    std::size_t view;
+    IndexT featId;
+    Vec2 x;
+  };
 
-      const std::size_t I = std::min((IndexT)indexNew, indexPrev);
-      const std::size_t J = std::max((IndexT)indexNew, indexPrev);
+  // Landmark created or extended by a candidate track
+  struct TriangulatedTrack
+  {
+    std::size_t trackId;
+    bool isNewLandmark;
+    Vec3 X;
+    feature::EImageDescriberType descType;
+    std::vector<std::pair<IndexT, Observation>> observations;
+  };
+
+  // Small angles lead to imprecise triangulations
+  const double minAngle = 3.0;
+  const double maxCosAngle = std::cos(D2R(minAngle));
 
-      // Find track correspondences between I and J
-      const std::set<std::size_t> set_viewIndex = { I, J };
-      track::TracksMap map_tracksCommonIJ;
-      track::TracksUtilsMap::GetTracksInImagesFast(set_viewIndex, _map_tracks, _map_tracksPerView, map_tracksCommonIJ);
+  // Each thread triangulates tracks in its own buffer, the scene is read-only meanwhile
+  std::vector<std::vector<TriangulatedTrack>> triangulatedTracksPerThread(omp_get_max_threads());
 
-      const View* viewI = scene.GetViews().at(I).get();
-      const View* viewJ = scene.GetViews().at(J).get();
-      const IntrinsicBase* camI = scene.GetIntrinsics().at(viewI->getIntrinsicId()).get();
-      const IntrinsicBase* camJ = scene.GetIntrinsics().at(viewJ->getIntrinsicId()).get();
-      const Pose3 poseI = scene.getPose(*viewI);
-      const Pose3 poseJ = scene.getPose(*viewJ);
+  #pragma omp parallel
+  {
+    std::vector<TriangulatedTrack>& triangulatedTracks = triangulatedTracksPerThread[omp_get_thread_num()];
+    std::vector<TrackObservation> observations;
+    std::vector<Vec3> rays;
+
+    #pragma omp for schedule(dynamic, 64)
+    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(candidateTracks.size()); ++i)
+    {
+      const std::size_t trackId = candidateTracks[i];
+      const track::Track& track = _map_tracks.at(trackId);
 
-      std::size_t new_putative_track = 0, new_added_track = 0, extented_track = 0;
-      for (const std::pair<std::size_t, track::Track >& trackIt : map_tracksCommonIJ)
+      // Observations of the track in the reconstructed views
+      observations.clear();
+      for(const auto& featIt : track.featPerView)
       {
-        const std::size_t trackId = trackIt.first;
-        const track::Track & track = trackIt.second;
+        const auto viewIt = std::lower_bound(reconstructedViewIds.begin(), reconstructedViewIds.end(), featIt.first);
+        if(viewIt == reconstructedViewIds.end() || *viewIt != featIt.first)
+          continue;
+        const Vec2 x = _featuresPerView->getFeatures(featIt.first, track.descType)[featIt.second].coords().cast<double>();
+        observations.push_back({static_cast<std::size_t>(viewIt - reconstructedViewIds.begin()), static_cast<IndexT>(featIt.second), x});
+      }
+      if(observations.size() < 2)
+        continue;
 
-        const Vec2 xI = _featuresPerView->getFeatures(I, track.descType)[track.featPerView.at(I)].coords().cast<double>();
-        const Vec2 xJ = _featuresPerView->getFeatures(J, track.descType)[track.featPerView.at(J)].coords().cast<double>();
+      TriangulatedTrack triangulatedTrack;
+      triangulatedTrack.trackId = trackId;
+      triangulatedTrack.descType = track.descType;
 
-        // test if the track already exists in 3D
-        bool trackIdExists;
-        #pragma omp critical
+      const auto landmarkIt = scene.structure.find(trackId);
+      if(landmarkIt != scene.structure.end())
+      {
+        // 3D point triangulated before, only add image observations if needed
+        triangulatedTrack.isNewLandmark = false;
+        triangulatedTrack.X = landmarkIt->second.X;
+      }
+      else
+      {
+        // A new 3D point must be added:
+        // triangulate the first valid pair of views, with at least one new view
+        triangulatedTrack.isNewLandmark = true;
+
+        rays.resize(observations.size());
+        for(std::size_t o = 0; o < observations.size(); ++o)
         {
-            trackIdExists = scene.structure.find(trackId) != scene.structure.end();
+          const ReconstructedView& view = reconstructedViews[observations[o].view];
+          rays[o] = (view.pose.rotation().transpose() * view.intrinsic->operator()(observations[o].x)).normalized();
         }
-        if (trackIdExists)
+
+        bool isTriangulated = false;
+        for(std::size_t a = 0; a < observations.size() && !isTriangulated; ++a)
         {
-          // 3D point triangulated before, only add image observation if needed
-          #pragma omp critical
+          const ReconstructedView& viewA = reconstructedViews[observations[a].view];
+          for(std::size_t b = a + 1; b < observations.size(); ++b)
           {
-            Landmark& landmark = scene.structure.at(trackId);
-            if (landmark.observations.count(I) == 0)
+            const ReconstructedView& viewB = reconstructedViews[observations[b].view];
+            if(!viewA.isNew && !viewB.isNew)
+              continue;
+
+            // Check triangulation results
+            //  - Check angle (small angle leads imprecise triangulation)
+            //  - Check positive depth
+            //  - Check residual values
+            if(rays[a].dot(rays[b]) >= maxCosAngle)
+              continue;
+
+            Vec3 X_euclidean = Vec3::Zero();
+            TriangulateDLT(viewA.P, viewA.intrinsic->get_ud_pixel(observations[a].x),
+                           viewB.P, viewB.intrinsic->get_ud_pixel(observations[b].x), &X_euclidean);
+
+            if(viewA.pose.depth(X_euclidean) > 0 &&
+               viewB.pose.depth(X_euclidean) > 0 &&
+               viewA.intrinsic->residual(viewA.pose, X_euclidean, observations[a].x).norm() < viewA.acThreshold &&
+               viewB.intrinsic->residual(viewB.pose, X_euclidean, observations[b].x).norm() < viewB.acThreshold)
             {
-              const Vec2 residual = camI->residual(poseI, landmark.X, xI);
-              const auto& acThresholdIt = _map_ACThreshold.find(I);
-              // TODO assert(acThresholdIt != _map_ACThreshold.end());
-              const double acThreshold = (acThresholdIt != _map_ACThreshold.end()) ? acThresholdIt->second : 4.0;
-              if (poseI.depth(landmark.X) > 0 && residual.norm() < std::max(4.0, acThreshold))
-              {
-                landmark.observations[I] = Observation(xI, track.featPerView.at(I));
-                ++extented_track;
-              }
-            }
-            if (landmark.observations.count(J) == 0)
-            {
-              const Vec2 residual = camJ->residual(poseJ, landmark.X, xJ);
-              const auto& acThresholdIt = _map_ACThreshold.find(J);
-              // TODO assert(acThresholdIt != _map_ACThreshold.end());
-              const double acThreshold = (acThresholdIt != _map_ACThreshold.end()) ? acThresholdIt->second : 4.0;
-              if (poseJ.depth(landmark.X) > 0 && residual.norm() < std::max(4.0, acThreshold))
-              {
-                landmark.observations[J] = Observation(xJ, track.featPerView.at(J));
-                ++extented_track;
-              }
+              triangulatedTrack.X = X_euclidean;
+              triangulatedTrack.observations.emplace_back(reconstructedViewIds[observations[a].view], Observation(observations[a].x, observations[a].featId));
+              triangulatedTrack.observations.emplace_back(reconstructedViewIds[observations[b].view], Observation(observations[b].x, observations[b].featId));
+              isTriangulated = true;
+              break;
             }
           }
         }
-        else
-        {
-          // A new 3D point must be added
-          #pragma omp critical
-          {
-            ++new_putative_track;
-          }
-
-          Vec3 X_euclidean = Vec3::Zero();
-          const Vec2 xI_ud = camI->get_ud_pixel(xI);
-          const Vec2 xJ_ud = camJ->get_ud_pixel(xJ);
-          const Mat34 pI = camI->get_projective_equivalent(poseI);
-          const Mat34 pJ = camJ->get_projective_equivalent(poseJ);
-
-          TriangulateDLT(pI, xI_ud, pJ, xJ_ud, &X_euclidean);
+        if(!isTriangulated)
+          continue;
+      }
 
-          // Check triangulation results
-          //  - Check angle (small angle leads imprecise triangulation)
-          //  - Check positive depth
-          //  - Check residual values
-          const double angle = AngleBetweenRay(poseI, camI, poseJ, camJ, xI, xJ);
-          const Vec2 residualI = camI->residual(poseI, X_euclidean, xI);
-          const Vec2 residualJ = camJ->residual(poseJ, X_euclidean, xJ);
+      // Add the observations of the other reconstructed views compatible with the 3D point
+      const Landmark* landmark = (landmarkIt != scene.structure.end()) ? &landmarkIt->second : nullptr;
+      for(const TrackObservation& observation : observations)
+      {
+        const IndexT viewId = reconstructedViewIds[observation.view];
+        if(landmark != nullptr && landmark->observations.count(viewId))
+          continue;
+        if(std::find_if(triangulatedTrack.observations.begin(), triangulatedTrack.observations.end(),
+                        [&](const std::pair<IndexT, Observation>& o) { return o.first == viewId; }) != triangulatedTrack.observations.end())
+          continue;
 
-          // TODO assert(acThresholdIt != _map_ACThreshold.end());
+        const ReconstructedView& view = reconstructedViews[observation.view];
+        const Vec2 residual = view.intrinsic->residual(view.pose, triangulatedTrack.X, observation.x);
+        if(view.pose.depth(triangulatedTrack.X) > 0 && residual.norm() < std::max(4.0, view.acThreshold))
+          triangulatedTrack.observations.emplace_back(viewId, Observation(observation.x, observation.featId));
+      }
 
-          const auto& acThresholdItI = _map_ACThreshold.find(I);
-          const auto& acThresholdItJ = _map_ACThreshold.find(J);
+      if(!triangulatedTrack.observations.empty())
+        triangulatedTracks.push_back(std::move(triangulatedTrack));
+    }
+  }
 
-          const double& acThresholdI = (acThresholdItI != _map_ACThreshold.end()) ? acThresholdItI->second : 4.0;
-          const double& acThresholdJ = (acThresholdItJ != _map_ACThreshold.end()) ? acThresholdItJ->second : 4.0;
+  // Merge the thread buffers into the scene, by track id
+  std::vector<TriangulatedTrack> triangulatedTracks;
+  for(std::vector<TriangulatedTrack>& threadTracks : triangulatedTracksPerThread)
+    std::move(threadTracks.begin(), threadTracks.end(), std::back_inserter(triangulatedTracks));
+  std::sort(triangulatedTracks.begin(), triangulatedTracks.end(),
+            [](const TriangulatedTrack& a, const TriangulatedTrack& b) { return a.trackId < b.trackId; });
 
-          if (angle > 3.0 &&
-              poseI.depth(X_euclidean) > 0 &&
-              poseJ.depth(X_euclidean) > 0 &&
-              residualI.norm() < acThresholdI &&
-              residualJ.norm() < acThresholdJ)
-          {
-            #pragma omp critical
-            {
-              // Add a new track
-              Landmark & landmark = scene.structure[trackId];
-              landmark.X = X_euclidean;
-              landmark.descType = track.descType;
-
-              landmark.observations[I] = Observation(xI, track.featPerView.at(I));
-              landmark.observations[J] = Observation(xJ, track.featPerView.at(J));
-
-              ++new_added_track;
-            } // critical
-          } // 3D point is valid
-        } // else (New 3D point)
-      }// for all correspondences
+  std::size_t nbNewLandmarks = 0;
+  std::size_t nbNewObservations = 0;
+  for(TriangulatedTrack& triangulatedTrack : triangulatedTracks)
+  {
+    Landmark& landmark = scene.structure[triangulatedTrack.trackId];
+    if(triangulatedTrack.isNewLandmark)
+    {
+      landmark.X = triangulatedTrack.X;
+      landmark.descType = triangulatedTrack.descType;
+      ++nbNewLandmarks;
     }
-
-//  #pragma omp critical
-//  if (!map_tracksCommonIJ.empty())
-//  {
-//    ALICEVISION_LOG_DEBUG("--Triangulated 3D points [" << I << "-" << J << "]:\n"
-//                      "\t#Track extented: " << extented_track << "\n"
-//                      "\t#Validated/#Possible: " << new_added_track << "/" << new_putative_track << "\n"
-//                      "\t#3DPoint for the entire scene: " << scene.GetLandmarks().size());
-//  }
+    for(auto& observation : triangulatedTrack.observations)
+      landmark.observations[observation.first] = std::move(observation.second);
+    nbNewObservations += triangulatedTrack.observations.size();
   }
+
+  ALICEVISION_LOG_DEBUG("Triangulation of " << candidateTracks.size() << " candidate tracks:\n"
+                        "\t- # new 3D points: " << nbNewLandmarks << "\n"
+                        "\t- # new observations: " << nbNewObservations << "\n"
+                        "\t- # 3D points in the scene: " << scene.GetLandmarks().size());
 }
 
 /// Bundle adjustment to refine Structure; Motion and Intrinsics
 bool ReconstructionEngine_sequentialSfM::BundleAdjustment(bool fixedIntrinsics)
 {
+  // dense, sparse or iterative BA according to the number of poses
   BundleAdjustmentCeres::BA_options options;
-  if (_sfm_data.GetPoses().size() > 100)
-  {
-    ALICEVISION_LOG_DEBUG("Global BundleAdjustment sparse");
-    options.setSparseBA();
-  }
-  else
-  {
-    ALICEVISION_LOG_DEBUG("Global BundleAdjustment dense");
-    options.setDenseBA();
-  }
+  options.setAutomaticBA();
   BundleAdjustmentCeres bundle_adjustment_obj(options);
   BA_Refine refineOptions = BA_REFINE_ROTATION | BA_REFINE_TRANSLATION | BA_REFINE_STRUCTURE;
   if(!fixedIntrinsics)
     refineOptions |= BA_REFINE_INTRINSICS_ALL;
-  return bundle_adjustment_obj.Adjust(_sfm_data, refineOptions);
+  const bool success = bundle_adjustment_obj.Adjust(_sfm_data, refineOptions);
+
+  // Export the sizes & timings of each bundle adjustment
+  if (!_sLoggingFile.empty())
+    bundle_adjustment_obj.exportStatistics(stlplus::create_filespec(_sOutDirectory, "bundleAdjustmentStats", "txt"));
+
+  return success;
 }
 
 bool ReconstructionEngine_sequentialSfM::localBundleAdjustment(const std::set<IndexT>& newReconstructedViews)
 {
+  ALICEVISION_TRACE_SCOPE("sfm.localBundleAdjustment", newReconstructedViews.size());
   
   // -- Manage Ceres options (parameter ordering, local BA, sparse/dense mode, etc.)
   
@@ -9,6 +9,8 @@
 #include "aliceVision/sfm/pipeline/ReconstructionEngine.hpp"
 #include "aliceVision/feature/FeaturesPerView.hpp"
 #include "aliceVision/sfm/pipeline/pairwiseMatchesIO.hpp"
+#include "aliceVision/sfm/pipeline/localization/SfMLocalizer.hpp"
+#include "aliceVision/sfm/pipeline/sequential/NextBestViewIndex.hpp"
 #include "aliceVision/track/Track.hpp"
 #include "aliceVision/sfm/LocalBundleAdjustmentData.hpp"
 
@@ -166,7 +168,7 @@ private:
    */
   bool FindConnectedViews(
     std::vector<ViewConnectionScore>& out_connectedViews,
-    const std::set<size_t>& remainingViewIds) const;
+    const std::set<size_t>& remainingViewIds);
 
   /**
    * @brief Estimate the best images on which we can compute the resectioning safely.
@@ -179,14 +181,46 @@ private:
    */
   bool FindNextImagesGroupForResection(
     std::vector<size_t>& out_selectedViewIds,
-    const std::set<size_t>& remainingViewIds) const;
+    const std::set<size_t>& remainingViewIds);
+
+  /// Camera pose of a view estimated against the current scene, not yet added to the scene
+  struct ResectionData
+  {
+    IndexT viewId = UndefinedIndexT;
+    /// 2D-3D associations and robust estimation result
+    ImageLocalizerMatchData matchData;
+    /// reconstructed tracks used for the resection, ordered as the matchData columns
+    std::vector<std::size_t> trackIds;
+    std::vector<track::TracksUtilsMap::FeatureId> featureIds;
+    /// true if the robust estimation has been run
+    bool isLocalizationRun = false;
+    geometry::Pose3 pose;
+    /// copy of the view intrinsic used to refine the pose
+    std::shared_ptr<camera::IntrinsicBase> intrinsic;
+    /// the view has no valid intrinsic in the scene
+    bool isNewIntrinsic = false;
+    /// the intrinsic has been refined with the pose
+    bool isIntrinsicRefined = false;
+  };
 
   /**
-   * @brief Add a single Image to the scene and triangulate new possible tracks.
-   * @param imageIndex
+   * @brief Compute the camera pose of a view from its 2D-3D associations,
+   * without modifying the scene (can be called concurrently).
+   * @param[in] viewIndex: the view to localize
+   * @param[out] resectionData: the estimated pose and its inliers
    * @return false if resection failed
    */
-  bool Resection(const size_t imageIndex);
+  bool computeResection(const IndexT viewIndex, ResectionData& resectionData) const;
+
+  /**
+   * @brief Add a resected view to the scene: update the view pose or rig pose/sub-pose,
+   * its intrinsic and add its inliers observations to the reconstructed tracks.
+   * @param[in] resectionData: a successful resection
+   */
+  void updateScene(const ResectionData& resectionData);
+
+  /// Log a resection in the HTML report
+  void logResection(const ResectionData& resectionData, bool success);
 
   /**
    * @brief  Triangulate new possible 2D tracks
@@ -258,6 +292,8 @@ private:
   track::TracksPerView _map_tracksPerView;
   /// Precomputed pyramid index for each trackId of each viewId.
   track::TracksPyramidPerView _map_featsPyramidPerView;
+  /// Incremental next best view scores, updated with the reconstructed landmarks
+  NextBestViewIndex _nextBestViewIndex;
   /// Per camera confidence (A contrario estimated threshold error)
   HashMap<IndexT, double> _map_ACThreshold;
   
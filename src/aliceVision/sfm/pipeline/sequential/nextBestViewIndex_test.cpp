@@ -0,0 +1,130 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/pipeline/sequential/NextBestViewIndex.hpp>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <set>
+#include <vector>
+
+#define BOOST_TEST_MODULE nextBestViewIndex
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::sfm;
+
+/**
+ * @brief Score of a view recomputed from scratch, as in ReconstructionEngine_sequentialSfM::computeImageScore.
+ */
+std::size_t computeImageScore(const track::TracksPyramidPerView& tracksPyramidPerView,
+                              const std::vector<int>& pyramidWeights,
+                              std::size_t viewId,
+                              const std::vector<std::size_t>& trackIds)
+{
+  const std::size_t pyramidDepth = pyramidWeights.size();
+  const auto& featsPyramid = tracksPyramidPerView.at(viewId);
+  std::size_t score = 0;
+  for(std::size_t level = 0; level < pyramidDepth; ++level)
+  {
+    std::set<std::size_t> featIndexes;
+    for(std::size_t trackId : trackIds)
+      featIndexes.insert(featsPyramid.at(trackId * pyramidDepth + level));
+    score += featIndexes.size() * pyramidWeights[level];
+  }
+  return score;
+}
+
+BOOST_AUTO_TEST_CASE(NextBestViewIndex_incrementalScores)
+{
+  std::mt19937 generator(0);
+
+  const std::size_t nbViews = 20;
+  const std::size_t nbTracks = 2000;
+  const std::size_t pyramidBase = 2;
+  const std::vector<int> pyramidWeights = {16, 8, 4, 2, 1};
+  const std::size_t pyramidDepth = pyramidWeights.size();
+
+  // random tracks visible in 2 to 6 views, with random positions in the images
+  track::TracksPerView tracksPerView;
+  track::TracksPyramidPerView tracksPyramidPerView;
+  std::uniform_int_distribution<std::size_t> viewDistribution(0, nbViews - 1);
+  std::uniform_int_distribution<std::size_t> lengthDistribution(2, 6);
+  std::uniform_real_distribution<double> positionDistribution(0.0, 1.0);
+
+  for(std::size_t trackId = 0; trackId < nbTracks; ++trackId)
+  {
+    std::set<std::size_t> views;
+    const std::size_t length = lengthDistribution(generator);
+    while(views.size() < length)
+      views.insert(viewDistribution(generator));
+
+    for(const std::size_t viewId : views)
+    {
+      tracksPerView[viewId].push_back(trackId);
+      const double x = positionDistribution(generator);
+      const double y = positionDistribution(generator);
+      std::size_t start = 0;
+      for(std::size_t level = 0; level < pyramidDepth; ++level)
+      {
+        const std::size_t width = std::pow(pyramidBase, level + 1);
+        const std::size_t cell = std::size_t(x * width) + std::size_t(y * width) * width;
+        tracksPyramidPerView[viewId][trackId * pyramidDepth + level] = start + cell;
+        start += width * width;
+      }
+    }
+  }
+
+  NextBestViewIndex index;
+  index.build(tracksPerView, tracksPyramidPerView, pyramidWeights);
+  BOOST_CHECK_EQUAL(index.getRanking().size(), tracksPerView.size());
+
+  // add and remove landmarks, and compare the scores with the full computation
+  Landmarks landmarks;
+  std::uniform_int_distribution<std::size_t> trackDistribution(0, nbTracks - 1);
+  std::uniform_real_distribution<double> removeDistribution(0.0, 1.0);
+
+  for(int step = 0; step < 20; ++step)
+  {
+    for(int i = 0; i < 100; ++i)
+      landmarks[trackDistribution(generator)] = Landmark();
+
+    for(auto it = landmarks.begin(); it != landmarks.end();)
+    {
+      if(removeDistribution(generator) < 0.1)
+        it = landmarks.erase(it);
+      else
+        ++it;
+    }
+
+    index.update(landmarks);
+    BOOST_CHECK_EQUAL(index.getNbReconstructedTracks(), landmarks.size());
+
+    std::size_t previousScore = std::numeric_limits<std::size_t>::max();
+    IndexT previousViewId = 0;
+    for(const NextBestViewIndex::RankedView& rankedView : index.getRanking())
+    {
+      const IndexT viewId = rankedView.second;
+      std::vector<std::size_t> reconstructedTracks;
+      for(const std::size_t trackId : tracksPerView.at(viewId))
+      {
+        if(landmarks.count(trackId))
+          reconstructedTracks.push_back(trackId);
+      }
+
+      const std::size_t score = computeImageScore(tracksPyramidPerView, pyramidWeights, viewId, reconstructedTracks);
+      BOOST_CHECK_EQUAL(rankedView.first, score);
+      BOOST_CHECK_EQUAL(index.getScore(viewId), score);
+      BOOST_CHECK_EQUAL(index.getNbReconstructedTracks(viewId), reconstructedTracks.size());
+
+      // decreasing scores, then increasing view ids
+      BOOST_CHECK(score < previousScore || (score == previousScore && viewId > previousViewId));
+      previousScore = score;
+      previousViewId = viewId;
+    }
+  }
+}
@@ -16,6 +16,12 @@
 
 #include <boost/progress.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
 namespace aliceVision {
 namespace sfm {
 
@@ -77,82 +83,250 @@ void StructureEstimationFromKnownPoses::match(
   boost::progress_display my_progress_bar( pairs.size(), std::cout,
     "Compute pairwise fundamental guided matching:\n" );
 
+  // flat list of pairs, the matches are merged in the pairs order
+  const PairVec pairsVec(pairs.begin(), pairs.end());
+  std::vector<matching::MatchesPerDescType> matchesPerPair(pairsVec.size());
+  std::vector<char> isPairMatched(pairsVec.size(), 0);
+
   #pragma omp parallel
-  for (PairSet::const_iterator it = pairs.begin(); it != pairs.end(); ++it)
   {
-    #pragma omp single nowait
-    {
-    // --
-    // Perform GUIDED MATCHING
-    // --
-    // Use the computed model to check valid correspondences
-    // - by considering geometric error and descriptor distance ratio.
-
-    const View * viewL = sfm_data.GetViews().at(it->first).get();
-    const Pose3 poseL = sfm_data.getPose(*viewL);
-    const Intrinsics::const_iterator iterIntrinsicL = sfm_data.GetIntrinsics().find(viewL->getIntrinsicId());
-    const View * viewR = sfm_data.GetViews().at(it->second).get();
-    const Pose3 poseR = sfm_data.getPose(*viewR);
-    const Intrinsics::const_iterator iterIntrinsicR = sfm_data.GetIntrinsics().find(viewR->getIntrinsicId());
-
-    if (sfm_data.GetIntrinsics().count(viewL->getIntrinsicId()) != 0 ||
-        sfm_data.GetIntrinsics().count(viewR->getIntrinsicId()) != 0)
+    // guided matching buffers of the thread
+    robustEstimation::GuidedMatchingFundamentalBuffers buffers;
+
+    #pragma omp for schedule(dynamic)
+    for (int p = 0; p < static_cast<int>(pairsVec.size()); ++p)
     {
-      const Mat34 P_L = iterIntrinsicL->second.get()->get_projective_equivalent(poseL);
-      const Mat34 P_R = iterIntrinsicR->second.get()->get_projective_equivalent(poseR);
-
-      const Mat3 F_lr = F_from_P(P_L, P_R);
-      const double thresholdF = 4.0;
-      std::vector<feature::EImageDescriberType> commonDescTypes = regionsPerView.getCommonDescTypes(*it);
-      
-      matching::MatchesPerDescType allImagePairMatches;
-      for(feature::EImageDescriberType descType: commonDescTypes)
+      // --
+      // Perform GUIDED MATCHING
+      // --
+      // Use the computed model to check valid correspondences
+      // - by considering geometric error and descriptor distance ratio.
+
+      const Pair & pair = pairsVec[p];
+      const View * viewL = sfm_data.GetViews().at(pair.first).get();
+      const View * viewR = sfm_data.GetViews().at(pair.second).get();
+      const Intrinsics::const_iterator iterIntrinsicL = sfm_data.GetIntrinsics().find(viewL->getIntrinsicId());
+      const Intrinsics::const_iterator iterIntrinsicR = sfm_data.GetIntrinsics().find(viewR->getIntrinsicId());
+
+      if (iterIntrinsicL != sfm_data.GetIntrinsics().end() &&
+          iterIntrinsicR != sfm_data.GetIntrinsics().end())
       {
-        std::vector<matching::IndMatch> matches;
-      #ifdef EXHAUSTIVE_MATCHING
-        robustEstimation::GuidedMatching
-          <Mat3, fundamental::kernel::EpipolarDistanceError>
-          (
-            F_lr,
-            iterIntrinsicL->second.get(),
-            regionsPerView.getRegions(it->first),
-            iterIntrinsicR->second.get(),
-            regionsPerView.getRegions(it->second),
-            descType,
-            Square(thresholdF), Square(0.8),
-            matches
-          );
-      #else
-        const Vec3 epipole2  = epipole_from_P(P_R, poseL);
-
-        //const feature::Regions& regions = regionsPerView.getRegions(it->first);
-        robustEstimation::GuidedMatching_Fundamental_Fast
-          <fundamental::kernel::EpipolarDistanceError>
-          (
-            F_lr,
-            epipole2,
-            iterIntrinsicL->second.get(),
-            regionsPerView.getRegions(it->first, descType),
-            iterIntrinsicR->second.get(),
-            regionsPerView.getRegions(it->second, descType),
-            iterIntrinsicR->second->w(), iterIntrinsicR->second->h(),
-            //descType,
-            Square(thresholdF), Square(0.8),
-            matches
-          );
-      #endif
-         allImagePairMatches[descType] = matches;
+        const Pose3 poseL = sfm_data.getPose(*viewL);
+        const Pose3 poseR = sfm_data.getPose(*viewR);
+        const Mat34 P_L = iterIntrinsicL->second.get()->get_projective_equivalent(poseL);
+        const Mat34 P_R = iterIntrinsicR->second.get()->get_projective_equivalent(poseR);
+
+        const Mat3 F_lr = F_from_P(P_L, P_R);
+        const double thresholdF = 4.0;
+        const std::vector<feature::EImageDescriberType> commonDescTypes = regionsPerView.getCommonDescTypes(pair);
+
+        matching::MatchesPerDescType & allImagePairMatches = matchesPerPair[p];
+        for(feature::EImageDescriberType descType: commonDescTypes)
+        {
+          std::vector<matching::IndMatch> & matches = allImagePairMatches[descType];
+        #ifdef EXHAUSTIVE_MATCHING
+          robustEstimation::GuidedMatching
+            <Mat3, fundamental::kernel::EpipolarDistanceError>
+            (
+              F_lr,
+              iterIntrinsicL->second.get(),
+              regionsPerView.getRegions(pair.first),
+              iterIntrinsicR->second.get(),
+              regionsPerView.getRegions(pair.second),
+              descType,
+              Square(thresholdF), Square(0.8),
+              matches
+            );
+        #else
+          const Vec3 epipole2  = epipole_from_P(P_R, poseL);
+
+          robustEstimation::GuidedMatching_Fundamental_Fast
+            <fundamental::kernel::EpipolarDistanceError>
+            (
+              F_lr,
+              epipole2,
+              iterIntrinsicL->second.get(),
+              regionsPerView.getRegions(pair.first, descType),
+              iterIntrinsicR->second.get(),
+              regionsPerView.getRegions(pair.second, descType),
+              iterIntrinsicR->second->w(), iterIntrinsicR->second->h(),
+              Square(thresholdF), Square(0.8),
+              matches,
+              buffers
+            );
+        #endif
+        }
+        isPairMatched[p] = 1;
       }
 
       #pragma omp critical
+      ++my_progress_bar;
+    }
+  }
+
+  for (std::size_t p = 0; p < pairsVec.size(); ++p)
+  {
+    if (isPairMatched[p])
+      _putativeMatches[pairsVec[p]] = std::move(matchesPerPair[p]);
+  }
+}
+
+namespace {
+
+/// Track of a view triplet (I < J < K): one feature per view
+struct TripletTrack
+{
+  feature::EImageDescriberType descType;
+  IndexT featI;
+  IndexT featJ;
+  IndexT featK;
+};
+
+/**
+ * @brief Build the tracks of view triplets with a union-find on the matched features of the 3 pairs.
+ * Only the tracks with exactly one feature per view are kept (as TracksBuilder::Filter(3)).
+ * The buffers are reused from one triplet to the next (i.e. one builder per thread).
+ */
+class TripletTracksBuilder
+{
+public:
+
+  /**
+   * @brief Build the tracks of a triplet
+   * @param[in] matchesPerPair The matches of the pairs IJ, IK and JK (nullptr if not matched)
+   * @param[out] tracks The triplet tracks
+   */
+  void build(const std::array<const matching::MatchesPerDescType*, 3> & matchesPerPair,
+             std::vector<TripletTrack> & tracks)
+  {
+    tracks.clear();
+
+    // the same tracks as TracksBuilder require at least 2 pairs
+    if (std::count(matchesPerPair.begin(), matchesPerPair.end(), nullptr) > 1)
+      return;
+
+    _descTypes.clear();
+    for (const matching::MatchesPerDescType * matchesPerDesc : matchesPerPair)
+    {
+      if (matchesPerDesc == nullptr)
+        continue;
+      for (const auto & matchesIt : *matchesPerDesc)
+        _descTypes.push_back(matchesIt.first);
+    }
+    std::sort(_descTypes.begin(), _descTypes.end());
+    _descTypes.erase(std::unique(_descTypes.begin(), _descTypes.end()), _descTypes.end());
+
+    for (const feature::EImageDescriberType descType : _descTypes)
+      build(matchesPerPair, descType, tracks);
+  }
+
+private:
+
+  static std::uint64_t getNode(std::uint64_t slot, IndexT featIndex)
+  {
+    return (slot << 32) | featIndex;
+  }
+
+  std::size_t getNodeIndex(std::uint64_t node) const
+  {
+    return std::lower_bound(_nodes.begin(), _nodes.end(), node) - _nodes.begin();
+  }
+
+  std::size_t find(std::size_t i)
+  {
+    while (_parents[i] != i)
+    {
+      _parents[i] = _parents[_parents[i]];
+      i = _parents[i];
+    }
+    return i;
+  }
+
+  void build(const std::array<const matching::MatchesPerDescType*, 3> & matchesPerPair,
+             feature::EImageDescriberType descType,
+             std::vector<TripletTrack> & tracks)
+  {
+    // view slots of the pairs IJ, IK, JK
+    const std::uint64_t slots[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+
+    // matched features of the 3 views
+    _nodes.clear();
+    for (std::size_t p = 0; p < 3; ++p)
+    {
+      const matching::IndMatches * matches = getMatches(matchesPerPair[p], descType);
+      if (matches == nullptr)
+        continue;
+      for (const matching::IndMatch & match : *matches)
       {
-        ++my_progress_bar;
-        _putativeMatches[*it] = allImagePairMatches;
+        _nodes.push_back(getNode(slots[p][0], match._i));
+        _nodes.push_back(getNode(slots[p][1], match._j));
       }
     }
+    std::sort(_nodes.begin(), _nodes.end());
+    _nodes.erase(std::unique(_nodes.begin(), _nodes.end()), _nodes.end());
+
+    // union-find
+    _parents.resize(_nodes.size());
+    std::iota(_parents.begin(), _parents.end(), 0);
+    for (std::size_t p = 0; p < 3; ++p)
+    {
+      const matching::IndMatches * matches = getMatches(matchesPerPair[p], descType);
+      if (matches == nullptr)
+        continue;
+      for (const matching::IndMatch & match : *matches)
+      {
+        const std::size_t a = find(getNodeIndex(getNode(slots[p][0], match._i)));
+        const std::size_t b = find(getNodeIndex(getNode(slots[p][1], match._j)));
+        if (a != b)
+          _parents[std::max(a, b)] = std::min(a, b);
+      }
+    }
+
+    // group the features per track
+    _components.clear();
+    for (std::size_t i = 0; i < _nodes.size(); ++i)
+      _components.emplace_back(find(i), i);
+    std::sort(_components.begin(), _components.end());
+
+    for (std::size_t begin = 0; begin < _components.size();)
+    {
+      std::size_t end = begin + 1;
+      while (end < _components.size() && _components[end].first == _components[begin].first)
+        ++end;
+
+      // one feature in each view (the nodes are sorted by view slot)
+      if (end - begin == 3 &&
+          (_nodes[_components[begin].second] >> 32) == 0 &&
+          (_nodes[_components[begin + 1].second] >> 32) == 1 &&
+          (_nodes[_components[begin + 2].second] >> 32) == 2)
+      {
+        tracks.push_back({descType,
+                          static_cast<IndexT>(_nodes[_components[begin].second] & 0xFFFFFFFF),
+                          static_cast<IndexT>(_nodes[_components[begin + 1].second] & 0xFFFFFFFF),
+                          static_cast<IndexT>(_nodes[_components[begin + 2].second] & 0xFFFFFFFF)});
+      }
+      begin = end;
     }
   }
-}
+
+  static const matching::IndMatches * getMatches(const matching::MatchesPerDescType * matchesPerDesc,
+                                                 feature::EImageDescriberType descType)
+  {
+    if (matchesPerDesc == nullptr)
+      return nullptr;
+    const auto it = matchesPerDesc->find(descType);
+    return (it == matchesPerDesc->end()) ? nullptr : &it->second;
+  }
+
+  std::vector<feature::EImageDescriberType> _descTypes;
+  /// matched features: (view slot << 32 | feature index), sorted
+  std::vector<std::uint64_t> _nodes;
+  std::vector<std::size_t> _parents;
+  /// <root, node index>
+  std::vector<std::pair<std::size_t, std::size_t>> _components;
+};
+
+} // namespace
 
 /// Filter inconsistent correspondences by using 3-view correspondences on view triplets
 void StructureEstimationFromKnownPoses::filter(
@@ -167,77 +341,90 @@ void StructureEstimationFromKnownPoses::filter(
   typedef std::vector< graph::Triplet > Triplets;
   const Triplets triplets = graph::tripletListing(pairs);
 
+  // projection matrix and intrinsic of the matched views, computed once
+  HashMap<IndexT, std::size_t> viewIndexes;
+  std::vector<Mat34, Eigen::aligned_allocator<Mat34>> projectionPerView;
+  std::vector<const IntrinsicBase*> intrinsicPerView;
+  for (const auto & pairMatches : _putativeMatches)
+  {
+    for (const IndexT viewId : {pairMatches.first.first, pairMatches.first.second})
+    {
+      if (!viewIndexes.emplace(viewId, projectionPerView.size()).second)
+        continue;
+      const View * view = sfm_data.GetViews().at(viewId).get();
+      const IntrinsicBase * cam = sfm_data.GetIntrinsics().at(view->getIntrinsicId()).get();
+      projectionPerView.push_back(cam->get_projective_equivalent(sfm_data.getPose(*view)));
+      intrinsicPerView.push_back(cam);
+    }
+  }
+
+  // valid tracks of each triplet, merged in the triplets order
+  std::vector<std::vector<TripletTrack>> validTracksPerTriplet(triplets.size());
+
   boost::progress_display my_progress_bar( triplets.size(), std::cout,
     "Per triplet tracks validation (discard spurious correspondences):\n" );
+
   #pragma omp parallel
-  for( Triplets::const_iterator it = triplets.begin(); it != triplets.end(); ++it)
   {
-    #pragma omp single nowait
-    {
-      #pragma omp critical
-      {++my_progress_bar;}
+    // buffers of the thread
+    TripletTracksBuilder tracksBuilder;
+    std::vector<TripletTrack> tracks;
+    Triangulation trianObj;
 
-      const graph::Triplet & triplet = *it;
-      const IndexT I = triplet.i, J = triplet.j , K = triplet.k;
+    #pragma omp for schedule(dynamic)
+    for (int t = 0; t < static_cast<int>(triplets.size()); ++t)
+    {
+      const graph::Triplet & triplet = triplets[t];
+      const IndexT viewIds[3] = {triplet.i, triplet.j, triplet.k};
 
-      track::TracksMap map_tracksCommon;
-      track::TracksBuilder tracksBuilder;
+      std::array<const matching::MatchesPerDescType*, 3> matchesPerPair;
+      const Pair tripletPairs[3] = {{triplet.i, triplet.j}, {triplet.i, triplet.k}, {triplet.j, triplet.k}};
+      for (int p = 0; p < 3; ++p)
       {
-        matching::PairwiseMatches map_matchesIJK;
-        if (_putativeMatches.count(std::make_pair(I,J)))
-          map_matchesIJK.insert(*_putativeMatches.find(std::make_pair(I,J)));
-
-        if (_putativeMatches.count(std::make_pair(I,K)))
-          map_matchesIJK.insert(*_putativeMatches.find(std::make_pair(I,K)));
+        const auto it = _putativeMatches.find(tripletPairs[p]);
+        matchesPerPair[p] = (it == _putativeMatches.end()) ? nullptr : &it->second;
+      }
 
-        if (_putativeMatches.count(std::make_pair(J,K)))
-          map_matchesIJK.insert(*_putativeMatches.find(std::make_pair(J,K)));
+      tracksBuilder.build(matchesPerPair, tracks);
 
-        if (map_matchesIJK.size() >= 2) {
-          tracksBuilder.Build(map_matchesIJK);
-          tracksBuilder.Filter(3, false);
-          tracksBuilder.ExportToSTL(map_tracksCommon);
+      // Triangulate the tracks
+      for (const TripletTrack & track : tracks)
+      {
+        const IndexT featIndexes[3] = {track.featI, track.featJ, track.featK};
+        trianObj.clear();
+        for (int v = 0; v < 3; ++v)
+        {
+          const std::size_t viewIndex = viewIndexes.at(viewIds[v]);
+          const Vec2 pt = regionsPerView.getRegions(viewIds[v], track.descType).GetRegionPosition(featIndexes[v]);
+          trianObj.add(projectionPerView[viewIndex], intrinsicPerView[viewIndex]->get_ud_pixel(pt));
         }
-
-        // Triangulate the tracks
-        for (track::TracksMap::const_iterator iterTracks = map_tracksCommon.begin();
-          iterTracks != map_tracksCommon.end(); ++iterTracks) {
-          {
-            const track::Track & subTrack = iterTracks->second;
-            Triangulation trianObj;
-            for (auto iter = subTrack.featPerView.begin(); iter != subTrack.featPerView.end(); ++iter)
-            {
-              const size_t imaIndex = iter->first;
-              const size_t featIndex = iter->second;
-              const View * view = sfm_data.GetViews().at(imaIndex).get();
-              const IntrinsicBase * cam = sfm_data.GetIntrinsics().at(view->getIntrinsicId()).get();
-              const Pose3 pose = sfm_data.getPose(*view);
-              const Vec2 pt = regionsPerView.getRegions(imaIndex, subTrack.descType).GetRegionPosition(featIndex);
-              trianObj.add(cam->get_projective_equivalent(pose), cam->get_ud_pixel(pt));
-            }
-            const Vec3 Xs = trianObj.compute();
-            if (trianObj.minDepth() > 0 && trianObj.error()/(double)trianObj.size() < 4.0)
-            // TODO: Add an angular check ?
-            {
-              #pragma omp critical
-              {
-                track::Track::FeatureIdPerView::const_iterator iterI, iterJ, iterK;
-                iterI = iterJ = iterK = subTrack.featPerView.begin();
-                std::advance(iterJ,1);
-                std::advance(iterK,2);
-
-                _tripletMatches[std::make_pair(I,J)][subTrack.descType].emplace_back(iterI->second, iterJ->second);
-                _tripletMatches[std::make_pair(J,K)][subTrack.descType].emplace_back(iterJ->second, iterK->second);
-                _tripletMatches[std::make_pair(I,K)][subTrack.descType].emplace_back(iterI->second, iterK->second);
-              }
-            }
-          }
+        trianObj.compute();
+        if (trianObj.minDepth() > 0 && trianObj.error()/(double)trianObj.size() < 4.0)
+        // TODO: Add an angular check ?
+        {
+          validTracksPerTriplet[t].push_back(track);
         }
       }
+
+      #pragma omp critical
+      ++my_progress_bar;
     }
   }
+
   // Clear putatives matches since they are no longer required
   matching::PairwiseMatches().swap(_putativeMatches);
+
+  for (std::size_t t = 0; t < triplets.size(); ++t)
+  {
+    const IndexT I = triplets[t].i, J = triplets[t].j , K = triplets[t].k;
+    for (const TripletTrack & track : validTracksPerTriplet[t])
+    {
+      _tripletMatches[std::make_pair(I,J)][track.descType].emplace_back(track.featI, track.featJ);
+      _tripletMatches[std::make_pair(J,K)][track.descType].emplace_back(track.featJ, track.featK);
+      _tripletMatches[std::make_pair(I,K)][track.descType].emplace_back(track.featI, track.featK);
+    }
+    std::vector<TripletTrack>().swap(validTracksPerTriplet[t]);
+  }
 }
 
 /// Init & triangulate landmark observations from validated 3-view correspondences
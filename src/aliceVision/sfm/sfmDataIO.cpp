@@ -103,6 +103,8 @@ bool Load(SfMData& sfmData, const std::string& filename, ESfMData partFlag)
     bStatus = Load_Cereal<cereal::PortableBinaryInputArchive>(sfmData, filename, partFlag);
   else if (ext == "xml")
     bStatus = Load_Cereal<cereal::XMLInputArchive>(sfmData, filename, partFlag);
+  else if (ext == "ply")
+    bStatus = Load_PLY(sfmData, filename, partFlag);
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
   else if (ext == "abc") {
     aliceVision::sfm::AlembicImporter(filename).populate(sfmData, partFlag);
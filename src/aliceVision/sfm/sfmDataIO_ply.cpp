@@ -5,16 +5,296 @@
 
 #include "sfmDataIO_ply.hpp"
 
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <sstream>
+#include <vector>
 
 namespace aliceVision {
 namespace sfm {
 
-/// Save the structure and camera positions of a SfMData container as 3D points in a PLY ASCII file.
- bool Save_PLY(
-  const SfMData & sfm_data,
-  const std::string & filename,
-  ESfMData flags_part)
+namespace {
+
+/// header comment giving the number of camera vertices, written before the landmarks
+const std::string kNbCamerasComment = "aliceVision_nbCameras";
+
+/// number of vertices encoded by a task in ASCII
+const std::size_t kAsciiChunkSize = 65536;
+
+/// A vertex of the PLY file
+struct PLYVertex
+{
+  Vec3 X = Vec3::Zero();
+  Vec3 normal = Vec3::Zero();
+  image::RGBColor color = image::WHITE;
+  std::uint32_t nbObservations = 0;
+};
+
+/// PLY scalar types
+enum class EPLYType
+{
+  INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64, UNKNOWN
+};
+
+/// PLY body encodings
+enum class EPLYFormat
+{
+  ASCII, BINARY_LITTLE_ENDIAN, BINARY_BIG_ENDIAN
+};
+
+struct PLYProperty
+{
+  std::string name;
+  /// type of the values
+  EPLYType type = EPLYType::UNKNOWN;
+  /// type of the number of values for a list
+  EPLYType countType = EPLYType::UNKNOWN;
+  bool isList = false;
+};
+
+struct PLYElement
+{
+  std::string name;
+  std::size_t count = 0;
+  std::vector<PLYProperty> properties;
+};
+
+EPLYType parseType(const std::string& type)
+{
+  if(type == "char" || type == "int8")       return EPLYType::INT8;
+  if(type == "uchar" || type == "uint8")     return EPLYType::UINT8;
+  if(type == "short" || type == "int16")     return EPLYType::INT16;
+  if(type == "ushort" || type == "uint16")   return EPLYType::UINT16;
+  if(type == "int" || type == "int32")       return EPLYType::INT32;
+  if(type == "uint" || type == "uint32")     return EPLYType::UINT32;
+  if(type == "float" || type == "float32")   return EPLYType::FLOAT32;
+  if(type == "double" || type == "float64")  return EPLYType::FLOAT64;
+  return EPLYType::UNKNOWN;
+}
+
+std::size_t getTypeSize(EPLYType type)
+{
+  switch(type)
+  {
+    case EPLYType::INT8:
+    case EPLYType::UINT8:   return 1;
+    case EPLYType::INT16:
+    case EPLYType::UINT16:  return 2;
+    case EPLYType::INT32:
+    case EPLYType::UINT32:
+    case EPLYType::FLOAT32: return 4;
+    case EPLYType::FLOAT64: return 8;
+    default:                return 0;
+  }
+}
+
+inline void writeLittleEndian(std::uint32_t value, char* buffer)
+{
+  buffer[0] = static_cast<char>(value & 0xFF);
+  buffer[1] = static_cast<char>((value >> 8) & 0xFF);
+  buffer[2] = static_cast<char>((value >> 16) & 0xFF);
+  buffer[3] = static_cast<char>((value >> 24) & 0xFF);
+}
+
+inline void writeLittleEndian(float value, char* buffer)
+{
+  std::uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  writeLittleEndian(bits, buffer);
+}
+
+/// Read a little endian scalar value
+double readLittleEndian(EPLYType type, const char* buffer)
+{
+  std::uint64_t bits = 0;
+  const std::size_t size = getTypeSize(type);
+  for(std::size_t i = 0; i < size; ++i)
+    bits |= static_cast<std::uint64_t>(static_cast<unsigned char>(buffer[i])) << (8 * i);
+
+  switch(type)
+  {
+    case EPLYType::INT8:    return static_cast<std::int8_t>(bits);
+    case EPLYType::INT16:   return static_cast<std::int16_t>(bits);
+    case EPLYType::INT32:   return static_cast<std::int32_t>(bits);
+    case EPLYType::FLOAT32:
+    {
+      const std::uint32_t bits32 = static_cast<std::uint32_t>(bits);
+      float value;
+      std::memcpy(&value, &bits32, sizeof(value));
+      return value;
+    }
+    case EPLYType::FLOAT64:
+    {
+      double value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+    default:                return static_cast<double>(bits);
+  }
+}
+
+/// Size of a binary vertex record
+std::size_t getVertexSize(const PLYExportOptions& options)
+{
+  return 3 * sizeof(float) +
+         (options.withNormals ? 3 * sizeof(float) : 0) +
+         (options.withColors ? 3 : 0) +
+         (options.withObservationsCount ? sizeof(std::uint32_t) : 0);
+}
+
+void encodeBinary(const PLYVertex& vertex, const PLYExportOptions& options, char* buffer)
+{
+  for(int i = 0; i < 3; ++i, buffer += sizeof(float))
+    writeLittleEndian(static_cast<float>(vertex.X(i)), buffer);
+
+  if(options.withNormals)
+  {
+    for(int i = 0; i < 3; ++i, buffer += sizeof(float))
+      writeLittleEndian(static_cast<float>(vertex.normal(i)), buffer);
+  }
+  if(options.withColors)
+  {
+    *buffer++ = static_cast<char>(vertex.color.r());
+    *buffer++ = static_cast<char>(vertex.color.g());
+    *buffer++ = static_cast<char>(vertex.color.b());
+  }
+  if(options.withObservationsCount)
+    writeLittleEndian(vertex.nbObservations, buffer);
+}
+
+void encodeAscii(const PLYVertex& vertex, const PLYExportOptions& options, std::ostream& stream)
+{
+  stream << vertex.X(0) << ' ' << vertex.X(1) << ' ' << vertex.X(2);
+
+  if(options.withNormals)
+    stream << ' ' << vertex.normal(0) << ' ' << vertex.normal(1) << ' ' << vertex.normal(2);
+  if(options.withColors)
+    stream << ' ' << static_cast<int>(vertex.color.r()) << ' ' << static_cast<int>(vertex.color.g()) << ' ' << static_cast<int>(vertex.color.b());
+  if(options.withObservationsCount)
+    stream << ' ' << vertex.nbObservations;
+
+  stream << '\n';
+}
+
+bool readHeader(std::istream& stream, EPLYFormat& format, std::vector<PLYElement>& elements, std::size_t& nbCameras)
+{
+  std::string line;
+  bool hasFormat = false;
+  while(std::getline(stream, line))
+  {
+    if(!line.empty() && line.back() == '\r')
+      line.pop_back();
+
+    std::istringstream lineStream(line);
+    std::string keyword;
+    lineStream >> keyword;
+
+    if(keyword == "ply")
+      continue;
+
+    if(keyword == "format")
+    {
+      std::string formatStr;
+      lineStream >> formatStr;
+      if(formatStr == "ascii")
+        format = EPLYFormat::ASCII;
+      else if(formatStr == "binary_little_endian")
+        format = EPLYFormat::BINARY_LITTLE_ENDIAN;
+      else if(formatStr == "binary_big_endian")
+        format = EPLYFormat::BINARY_BIG_ENDIAN;
+      else
+        return false;
+      hasFormat = true;
+    }
+    else if(keyword == "comment")
+    {
+      std::string name;
+      lineStream >> name;
+      if(name == kNbCamerasComment)
+        lineStream >> nbCameras;
+    }
+    else if(keyword == "element")
+    {
+      PLYElement element;
+      lineStream >> element.name >> element.count;
+      elements.push_back(element);
+    }
+    else if(keyword == "property")
+    {
+      if(elements.empty())
+        return false;
+
+      PLYProperty property;
+      std::string type;
+      lineStream >> type;
+      if(type == "list")
+      {
+        std::string countType;
+        lineStream >> countType >> type;
+        property.isList = true;
+        property.countType = parseType(countType);
+        if(property.countType == EPLYType::UNKNOWN)
+          return false;
+      }
+      lineStream >> property.name;
+      property.type = parseType(type);
+      if(property.type == EPLYType::UNKNOWN)
+        return false;
+      elements.back().properties.push_back(property);
+    }
+    else if(keyword == "end_header")
+    {
+      return hasFormat;
+    }
+    // obj_info and unknown keywords are ignored
+  }
+  return false;
+}
+
+/// Skip the data of an element placed before the vertices
+bool skipElement(std::istream& stream, EPLYFormat format, const PLYElement& element)
+{
+  if(format == EPLYFormat::ASCII)
+  {
+    std::string line;
+    for(std::size_t i = 0; i < element.count; ++i)
+    {
+      if(!std::getline(stream, line))
+        return false;
+    }
+    return true;
+  }
+
+  std::size_t recordSize = 0;
+  for(const PLYProperty& property : element.properties)
+  {
+    // the size of the records is not known
+    if(property.isList)
+      return false;
+    recordSize += getTypeSize(property.type);
+  }
+  stream.ignore(static_cast<std::streamsize>(recordSize * element.count));
+  return stream.good();
+}
+
+} // namespace
+
+bool Save_PLY(const SfMData & sfm_data,
+              const std::string & filename,
+              ESfMData flags_part)
+{
+  return Save_PLY(sfm_data, filename, flags_part, PLYExportOptions());
+}
+
+bool Save_PLY(const SfMData & sfm_data,
+              const std::string & filename,
+              ESfMData flags_part,
+              const PLYExportOptions & options)
 {
   const bool b_structure = (flags_part & STRUCTURE) == STRUCTURE;
   const bool b_extrinsics = (flags_part & EXTRINSICS) == EXTRINSICS;
@@ -22,66 +302,304 @@ namespace sfm {
   if (!(b_structure || b_extrinsics))
     return false;
 
+  // the camera vertices are written first
+  std::vector<PLYVertex> cameras;
+  if(b_extrinsics)
+  {
+    for(const auto & view : sfm_data.GetViews())
+    {
+      if(!sfm_data.IsPoseAndIntrinsicDefined(view.second.get()))
+        continue;
+
+      const geometry::Pose3 pose = sfm_data.getPose(*(view.second.get()));
+      PLYVertex vertex;
+      vertex.X = pose.center();
+      // optical axis
+      vertex.normal = pose.rotation().row(2).transpose();
+      vertex.color = image::RGBColor(0, 255, 0);
+      cameras.push_back(vertex);
+    }
+  }
+
+  // the landmarks are not randomly accessible
+  std::vector<const Landmark*> landmarks;
+  if(b_structure)
+  {
+    landmarks.reserve(sfm_data.GetLandmarks().size());
+    for(const auto & landmark : sfm_data.GetLandmarks())
+      landmarks.push_back(&landmark.second);
+  }
+
+  // camera centers to compute the viewing directions of the landmarks
+  HashMap<IndexT, Vec3> viewCenters;
+  if(b_structure && options.withNormals)
+  {
+    for(const auto & view : sfm_data.GetViews())
+    {
+      if(sfm_data.IsPoseAndIntrinsicDefined(view.second.get()))
+        viewCenters[view.first] = sfm_data.getPose(*(view.second.get())).center();
+    }
+  }
+
+  const std::size_t nbCameras = cameras.size();
+  const std::size_t nbVertices = nbCameras + landmarks.size();
+
+  const auto getVertex = [&](std::size_t i, PLYVertex & vertex)
+  {
+    if(i < nbCameras)
+    {
+      vertex = cameras[i];
+      return;
+    }
+
+    const Landmark & landmark = *landmarks[i - nbCameras];
+    vertex.X = landmark.X;
+    vertex.color = landmark.rgb;
+    vertex.nbObservations = static_cast<std::uint32_t>(landmark.observations.size());
+    vertex.normal = Vec3::Zero();
+
+    if(options.withNormals)
+    {
+      // mean direction from the landmark to the cameras observing it
+      for(const auto & observation : landmark.observations)
+      {
+        const auto itCenter = viewCenters.find(observation.first);
+        if(itCenter == viewCenters.end())
+          continue;
+        const Vec3 direction = itCenter->second - landmark.X;
+        const double distance = direction.norm();
+        if(distance > 0.0)
+          vertex.normal += direction / distance;
+      }
+      if(vertex.normal.squaredNorm() > 0.0)
+        vertex.normal.normalize();
+    }
+  };
+
+  std::ostringstream header;
+  header << "ply"
+    << '\n' << "format " << (options.binary ? "binary_little_endian" : "ascii") << " 1.0"
+    << '\n' << "comment " << kNbCamerasComment << " " << nbCameras
+    << '\n' << "element vertex " << nbVertices
+    << '\n' << "property float x"
+    << '\n' << "property float y"
+    << '\n' << "property float z";
+  if(options.withNormals)
+  {
+    header << '\n' << "property float nx"
+           << '\n' << "property float ny"
+           << '\n' << "property float nz";
+  }
+  if(options.withColors)
+  {
+    header << '\n' << "property uchar red"
+           << '\n' << "property uchar green"
+           << '\n' << "property uchar blue";
+  }
+  if(options.withObservationsCount)
+    header << '\n' << "property uint nb_observations";
+  header << '\n' << "end_header" << '\n';
+
   //Create the stream and check it is ok
-  std::ofstream stream(filename.c_str());
+  std::ofstream stream(filename.c_str(), std::ios::binary);
   if (!stream.is_open())
     return false;
 
-  bool bOk = false;
+  const std::string headerStr = header.str();
+  stream.write(headerStr.data(), headerStr.size());
+
+  if(options.binary)
+  {
+    // fixed size records: each vertex is encoded at its place in the buffer
+    const std::size_t vertexSize = getVertexSize(options);
+    std::vector<char> buffer(nbVertices * vertexSize);
+
+    #pragma omp parallel for
+    for(int i = 0; i < static_cast<int>(nbVertices); ++i)
+    {
+      PLYVertex vertex;
+      getVertex(i, vertex);
+      encodeBinary(vertex, options, &buffer[i * vertexSize]);
+    }
+    stream.write(buffer.data(), buffer.size());
+  }
+  else
+  {
+    const std::size_t nbChunks = (nbVertices + kAsciiChunkSize - 1) / kAsciiChunkSize;
+    std::vector<std::string> chunks(nbChunks);
+
+    #pragma omp parallel for
+    for(int c = 0; c < static_cast<int>(nbChunks); ++c)
+    {
+      std::ostringstream chunkStream;
+      const std::size_t end = std::min(nbVertices, (c + 1) * kAsciiChunkSize);
+      for(std::size_t i = c * kAsciiChunkSize; i < end; ++i)
+      {
+        PLYVertex vertex;
+        getVertex(i, vertex);
+        encodeAscii(vertex, options, chunkStream);
+      }
+      chunks[c] = chunkStream.str();
+    }
+    for(const std::string & chunk : chunks)
+      stream.write(chunk.data(), chunk.size());
+  }
+
+  stream.flush();
+  const bool bOk = stream.good();
+  stream.close();
+  return bOk;
+}
+
+bool Load_PLY(SfMData & sfm_data,
+              const std::string & filename,
+              ESfMData flags_part)
+{
+  // only the structure is stored in a PLY file
+  if(!(flags_part & STRUCTURE))
+    return true;
+
+  std::ifstream stream(filename.c_str(), std::ios::binary);
+  if(!stream.is_open())
+    return false;
+
+  EPLYFormat format = EPLYFormat::ASCII;
+  std::vector<PLYElement> elements;
+  std::size_t nbCameras = 0;
+  if(!readHeader(stream, format, elements, nbCameras))
+  {
+    ALICEVISION_LOG_WARNING("Invalid PLY header: " << filename);
+    return false;
+  }
+  if(format == EPLYFormat::BINARY_BIG_ENDIAN)
+  {
+    ALICEVISION_LOG_WARNING("Binary big endian PLY files are not supported: " << filename);
+    return false;
+  }
+
+  for(const PLYElement & element : elements)
   {
-    // Count how many views having valid poses:
-    IndexT view_with_pose_count = 0;
-    if (b_extrinsics)
+    if(element.name != "vertex")
     {
-      for (const auto & view : sfm_data.GetViews())
+      if(!skipElement(stream, format, element))
       {
-        view_with_pose_count += sfm_data.IsPoseAndIntrinsicDefined(view.second.get());
+        ALICEVISION_LOG_WARNING("Cannot read the element '" << element.name << "' of the PLY file: " << filename);
+        return false;
       }
+      continue;
     }
-    stream << "ply"
-      << '\n' << "format ascii 1.0"
-      << '\n' << "element vertex "
-        // Vertex count: (#landmark + #view_with_valid_pose)
-        << ((b_structure ? sfm_data.GetLandmarks().size() : 0) +
-            view_with_pose_count)
-      << '\n' << "property float x"
-      << '\n' << "property float y"
-      << '\n' << "property float z"
-      << '\n' << "property uchar red"
-      << '\n' << "property uchar green"
-      << '\n' << "property uchar blue"
-      << '\n' << "end_header" << std::endl;
-
-      if (b_extrinsics)
+
+    if(nbCameras > element.count)
+      return false;
+
+    // position of the useful properties
+    enum { X = 0, Y, Z, RED, GREEN, BLUE, NB_FIELDS };
+    const std::vector<std::string> fieldNames = {"x", "y", "z", "red", "green", "blue"};
+    std::vector<int> fieldIndex(NB_FIELDS, -1);
+    for(std::size_t p = 0; p < element.properties.size(); ++p)
+    {
+      const auto it = std::find(fieldNames.begin(), fieldNames.end(), element.properties[p].name);
+      if(it != fieldNames.end())
+        fieldIndex[std::distance(fieldNames.begin(), it)] = static_cast<int>(p);
+    }
+    if(fieldIndex[X] < 0 || fieldIndex[Y] < 0 || fieldIndex[Z] < 0)
+    {
+      ALICEVISION_LOG_WARNING("No vertex position in the PLY file: " << filename);
+      return false;
+    }
+    const bool hasColors = (fieldIndex[RED] >= 0 && fieldIndex[GREEN] >= 0 && fieldIndex[BLUE] >= 0);
+
+    const std::size_t nbLandmarks = element.count - nbCameras;
+    std::vector<Landmark> landmarks(nbLandmarks, Landmark(feature::EImageDescriberType::UNKNOWN));
+
+    const auto setLandmark = [&](std::size_t i, const std::vector<double> & values)
+    {
+      if(i < nbCameras)
+        return;
+      Landmark & landmark = landmarks[i - nbCameras];
+      landmark.X = Vec3(values[fieldIndex[X]], values[fieldIndex[Y]], values[fieldIndex[Z]]);
+      if(hasColors)
+      {
+        const auto toColor = [](double value) { return static_cast<unsigned char>(std::min(255.0, std::max(0.0, value))); };
+        landmark.rgb = image::RGBColor(toColor(values[fieldIndex[RED]]), toColor(values[fieldIndex[GREEN]]), toColor(values[fieldIndex[BLUE]]));
+      }
+    };
+
+    if(format == EPLYFormat::ASCII)
+    {
+      std::string line;
+      std::vector<double> values(element.properties.size());
+      for(std::size_t i = 0; i < element.count; ++i)
       {
-        for (const auto & view : sfm_data.GetViews())
+        if(!std::getline(stream, line))
+          return false;
+        std::istringstream lineStream(line);
+        for(std::size_t p = 0; p < element.properties.size(); ++p)
         {
-          if (sfm_data.IsPoseAndIntrinsicDefined(view.second.get()))
+          if(element.properties[p].isList)
           {
-            const geometry::Pose3 pose = sfm_data.getPose(*(view.second.get()));
-            stream << pose.center().transpose()
-              << " 0 255 0" << "\n";
+            // lists are not used, skip their values
+            std::size_t listSize = 0;
+            double value;
+            lineStream >> listSize;
+            for(std::size_t j = 0; j < listSize; ++j)
+              lineStream >> value;
           }
+          else
+          {
+            lineStream >> values[p];
+          }
+        }
+        if(lineStream.fail())
+          return false;
+        setLandmark(i, values);
+      }
+    }
+    else
+    {
+      // fixed size records: read all the vertices at once and decode them in parallel
+      std::vector<std::size_t> offsets(element.properties.size());
+      std::size_t vertexSize = 0;
+      for(std::size_t p = 0; p < element.properties.size(); ++p)
+      {
+        if(element.properties[p].isList)
+        {
+          ALICEVISION_LOG_WARNING("Binary PLY vertices with list properties are not supported: " << filename);
+          return false;
         }
+        offsets[p] = vertexSize;
+        vertexSize += getTypeSize(element.properties[p].type);
       }
 
-      if (b_structure)
+      std::vector<char> buffer(element.count * vertexSize);
+      stream.read(buffer.data(), buffer.size());
+      if(static_cast<std::size_t>(stream.gcount()) != buffer.size())
+        return false;
+
+      #pragma omp parallel
       {
-        const Landmarks & landmarks = sfm_data.GetLandmarks();
-        for (Landmarks::const_iterator iterLandmarks = landmarks.begin();
-          iterLandmarks != landmarks.end();
-          ++iterLandmarks)  {
-          stream << iterLandmarks->second.X.transpose() << " "
-                 << (int)iterLandmarks->second.rgb.r() << " "
-                 << (int)iterLandmarks->second.rgb.g() << " "
-                 << (int)iterLandmarks->second.rgb.b() << "\n";
+        std::vector<double> values(element.properties.size());
+
+        #pragma omp for
+        for(int i = static_cast<int>(nbCameras); i < static_cast<int>(element.count); ++i)
+        {
+          for(std::size_t p = 0; p < element.properties.size(); ++p)
+            values[p] = readLittleEndian(element.properties[p].type, &buffer[i * vertexSize + offsets[p]]);
+          setLandmark(i, values);
         }
       }
-      stream.flush();
-      bOk = stream.good();
-      stream.close();
+    }
+
+    // Number of points before adding the PLY data
+    const std::size_t nbPointsInit = sfm_data.structure.size();
+    for(std::size_t i = 0; i < nbLandmarks; ++i)
+      sfm_data.structure[nbPointsInit + i] = std::move(landmarks[i]);
+
+    return true;
   }
-  return bOk;
+
+  ALICEVISION_LOG_WARNING("No vertex in the PLY file: " << filename);
+  return false;
 }
 
 } // namespace sfm
@@ -7,11 +7,55 @@
 
 #include <aliceVision/sfm/sfmDataIO.hpp>
 
+#include <string>
+
 namespace aliceVision {
 namespace sfm {
 
-/// Save the structure and camera positions of a SfMData container as 3D points in a PLY ASCII file.
+/**
+ * @brief Content and encoding of a PLY export
+ */
+struct PLYExportOptions
+{
+  /// binary little endian encoding, ASCII otherwise
+  bool binary = true;
+  /// per-vertex colors (red, green, blue)
+  bool withColors = true;
+  /// per-vertex normals (nx, ny, nz): the mean viewing direction of the landmarks
+  /// and the optical axis of the cameras
+  bool withNormals = false;
+  /// per-vertex number of observations (nb_observations), 0 for the cameras
+  bool withObservationsCount = false;
+};
+
+/// Save the structure and camera positions of a SfMData container as 3D points in a binary PLY file.
+bool Save_PLY(const SfMData & sfm_data,
+              const std::string & filename,
+              ESfMData flags_part);
+
+/**
+ * @brief Save the structure and camera positions of a SfMData container as 3D points in a PLY file.
+ * The vertices are encoded in parallel in a single buffer written at once.
+ * @param[in] sfm_data The SfMData container
+ * @param[in] filename The PLY file path
+ * @param[in] flags_part The elements to save (STRUCTURE and/or EXTRINSICS)
+ * @param[in] options The content and encoding of the file
+ * @return true if the file has been written
+ */
 bool Save_PLY(const SfMData & sfm_data,
+              const std::string & filename,
+              ESfMData flags_part,
+              const PLYExportOptions & options);
+
+/**
+ * @brief Load the 3D points of a PLY file (ASCII or binary little endian) as landmarks.
+ * The camera positions written by Save_PLY are skipped.
+ * @param[in,out] sfm_data The SfMData container
+ * @param[in] filename The PLY file path
+ * @param[in] flags_part The elements to load, only STRUCTURE is stored in a PLY file
+ * @return true if the file has been read
+ */
+bool Load_PLY(SfMData & sfm_data,
               const std::string & filename,
               ESfMData flags_part);
 
@@ -5,6 +5,7 @@
 
 #include "aliceVision/system/Timer.hpp"
 #include "aliceVision/sfm/sfm.hpp"
+#include "aliceVision/sfm/sfmDataIO_ply.hpp"
 #include "dependencies/stlplus3/filesystemSimplified/file_system.hpp"
 #include <sstream>
 
@@ -220,3 +221,39 @@ BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_PLY) {
     BOOST_CHECK( stlplus::is_file(filename) );
   }
 }
+
+BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_LOAD_PLY) {
+
+  SfMData sfmData = createTestScene(3, 2, true);
+  for(IndexT i = 1; i < 1000; ++i)
+  {
+    sfmData.structure[i].X = Vec3(i, -0.5 * i, 0.25 * i);
+    sfmData.structure[i].rgb = image::RGBColor(i % 256, (3 * i) % 256, (7 * i) % 256);
+    sfmData.structure[i].observations[i % 3] = Observation(Vec2(i, i), i);
+  }
+
+  for(const bool binary : {true, false})
+  {
+    const std::string filename = binary ? "SAVE_LOAD_BINARY.ply" : "SAVE_LOAD_ASCII.ply";
+
+    PLYExportOptions options;
+    options.binary = binary;
+    options.withNormals = true;
+    options.withObservationsCount = true;
+    BOOST_CHECK( Save_PLY(sfmData, filename, ESfMData(EXTRINSICS | STRUCTURE), options) );
+
+    // the camera positions are not loaded
+    SfMData sfmDataLoad;
+    BOOST_CHECK( Load(sfmDataLoad, filename, STRUCTURE) );
+    BOOST_CHECK_EQUAL( sfmDataLoad.structure.size(), sfmData.structure.size() );
+
+    // the landmarks are loaded in the order of the structure
+    IndexT landmarkId = 0;
+    for(const auto& landmark : sfmData.GetLandmarks())
+    {
+      const Landmark& landmarkLoad = sfmDataLoad.structure.at(landmarkId++);
+      BOOST_CHECK_SMALL( (landmark.second.X - landmarkLoad.X).norm(), 1e-3 );
+      BOOST_CHECK( landmark.second.rgb == landmarkLoad.rgb );
+    }
+  }
+}
@@ -0,0 +1,101 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief A thread-safe FIFO queue with an optional maximum size,
+ * used to connect the stages of a producer/consumer pipeline.
+ * Pushing blocks while the queue is full, popping blocks while the queue is empty.
+ * Once closed, the queue rejects new elements and the consumers
+ * drain the remaining elements before being released.
+ */
+template<typename T>
+class ConcurrentQueue
+{
+public:
+
+  /**
+   * @brief Build a queue.
+   * @param[in] maxSize The maximum number of elements in the queue (0 for unbounded)
+   */
+  explicit ConcurrentQueue(std::size_t maxSize = 0)
+    : _maxSize(maxSize)
+  {}
+
+  /**
+   * @brief Add an element at the end of the queue, wait if the queue is full.
+   * @param[in] value The element to add
+   * @return false if the queue has been closed
+   */
+  bool push(T value)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notFull.wait(lock, [this]{ return _closed || _maxSize == 0 || _queue.size() < _maxSize; });
+    if(_closed)
+      return false;
+    _queue.push_back(std::move(value));
+    _notEmpty.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Remove the first element of the queue, wait if the queue is empty.
+   * @param[out] value The removed element
+   * @return false if the queue is closed and empty
+   */
+  bool pop(T& value)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notEmpty.wait(lock, [this]{ return _closed || !_queue.empty(); });
+    if(_queue.empty())
+      return false;
+    value = std::move(_queue.front());
+    _queue.pop_front();
+    _notFull.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Close the queue: no more element can be pushed
+   * and the waiting consumers are released once the queue is empty.
+   */
+  void close()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _closed = true;
+    _notEmpty.notify_all();
+    _notFull.notify_all();
+  }
+
+  /**
+   * @brief Get the current number of elements in the queue.
+   * @return the number of elements
+   */
+  std::size_t size() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _queue.size();
+  }
+
+private:
+  std::deque<T> _queue;
+  std::size_t _maxSize;
+  bool _closed = false;
+  mutable std::mutex _mutex;
+  std::condition_variable _notEmpty;
+  std::condition_variable _notFull;
+};
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,186 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/system/ConcurrentQueue.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#define BOOST_TEST_MODULE ConcurrentQueue
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::system;
+
+BOOST_AUTO_TEST_CASE(ConcurrentQueue_fifo)
+{
+  ConcurrentQueue<std::unique_ptr<int>> queue;
+  for(int i = 0; i < 5; ++i)
+    BOOST_CHECK(queue.push(std::unique_ptr<int>(new int(i))));
+  BOOST_CHECK_EQUAL(queue.size(), 5);
+
+  std::unique_ptr<int> value;
+  for(int i = 0; i < 5; ++i)
+  {
+    BOOST_CHECK(queue.pop(value));
+    BOOST_CHECK_EQUAL(*value, i);
+  }
+  BOOST_CHECK_EQUAL(queue.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentQueue_close)
+{
+  ConcurrentQueue<int> queue;
+  BOOST_CHECK(queue.push(1));
+  BOOST_CHECK(queue.push(2));
+  queue.close();
+
+  // no more push, the remaining elements are drained before pop fails
+  BOOST_CHECK(!queue.push(3));
+  int value = 0;
+  BOOST_CHECK(queue.pop(value));
+  BOOST_CHECK_EQUAL(value, 1);
+  BOOST_CHECK(queue.pop(value));
+  BOOST_CHECK_EQUAL(value, 2);
+  BOOST_CHECK(!queue.pop(value));
+  BOOST_CHECK(!queue.pop(value));
+  BOOST_CHECK_EQUAL(value, 2);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentQueue_closeReleasesWaitingThreads)
+{
+  // consumers waiting on an empty queue
+  {
+    ConcurrentQueue<int> queue;
+    std::atomic<int> nbReleased(0);
+    std::vector<std::thread> consumers;
+    for(int i = 0; i < 3; ++i)
+    {
+      consumers.emplace_back([&]()
+      {
+        int value;
+        if(!queue.pop(value))
+          ++nbReleased;
+      });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    BOOST_CHECK_EQUAL(nbReleased, 0);
+    queue.close();
+    for(std::thread& consumer : consumers)
+      consumer.join();
+    BOOST_CHECK_EQUAL(nbReleased, 3);
+  }
+
+  // producer waiting on a full queue
+  {
+    ConcurrentQueue<int> queue(1);
+    BOOST_CHECK(queue.push(0));
+    std::atomic<bool> isPushed(true);
+    std::thread producer([&]()
+    {
+      isPushed = queue.push(1);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    BOOST_CHECK_EQUAL(queue.size(), 1);
+    queue.close();
+    producer.join();
+    BOOST_CHECK(!isPushed);
+    BOOST_CHECK_EQUAL(queue.size(), 1);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentQueue_bounded)
+{
+  const std::size_t maxSize = 4;
+  ConcurrentQueue<int> queue(maxSize);
+  std::atomic<int> nbPushed(0);
+
+  std::thread producer([&]()
+  {
+    for(int i = 0; i < 10; ++i)
+    {
+      queue.push(i);
+      ++nbPushed;
+    }
+  });
+
+  // once the queue is full, the producer waits until there is room in the queue
+  while(queue.size() < maxSize)
+    std::this_thread::yield();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  BOOST_CHECK_EQUAL(nbPushed, maxSize);
+  BOOST_CHECK_EQUAL(queue.size(), maxSize);
+
+  int value = -1;
+  for(int i = 0; i < 10; ++i)
+  {
+    BOOST_CHECK(queue.pop(value));
+    BOOST_CHECK_EQUAL(value, i);
+    BOOST_CHECK_LE(queue.size(), maxSize);
+  }
+  producer.join();
+  BOOST_CHECK_EQUAL(nbPushed, 10);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentQueue_multipleProducersConsumers)
+{
+  const int nbProducers = 4;
+  const int nbConsumers = 3;
+  const int nbValuesPerProducer = 2000;
+  ConcurrentQueue<std::pair<int, int>> queue(8);
+
+  std::vector<std::vector<std::pair<int, int>>> consumed(nbConsumers);
+  std::vector<std::thread> consumers;
+  for(int c = 0; c < nbConsumers; ++c)
+  {
+    consumers.emplace_back([&, c]()
+    {
+      std::pair<int, int> value;
+      while(queue.pop(value))
+        consumed[c].push_back(value);
+    });
+  }
+
+  std::atomic<int> nbRejected(0);
+  std::vector<std::thread> producers;
+  for(int p = 0; p < nbProducers; ++p)
+  {
+    producers.emplace_back([&, p]()
+    {
+      for(int i = 0; i < nbValuesPerProducer; ++i)
+        if(!queue.push(std::make_pair(p, i)))
+          ++nbRejected;
+    });
+  }
+
+  // close once all the producers are done, as the pipeline stages do
+  for(std::thread& producer : producers)
+    producer.join();
+  queue.close();
+  for(std::thread& consumer : consumers)
+    consumer.join();
+  BOOST_CHECK_EQUAL(nbRejected, 0);
+
+  // each value is received once, and the values of a producer keep their order for each consumer
+  std::vector<std::vector<int>> nbReceived(nbProducers, std::vector<int>(nbValuesPerProducer, 0));
+  for(const std::vector<std::pair<int, int>>& values : consumed)
+  {
+    std::vector<int> lastValue(nbProducers, -1);
+    for(const std::pair<int, int>& value : values)
+    {
+      BOOST_CHECK_GT(value.second, lastValue[value.first]);
+      lastValue[value.first] = value.second;
+      ++nbReceived[value.first][value.second];
+    }
+  }
+  for(int p = 0; p < nbProducers; ++p)
+    for(int i = 0; i < nbValuesPerProducer; ++i)
+      BOOST_CHECK_EQUAL(nbReceived[p][i], 1);
+  BOOST_CHECK_EQUAL(queue.size(), 0);
+}
@@ -8,10 +8,14 @@
 
 #if defined(__WINDOWS__)
 #include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
 #elif defined(__LINUX__)
 #include <sys/sysinfo.h>
+#include <sys/resource.h>
 #elif defined(__APPLE__)
 #include <sys/types.h>
+#include <sys/resource.h>
 #include <sys/sysctl.h>
 #include <mach/vm_statistics.h>
 #include <mach/mach_types.h>
@@ -94,6 +98,29 @@ MemoryInfo getMemoryInfo()
     return infos;
 }
 
+std::size_t getPeakResidentMemory()
+{
+#if defined(__WINDOWS__)
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+    return 0;
+#elif defined(__LINUX__) || defined(__APPLE__)
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#if defined(__APPLE__)
+    // bytes on macOS
+    return usage.ru_maxrss;
+#else
+    // kilobytes on Linux
+    return usage.ru_maxrss * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
 std::ostream& operator<<(std::ostream& os, const MemoryInfo& infos)
 {
     os << "total ram:" << infos.totalRam << std::endl
@@ -23,6 +23,12 @@ struct MemoryInfo
 
 MemoryInfo getMemoryInfo();
 
+/**
+ * @brief Get the peak resident memory (bytes) used by the current process.
+ * @return 0 if unavailable
+ */
+std::size_t getPeakResidentMemory();
+
 std::ostream& operator<<(std::ostream& os, const MemoryInfo& infos);
 
 }
@@ -0,0 +1,219 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "Tracing.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace aliceVision {
+namespace system {
+
+namespace {
+
+/// Write a JSON string with its special characters escaped
+void writeJsonString(std::ostream& os, const char* str)
+{
+  os << '"';
+  for(const char* c = str; *c != '\0'; ++c)
+  {
+    switch(*c)
+    {
+      case '"':  os << "\\\""; break;
+      case '\\': os << "\\\\"; break;
+      case '\n': os << "\\n"; break;
+      case '\t': os << "\\t"; break;
+      default:
+        if(static_cast<unsigned char>(*c) < 0x20)
+          os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(*c) << std::dec << std::setfill(' ');
+        else
+          os << *c;
+    }
+  }
+  os << '"';
+}
+
+} // namespace
+
+Tracer& Tracer::get()
+{
+  // never destroyed: the spans closed during the static destruction are still recorded
+  static Tracer* tracer = new Tracer();
+  return *tracer;
+}
+
+Tracer::Tracer()
+  : _enabled(false)
+  , _maxEventsPerThread(std::size_t(1) << 22)
+  , _nbOpenedSpans(0)
+  , _start(std::chrono::steady_clock::now())
+{
+  const char* filename = std::getenv("ALICEVISION_TRACE_FILE");
+  if(filename != nullptr && filename[0] != '\0')
+  {
+    _exportFilename = filename;
+    setEnabled(true);
+    std::atexit(&Tracer::exportAtExit);
+  }
+}
+
+void Tracer::exportAtExit()
+{
+  // the logger may already be destroyed at exit
+  const Tracer& tracer = get();
+  if(!tracer.writeChromeTrace(tracer._exportFilename))
+    std::cerr << "Unable to write the trace file: " << tracer._exportFilename << std::endl;
+  else if(tracer.getNbDroppedEvents() > 0)
+    std::cerr << "Trace: " << tracer.getNbDroppedEvents() << " events dropped, the thread buffers are limited to "
+              << tracer.getMaxEventsPerThread() << " events." << std::endl;
+}
+
+Tracer::ThreadBuffer& Tracer::getThreadBuffer()
+{
+  // buffers are never destroyed before the tracer
+  thread_local ThreadBuffer* threadBuffer = nullptr;
+  if(threadBuffer == nullptr)
+  {
+    std::lock_guard<std::mutex> lock(_buffersMutex);
+    _buffers.emplace_back(new ThreadBuffer(_buffers.size()));
+    threadBuffer = _buffers.back().get();
+  }
+  return *threadBuffer;
+}
+
+void Tracer::clear()
+{
+  std::lock_guard<std::mutex> lock(_buffersMutex);
+  for(auto& buffer : _buffers)
+  {
+    buffer->events.clear();
+    buffer->nbDroppedEvents = 0;
+  }
+}
+
+void Tracer::addEvent(TraceEvent event)
+{
+  ThreadBuffer& buffer = getThreadBuffer();
+  const std::size_t maxEventsPerThread = getMaxEventsPerThread();
+  if(maxEventsPerThread != 0 && buffer.events.size() >= maxEventsPerThread)
+  {
+    ++buffer.nbDroppedEvents;
+    return;
+  }
+  buffer.events.push_back(std::move(event));
+}
+
+double Tracer::beginSpan(bool& isTopLevel)
+{
+  isTopLevel = (_nbOpenedSpans.fetch_add(1, std::memory_order_relaxed) == 0);
+  return now();
+}
+
+void Tracer::endSpan(const char* name, std::string detail, double start, bool isTopLevel)
+{
+  const double end = now();
+  addEvent({TraceEvent::EType::Span, name, std::move(detail), start, end - start});
+  _nbOpenedSpans.fetch_sub(1, std::memory_order_relaxed);
+  if(isTopLevel)
+    sampleMemory();
+}
+
+void Tracer::addCounter(const char* name, double value)
+{
+  addEvent({TraceEvent::EType::Counter, name, std::string(), now(), value});
+}
+
+void Tracer::sampleMemory()
+{
+  addCounter("peakResidentMemory (MB)", getPeakResidentMemory() / (1024.0 * 1024.0));
+}
+
+std::size_t Tracer::getNbEvents() const
+{
+  std::lock_guard<std::mutex> lock(_buffersMutex);
+  std::size_t nbEvents = 0;
+  for(const auto& buffer : _buffers)
+    nbEvents += buffer->events.size();
+  return nbEvents;
+}
+
+std::size_t Tracer::getNbDroppedEvents() const
+{
+  std::lock_guard<std::mutex> lock(_buffersMutex);
+  std::size_t nbDroppedEvents = 0;
+  for(const auto& buffer : _buffers)
+    nbDroppedEvents += buffer->nbDroppedEvents;
+  return nbDroppedEvents;
+}
+
+bool Tracer::exportChromeTrace(const std::string& filename) const
+{
+  if(!writeChromeTrace(filename))
+  {
+    ALICEVISION_LOG_WARNING("Unable to write the trace file: " << filename);
+    return false;
+  }
+
+  const std::size_t nbDroppedEvents = getNbDroppedEvents();
+  if(nbDroppedEvents > 0)
+    ALICEVISION_LOG_WARNING("Trace: " << nbDroppedEvents << " events dropped, the thread buffers are limited to " << getMaxEventsPerThread() << " events.");
+
+  ALICEVISION_LOG_INFO("Trace exported: " << filename);
+  return true;
+}
+
+bool Tracer::writeChromeTrace(const std::string& filename) const
+{
+  std::ofstream file(filename);
+  if(!file.is_open())
+    return false;
+
+  file << std::fixed << std::setprecision(3);
+  file << "{\"traceEvents\":[\n";
+
+  std::lock_guard<std::mutex> lock(_buffersMutex);
+  bool first = true;
+  for(const auto& buffer : _buffers)
+  {
+    // thread name metadata
+    file << (first ? "" : ",\n")
+         << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+         << ",\"args\":{\"name\":\"thread " << buffer->threadId << "\"}}";
+    first = false;
+
+    for(const TraceEvent& event : buffer->events)
+    {
+      file << ",\n{\"name\":";
+      writeJsonString(file, event.name);
+      if(event.type == TraceEvent::EType::Span)
+      {
+        file << ",\"ph\":\"X\",\"ts\":" << event.timestamp << ",\"dur\":" << event.value
+             << ",\"pid\":1,\"tid\":" << buffer->threadId;
+        if(!event.detail.empty())
+        {
+          file << ",\"args\":{\"detail\":";
+          writeJsonString(file, event.detail.c_str());
+          file << "}";
+        }
+        file << "}";
+      }
+      else
+      {
+        file << ",\"ph\":\"C\",\"ts\":" << event.timestamp
+             << ",\"pid\":1,\"tid\":" << buffer->threadId
+             << ",\"args\":{\"value\":" << event.value << "}}";
+      }
+    }
+  }
+  file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  return file.good();
+}
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,247 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Event recorded by the Tracer.
+ */
+struct TraceEvent
+{
+  enum class EType : char
+  {
+    Span,
+    Counter
+  };
+
+  EType type;
+  /// static string: span or counter name
+  const char* name;
+  /// optional dynamic detail (i.e. view id)
+  std::string detail;
+  /// start time in microseconds since the tracer start
+  double timestamp;
+  /// span duration in microseconds, counter value
+  double value;
+};
+
+/**
+ * @brief Collect the spans and counters of a process and export them
+ * in the Chrome trace event format (chrome://tracing, Perfetto).
+ *
+ * Each thread records its events in its own buffer without locking, up to a
+ * maximum number of events per thread: the next events are dropped and counted.
+ * The tracer is disabled by default and the instrumentation then only costs
+ * the test of an atomic flag. It is enabled at startup if the environment
+ * variable ALICEVISION_TRACE_FILE is set, and the trace is written to this file
+ * by an atexit handler (without logging, the logger may already be destroyed).
+ *
+ * Export the trace when the traced threads are idle.
+ */
+class Tracer
+{
+public:
+
+  /// Get the process tracer
+  static Tracer& get();
+
+  inline bool isEnabled() const
+  {
+    return _enabled.load(std::memory_order_relaxed);
+  }
+
+  void setEnabled(bool enabled)
+  {
+    _enabled.store(enabled, std::memory_order_relaxed);
+  }
+
+  /// Remove all the recorded events
+  void clear();
+
+  /**
+   * @brief Set the maximum number of events recorded per thread (0 for unlimited),
+   * the next events of a thread are dropped.
+   */
+  void setMaxEventsPerThread(std::size_t maxEventsPerThread)
+  {
+    _maxEventsPerThread.store(maxEventsPerThread, std::memory_order_relaxed);
+  }
+
+  std::size_t getMaxEventsPerThread() const
+  {
+    return _maxEventsPerThread.load(std::memory_order_relaxed);
+  }
+
+  /// Microseconds since the tracer start
+  double now() const
+  {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - _start).count();
+  }
+
+  /**
+   * @brief Start a span of the calling thread.
+   * @param[out] isTopLevel true if no other span is opened in the process
+   * @return The span start (microseconds)
+   */
+  double beginSpan(bool& isTopLevel);
+
+  /**
+   * @brief Record a span of the calling thread.
+   * The peak resident memory is only sampled at the end of the top-level spans,
+   * not for the spans of the worker threads of a traced parallel section.
+   * @param[in] name Static span name
+   * @param[in] detail Optional detail
+   * @param[in] start Span start returned by beginSpan
+   * @param[in] isTopLevel Returned by beginSpan
+   */
+  void endSpan(const char* name, std::string detail, double start, bool isTopLevel);
+
+  /**
+   * @brief Record a counter value.
+   * @param[in] name Static counter name
+   * @param[in] value The counter value
+   */
+  void addCounter(const char* name, double value);
+
+  /// Record the peak resident memory of the process as a counter
+  void sampleMemory();
+
+  /// Get the number of recorded events
+  std::size_t getNbEvents() const;
+
+  /// Get the number of events dropped because a thread buffer was full
+  std::size_t getNbDroppedEvents() const;
+
+  /**
+   * @brief Export the events in the Chrome trace event format.
+   * @param[in] filename The output JSON file
+   * @return true if the file has been written
+   */
+  bool exportChromeTrace(const std::string& filename) const;
+
+private:
+
+  Tracer();
+
+  /// Export the trace to the ALICEVISION_TRACE_FILE file, errors are written to stderr
+  static void exportAtExit();
+
+  /// Write the events in the Chrome trace event format, without logging
+  bool writeChromeTrace(const std::string& filename) const;
+
+  struct ThreadBuffer
+  {
+    explicit ThreadBuffer(std::size_t threadId)
+      : threadId(threadId)
+    {}
+
+    std::size_t threadId;
+    std::vector<TraceEvent> events;
+    std::size_t nbDroppedEvents = 0;
+  };
+
+  /// Get the events buffer of the calling thread, created on first use
+  ThreadBuffer& getThreadBuffer();
+
+  /// Record an event in the buffer of the calling thread, if it is not full
+  void addEvent(TraceEvent event);
+
+  std::atomic<bool> _enabled;
+  std::atomic<std::size_t> _maxEventsPerThread;
+  /// number of opened spans in the process
+  std::atomic<int> _nbOpenedSpans;
+  std::chrono::steady_clock::time_point _start;
+  std::string _exportFilename;
+
+  mutable std::mutex _buffersMutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> _buffers;
+};
+
+/**
+ * @brief Scoped span, recorded at destruction if the tracer was enabled at construction.
+ * Nested spans of a thread are displayed as a hierarchy.
+ */
+class TraceSpan
+{
+public:
+
+  explicit TraceSpan(const char* name)
+    : _name(Tracer::get().isEnabled() ? name : nullptr)
+  {
+    if(_name)
+      _start = Tracer::get().beginSpan(_isTopLevel);
+  }
+
+  /**
+   * @param[in] name Static span name
+   * @param[in] detail Detail, only used if the tracer is enabled
+   */
+  template<typename T>
+  TraceSpan(const char* name, const T& detail)
+    : TraceSpan(name)
+  {
+    if(_name)
+      _detail = toDetail(detail);
+  }
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+  ~TraceSpan()
+  {
+    if(_name)
+      Tracer::get().endSpan(_name, std::move(_detail), _start, _isTopLevel);
+  }
+
+private:
+  template<typename T>
+  static std::string toDetail(const T& detail)
+  {
+    return std::to_string(detail);
+  }
+
+  /// Image pairs (I, J) as "I-J"
+  template<typename T1, typename T2>
+  static std::string toDetail(const std::pair<T1, T2>& detail)
+  {
+    return std::to_string(detail.first) + "-" + std::to_string(detail.second);
+  }
+
+  const char* _name;
+  double _start = 0.0;
+  bool _isTopLevel = false;
+  std::string _detail;
+};
+
+} // namespace system
+} // namespace aliceVision
+
+#define ALICEVISION_TRACE_CONCAT_IMPL(a, b) a##b
+#define ALICEVISION_TRACE_CONCAT(a, b) ALICEVISION_TRACE_CONCAT_IMPL(a, b)
+
+/// Trace the enclosing scope, with an optional detail (i.e. ALICEVISION_TRACE_SCOPE("resection", viewId)),
+/// a number or a pair of numbers
+#define ALICEVISION_TRACE_SCOPE(...) \
+  const aliceVision::system::TraceSpan ALICEVISION_TRACE_CONCAT(aliceVision_traceSpan_, __LINE__)(__VA_ARGS__)
+
+/// Record a counter value if the tracing is enabled
+#define ALICEVISION_TRACE_COUNTER(name, value) \
+  do { \
+    if(aliceVision::system::Tracer::get().isEnabled()) \
+      aliceVision::system::Tracer::get().addCounter(name, static_cast<double>(value)); \
+  } while(0)
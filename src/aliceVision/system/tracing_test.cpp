@@ -0,0 +1,156 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/system/Tracing.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+#define BOOST_TEST_MODULE tracing
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::system;
+
+BOOST_AUTO_TEST_CASE(tracing_disabled)
+{
+  Tracer& tracer = Tracer::get();
+  tracer.setEnabled(false);
+  tracer.clear();
+  {
+    ALICEVISION_TRACE_SCOPE("disabled");
+    ALICEVISION_TRACE_COUNTER("counter", 1);
+  }
+  BOOST_CHECK_EQUAL(tracer.getNbEvents(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(tracing_chromeTrace)
+{
+  Tracer& tracer = Tracer::get();
+  tracer.setEnabled(true);
+  tracer.clear();
+
+  const int nbSpans = 64;
+  {
+    ALICEVISION_TRACE_SCOPE("root");
+    #pragma omp parallel for
+    for(int i = 0; i < nbSpans; ++i)
+    {
+      ALICEVISION_TRACE_SCOPE("outer", std::make_pair(i, i + 1));
+      {
+        ALICEVISION_TRACE_SCOPE("inner \"quoted\"");
+      }
+    }
+  }
+  ALICEVISION_TRACE_COUNTER("counter", 42);
+  tracer.setEnabled(false);
+
+  // 2 spans per iteration, the root span and its memory sample, 1 counter:
+  // the spans of the worker threads are nested in the root span
+  BOOST_CHECK_EQUAL(tracer.getNbEvents(), 2 * nbSpans + 3);
+  BOOST_CHECK_EQUAL(tracer.getNbDroppedEvents(), 0);
+
+  const std::string filename = "tracing_test.json";
+  BOOST_CHECK(tracer.exportChromeTrace(filename));
+
+  namespace pt = boost::property_tree;
+  pt::ptree tree;
+  BOOST_CHECK_NO_THROW(pt::read_json(filename, tree));
+
+  int nbOuter = 0;
+  int nbInner = 0;
+  int nbCounters = 0;
+  for(const auto& event : tree.get_child("traceEvents"))
+  {
+    const std::string name = event.second.get<std::string>("name");
+    const std::string phase = event.second.get<std::string>("ph");
+    if(name == "outer" && phase == "X")
+    {
+      ++nbOuter;
+      BOOST_CHECK(event.second.get<double>("dur") >= 0.0);
+      const std::string detail = event.second.get<std::string>("args.detail");
+      BOOST_CHECK(detail.find('-') != std::string::npos);
+    }
+    else if(name == "inner \"quoted\"")
+      ++nbInner;
+    else if(name == "counter")
+    {
+      ++nbCounters;
+      BOOST_CHECK_EQUAL(event.second.get<double>("args.value"), 42.0);
+    }
+  }
+  BOOST_CHECK_EQUAL(nbOuter, nbSpans);
+  BOOST_CHECK_EQUAL(nbInner, nbSpans);
+  BOOST_CHECK_EQUAL(nbCounters, 1);
+
+  std::remove(filename.c_str());
+  tracer.clear();
+}
+
+BOOST_AUTO_TEST_CASE(tracing_maxEventsPerThread)
+{
+  Tracer& tracer = Tracer::get();
+  const std::size_t maxEventsPerThread = tracer.getMaxEventsPerThread();
+  tracer.setEnabled(true);
+  tracer.clear();
+  tracer.setMaxEventsPerThread(10);
+
+  // 1 span and 1 memory sample per iteration
+  for(int i = 0; i < 20; ++i)
+  {
+    ALICEVISION_TRACE_SCOPE("span", i);
+  }
+  tracer.setEnabled(false);
+
+  BOOST_CHECK_EQUAL(tracer.getNbEvents(), 10);
+  BOOST_CHECK_EQUAL(tracer.getNbDroppedEvents(), 30);
+
+  tracer.setMaxEventsPerThread(maxEventsPerThread);
+  tracer.clear();
+  BOOST_CHECK_EQUAL(tracer.getNbDroppedEvents(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(tracing_exportAtExit)
+{
+  // child process: the tracer is enabled by the environment and exported at exit
+  if(std::getenv("ALICEVISION_TRACE_FILE") != nullptr)
+  {
+    BOOST_CHECK(Tracer::get().isEnabled());
+    ALICEVISION_TRACE_SCOPE("exportAtExit");
+    return;
+  }
+
+  // run this test in a child process with the trace file set, it must exit cleanly
+  const std::string filename = "tracing_exportAtExit.json";
+  const std::string executable = boost::unit_test::framework::master_test_suite().argv[0];
+  std::remove(filename.c_str());
+#ifdef _WIN32
+  const std::string command = "set ALICEVISION_TRACE_FILE=" + filename + "&& \"" + executable + "\" --run_test=tracing_exportAtExit";
+#else
+  const std::string command = "ALICEVISION_TRACE_FILE=" + filename + " \"" + executable + "\" --run_test=tracing_exportAtExit";
+#endif
+  BOOST_REQUIRE_EQUAL(std::system(command.c_str()), 0);
+
+  namespace pt = boost::property_tree;
+  pt::ptree tree;
+  BOOST_REQUIRE_NO_THROW(pt::read_json(filename, tree));
+
+  int nbSpans = 0;
+  for(const auto& event : tree.get_child("traceEvents"))
+  {
+    if(event.second.get<std::string>("name") == "exportAtExit")
+      ++nbSpans;
+  }
+  BOOST_CHECK_EQUAL(nbSpans, 1);
+
+  std::remove(filename.c_str());
+}
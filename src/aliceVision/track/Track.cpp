@@ -4,6 +4,7 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "Track.hpp"
+#include <aliceVision/system/Tracing.hpp>
 
 namespace aliceVision {
 namespace track {
@@ -14,17 +15,28 @@ using namespace lemon;
 /// Build tracks for a given series of pairWise matches
 bool TracksBuilder::Build( const PairwiseMatches &  pairwiseMatches)
 {
+  std::vector<PairwiseMatches::const_iterator> pairwiseMatchesIts;
+  pairwiseMatchesIts.reserve(pairwiseMatches.size());
+  for(PairwiseMatches::const_iterator it = pairwiseMatches.begin(); it != pairwiseMatches.end(); ++it)
+    pairwiseMatchesIts.push_back(it);
+  return Build(pairwiseMatchesIts);
+}
+
+/// Build tracks for a given series of pairWise matches, referenced by iterators
+bool TracksBuilder::Build(const std::vector<PairwiseMatches::const_iterator>& pairwiseMatches)
+{
+  ALICEVISION_TRACE_SCOPE("tracks.build", pairwiseMatches.size());
   typedef std::set<IndexedFeaturePair> SetIndexedPair;
   // Set of all features of all images: (imageIndex, featureIndex)
   SetIndexedPair allFeatures;
   // For each couple of images
 
   // Make the union according the pair matches
-  for(const auto& matchesPerDescIt: pairwiseMatches)
+  for(const PairwiseMatches::const_iterator& matchesPerDescIt: pairwiseMatches)
   {
-    const size_t & I = matchesPerDescIt.first.first;
-    const size_t & J = matchesPerDescIt.first.second;
-    const MatchesPerDescType& matchesPerDesc = matchesPerDescIt.second;
+    const size_t & I = matchesPerDescIt->first.first;
+    const size_t & J = matchesPerDescIt->first.second;
+    const MatchesPerDescType& matchesPerDesc = matchesPerDescIt->second;
 
     for(const auto& matchesIt: matchesPerDesc)
     {
@@ -62,11 +74,11 @@ bool TracksBuilder::Build( const PairwiseMatches &  pairwiseMatches)
   }
 
   // Make the union according the pair matches
-  for(const auto& matchesPerDescIt: pairwiseMatches)
+  for(const PairwiseMatches::const_iterator& matchesPerDescIt: pairwiseMatches)
   {
-    const size_t & I = matchesPerDescIt.first.first;
-    const size_t & J = matchesPerDescIt.first.second;
-    const MatchesPerDescType& matchesPerDesc = matchesPerDescIt.second;
+    const size_t & I = matchesPerDescIt->first.first;
+    const size_t & J = matchesPerDescIt->first.second;
+    const MatchesPerDescType& matchesPerDesc = matchesPerDescIt->second;
 
     for(const auto& matchesIt: matchesPerDesc)
     {
@@ -86,6 +98,7 @@ bool TracksBuilder::Build( const PairwiseMatches &  pairwiseMatches)
 
 bool TracksBuilder::Filter(size_t nLengthSupTo, bool bMultithread)
 {
+  ALICEVISION_TRACE_SCOPE("tracks.filter");
   // Remove bad tracks:
   // - track that are too short,
   // - track with id conflicts (many times the same image index)
@@ -151,6 +151,12 @@ struct TracksBuilder
   /// Build tracks for a given series of pairWise matches
   bool Build(const PairwiseMatches&  pairwiseMatches);
 
+  /**
+   * @brief Build tracks for a subset of pairWise matches, without copying them.
+   * @param[in] pairwiseMatches Iterators on the pairwise matches to use
+   */
+  bool Build(const std::vector<PairwiseMatches::const_iterator>& pairwiseMatches);
+
   /// Remove bad tracks (too short or track with ids collision)
   bool Filter(size_t nLengthSupTo = 2, bool bMultithread = true);
 
@@ -0,0 +1,300 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/system/cpu.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace benchmark {
+
+/// Named parameters of a benchmark run (problem sizes, options)
+typedef std::map<std::string, double> BenchmarkParameters;
+
+/// Named measures of a benchmark run besides the timings (inliers, errors, iterations...)
+typedef std::map<std::string, double> BenchmarkMetrics;
+
+/**
+ * @brief Get the value at the given percentile of sorted values (nearest rank).
+ * @param[in] sortedValues The values, sorted by increasing order
+ * @param[in] p The percentile in [0, 1]
+ * @return the percentile value, 0 if there is no value
+ */
+inline double percentile(const std::vector<double>& sortedValues, double p)
+{
+  if(sortedValues.empty())
+    return 0.0;
+  const double rank = std::ceil(p * sortedValues.size());
+  const std::size_t index = static_cast<std::size_t>(std::max(rank, 1.0)) - 1;
+  return sortedValues[std::min(index, sortedValues.size() - 1)];
+}
+
+/**
+ * @brief Timings of a benchmark run.
+ */
+struct BenchmarkResult
+{
+  std::string name;
+  BenchmarkParameters parameters;
+  /// number of timed samples (repetitions or externally measured durations)
+  std::size_t repetitions = 0;
+  /// number of processed items per repetition (descriptors, points, observations...)
+  std::size_t nbItems = 0;
+  double minMs = 0.0;
+  double meanMs = 0.0;
+  double p50Ms = 0.0;
+  double p90Ms = 0.0;
+  double p99Ms = 0.0;
+  double maxMs = 0.0;
+  /// metrics averaged over the timed repetitions
+  BenchmarkMetrics metrics;
+
+  /// processed items per second, based on the best repetition
+  double itemsPerSecond() const
+  {
+    return (minMs > 0.0) ? nbItems / (minMs * 1e-3) : 0.0;
+  }
+};
+
+/**
+ * @brief Run timed benchmarks, print them as a table and export them as JSON.
+ *
+ * Each benchmark is run once untimed (warm-up), then timed for a number of repetitions.
+ * An optional setup function is called before each run, outside of the timings,
+ * for the benchmarks that modify their input (i.e. bundle adjustment).
+ * The durations measured outside of the suite (i.e. request latencies) are added with addSamples,
+ * so all the benchmarks share the same statistics, table and JSON format.
+ */
+class BenchmarkSuite
+{
+public:
+
+  /**
+   * @param[in] repetitions The number of timed runs of each benchmark
+   * @param[in] filter Regular expression, only the benchmarks with a matching name are run
+   */
+  BenchmarkSuite(std::size_t repetitions, const std::string& filter = ".*")
+    : _repetitions(std::max(std::size_t(1), repetitions))
+    , _filter(filter)
+  {}
+
+  /// Return true if the benchmark of this name is selected by the filter
+  bool isEnabled(const std::string& name) const
+  {
+    return std::regex_search(name, _filter);
+  }
+
+  /**
+   * @brief Run and time a benchmark.
+   * @param[in] name The benchmark name, "group.benchmark"
+   * @param[in] parameters The benchmark parameters
+   * @param[in] nbItems The number of items processed by a run
+   * @param[in] function The timed function
+   * @param[in] setup Called before each run, not timed
+   */
+  void run(const std::string& name,
+           const BenchmarkParameters& parameters,
+           std::size_t nbItems,
+           const std::function<void()>& function,
+           const std::function<void()>& setup = std::function<void()>())
+  {
+    if(!isEnabled(name))
+      return;
+
+    BenchmarkResult result;
+    result.name = name;
+    result.parameters = parameters;
+    result.nbItems = nbItems;
+
+    // warm-up
+    if(setup)
+      setup();
+    function();
+
+    std::vector<double> samplesMs;
+    samplesMs.reserve(_repetitions);
+    _currentResult = &result;
+
+    for(std::size_t r = 0; r < _repetitions; ++r)
+    {
+      if(setup)
+        setup();
+      system::Timer timer;
+      function();
+      samplesMs.push_back(timer.elapsedMs());
+    }
+
+    _currentResult = nullptr;
+    addResult(result, samplesMs);
+  }
+
+  /**
+   * @brief Add a value to a metric of the running benchmark, averaged over the timed repetitions.
+   * Only valid in the function given to run, the values of the warm-up run are ignored.
+   * @param[in] name The metric name
+   * @param[in] value The value of the current repetition
+   */
+  void addMetric(const std::string& name, double value)
+  {
+    if(_currentResult != nullptr)
+      _currentResult->metrics[name] += value / _repetitions;
+  }
+
+  /**
+   * @brief Add a benchmark from durations measured outside of the suite (i.e. request latencies).
+   * @param[in] name The benchmark name, "group.benchmark"
+   * @param[in] parameters The benchmark parameters
+   * @param[in] samplesMs The measured durations in milliseconds
+   * @param[in] metrics The benchmark metrics
+   */
+  void addSamples(const std::string& name,
+                  const BenchmarkParameters& parameters,
+                  const std::vector<double>& samplesMs,
+                  const BenchmarkMetrics& metrics = BenchmarkMetrics())
+  {
+    if(!isEnabled(name))
+      return;
+
+    BenchmarkResult result;
+    result.name = name;
+    result.parameters = parameters;
+    result.metrics = metrics;
+    addResult(result, samplesMs);
+  }
+
+  const std::vector<BenchmarkResult>& getResults() const
+  {
+    return _results;
+  }
+
+  /// Print the header of the results table
+  void printHeader() const
+  {
+    std::cout << std::left << std::setw(32) << "Benchmark" << std::setw(40) << "Parameters" << std::right
+              << std::setw(12) << "Min(ms)"
+              << std::setw(12) << "Mean(ms)"
+              << std::setw(12) << "P50(ms)"
+              << std::setw(12) << "P90(ms)"
+              << std::setw(12) << "P99(ms)"
+              << std::setw(12) << "Max(ms)"
+              << std::setw(14) << "Items/s"
+              << "  Metrics"
+              << std::endl;
+  }
+
+  /**
+   * @brief Export the results and the hardware description as JSON.
+   * @param[in] filename The output file
+   */
+  void exportJson(const std::string& filename) const
+  {
+    namespace pt = boost::property_tree;
+    pt::ptree tree;
+
+    tree.put("hardware.cpu.freq", system::cpu_clock_by_os());
+    tree.put("hardware.cpu.cores", system::get_total_cpus());
+    tree.put("hardware.ram.size", system::getMemoryInfo().totalRam);
+    tree.put("repetitions", _repetitions);
+
+    pt::ptree resultsTree;
+    for(const BenchmarkResult& result : _results)
+    {
+      pt::ptree resultTree;
+      resultTree.put("name", result.name);
+      for(const auto& parameter : result.parameters)
+        resultTree.put("parameters." + parameter.first, parameter.second);
+      resultTree.put("repetitions", result.repetitions);
+      resultTree.put("items", result.nbItems);
+      resultTree.put("minMs", result.minMs);
+      resultTree.put("meanMs", result.meanMs);
+      resultTree.put("p50Ms", result.p50Ms);
+      resultTree.put("p90Ms", result.p90Ms);
+      resultTree.put("p99Ms", result.p99Ms);
+      resultTree.put("maxMs", result.maxMs);
+      resultTree.put("itemsPerSecond", result.itemsPerSecond());
+      for(const auto& metric : result.metrics)
+        resultTree.put("metrics." + metric.first, metric.second);
+      resultsTree.push_back(std::make_pair("", resultTree));
+    }
+    tree.add_child("results", resultsTree);
+
+    pt::write_json(filename, tree);
+  }
+
+private:
+
+  /// Compute the statistics of the samples, print and store the result
+  void addResult(BenchmarkResult& result, std::vector<double> samplesMs)
+  {
+    std::sort(samplesMs.begin(), samplesMs.end());
+    result.repetitions = samplesMs.size();
+    if(!samplesMs.empty())
+    {
+      double sum = 0.0;
+      for(const double sample : samplesMs)
+        sum += sample;
+      result.minMs = samplesMs.front();
+      result.meanMs = sum / samplesMs.size();
+      result.maxMs = samplesMs.back();
+    }
+    result.p50Ms = percentile(samplesMs, 0.5);
+    result.p90Ms = percentile(samplesMs, 0.9);
+    result.p99Ms = percentile(samplesMs, 0.99);
+
+    printResult(result);
+    _results.push_back(result);
+  }
+
+  void printResult(const BenchmarkResult& result) const
+  {
+    std::string parameters;
+    for(const auto& parameter : result.parameters)
+    {
+      std::ostringstream ss;
+      ss << parameter.first << "=" << parameter.second << " ";
+      parameters += ss.str();
+    }
+    std::cout << std::left << std::setw(32) << result.name << std::setw(40) << parameters << std::right
+              << std::fixed << std::setprecision(3)
+              << std::setw(12) << result.minMs
+              << std::setw(12) << result.meanMs
+              << std::setw(12) << result.p50Ms
+              << std::setw(12) << result.p90Ms
+              << std::setw(12) << result.p99Ms
+              << std::setw(12) << result.maxMs
+              << std::setprecision(0)
+              << std::setw(14) << result.itemsPerSecond()
+              << std::setprecision(3);
+    for(const auto& metric : result.metrics)
+      std::cout << "  " << metric.first << "=" << metric.second;
+    std::cout << std::endl;
+  }
+
+  std::size_t _repetitions;
+  std::regex _filter;
+  std::vector<BenchmarkResult> _results;
+  /// result of the benchmark being run, receives the metrics
+  BenchmarkResult* _currentResult = nullptr;
+};
+
+} // namespace benchmark
+} // namespace aliceVision
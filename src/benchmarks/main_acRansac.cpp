@@ -0,0 +1,269 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "BenchmarkSuite.hpp"
+
+#include <aliceVision/multiview/NViewDataSet.hpp>
+#include <aliceVision/multiview/conditioning.hpp>
+#include <aliceVision/multiview/essentialKernelSolver.hpp>
+#include <aliceVision/multiview/fundamentalKernelSolver.hpp>
+#include <aliceVision/multiview/homographyKernelSolver.hpp>
+#include <aliceVision/robustEstimation/ACRansac.hpp>
+#include <aliceVision/robustEstimation/ACRansacFast.hpp>
+#include <aliceVision/robustEstimation/ACRansacKernelAdaptator.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace aliceVision;
+using namespace aliceVision::robustEstimation;
+using namespace aliceVision::benchmark;
+
+namespace po = boost::program_options;
+
+/**
+ * @brief Two-view correspondences with a known set of inliers.
+ */
+struct TwoViewData
+{
+  Mat x1;
+  Mat x2;
+  Mat3 K;
+  int width = 1000;
+  int height = 1000;
+};
+
+/**
+ * @brief Replace a ratio of the correspondences by random points
+ *        and add gaussian noise to the others.
+ */
+void addOutliersAndNoise(TwoViewData& data, double outlierRatio, double noise, std::mt19937& generator)
+{
+  std::normal_distribution<double> noiseDistribution(0.0, noise);
+  std::uniform_real_distribution<double> xDistribution(0.0, data.width);
+  std::uniform_real_distribution<double> yDistribution(0.0, data.height);
+
+  const std::size_t nbOutliers = static_cast<std::size_t>(outlierRatio * data.x1.cols());
+  for(Mat::Index i = 0; i < data.x1.cols(); ++i)
+  {
+    if(static_cast<std::size_t>(i) < nbOutliers)
+    {
+      data.x2.col(i) << xDistribution(generator), yDistribution(generator);
+    }
+    else
+    {
+      data.x1.col(i) += Vec2(noiseDistribution(generator), noiseDistribution(generator));
+      data.x2.col(i) += Vec2(noiseDistribution(generator), noiseDistribution(generator));
+    }
+  }
+}
+
+/**
+ * @brief Points of a plane seen by two cameras related by a random homography.
+ */
+TwoViewData makeHomographyData(std::size_t nbPoints, std::mt19937& generator)
+{
+  TwoViewData data;
+  data.K = Mat3::Identity();
+  data.x1.resize(2, nbPoints);
+  data.x2.resize(2, nbPoints);
+
+  std::uniform_real_distribution<double> perturbation(-0.1, 0.1);
+  Mat3 H = Mat3::Identity();
+  for(int i = 0; i < 2; ++i)
+    for(int j = 0; j < 2; ++j)
+      H(i, j) += perturbation(generator);
+  H(0, 2) = 50.0 * perturbation(generator);
+  H(1, 2) = 50.0 * perturbation(generator);
+  H(2, 0) = 1e-3 * perturbation(generator);
+  H(2, 1) = 1e-3 * perturbation(generator);
+
+  std::uniform_real_distribution<double> position(100.0, 900.0);
+  for(std::size_t i = 0; i < nbPoints; ++i)
+  {
+    const Vec3 p(position(generator), position(generator), 1.0);
+    data.x1.col(i) = p.head<2>();
+    data.x2.col(i) = (H * p).hnormalized();
+  }
+  return data;
+}
+
+/**
+ * @brief 3D points seen by two realistic cameras.
+ */
+TwoViewData makeTwoViewData(std::size_t nbPoints)
+{
+  const NViewDataSet dataset = NRealisticCamerasRing(2, nbPoints, NViewDatasetConfigurator(1000, 1000, 500, 500, 5, 0));
+
+  TwoViewData data;
+  data.K = dataset._K[0];
+  data.x1 = dataset._x[0];
+  data.x2 = dataset._x[1];
+  return data;
+}
+
+/**
+ * @brief Time ACRANSAC and ACRANSAC_Fast on the same problem,
+ *        with the number of inliers, the threshold (pixel) and the NFA as metrics.
+ */
+template<typename Kernel>
+void benchmarkKernel(BenchmarkSuite& suite,
+                     const std::string& name,
+                     const Kernel& kernel,
+                     const BenchmarkParameters& parameters,
+                     std::size_t nbIterations,
+                     unsigned int seed)
+{
+  // each repetition uses a different seed, the same one for both implementations
+  unsigned int runSeed = seed;
+  std::vector<std::size_t> inliers;
+  typename Kernel::Model model;
+
+  suite.run("acRansac." + name + ".reference", parameters, kernel.NumSamples(), [&]()
+  {
+    const std::pair<double, double> result = ACRANSAC(kernel, inliers, nbIterations, &model);
+    suite.addMetric("inliers", inliers.size());
+    suite.addMetric("thresholdPx", result.first);
+    suite.addMetric("nfa", result.second);
+  },
+  [&]()
+  {
+    std::srand(runSeed++);
+  });
+
+  runSeed = seed;
+  suite.run("acRansac." + name + ".fast", parameters, kernel.NumSamples(), [&]()
+  {
+    const std::pair<double, double> result = ACRANSAC_Fast(kernel, inliers, nbIterations, &model, std::numeric_limits<double>::infinity(), runSeed++);
+    suite.addMetric("inliers", inliers.size());
+    suite.addMetric("thresholdPx", result.first);
+    suite.addMetric("nfa", result.second);
+  });
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<std::size_t> nbPointsList = {500, 2000, 10000};
+  double outlierRatio = 0.5;
+  double noise = 0.5;
+  std::size_t nbIterations = 1024;
+  std::size_t nbRepetitions = 5;
+  std::string filter = ".*";
+  std::string outputFilepath;
+  unsigned int seed = 0;
+
+  po::options_description allParams("AliceVision benchmark of AC-RANSAC implementations.\n"
+                                    "Compare ACRANSAC and ACRANSAC_Fast on synthetic H, F and E problems");
+  allParams.add_options()
+    ("points", po::value<std::vector<std::size_t>>(&nbPointsList)->multitoken(),
+      "Number of correspondences of the problems.")
+    ("outlierRatio", po::value<double>(&outlierRatio)->default_value(outlierRatio),
+      "Ratio of outliers in [0, 1).")
+    ("noise", po::value<double>(&noise)->default_value(noise),
+      "Standard deviation of the inliers noise in pixels.")
+    ("iterations", po::value<std::size_t>(&nbIterations)->default_value(nbIterations),
+      "Maximum number of AC-RANSAC iterations.")
+    ("repetitions", po::value<std::size_t>(&nbRepetitions)->default_value(nbRepetitions),
+      "Number of timed runs of each problem.")
+    ("filter", po::value<std::string>(&filter)->default_value(filter),
+      "Regular expression on the names of the benchmarks to run "
+      "(homography, fundamental, essential, reference, fast).")
+    ("output,o", po::value<std::string>(&outputFilepath),
+      "Output JSON file of the results.")
+    ("seed", po::value<unsigned int>(&seed)->default_value(seed),
+      "Random seed of the data generation and of the samplers.")
+    ("help,h", "Print this help.");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  if(outlierRatio < 0.0 || outlierRatio >= 1.0 || nbRepetitions == 0)
+  {
+    ALICEVISION_CERR("ERROR: invalid parameters.");
+    return EXIT_FAILURE;
+  }
+
+  BenchmarkSuite suite(nbRepetitions, filter);
+  suite.printHeader();
+
+  std::mt19937 generator(seed);
+
+  for(const std::size_t nbPoints : nbPointsList)
+  {
+    const BenchmarkParameters parameters = {{"points", nbPoints},
+                                            {"outlierRatio", outlierRatio},
+                                            {"noise", noise},
+                                            {"iterations", nbIterations}};
+
+    // homography
+    {
+      TwoViewData data = makeHomographyData(nbPoints, generator);
+      addOutliersAndNoise(data, outlierRatio, noise, generator);
+
+      typedef ACKernelAdaptor<homography::kernel::FourPointSolver,
+                              homography::kernel::AsymmetricError,
+                              UnnormalizerI,
+                              Mat3> KernelType;
+      const KernelType kernel(data.x1, data.width, data.height, data.x2, data.width, data.height, false);
+      benchmarkKernel(suite, "homography", kernel, parameters, nbIterations, seed);
+    }
+
+    // fundamental matrix
+    {
+      TwoViewData data = makeTwoViewData(nbPoints);
+      addOutliersAndNoise(data, outlierRatio, noise, generator);
+
+      typedef ACKernelAdaptor<fundamental::kernel::SevenPointSolver,
+                              fundamental::kernel::SimpleError,
+                              UnnormalizerT,
+                              Mat3> KernelType;
+      const KernelType kernel(data.x1, data.width, data.height, data.x2, data.width, data.height, true);
+      benchmarkKernel(suite, "fundamental", kernel, parameters, nbIterations, seed);
+    }
+
+    // essential matrix
+    {
+      TwoViewData data = makeTwoViewData(nbPoints);
+      addOutliersAndNoise(data, outlierRatio, noise, generator);
+
+      typedef ACKernelAdaptorEssential<essential::kernel::FivePointKernel,
+                                       fundamental::kernel::EpipolarDistanceError,
+                                       UnnormalizerT,
+                                       Mat3> KernelType;
+      const KernelType kernel(data.x1, data.width, data.height, data.x2, data.width, data.height, data.K, data.K);
+      benchmarkKernel(suite, "essential", kernel, parameters, nbIterations, seed);
+    }
+  }
+
+  if(!outputFilepath.empty())
+  {
+    suite.exportJson(outputFilepath);
+    ALICEVISION_COUT("Results exported to " << outputFilepath);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,311 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "BenchmarkSuite.hpp"
+
+#include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/image/io.hpp>
+#include <aliceVision/localization/LocalizationServer.hpp>
+#include <aliceVision/localization/VoctreeLocalizer.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace aliceVision;
+using namespace aliceVision::benchmark;
+
+namespace po = boost::program_options;
+namespace bfs = boost::filesystem;
+
+/**
+ * @brief Get the images of a folder, sorted by name.
+ */
+std::vector<std::string> listFrames(const std::string& folder)
+{
+  const std::vector<std::string> extensions = {".jpg", ".jpeg", ".png", ".ppm"};
+  std::vector<std::string> frames;
+  for(bfs::directory_iterator it(folder); it != bfs::directory_iterator(); ++it)
+  {
+    const std::string extension = boost::to_lower_copy(it->path().extension().string());
+    if(bfs::is_regular_file(it->status()) && std::find(extensions.begin(), extensions.end(), extension) != extensions.end())
+      frames.push_back(it->path().string());
+  }
+  std::sort(frames.begin(), frames.end());
+  return frames;
+}
+
+/**
+ * @brief The features of a frame, described once before the benchmark.
+ */
+struct DescribedFrame
+{
+  std::string imagePath;
+  std::pair<std::size_t, std::size_t> imageSize;
+  feature::MapRegionsPerDesc regions;
+};
+
+feature::MapRegionsPerDesc copyRegions(const feature::MapRegionsPerDesc& regionsPerDesc)
+{
+  feature::MapRegionsPerDesc copy;
+  for(const auto& regions : regionsPerDesc)
+  {
+    std::unique_ptr<feature::Regions>& regionsCopy = copy[regions.first];
+    regionsCopy.reset(regions.second->EmptyClone());
+    for(std::size_t i = 0; i < regions.second->RegionCount(); ++i)
+      regions.second->CopyRegion(i, regionsCopy.get());
+  }
+  return copy;
+}
+
+int main(int argc, char** argv)
+{
+  std::string sfmFilePath;
+  std::string descriptorsFolder;
+  std::string vocTreeFilepath;
+  std::string weightsFilepath;
+  std::string framesFolder;
+  std::string matchDescTypeNames = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
+  feature::EImageDescriberPreset featurePreset = feature::EImageDescriberPreset::NORMAL;
+  std::string algostring = "AllResults";
+  std::size_t numResults = 4;
+  std::size_t nbFrameBufferMatching = 10;
+  bool temporalPrior = false;
+  std::size_t nbCameras = 4;
+  std::size_t nbFramesPerCamera = 0;
+  double frameRate = 0.0;
+  std::size_t nbWorkers = 0;
+  std::size_t maxPendingRequests = 0;
+  bool describeInServer = false;
+  std::string outputFilepath;
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::EVerboseLevel::Error);
+
+  po::options_description allParams("AliceVision load generator of the localization server.\n"
+                                    "Several cameras replay the frames of a folder and submit them "
+                                    "concurrently to a LocalizationServer sharing one localizer");
+  allParams.add_options()
+    ("sfmdata", po::value<std::string>(&sfmFilePath)->required(),
+      "The sfm_data.json kind of file generated by AliceVision.")
+    ("framesFolder", po::value<std::string>(&framesFolder)->required(),
+      "Folder of the frames to localize (jpg, png, ppm).")
+    ("voctree", po::value<std::string>(&vocTreeFilepath)->required(),
+      "Filename for the vocabulary tree.")
+    ("voctreeWeights", po::value<std::string>(&weightsFilepath),
+      "Filename for the vocabulary tree weights.")
+    ("descriptorPath", po::value<std::string>(&descriptorsFolder),
+      "Folder containing the descriptors for all the images (ie the *.desc.)")
+    ("matchDescTypes", po::value<std::string>(&matchDescTypeNames)->default_value(matchDescTypeNames),
+      "The describer types to use for the matching.")
+    ("preset", po::value<feature::EImageDescriberPreset>(&featurePreset)->default_value(featurePreset),
+      "Preset for the feature extractor {LOW,MEDIUM,NORMAL,HIGH,ULTRA}.")
+    ("algorithm", po::value<std::string>(&algostring)->default_value(algostring),
+      "Algorithm type: FirstBest, AllResults.")
+    ("nbImageMatch", po::value<std::size_t>(&numResults)->default_value(numResults),
+      "Number of images to retrieve in database.")
+    ("nbFrameBufferMatching", po::value<std::size_t>(&nbFrameBufferMatching)->default_value(nbFrameBufferMatching),
+      "Number of previous frame of the camera to use for matching (0 = Disable).")
+    ("temporalPrior", po::value<bool>(&temporalPrior)->default_value(temporalPrior),
+      "Enable/Disable the tracking mode from the previous pose of the camera.")
+    ("nbCameras", po::value<std::size_t>(&nbCameras)->default_value(nbCameras),
+      "Number of simulated cameras, each one replays the frames with a different starting frame.")
+    ("nbFramesPerCamera", po::value<std::size_t>(&nbFramesPerCamera)->default_value(nbFramesPerCamera),
+      "Number of frames submitted by each camera (0 for all the frames of the folder).")
+    ("frameRate", po::value<double>(&frameRate)->default_value(frameRate),
+      "Frames per second submitted by each camera (0 to submit as fast as possible).")
+    ("nbWorkers", po::value<std::size_t>(&nbWorkers)->default_value(nbWorkers),
+      "Number of worker threads of the server (0 for the number of cores).")
+    ("maxPendingRequests", po::value<std::size_t>(&maxPendingRequests)->default_value(maxPendingRequests),
+      "Maximum number of requests waiting in the server (0 for unbounded).")
+    ("describeInServer", po::value<bool>(&describeInServer)->default_value(describeInServer),
+      "Submit the images and describe them in the server, "
+      "otherwise the frames are described once before the benchmark.")
+    ("output,o", po::value<std::string>(&outputFilepath),
+      "Output JSON file of the results.")
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).")
+    ("help,h", "Print this help.");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  const std::vector<std::string> framePaths = listFrames(framesFolder);
+  if(framePaths.empty())
+  {
+    ALICEVISION_CERR("ERROR: no frame found in " << framesFolder);
+    return EXIT_FAILURE;
+  }
+  if(nbFramesPerCamera == 0)
+    nbFramesPerCamera = framePaths.size();
+  nbCameras = std::max(nbCameras, std::size_t(1));
+
+  // initialize the shared localizer
+  system::Timer initTimer;
+  const std::vector<feature::EImageDescriberType> matchDescTypes = feature::EImageDescriberType_stringToEnums(matchDescTypeNames);
+  localization::VoctreeLocalizer localizer(sfmFilePath, descriptorsFolder, vocTreeFilepath, weightsFilepath, matchDescTypes);
+  if(!localizer.isInit())
+  {
+    ALICEVISION_CERR("ERROR while initializing the localizer!");
+    return EXIT_FAILURE;
+  }
+  ALICEVISION_COUT("Localizer initialized in " << initTimer.elapsed() << " s");
+
+  localization::VoctreeLocalizer::Parameters param;
+  param._algorithm = localization::VoctreeLocalizer::initFromString(algostring);
+  param._numResults = numResults;
+  param._nbFrameBufferMatching = nbFrameBufferMatching;
+  param._useTemporalPrior = temporalPrior;
+  param._ccTagUseCuda = false;
+  param._featurePreset = featurePreset;
+  param._errorMax = 4.0;
+  param._matchingError = 4.0;
+
+  // describe the frames once, the requests get a copy of their features
+  std::vector<DescribedFrame> frames(framePaths.size());
+  for(std::size_t i = 0; i < framePaths.size(); ++i)
+    frames[i].imagePath = framePaths[i];
+
+  if(!describeInServer)
+  {
+    system::Timer describeTimer;
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int i = 0; i < frames.size(); ++i)
+    {
+      DescribedFrame& frame = frames[i];
+      image::Image<unsigned char> imageGrey;
+      image::readImage(frame.imagePath, imageGrey);
+      frame.imageSize = std::make_pair(imageGrey.Width(), imageGrey.Height());
+
+      for(const feature::EImageDescriberType descType : matchDescTypes)
+      {
+        std::unique_ptr<feature::ImageDescriber> describer = feature::createImageDescriber(descType);
+        describer->Set_configuration_preset(featurePreset);
+        describer->Allocate(frame.regions[descType]);
+        describer->Describe(imageGrey, frame.regions[descType], nullptr);
+      }
+    }
+    ALICEVISION_COUT(frames.size() << " frames described in " << describeTimer.elapsed() << " s");
+  }
+
+  localization::LocalizationServerParams serverParams;
+  serverParams.nbWorkers = nbWorkers;
+  serverParams.maxPendingRequests = maxPendingRequests;
+
+  std::vector<localization::LocalizationResponse> responses;
+  responses.reserve(nbCameras * nbFramesPerCamera);
+
+  system::Timer timer;
+  {
+    localization::LocalizationServer server(localizer, param, serverParams);
+
+    // collect the responses while the requests are submitted
+    std::thread consumer([&]()
+    {
+      localization::LocalizationResponse response;
+      while(server.waitResponse(response))
+        responses.push_back(std::move(response));
+    });
+
+    // the cameras submit their frames on a common timeline, each one with a different starting frame
+    const auto start = std::chrono::steady_clock::now();
+    for(std::size_t f = 0; f < nbFramesPerCamera; ++f)
+    {
+      if(frameRate > 0.0)
+        std::this_thread::sleep_until(start + std::chrono::duration<double>(f / frameRate));
+
+      for(std::size_t c = 0; c < nbCameras; ++c)
+      {
+        const DescribedFrame& frame = frames[(c * frames.size() / nbCameras + f) % frames.size()];
+
+        localization::LocalizationRequest request;
+        request.cameraId = c;
+        request.frameId = f;
+        request.imagePath = frame.imagePath;
+        if(!describeInServer)
+        {
+          request.regions = copyRegions(frame.regions);
+          request.imageSize = frame.imageSize;
+        }
+        server.submit(std::move(request));
+      }
+    }
+
+    server.stop();
+    consumer.join();
+  }
+  const double totalTime = timer.elapsed();
+
+  // statistics
+  std::vector<double> latencies;
+  std::vector<double> queueTimes;
+  std::vector<double> featureTimes;
+  std::vector<double> localizationTimes;
+  std::size_t nbLocalized = 0;
+
+  for(const localization::LocalizationResponse& response : responses)
+  {
+    latencies.push_back(response.latency);
+    queueTimes.push_back(response.queueTime);
+    featureTimes.push_back(response.featureTime);
+    localizationTimes.push_back(response.localizationTime);
+    nbLocalized += response.isLocalized;
+  }
+
+  const BenchmarkParameters parameters = {{"cameras", nbCameras},
+                                          {"framesPerCamera", nbFramesPerCamera},
+                                          {"frameRate", frameRate},
+                                          {"workers", nbWorkers},
+                                          {"maxPendingRequests", maxPendingRequests},
+                                          {"describeInServer", describeInServer}};
+  const BenchmarkMetrics metrics = {{"requests", responses.size()},
+                                    {"localized", nbLocalized},
+                                    {"totalTimeS", totalTime},
+                                    {"framesPerSecond", (totalTime > 0.0) ? responses.size() / totalTime : 0.0}};
+
+  // the server is run once, the samples are the durations of the requests
+  BenchmarkSuite suite(1);
+  suite.printHeader();
+  suite.addSamples("localizationServer.latency", parameters, latencies, metrics);
+  suite.addSamples("localizationServer.queue", parameters, queueTimes);
+  suite.addSamples("localizationServer.features", parameters, featureTimes);
+  suite.addSamples("localizationServer.localization", parameters, localizationTimes);
+
+  if(!outputFilepath.empty())
+  {
+    suite.exportJson(outputFilepath);
+    ALICEVISION_COUT("Results exported to " << outputFilepath);
+  }
+
+  return EXIT_SUCCESS;
+}
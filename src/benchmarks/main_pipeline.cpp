@@ -0,0 +1,409 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "BenchmarkSuite.hpp"
+
+#include <aliceVision/feature/Descriptor.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/image/Image.hpp>
+#include <aliceVision/image/convolution.hpp>
+#include <aliceVision/image/filtering.hpp>
+#include <aliceVision/matching/ArrayMatcher_cascadeHashing.hpp>
+#include <aliceVision/matching/metric.hpp>
+#include <aliceVision/multiview/NViewDataSet.hpp>
+#include <aliceVision/multiview/homographyKernelSolver.hpp>
+#include <aliceVision/robustEstimation/ACRansac.hpp>
+#include <aliceVision/robustEstimation/ACRansacKernelAdaptator.hpp>
+#include <aliceVision/sfm/sfm.hpp>
+#include <aliceVision/sfm/utils/syntheticScene.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/track/Track.hpp>
+#include <aliceVision/voctree/TreeBuilder.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace aliceVision;
+using namespace aliceVision::benchmark;
+
+namespace po = boost::program_options;
+
+typedef feature::Descriptor<float, 128> DescriptorFloat;
+typedef feature::Descriptor<unsigned char, 128> DescriptorUChar;
+
+/// Avoid the optimization of the benchmarked computations
+volatile double benchmarkSink = 0.0;
+
+/**
+ * @brief Random descriptors, stored contiguously.
+ * @param[in] nbDescriptors The number of descriptors
+ * @param[in] dimension The descriptors dimension
+ * @param[in] maxValue The maximum value of the components
+ */
+template<typename Scalar>
+std::vector<Scalar> makeDescriptors(std::size_t nbDescriptors, std::size_t dimension, double maxValue, std::mt19937& generator)
+{
+  std::uniform_real_distribution<double> distribution(0.0, maxValue);
+  std::vector<Scalar> descriptors(nbDescriptors * dimension);
+  for(Scalar& value : descriptors)
+    value = static_cast<Scalar>(distribution(generator));
+  return descriptors;
+}
+
+/**
+ * @brief Descriptors near the given ones (matches) and random descriptors (outliers).
+ */
+template<typename Scalar>
+std::vector<Scalar> makeQueryDescriptors(const std::vector<Scalar>& descriptors, double maxValue, std::mt19937& generator)
+{
+  std::normal_distribution<double> noise(0.0, 0.02 * maxValue);
+  std::uniform_real_distribution<double> distribution(0.0, maxValue);
+  std::vector<Scalar> queries(descriptors.size());
+  for(std::size_t i = 0; i < descriptors.size(); ++i)
+  {
+    // one half of the queries are matches
+    const double value = ((i / 128) % 2) ? distribution(generator) : descriptors[i] + noise(generator);
+    queries[i] = static_cast<Scalar>(std::min(maxValue, std::max(0.0, value)));
+  }
+  return queries;
+}
+
+template<typename Scalar, typename Metric>
+void benchmarkMetric(BenchmarkSuite& suite, const std::string& name, std::size_t nbDescriptors, double maxValue, unsigned int seed)
+{
+  if(!suite.isEnabled("metric." + name))
+    return;
+
+  std::mt19937 generator(seed);
+  const std::size_t dimension = 128;
+  const std::vector<Scalar> descriptors = makeDescriptors<Scalar>(nbDescriptors + 1, dimension, maxValue, generator);
+
+  suite.run("metric." + name, {{"descriptors", nbDescriptors}, {"dimension", dimension}}, nbDescriptors, [&]()
+  {
+    Metric metric;
+    double sum = 0.0;
+    for(std::size_t i = 0; i < nbDescriptors; ++i)
+      sum += metric(&descriptors[i * dimension], &descriptors[(i + 1) * dimension], dimension);
+    benchmarkSink = sum;
+  });
+}
+
+void benchmarkCascadeHasher(BenchmarkSuite& suite, std::size_t nbDescriptors, unsigned int seed)
+{
+  if(!suite.isEnabled("matching.cascadeHasher"))
+    return;
+
+  std::mt19937 generator(seed);
+  const std::size_t dimension = 128;
+  const std::vector<float> descriptors = makeDescriptors<float>(nbDescriptors, dimension, 1.0, generator);
+  const std::vector<float> queries = makeQueryDescriptors(descriptors, 1.0, generator);
+
+  suite.run("matching.cascadeHasher", {{"descriptors", nbDescriptors}, {"dimension", dimension}}, nbDescriptors, [&]()
+  {
+    matching::ArrayMatcher_cascadeHashing<float> matcher;
+    matcher.Build(descriptors.data(), nbDescriptors, dimension);
+
+    matching::IndMatches indices;
+    std::vector<float> distances;
+    matcher.SearchNeighbours(queries.data(), nbDescriptors, &indices, &distances, 2);
+    benchmarkSink = indices.size();
+  });
+}
+
+/**
+ * @brief Synthetic scene with all the points seen by all the cameras.
+ */
+sfm::SfMData makeScene(std::size_t nbViews, std::size_t nbPoints)
+{
+  const NViewDatasetConfigurator config;
+  const NViewDataSet dataset = NRealisticCamerasRing(nbViews, nbPoints, config);
+  return sfm::getInputScene(dataset, config, camera::PINHOLE_CAMERA);
+}
+
+void benchmarkTracksBuilder(BenchmarkSuite& suite, std::size_t nbViews, std::size_t nbPoints)
+{
+  if(!suite.isEnabled("track.tracksBuilder"))
+    return;
+
+  const sfm::SfMData sfmData = makeScene(nbViews, nbPoints);
+  matching::PairwiseMatches pairwiseMatches;
+  sfm::generateSyntheticMatches(pairwiseMatches, sfmData, feature::EImageDescriberType::UNKNOWN);
+
+  std::size_t nbMatches = 0;
+  for(const auto& matchesPerDesc : pairwiseMatches)
+    nbMatches += matchesPerDesc.second.getNbAllMatches();
+
+  suite.run("track.tracksBuilder", {{"views", nbViews}, {"points", nbPoints}}, nbMatches, [&]()
+  {
+    track::TracksBuilder tracksBuilder;
+    tracksBuilder.Build(pairwiseMatches);
+    tracksBuilder.Filter();
+    track::TracksMap tracks;
+    tracksBuilder.ExportToSTL(tracks);
+    benchmarkSink = tracks.size();
+  });
+}
+
+void benchmarkACRansac(BenchmarkSuite& suite, std::size_t nbPoints, unsigned int seed)
+{
+  using namespace aliceVision::robustEstimation;
+
+  if(!suite.isEnabled("robustEstimation.ACRansac"))
+    return;
+
+  std::mt19937 generator(seed);
+
+  // points of a plane seen by two cameras, one half of outliers
+  Mat3 H;
+  H << 1.1, 0.05, 20.0,
+       -0.03, 0.95, -15.0,
+       1e-5, -2e-5, 1.0;
+  std::uniform_real_distribution<double> position(0.0, 1000.0);
+  std::normal_distribution<double> noise(0.0, 0.5);
+  Mat x1(2, nbPoints), x2(2, nbPoints);
+  for(std::size_t i = 0; i < nbPoints; ++i)
+  {
+    x1.col(i) << position(generator), position(generator);
+    if(i % 2)
+    {
+      const Vec3 x = H * Vec3(x1(0, i), x1(1, i), 1.0);
+      x2.col(i) = x.head<2>() / x(2) + Vec2(noise(generator), noise(generator));
+    }
+    else
+      x2.col(i) << position(generator), position(generator);
+  }
+
+  typedef ACKernelAdaptor<homography::kernel::FourPointSolver,
+                          homography::kernel::AsymmetricError,
+                          UnnormalizerI,
+                          Mat3> KernelType;
+  const KernelType kernel(x1, 1000, 1000, x2, 1000, 1000, false);
+
+  suite.run("robustEstimation.ACRansac", {{"points", nbPoints}, {"iterations", 1024}}, nbPoints, [&]()
+  {
+    std::srand(0);
+    std::vector<std::size_t> inliers;
+    Mat3 model;
+    ACRANSAC(kernel, inliers, 1024, &model);
+    benchmarkSink = inliers.size();
+  });
+}
+
+void benchmarkVocabularyTree(BenchmarkSuite& suite, std::size_t nbDescriptors, unsigned int seed)
+{
+  if(!suite.isEnabled("voctree.quantize"))
+    return;
+
+  std::mt19937 generator(seed);
+  const std::uint32_t k = 10;
+  const std::uint32_t levels = 3;
+
+  // train a small tree on random descriptors
+  std::uniform_real_distribution<float> distribution(0.f, 255.f);
+  std::vector<DescriptorFloat> trainingDescriptors(20 * std::pow(k, levels));
+  for(DescriptorFloat& descriptor : trainingDescriptors)
+    for(std::size_t i = 0; i < descriptor.size(); ++i)
+      descriptor[i] = distribution(generator);
+
+  voctree::TreeBuilder<DescriptorFloat> builder(DescriptorFloat(0));
+  builder.kmeans().setRestarts(1);
+  builder.kmeans().setMaxIterations(10);
+  builder.build(trainingDescriptors, k, levels);
+
+  std::vector<DescriptorUChar> descriptors(nbDescriptors);
+  for(DescriptorUChar& descriptor : descriptors)
+    for(std::size_t i = 0; i < descriptor.size(); ++i)
+      descriptor[i] = static_cast<unsigned char>(distribution(generator));
+
+  suite.run("voctree.quantize", {{"descriptors", nbDescriptors}, {"k", k}, {"levels", levels}}, nbDescriptors, [&]()
+  {
+    const std::vector<voctree::Word> words = builder.tree().quantize(descriptors);
+    benchmarkSink = words.back();
+  });
+}
+
+void benchmarkBundleAdjustment(BenchmarkSuite& suite, std::size_t nbViews, std::size_t nbPoints)
+{
+  if(!suite.isEnabled("sfm.bundleAdjustmentCeres"))
+    return;
+
+  const sfm::SfMData groundTruth = makeScene(nbViews, nbPoints);
+  std::size_t nbObservations = 0;
+  for(const auto& landmark : groundTruth.GetLandmarks())
+    nbObservations += landmark.second.observations.size();
+
+  sfm::SfMData sfmData;
+  suite.run("sfm.bundleAdjustmentCeres", {{"views", nbViews}, {"points", nbPoints}}, nbObservations, [&]()
+  {
+    sfm::BundleAdjustmentCeres bundleAdjustment(sfm::BundleAdjustmentCeres::BA_options(false));
+    bundleAdjustment.Adjust(sfmData, sfm::BA_REFINE_ROTATION | sfm::BA_REFINE_TRANSLATION | sfm::BA_REFINE_STRUCTURE);
+    benchmarkSink = sfmData.GetLandmarks().size();
+  },
+  [&]()
+  {
+    // same perturbation of the scene for all the runs
+    std::mt19937 generator(0);
+    std::normal_distribution<double> noise(0.0, 0.01);
+    sfmData = groundTruth;
+    for(auto& landmark : sfmData.structure)
+      landmark.second.X += Vec3(noise(generator), noise(generator), noise(generator));
+    for(auto& pose : sfmData.GetPoses())
+      pose.second.center() += Vec3(noise(generator), noise(generator), noise(generator));
+  });
+}
+
+void benchmarkConvolution(BenchmarkSuite& suite, std::size_t size, unsigned int seed)
+{
+  if(!suite.isEnabled("image.separableConvolution"))
+    return;
+
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<float> distribution(0.f, 1.f);
+  image::Image<float> img(size, size);
+  for(int y = 0; y < img.Height(); ++y)
+    for(int x = 0; x < img.Width(); ++x)
+      img(y, x) = distribution(generator);
+
+  for(const double sigma : {1.6, 4.0})
+  {
+    suite.run("image.separableConvolution", {{"size", size}, {"sigma", sigma}}, size * size, [&]()
+    {
+      image::Image<float> out;
+      image::ImageGaussianFilter(img, sigma, out);
+      benchmarkSink = out(0, 0);
+    });
+  }
+}
+
+/**
+ * @brief Structure from motion from synthetic features and matches.
+ */
+void benchmarkReconstruction(BenchmarkSuite& suite, const std::string& workFolder, std::size_t nbViews, std::size_t nbPoints)
+{
+  if(!suite.isEnabled("sfm.sequential") && !suite.isEnabled("sfm.global"))
+    return;
+
+  const sfm::SfMData groundTruth = makeScene(nbViews, nbPoints);
+  sfm::SfMData sfmData = groundTruth;
+  sfmData.GetPoses().clear();
+  sfmData.structure.clear();
+
+  std::normal_distribution<double> noise(0.0, 0.5);
+  feature::FeaturesPerView featuresPerView;
+  sfm::generateSyntheticFeatures(featuresPerView, feature::EImageDescriberType::UNKNOWN, groundTruth, noise);
+  matching::PairwiseMatches pairwiseMatches;
+  sfm::generateSyntheticMatches(pairwiseMatches, groundTruth, feature::EImageDescriberType::UNKNOWN);
+
+  const BenchmarkParameters parameters = {{"views", nbViews}, {"points", nbPoints}};
+
+  suite.run("sfm.sequential", parameters, nbViews, [&]()
+  {
+    sfm::ReconstructionEngine_sequentialSfM sfmEngine(sfmData, workFolder);
+    sfmEngine.setFeatures(&featuresPerView);
+    sfmEngine.setMatches(&pairwiseMatches);
+    sfmEngine.setInitialPair(Pair(0, 1));
+    sfmEngine.Set_bFixedIntrinsics(true);
+    sfmEngine.Process();
+    benchmarkSink = sfmEngine.Get_SfMData().GetPoses().size();
+  });
+
+  suite.run("sfm.global", parameters, nbViews, [&]()
+  {
+    sfm::ReconstructionEngine_globalSfM sfmEngine(sfmData, workFolder);
+    sfmEngine.SetFeaturesProvider(&featuresPerView);
+    sfmEngine.SetMatchesProvider(&pairwiseMatches);
+    sfmEngine.Set_bFixedIntrinsics(true);
+    sfmEngine.SetRotationAveragingMethod(sfm::ROTATION_AVERAGING_L2);
+    sfmEngine.SetTranslationAveragingMethod(sfm::TRANSLATION_AVERAGING_SOFTL1);
+    sfmEngine.Process();
+    benchmarkSink = sfmEngine.Get_SfMData().GetPoses().size();
+  });
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<std::size_t> scales = {1, 2, 4};
+  std::size_t nbRepetitions = 3;
+  std::string filter = ".*";
+  std::string outputFilepath;
+  std::string workFolder = ".";
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::EVerboseLevel::Error);
+  unsigned int seed = 0;
+
+  po::options_description allParams("AliceVision benchmarks of the photogrammetry pipeline.\n"
+                                    "Micro-benchmarks of the main algorithms and synthetic reconstructions, "
+                                    "run at several problem scales");
+  allParams.add_options()
+    ("scales", po::value<std::vector<std::size_t>>(&scales)->multitoken(),
+      "Scale factors of the problem sizes.")
+    ("repetitions", po::value<std::size_t>(&nbRepetitions)->default_value(nbRepetitions),
+      "Number of timed runs of each benchmark.")
+    ("filter", po::value<std::string>(&filter)->default_value(filter),
+      "Regular expression on the names of the benchmarks to run "
+      "(metric, matching, track, robustEstimation, voctree, image, sfm).")
+    ("output,o", po::value<std::string>(&outputFilepath),
+      "Output JSON file of the results.")
+    ("workFolder", po::value<std::string>(&workFolder)->default_value(workFolder),
+      "Folder of the files written by the reconstruction engines.")
+    ("seed", po::value<unsigned int>(&seed)->default_value(seed),
+      "Random seed of the data generation.")
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).")
+    ("help,h", "Print this help.");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  BenchmarkSuite suite(nbRepetitions, filter);
+  suite.printHeader();
+
+  for(const std::size_t scale : scales)
+  {
+    benchmarkMetric<unsigned char, matching::L2_Simple<unsigned char> >(suite, "L2_Simple.uchar", 100000 * scale, 255.0, seed);
+    benchmarkMetric<unsigned char, matching::L2_Vectorized<unsigned char> >(suite, "L2_Vectorized.uchar", 100000 * scale, 255.0, seed);
+    benchmarkMetric<float, matching::L2_Simple<float> >(suite, "L2_Simple.float", 100000 * scale, 1.0, seed);
+    benchmarkMetric<float, matching::L2_Vectorized<float> >(suite, "L2_Vectorized.float", 100000 * scale, 1.0, seed);
+    benchmarkCascadeHasher(suite, 2000 * scale, seed);
+    benchmarkTracksBuilder(suite, 10 * scale, 1000 * scale);
+    benchmarkACRansac(suite, 1000 * scale, seed);
+    benchmarkVocabularyTree(suite, 10000 * scale, seed);
+    benchmarkConvolution(suite, 512 * scale, seed);
+    benchmarkBundleAdjustment(suite, 10 * scale, 500 * scale);
+    benchmarkReconstruction(suite, workFolder, 8 * scale, 256 * scale);
+  }
+
+  if(!outputFilepath.empty())
+  {
+    suite.exportJson(outputFilepath);
+    ALICEVISION_COUT("Results exported to " << outputFilepath);
+  }
+
+  return EXIT_SUCCESS;
+}
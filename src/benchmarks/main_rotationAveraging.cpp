@@ -0,0 +1,251 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "BenchmarkSuite.hpp"
+
+#include <aliceVision/multiview/rotationAveraging/l1.hpp>
+#include <aliceVision/multiview/rotationAveraging/l2.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace aliceVision;
+using namespace aliceVision::rotationAveraging;
+using namespace aliceVision::benchmark;
+
+namespace po = boost::program_options;
+
+/**
+ * @brief Random rotation from a normalized gaussian quaternion.
+ */
+Mat3 randomRotation(std::mt19937& generator)
+{
+  std::normal_distribution<double> distribution(0.0, 1.0);
+  Eigen::Quaterniond q(distribution(generator), distribution(generator), distribution(generator), distribution(generator));
+  q.normalize();
+  return q.toRotationMatrix();
+}
+
+/**
+ * @brief Random rotation of a given angle (radian) around a random axis.
+ */
+Mat3 randomRotation(double angle, std::mt19937& generator)
+{
+  std::normal_distribution<double> distribution(0.0, 1.0);
+  const Vec3 axis = Vec3(distribution(generator), distribution(generator), distribution(generator)).normalized();
+  return Eigen::AngleAxisd(angle, axis).toRotationMatrix();
+}
+
+/**
+ * @brief Angle (degree) of the rotation between two rotations.
+ */
+double angularError(const Mat3& R1, const Mat3& R2)
+{
+  const double cosAngle = 0.5 * ((R1 * R2.transpose()).trace() - 1.0);
+  return R2D(std::acos(std::max(-1.0, std::min(1.0, cosAngle))));
+}
+
+/**
+ * @brief Synthetic pose graph of a sequential acquisition: a chain through all the poses,
+ *        edges to the next poses and random loop closures,
+ *        with noisy relative rotations and a ratio of random outliers.
+ */
+struct PoseGraph
+{
+  std::vector<Mat3> groundTruth;
+  RelativeRotations relativeRotations;
+};
+
+PoseGraph makePoseGraph(std::size_t nbPoses,
+                        std::size_t nbNeighbours,
+                        double noise,
+                        double loopClosureRatio,
+                        double outlierRatio,
+                        std::mt19937& generator)
+{
+  PoseGraph graph;
+  graph.groundTruth.resize(nbPoses);
+  for(Mat3& R : graph.groundTruth)
+    R = randomRotation(generator);
+
+  // express the ground truth in the first pose frame
+  const Mat3 R0t = graph.groundTruth.front().transpose();
+  for(Mat3& R : graph.groundTruth)
+    R = R * R0t;
+
+  // sequential acquisition: edges between close poses and a few loop closures
+  std::set<Pair> edges;
+  for(IndexT i = 0; i + 1 < nbPoses; ++i)
+    edges.insert(Pair(i, i + 1));
+
+  std::uniform_int_distribution<IndexT> poseDistribution(0, nbPoses - 1);
+  std::uniform_int_distribution<IndexT> offsetDistribution(2, nbNeighbours);
+  std::uniform_real_distribution<double> closureDistribution(0.0, 1.0);
+  const std::size_t nbEdges = std::min(nbPoses * nbNeighbours / 2, nbPoses * (nbPoses - 1) / 2);
+  while(edges.size() < nbEdges)
+  {
+    const IndexT i = poseDistribution(generator);
+    const IndexT j = (closureDistribution(generator) < loopClosureRatio) ? poseDistribution(generator)
+                                                                         : i + offsetDistribution(generator);
+    if(i != j && j < nbPoses)
+      edges.insert(Pair(std::min(i, j), std::max(i, j)));
+  }
+
+  std::normal_distribution<double> noiseDistribution(0.0, D2R(noise));
+  std::uniform_real_distribution<double> outlierDistribution(0.0, 1.0);
+  for(const Pair& edge : edges)
+  {
+    Mat3 Rij;
+    if(edge.second != edge.first + 1 && outlierDistribution(generator) < outlierRatio)
+      Rij = randomRotation(generator);
+    else
+      Rij = randomRotation(noiseDistribution(generator), generator) *
+            graph.groundTruth[edge.second] * graph.groundTruth[edge.first].transpose();
+    graph.relativeRotations.emplace_back(edge.first, edge.second, Rij);
+  }
+  return graph;
+}
+
+/**
+ * @brief Mean angular error (degree) of the global rotations, the first pose is the reference.
+ */
+double meanAngularError(const std::vector<Mat3>& rotations, const std::vector<Mat3>& groundTruth)
+{
+  const Mat3 R0t = rotations.front().transpose();
+  double error = 0.0;
+  for(std::size_t i = 0; i < rotations.size(); ++i)
+    error += angularError(rotations[i] * R0t, groundTruth[i]);
+  return error / rotations.size();
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<std::size_t> nbPosesList = {100, 1000, 5000};
+  std::size_t nbNeighbours = 10;
+  double noise = 1.0;
+  double loopClosureRatio = 0.05;
+  double outlierRatio = 0.1;
+  std::size_t nbRepetitions = 3;
+  std::string filter = ".*";
+  std::string outputFilepath;
+  unsigned int seed = 0;
+
+  po::options_description allParams("AliceVision benchmark of rotation averaging.\n"
+                                    "Time the MST initialization, the L1 IRLS refinement and the sparse L2 averaging on synthetic pose graphs");
+  allParams.add_options()
+    ("poses", po::value<std::vector<std::size_t>>(&nbPosesList)->multitoken(),
+      "Number of poses of the graphs.")
+    ("neighbours", po::value<std::size_t>(&nbNeighbours)->default_value(nbNeighbours),
+      "Mean number of relative rotations per pose.")
+    ("loopClosureRatio", po::value<double>(&loopClosureRatio)->default_value(loopClosureRatio),
+      "Ratio of relative rotations between random poses in [0, 1].")
+    ("noise", po::value<double>(&noise)->default_value(noise),
+      "Standard deviation of the relative rotations noise in degrees.")
+    ("outlierRatio", po::value<double>(&outlierRatio)->default_value(outlierRatio),
+      "Ratio of random relative rotations in [0, 1).")
+    ("repetitions", po::value<std::size_t>(&nbRepetitions)->default_value(nbRepetitions),
+      "Number of timed runs of each method.")
+    ("filter", po::value<std::string>(&filter)->default_value(filter),
+      "Regular expression on the names of the benchmarks to run (mst, l1Irls, l2Sparse).")
+    ("output,o", po::value<std::string>(&outputFilepath),
+      "Output JSON file of the results.")
+    ("seed", po::value<unsigned int>(&seed)->default_value(seed),
+      "Random seed of the data generation.")
+    ("help,h", "Print this help.");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  if(outlierRatio < 0.0 || outlierRatio >= 1.0 || loopClosureRatio < 0.0 || loopClosureRatio > 1.0 || nbNeighbours < 2)
+  {
+    ALICEVISION_CERR("ERROR: invalid parameters.");
+    return EXIT_FAILURE;
+  }
+
+  BenchmarkSuite suite(nbRepetitions, filter);
+  suite.printHeader();
+
+  std::mt19937 generator(seed);
+
+  for(const std::size_t nbPoses : nbPosesList)
+  {
+    if(nbPoses < 2)
+      continue;
+
+    const PoseGraph graph = makePoseGraph(nbPoses, nbNeighbours, noise, loopClosureRatio, outlierRatio, generator);
+    const std::size_t nbEdges = graph.relativeRotations.size();
+
+    const BenchmarkParameters parameters = {{"poses", nbPoses},
+                                            {"edges", nbEdges},
+                                            {"noise", noise},
+                                            {"outlierRatio", outlierRatio}};
+
+    // maximum spanning tree initialization, also the starting point of the L1 refinement
+    l1::Matrix3x3Arr mstRotations(nbPoses, Mat3::Identity());
+    l1::InitRotationsMST(graph.relativeRotations, mstRotations, 0);
+    suite.run("rotationAveraging.mst", parameters, nbEdges, [&]()
+    {
+      l1::Matrix3x3Arr rotations(nbPoses, Mat3::Identity());
+      l1::InitRotationsMST(graph.relativeRotations, rotations, 0);
+      suite.addMetric("errorDeg", meanAngularError(rotations, graph.groundTruth));
+    });
+
+    // L1 IRLS refinement from the MST initialization
+    l1::Matrix3x3Arr rotations;
+    suite.run("rotationAveraging.l1Irls", parameters, nbEdges, [&]()
+    {
+      unsigned int nbIterations = 0;
+      l1::RefineRotationsAvgL1IRLS(graph.relativeRotations, rotations, 0, D2R(5), &nbIterations);
+      suite.addMetric("iterations", nbIterations);
+      suite.addMetric("errorDeg", meanAngularError(rotations, graph.groundTruth));
+    },
+    [&]()
+    {
+      rotations = mstRotations;
+    });
+
+    // sparse L2 averaging, includes its own MST warm start
+    suite.run("rotationAveraging.l2Sparse", parameters, nbEdges, [&]()
+    {
+      std::vector<Mat3> l2Rotations;
+      unsigned int nbIterations = 0;
+      l2::L2RotationAveraging_Sparse(nbPoses, graph.relativeRotations, l2Rotations, &nbIterations);
+      suite.addMetric("iterations", nbIterations);
+      suite.addMetric("errorDeg", meanAngularError(l2Rotations, graph.groundTruth));
+    });
+  }
+
+  if(!outputFilepath.empty())
+  {
+    suite.exportJson(outputFilepath);
+    ALICEVISION_COUT("Results exported to " << outputFilepath);
+  }
+
+  return EXIT_SUCCESS;
+}
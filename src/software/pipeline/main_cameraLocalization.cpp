@@ -11,6 +11,7 @@
 #endif
 #include <aliceVision/localization/LocalizationResult.hpp>
 #include <aliceVision/localization/optimization.hpp>
+#include <aliceVision/localization/SlidingWindowRefiner.hpp>
 #include <aliceVision/image/io.hpp>
 #include <aliceVision/dataio/FeedProvider.hpp>
 #include <aliceVision/feature/ImageDescriber.hpp>
@@ -143,6 +144,12 @@ int main(int argc, char** argv)
   /// enable/disable the robust matching (geometric validation) when matching query image
   /// and databases images
   bool robustMatching = true;
+  /// enable the tracking from the pose of the previous frame before the voctree retrieval
+  bool temporalPrior = false;
+  /// number of views selected from the previous pose in tracking mode
+  std::size_t temporalPriorNbViews = 4;
+  /// minimum number of resection inliers for the tracking to succeed
+  std::size_t temporalPriorMinInliers = 30;
   
   /// the Alembic export file
   std::string exportAlembicFile = "trackedcameras.abc";
@@ -163,6 +170,14 @@ int main(int argc, char** argv)
   /// remove the points that does not have a minimum visibility over the sequence
   /// ie that are seen at least by minPointVisibility frames of the sequence
   std::size_t minPointVisibility = 0;
+
+  // parameters for the online sliding window refinement
+  /// number of frames of the sliding window (0 to disable the refinement)
+  std::size_t slidingWindowSize = 0;
+  /// weight of the constant velocity prior
+  double slidingWindowSmoothing = 1.0;
+  /// refine the intrinsics shared by the frames of the sequence
+  bool slidingWindowRefineIntrinsics = false;
   
   /// whether to save visual debug info
   std::string visualDebug = "";
@@ -230,6 +245,14 @@ int main(int argc, char** argv)
       ("robustMatching", po::value<bool>(&robustMatching)->default_value(robustMatching), 
           "[voctree] Enable/Disable the robust matching between query and database images, "
           "all putative matches will be considered.")
+      ("temporalPrior", po::value<bool>(&temporalPrior)->default_value(temporalPrior),
+          "[voctree] Enable/Disable the tracking mode: the query image is first matched with "
+          "the views that see the landmarks visible from the previous pose, the voctree "
+          "retrieval is used only if it fails.")
+      ("temporalPriorNbViews", po::value<std::size_t>(&temporalPriorNbViews)->default_value(temporalPriorNbViews),
+          "[voctree] Number of views selected from the previous pose in tracking mode")
+      ("temporalPriorMinInliers", po::value<std::size_t>(&temporalPriorMinInliers)->default_value(temporalPriorMinInliers),
+          "[voctree] Minimum number of resection inliers for the tracking to succeed")
 // cctag specific options
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
       ("nNearestKeyFrames", po::value<size_t>(&nNearestKeyFrames)->default_value(nNearestKeyFrames), 
@@ -251,6 +274,18 @@ int main(int argc, char** argv)
       ("minPointVisibility", po::value<size_t>(&minPointVisibility)->default_value(minPointVisibility), 
           "[bundle adjustment] Minimum number of observation that a point must "
           "have in order to be considered for bundle adjustment");
+
+// online sliding window refinement options
+  po::options_description slidingWindowParams("Parameters specific for the online (optional) sliding window refinement of the sequence");
+  slidingWindowParams.add_options()
+      ("slidingWindowSize", po::value<std::size_t>(&slidingWindowSize)->default_value(slidingWindowSize),
+          "[sliding window] Number of frames refined together after the localization "
+          "of each frame, 0 to disable the online refinement")
+      ("slidingWindowSmoothing", po::value<double>(&slidingWindowSmoothing)->default_value(slidingWindowSmoothing),
+          "[sliding window] Weight of the constant velocity prior between consecutive "
+          "frames, relative to a reprojection error of 1 pixel (0 to disable)")
+      ("slidingWindowRefineIntrinsics", po::value<bool>(&slidingWindowRefineIntrinsics)->default_value(slidingWindowRefineIntrinsics),
+          "[sliding window] Refine the intrinsics shared by the frames of the sequence");
   
 // output options
   po::options_description outputParams("Options for the output of the localizer");
@@ -270,7 +305,7 @@ int main(int argc, char** argv)
 
       ;
   
-  allParams.add(inputParams).add(outputParams).add(commonParams).add(voctreeParams).add(bundleParams);
+  allParams.add(inputParams).add(outputParams).add(commonParams).add(voctreeParams).add(bundleParams).add(slidingWindowParams);
 
   po::variables_map vm;
 
@@ -346,6 +381,8 @@ int main(int argc, char** argv)
   std::unique_ptr<localization::LocalizerParameters> param;
   
   std::unique_ptr<localization::ILocalizer> localizer;
+  /// the voctree localizer, to get its timings (null for the cctag localizer)
+  localization::VoctreeLocalizer* voctreeLocalizer = nullptr;
   
   // initialize the localizer according to the chosen type of describer
 
@@ -380,6 +417,10 @@ int main(int argc, char** argv)
     tmpParam->_matchingError = matchingErrorMax;
     tmpParam->_nbFrameBufferMatching = nbFrameBufferMatching;
     tmpParam->_useRobustMatching = robustMatching;
+    tmpParam->_useTemporalPrior = temporalPrior;
+    tmpParam->_temporalPriorNbViews = temporalPriorNbViews;
+    tmpParam->_temporalPriorMinInliers = temporalPriorMinInliers;
+    voctreeLocalizer = tmpLoc;
   }
   
   assert(localizer);
@@ -432,6 +473,12 @@ int main(int argc, char** argv)
   bacc::accumulator_set<double, bacc::stats<bacc::tag::mean, bacc::tag::min, bacc::tag::max, bacc::tag::sum > > stats;
   
   std::vector<localization::LocalizationResult> vec_localizationResults;
+
+  localization::SlidingWindowRefiner::Options refinerOptions;
+  refinerOptions.windowSize = slidingWindowSize;
+  refinerOptions.smoothingWeight = slidingWindowSmoothing;
+  refinerOptions.refineIntrinsics = slidingWindowRefineIntrinsics;
+  localization::SlidingWindowRefiner refiner(refinerOptions);
   
   while(feed.readImage(imageGrey, queryIntrinsics, currentImgName, hasIntrinsics))
   {
@@ -449,7 +496,21 @@ int main(int argc, char** argv)
     auto detect_end = std::chrono::steady_clock::now();
     auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
     ALICEVISION_COUT("\nLocalization took  " << detect_elapsed.count() << " [ms]");
+    if(voctreeLocalizer)
+    {
+      const localization::VoctreeLocalizer::FrameStats& frameStats = voctreeLocalizer->getLastFrameStats();
+      ALICEVISION_COUT("\tretrieval: " << frameStats.retrievalTime << " [ms]"
+                       << ", matching: " << frameStats.matchingTime << " [ms]"
+                       << ", resection: " << frameStats.resectionTime << " [ms]"
+                       << (frameStats.isTracked ? " (tracked)" : ""));
+    }
     stats(detect_elapsed.count());
+
+    if(slidingWindowSize > 0 && localizationResult.isValid())
+    {
+      refiner.addFrame(frameCounter, localizationResult);
+      ALICEVISION_COUT("Sliding window refinement took  " << refiner.getLastLatency() << " [ms]");
+    }
     
     vec_localizationResults.emplace_back(localizationResult);
 
@@ -474,6 +535,13 @@ int main(int argc, char** argv)
     feed.goToNextFrame();
   }
 
+  if(slidingWindowSize > 0)
+  {
+    // the last frames of the window have been refined again by the next frames
+    for(const auto& posePair : refiner.getPoses())
+      vec_localizationResults.at(posePair.first).setPose(posePair.second);
+  }
+
   if(wantsBinaryOutput)
   {
     localization::save(vec_localizationResults, basenameBinary + ".bin");
@@ -543,5 +611,21 @@ int main(int argc, char** argv)
   ALICEVISION_COUT("Processing took " << bacc::sum(stats)/1000 << " [s] overall");
   ALICEVISION_COUT("Mean time for localization:   " << bacc::mean(stats) << " [ms]");
   ALICEVISION_COUT("Max time for localization:   " << bacc::max(stats) << " [ms]");
+  if(voctreeLocalizer && frameCounter > 0)
+  {
+    const localization::VoctreeLocalizer::SequenceStats& sequenceStats = voctreeLocalizer->getSequenceStats();
+    ALICEVISION_COUT("Mean time for retrieval:   " << sequenceStats.retrievalTime / sequenceStats.nbFrames << " [ms]");
+    ALICEVISION_COUT("Mean time for matching:   " << sequenceStats.matchingTime / sequenceStats.nbFrames << " [ms]");
+    ALICEVISION_COUT("Mean time for resection:   " << sequenceStats.resectionTime / sequenceStats.nbFrames << " [ms]");
+    ALICEVISION_COUT("Localization success rate:   " << 100.0 * sequenceStats.nbLocalizedFrames / sequenceStats.nbFrames << "%");
+    if(temporalPrior && sequenceStats.nbTrackingAttempts > 0)
+      ALICEVISION_COUT("Tracking success rate:   " << 100.0 * sequenceStats.nbTrackedFrames / sequenceStats.nbTrackingAttempts << "% ("
+                       << sequenceStats.nbTrackedFrames << "/" << sequenceStats.nbTrackingAttempts << ")");
+  }
+  if(slidingWindowSize > 0)
+  {
+    ALICEVISION_COUT("Mean time for sliding window refinement:   " << refiner.getMeanLatency() << " [ms]");
+    ALICEVISION_COUT("Max time for sliding window refinement:   " << refiner.getMaxLatency() << " [ms]");
+  }
   ALICEVISION_COUT("Min time for localization:   " << bacc::min(stats) << " [ms]");
 }
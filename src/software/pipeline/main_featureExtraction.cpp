@@ -8,6 +8,7 @@
 #include <aliceVision/sfm/sfm.hpp>
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/feature/feature.hpp>
+#include <aliceVision/feature/FeatureExtractor.hpp>
 #include <aliceVision/stl/split.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/system/Logger.hpp>
@@ -15,7 +16,6 @@
 
 #include <dependencies/stlplus3/filesystemSimplified/file_system.hpp>
 
-#include <boost/progress.hpp>
 #include <boost/program_options.hpp>
 
 #include <cereal/archives/json.hpp>
@@ -24,7 +24,6 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
-#include <functional>
 #include <limits>
 
 using namespace aliceVision;
@@ -34,174 +33,6 @@ using namespace aliceVision::sfm;
 using namespace std;
 namespace po = boost::program_options;
 
-// ----------
-// Dispatcher
-// ----------
-
-#ifdef __linux__
-#include <unistd.h>
-#include <sys/wait.h>
-
-// Returns a map containing information about the memory usage o
-// of the system, it basically reads /proc/meminfo  
-std::map<std::string, unsigned long> memInfos()
-{
-  std::map<std::string, unsigned long> memoryInfos;
-  std::ifstream meminfoFile("/proc/meminfo");
-  if (meminfoFile.is_open())
-  {
-    std::string line;
-    while(getline(meminfoFile, line))
-    {
-      auto separator = line.find(":"); 
-      if (separator!=std::string::npos)
-      {
-        const std::string key = line.substr(0, separator);
-        const std::string value = line.substr(separator+1);
-        memoryInfos[key] = std::strtoul(value.c_str(), nullptr, 10);
-      }
-    }
-  }
-  return memoryInfos;
-}
-
-
-// Count the number of processors of the machine using /proc/cpuinfo
-unsigned int countProcessors()
-{
-  unsigned int nprocessors = 0;
-  std::ifstream cpuinfoFile("/proc/cpuinfo");
-  if (cpuinfoFile.is_open())
-  {
-    std::string line;
-    while(getline(cpuinfoFile, line))
-    {
-        // The line must start with the word "processor"
-        if (line.compare(0, std::strlen("processor"), "processor") == 0)
-            nprocessors++;
-    }
-  }
-  return nprocessors; 
-}
-
-// Returns the number of jobs to run simultaneously if one job should 
-// run with jobMemoryRequirement Kb 
-int remainingJobSlots(unsigned long jobMemoryRequirement)
-{
-  assert(jobMemoryRequirement!=0);
-  auto meminfos = memInfos();
-  const unsigned long available = meminfos["MemFree"] + meminfos["Buffers"] + meminfos["Cached"]; 
-  const unsigned int memSlots = static_cast<unsigned int>(available/jobMemoryRequirement); 
-  const unsigned int cpuSlots = countProcessors(); 
-  return std::max(std::min(memSlots, cpuSlots), 1u);
-}
-
-// Returns the peak virtual memory of the process processID
-// returns 0 if the process is not alive anymore, ie the 
-// /proc/pid/status can't be opened
-unsigned long peakMemory(pid_t processID)
-{  
-  char processStatusFileName[256];
-  snprintf(processStatusFileName, 256, "/proc/%d/status", processID);
-  std::ifstream processStatusFile(processStatusFileName);
-  if (processStatusFile.is_open())
-  {
-    std::string line;
-    constexpr const char *peakString = "VmPeak:";
-    constexpr size_t peakStringLen = std::strlen(peakString);
-    while(getline(processStatusFile, line))
-    {
-      if (line.compare(0, peakStringLen, peakString) == 0)
-      {
-        const std::string value = line.substr(peakStringLen);
-        return std::strtoul(value.c_str(), nullptr, 10);  
-      }
-    }
-  }
-  return 0ul;
-}
-
-// This function dispatch the compute function on several sub processes
-// keeping the maximum number of subprocesses under maxJobs
-void dispatch(const int maxJobs, std::function<void()> compute)
-{
-  static int nbJobs;
-  static unsigned int subProcessPeakMemory = 0;
-  static int possibleJobs=0;
-  pid_t pid = fork();
-  if (pid < 0)           
-  {                      
-    // Something bad happened
-    std::cerr << "fork failed\n";
-    _exit(EXIT_FAILURE);
-  }
-  else if(pid == 0)
-  {
-    // Disable OpenMP as we dispatch the work on multiple sub processes
-    // and we don't want that each subprocess use all the cpu ressource
-    omp_set_num_threads(1); 
-    compute();
-    _exit(EXIT_SUCCESS);
-  }
-  else 
-  {
-    nbJobs++;
-    // Use subprocess peak memory and assume the next job will use the 
-    // same amount of memory. It allows to roughly determine the number 
-    // of possible jobs running simultaneously
-    if (subProcessPeakMemory==0)
-    {
-      unsigned int readPeak = peakMemory(pid);
-      while(readPeak != 0) 
-      { // sample memory of the first job 
-        sleep(0.2); // sample every 0.2 seconds;
-        if( subProcessPeakMemory < readPeak )
-        {
-          subProcessPeakMemory = readPeak;
-        }  
-        readPeak = peakMemory(pid);
-      } 
-      possibleJobs = remainingJobSlots(subProcessPeakMemory);
-    }
-    
-    // Wait for a subprocess to stop when no more job slots are available
-    if (nbJobs >= possibleJobs || (maxJobs != 0 && nbJobs >= maxJobs))
-    {
-      pid_t pids;
-      while(pids = waitpid(-1, NULL, 0)) 
-      {
-        nbJobs--;
-        break;
-      }
-    }
-  }
-}
-
-// Waits for all subprocesses to terminate 
-void waitForCompletion()
-{
-  pid_t pids;
-  while(pids = waitpid(-1, NULL, 0)) 
-  {
-    if (errno == ECHILD)
-        break;
-  }
-}
-
-
-#else // __linux__
-
-void dispatch(const int maxJobs, std::function<void()> compute)
-{
-  if(maxJobs != 0)
-    omp_set_num_threads(maxJobs);
-  compute();
-}
-void waitForCompletion() {}
-int remainingJobSlots(unsigned long jobMemoryRequirement) {return 1;}  
-
-#endif // __linux__
-
 /// - Compute view image description (feature & descriptor extraction)
 /// - Export computed data
 int main(int argc, char **argv)
@@ -217,9 +48,12 @@ int main(int argc, char **argv)
   std::string describerTypesName = EImageDescriberType_enumToString(EImageDescriberType::SIFT);
   std::string describerPreset = EImageDescriberPreset_enumToString(EImageDescriberPreset::NORMAL);
   bool describersAreUpRight = false;
+  std::string siftEngineName = ESiftEngine_enumToString(ESiftEngine::VLFEAT);
   int rangeStart = -1;
   int rangeSize = 1;
   int maxJobs = 0;
+  int maxMemory = 0;
+  int prefetchSize = 2;
 
   po::options_description allParams("AliceVision featureExtraction");
 
@@ -239,12 +73,20 @@ int main(int argc, char **argv)
       "Configuration 'ultra' can take long time !")
     ("upright,u", po::value<bool>(&describersAreUpRight)->default_value(describersAreUpRight),
       "Use Upright feature.")
+    ("siftEngine", po::value<std::string>(&siftEngineName)->default_value(siftEngineName),
+      "SIFT extraction engine on CPU:\n"
+      "* vlfeat: VLFeat implementation\n"
+      "* native: native multithreaded implementation, close to VLFeat but not identical")
     ("rangeStart", po::value<int>(&rangeStart)->default_value(rangeStart),
       "Range image index start.")
     ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
       "Range size.")
     ("jobs", po::value<int>(&maxJobs)->default_value(maxJobs),
-      "Specifies the number of jobs to run simultaneously (0 for automatic mode).");
+      "Specifies the number of images to describe simultaneously (0 for automatic mode).")
+    ("maxMemory", po::value<int>(&maxMemory)->default_value(maxMemory),
+      "Memory budget in MB shared by the images described simultaneously (0 for available memory).")
+    ("prefetch", po::value<int>(&prefetchSize)->default_value(prefetchSize),
+      "Number of decoded images waiting for description.");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -318,16 +160,17 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
-  // b. Init vector of imageDescriber 
-  
-  struct DescriberMethod
+  if(maxJobs < 0 || maxMemory < 0 || prefetchSize < 1)
   {
-    std::string typeName;
-    EImageDescriberType type;
-    std::shared_ptr<ImageDescriber> describer;
-  };
-  std::vector<DescriberMethod> imageDescribers;
-  
+    ALICEVISION_LOG_ERROR("Error: Invalid jobs, maxMemory or prefetch argument.");
+    return EXIT_FAILURE;
+  }
+
+  // b. Init vector of imageDescriber
+
+  std::vector<FeatureExtractorDescriber> imageDescribers;
+  std::vector<std::string> imageDescribersNames;
+
   {
     if(describerTypesName.empty())
     {
@@ -338,30 +181,24 @@ int main(int argc, char **argv)
 
     for(const auto& describerMethod: describerMethodsVec)
     {
-      DescriberMethod method;
-      method.typeName = EImageDescriberType_enumToString(describerMethod);
-      method.type = describerMethod;
-      method.describer = createImageDescriber(method.type);
-      method.describer->Set_configuration_preset(describerPreset);
-      method.describer->setUpRight(describersAreUpRight);
-      imageDescribers.push_back(method);
+      FeatureExtractorDescriber describer;
+      describer.type = describerMethod;
+      describer.preset = EImageDescriberPreset_stringToEnum(describerPreset);
+      describer.upRight = describersAreUpRight;
+      describer.siftEngine = ESiftEngine_stringToEnum(siftEngineName);
+      imageDescribers.push_back(describer);
+      imageDescribersNames.push_back(EImageDescriberType_enumToString(describerMethod));
     }
   }
 
-  using namespace aliceVision::feature;
-
   // Feature extraction routines
   // For each View of the SfMData container:
   // - if regions file exist continue,
   // - if no file, compute features
   {
-    system::Timer timer;
-    boost::progress_display my_progress_bar( sfmData.GetViews().size(),
-      std::cout, "\n- EXTRACT FEATURES -\n" );
-
     Views::const_iterator iterViews = sfmData.views.begin();
     Views::const_iterator iterViewsEnd = sfmData.views.end();
-    
+
     if(rangeStart != -1)
     {
       if(rangeStart < 0 || rangeStart > sfmData.views.size())
@@ -381,85 +218,64 @@ int main(int argc, char **argv)
       iterViewsEnd = iterViews;
       std::advance(iterViewsEnd, rangeSize);
     }
-    
-    struct DescriberComputeMethod
-    {
-      std::size_t methodIndex;
-      std::string featFilename;
-      std::string descFilename;
-    };
-    
-    for(; iterViews != iterViewsEnd; ++iterViews, ++my_progress_bar)
+
+    std::vector<FeatureExtractorJob> jobs;
+
+    for(; iterViews != iterViewsEnd; ++iterViews)
     {
       const View* view = iterViews->second.get();
-      const std::string viewFilename = view->getImagePath();
-      ALICEVISION_LOG_INFO("Extract features in view : " << viewFilename);
-      
-      std::vector<DescriberComputeMethod> computeMethods;
-      
+
+      FeatureExtractorJob job;
+      job.viewId = view->getViewId();
+      job.imagePath = view->getImagePath();
+      job.width = view->getWidth();
+      job.height = view->getHeight();
+
       for(std::size_t i = 0; i < imageDescribers.size(); ++i)
       {
-        DescriberComputeMethod computeMethod;
-        
-        computeMethod.featFilename = stlplus::create_filespec(outputFolder,
-              stlplus::basename_part(std::to_string(view->getViewId())), imageDescribers[i].typeName + ".feat");
-        computeMethod.descFilename = stlplus::create_filespec(outputFolder,
-              stlplus::basename_part(std::to_string(view->getViewId())), imageDescribers[i].typeName + ".desc");
-      
-        if (stlplus::file_exists(computeMethod.featFilename) &&
-            stlplus::file_exists(computeMethod.descFilename))
+        FeatureExtractorJob::Output output;
+
+        output.featFilename = stlplus::create_filespec(outputFolder,
+              stlplus::basename_part(std::to_string(view->getViewId())), imageDescribersNames[i] + ".feat");
+        output.descFilename = stlplus::create_filespec(outputFolder,
+              stlplus::basename_part(std::to_string(view->getViewId())), imageDescribersNames[i] + ".desc");
+
+        if (stlplus::file_exists(output.featFilename) &&
+            stlplus::file_exists(output.descFilename))
         {
           // Skip the feature extraction as the results are already computed.
           continue;
         }
-        
-        computeMethod.methodIndex = i;
-        
+
+        output.describerIndex = i;
+
         // If features or descriptors file are missing, compute and export them
-        computeMethods.push_back(computeMethod);
-      }
-      
-      if(!computeMethods.empty())
-      {
-        auto computeFunction = [&]() {
-            Image<float> imageGrayFloat;
-            Image<unsigned char> imageGrayUChar;
-
-            readImage(viewFilename, imageGrayFloat);
-
-            for(auto& compute : computeMethods)
-            {
-              // Compute features and descriptors and export them to files
-              ALICEVISION_LOG_INFO("Extracting " + imageDescribers[compute.methodIndex].typeName  + " features from view " + std::to_string(view->getViewId()) + " : '" + view->getImagePath() +"'");
-              std::unique_ptr<Regions> regions;
-
-              if(imageDescribers[compute.methodIndex].describer->useFloatImage())
-              {
-                // image buffer use float image, use the read buffer
-                imageDescribers[compute.methodIndex].describer->Describe(imageGrayFloat, regions);
-              }
-              else
-              {
-                // image buffer can't use float image
-                if(imageGrayUChar.Width() == 0) // the first time, convert the float buffer to uchar
-                  imageGrayUChar = imageGrayFloat.GetMat().cast<unsigned char>() * 255;
-                imageDescribers[compute.methodIndex].describer->Describe(imageGrayUChar, regions);
-              }
-
-              imageDescribers[compute.methodIndex].describer->Save(regions.get(), compute.featFilename, compute.descFilename);
-            }
-        };
-        
-        if (maxJobs == 1)
-          computeFunction();
-        else
-          dispatch(maxJobs, computeFunction);
+        job.outputs.push_back(output);
       }
+
+      if(!job.outputs.empty())
+        jobs.push_back(job);
     }
 
-    if (maxJobs != 1) waitForCompletion();
+    ALICEVISION_LOG_INFO("- EXTRACT FEATURES -" << std::endl
+                         << "\t- views: " << sfmData.views.size() << std::endl
+                         << "\t- views to describe: " << jobs.size());
+
+    FeatureExtractorParams params;
+    params.nbDescribeThreads = static_cast<std::size_t>(maxJobs);
+    params.prefetchSize = static_cast<std::size_t>(prefetchSize);
+    params.memoryBudget = static_cast<std::size_t>(maxMemory) * 1024 * 1024;
 
-    std::cout << "Task done in (s): " << timer.elapsed() << std::endl;
+    FeatureExtractor extractor(imageDescribers, params);
+    const bool success = extractor.process(jobs);
+
+    std::cout << "Task done in (s): " << extractor.getStats().totalTime << std::endl;
+
+    if(!success)
+    {
+      ALICEVISION_LOG_ERROR("Error: Feature extraction failed for " << extractor.getStats().nbFailures << " image(s).");
+      return EXIT_FAILURE;
+    }
   }
   return EXIT_SUCCESS;
 }
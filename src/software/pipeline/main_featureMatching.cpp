@@ -175,7 +175,7 @@ int main(int argc, char **argv)
     ("useGridSort", po::value<bool>(&useGridSort)->default_value(useGridSort),
       "Use matching grid sort.")
     ("exportDebugFiles", po::value<bool>(&exportDebugFiles)->default_value(exportDebugFiles),
-      "Export debug files (svg, dot).")
+      "Export debug files (svg, dot, geometric filter statistics).")
     ("fileExtension", po::value<std::string>(&fileExtension)->default_value(fileExtension),
       "File extension to store matches (bin or txt).")
     ("maxMatches", po::value<std::size_t>(&numMatchesToKeep)->default_value(numMatchesToKeep),
@@ -488,6 +488,12 @@ int main(int argc, char **argv)
     break;
   }
 
+  if(exportDebugFiles)
+  {
+    //-- export the robust estimation statistics of each pair
+    geometricFilter.exportStatistics(stlplus::create_filespec(matchesFolder, "geometricFilterStats", "txt"), geometricModel);
+  }
+
   std::cout << map_GeometricMatches.size() << " geometric image pair matches:" << std::endl;
   for(const auto& matchGeo: map_GeometricMatches)
   {
@@ -500,11 +506,20 @@ int main(int argc, char **argv)
   PairwiseMatches finalMatches;
 
   {
-    for(const auto& matchGeo: map_GeometricMatches)
+    // the image pairs are sorted and filtered in parallel
+    std::vector<PairwiseMatches::const_iterator> geometricMatchesIts;
+    geometricMatchesIts.reserve(map_GeometricMatches.size());
+    for(auto it = map_GeometricMatches.cbegin(); it != map_GeometricMatches.cend(); ++it)
+      geometricMatchesIts.push_back(it);
+
+    std::vector<aliceVision::matching::MatchesPerDescType> filteredMatchesPerPair(geometricMatchesIts.size());
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int p = 0; p < static_cast<int>(geometricMatchesIts.size()); ++p)
     {
       //Get the image pair and their matches.
-      const Pair& indexImagePair = matchGeo.first;
-      const aliceVision::matching::MatchesPerDescType& matchesPerDesc = matchGeo.second;
+      const Pair& indexImagePair = geometricMatchesIts[p]->first;
+      const aliceVision::matching::MatchesPerDescType& matchesPerDesc = geometricMatchesIts[p]->second;
 
       for(const auto& match: matchesPerDesc)
       {
@@ -519,8 +534,9 @@ int main(int argc, char **argv)
         if(rRegions && lRegions)
         {
           //Sorting function:
+          // without the grid ordering, only the kept matches are sorted
           aliceVision::matching::IndMatches outMatches;
-          sortMatches(inputMatches, *lRegions, *rRegions, outMatches);
+          sortMatches(inputMatches, *lRegions, *rRegions, outMatches, useGridSort ? 0 : numMatchesToKeep);
 
           if(useGridSort)
           {
@@ -534,15 +550,22 @@ int main(int argc, char **argv)
           }
 
           // std::cout << "Left features: " << lRegions->Features().size() << ", right features: " << rRegions->Features().size() << ", num matches: " << inputMatches.size() << ", num filtered matches: " << outMatches.size() << std::endl;
-          finalMatches[indexImagePair].insert(std::make_pair(descType, outMatches));
+          filteredMatchesPerPair[p].insert(std::make_pair(descType, outMatches));
         }
         else
         {
+          #pragma omp critical
           std::cout << "You cannot perform the grid filtering with these regions" << std::endl;
         }
       }
     }
 
+    for(std::size_t p = 0; p < geometricMatchesIts.size(); ++p)
+    {
+      if(!filteredMatchesPerPair[p].empty())
+        finalMatches[geometricMatchesIts[p]->first].swap(filteredMatchesPerPair[p]);
+    }
+
     std::cout << "After grid filtering:" << std::endl;
     for(const auto& matchGridFiltering: finalMatches)
     {
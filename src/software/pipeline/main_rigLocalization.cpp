@@ -404,20 +404,26 @@ int main(int argc, char** argv)
   while(haveImage)
   {
     // @fixme It's better to have arrays of pointers...
-    std::vector<image::Image<unsigned char> > vec_imageGrey;
-    std::vector<camera::PinholeRadialK3 > vec_queryIntrinsics;
-    vec_imageGrey.reserve(numCameras);
-    vec_queryIntrinsics.reserve(numCameras);
+    std::vector<image::Image<unsigned char> > vec_imageGrey(numCameras);
+    std::vector<camera::PinholeRadialK3 > vec_queryIntrinsics(numCameras);
+    std::vector<char> vec_hasImage(numCameras, false);
+    std::vector<char> vec_hasIntrinsics(numCameras, false);
+    std::vector<std::string> vec_imgName(numCameras);
            
-    // for each camera get the image and the associated internal parameters
-    for(std::size_t idCamera = 0; idCamera < numCameras; ++idCamera)
+    // for each camera get the image and the associated internal parameters,
+    // the feeds are independent so they are decoded in parallel
+    #pragma omp parallel for
+    for(int idCamera = 0; idCamera < static_cast<int>(numCameras); ++idCamera)
     {
-      image::Image<unsigned char> imageGrey;
-      camera::PinholeRadialK3 queryIntrinsics;
       bool hasIntrinsics = false;
-      std::string currentImgName;
-      haveImage = feeders[idCamera]->readImage(imageGrey, queryIntrinsics, currentImgName, hasIntrinsics);
+      vec_hasImage[idCamera] = feeders[idCamera]->readImage(vec_imageGrey[idCamera], vec_queryIntrinsics[idCamera], vec_imgName[idCamera], hasIntrinsics);
+      vec_hasIntrinsics[idCamera] = hasIntrinsics;
       feeders[idCamera]->goToNextFrame();
+    }
+
+    for(std::size_t idCamera = 0; idCamera < numCameras; ++idCamera)
+    {
+      haveImage = vec_hasImage[idCamera];
 
       if(!haveImage)
       {
@@ -432,15 +438,12 @@ int main(int argc, char** argv)
       }
       
       // for now let's suppose that the cameras are calibrated internally too
-      if(!hasIntrinsics)
+      if(!vec_hasIntrinsics[idCamera])
       {
         ALICEVISION_CERR("For now only internally calibrated cameras are supported!"
-                << "\nCamera " << idCamera << " does not have calibration for image " << currentImgName);
+                << "\nCamera " << idCamera << " does not have calibration for image " << vec_imgName[idCamera]);
         return EXIT_FAILURE;  // a bit harsh but if we are here it's cheesy to say the less
       }
-      
-      vec_imageGrey.push_back(imageGrey);
-      vec_queryIntrinsics.push_back(queryIntrinsics);
     }
     
     if(!haveImage)
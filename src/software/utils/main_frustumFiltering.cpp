@@ -12,6 +12,7 @@
 #include <boost/program_options.hpp>
 
 #include <cstdlib>
+#include <fstream>
 
 using namespace aliceVision;
 using namespace aliceVision::sfm;
@@ -64,6 +65,7 @@ int main(int argc, char **argv)
   std::string outputFilename;
   double zNear = -1.;
   double zFar = -1.;
+  bool streamPairs = false;
 
   po::options_description allParams(
     "Compute camera cones that share some putative visual content.\n"
@@ -81,7 +83,10 @@ int main(int argc, char **argv)
     ("zNear", po::value<double>(&zNear)->default_value(zNear),
       "Distance of the near camera plane.")
     ("zFar", po::value<double>(&zFar)->default_value(zFar),
-      "Distance of the far camera plane.");
+      "Distance of the far camera plane.")
+    ("streamPairs", po::value<bool>(&streamPairs)->default_value(streamPairs),
+      "Write the pairs in the output file while they are computed, "
+      "instead of keeping all of them in memory (for large scenes).");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -133,6 +138,34 @@ int main(int argc, char **argv)
 
   aliceVision::system::Timer timer;
 
+  if(streamPairs)
+  {
+    const FrustumFilter frustum_filter(sfm_data, zNear, zFar);
+    frustum_filter.export_Ply(stlplus::create_filespec(stlplus::folder_part(outputFilename), "frustums.ply"));
+
+    // export pairs on disk, chunk by chunk
+    std::ofstream outStream(outputFilename);
+    if(!outStream.is_open())
+    {
+      ALICEVISION_LOG_ERROR("Unable to open the output pair file: '" << outputFilename << "'.");
+      return EXIT_FAILURE;
+    }
+
+    std::size_t nbPairs = 0;
+    // the pairs of a view are all in the same chunk: same file as savePairs, one line per view
+    frustum_filter.streamFrustumIntersectionPairs([&](const PairVec& pairs)
+    {
+      writePairs(outStream, pairs);
+      nbPairs += pairs.size();
+    });
+
+    std::cout << "#pairs: " << nbPairs << std::endl;
+    std::cout << std::endl << " Pair filtering took (s): " << timer.elapsed() << std::endl;
+
+    outStream.close();
+    return outStream.fail() ? EXIT_FAILURE : EXIT_SUCCESS;
+  }
+
   const PairSet pairs = BuildPairsFromFrustumsIntersections(sfm_data, zNear, zFar, stlplus::folder_part(outputFilename));
   /*const PairSet pairs = BuildPairsFromStructureObservations(sfm_data); */
 